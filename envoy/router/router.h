@@ -466,6 +466,17 @@ public:
    */
   virtual RetryStatus shouldHedgeRetryPerTryTimeout(DoRetryCallback callback) PURE;
 
+  /**
+   * Determine whether a hedged request should be sent because the request has been waiting for
+   * response headers longer than the latency hedge delay. The original request is not reset.
+   * @param callback supplies the callback that will be invoked when the hedged request should be
+   *                 sent. The callback will never be called inline.
+   * @return RetryStatus if a hedged request should be sent. @param callback will be called at some
+   *         point in the future. Otherwise no hedged request is sent and the callback will never
+   *         be called.
+   */
+  virtual RetryStatus shouldHedgeOnLatency(DoRetryCallback callback) PURE;
+
   /**
    * Called when a host was attempted but the request failed and is eligible for another retry.
    * Should be used to update whatever internal state depends on previously attempted hosts.
@@ -744,6 +755,25 @@ public:
    * will be canceled immediately.
    */
   virtual bool hedgeOnPerTryTimeout() const PURE;
+
+  /**
+   * @return bool indicating whether a hedged request should be sent when no response headers were
+   * received after a percentile of the recent upstream latencies of the route.
+   */
+  virtual bool hedgeOnLatency() const PURE;
+
+  /**
+   * @return the delay after which a latency hedged request should be sent, or absl::nullopt if
+   * latency hedging is disabled or not enough upstream latencies were observed yet.
+   */
+  virtual absl::optional<std::chrono::milliseconds> latencyHedgeDelay() const PURE;
+
+  /**
+   * Record the time it took an upstream request of the route to receive response headers. This
+   * is used to derive the latency hedge delay and is a no-op if latency hedging is disabled.
+   * @param latency supplies the upstream response header latency.
+   */
+  virtual void recordUpstreamLatency(std::chrono::milliseconds latency) const PURE;
 };
 
 class MetadataMatchCriterion {
@@ -262,6 +262,11 @@ public:
    */
   virtual bool cpusetThreadsEnabled() const PURE;
 
+  /**
+   * @return bool indicating whether counters and gauges should be allocated in contiguous slabs.
+   */
+  virtual bool statsSlabAllocationEnabled() const PURE;
+
   /**
    * @return the names of extensions to disable.
    */
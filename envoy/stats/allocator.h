@@ -94,6 +94,20 @@ public:
   virtual void forEachSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) const PURE;
   virtual void forEachSinkedTextReadout(SizeFn f_size, StatFn<TextReadout> f_stat) const PURE;
 
+  /**
+   * Iterate over the sinked counters or gauges that changed since the previous call, rather than
+   * over all of them. Changes are only tracked once this was first called, so the first call
+   * visits every sinked counter, and every sinked gauge changed since it was created. A counter
+   * counts as changed when it was incremented, even if it was latched since, so callers still
+   * check latch(). Implementations hold a mutex that will deadlock if the passed in functors try
+   * to create or delete a stat.
+   * @param f_size functor that is provided an upper bound of the number of stats visited. Note
+   * that this is called only once, prior to any calls to f_stat.
+   * @param f_stat functor that is provided one changed stat at a time.
+   */
+  virtual void forEachChangedSinkedCounter(SizeFn f_size, StatFn<Counter> f_stat) PURE;
+  virtual void forEachChangedSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) PURE;
+
   /**
    * Set the predicates to filter stats for sink.
    */
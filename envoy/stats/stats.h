@@ -108,6 +108,7 @@ public:
     static constexpr uint8_t LogicAccumulate = 0x02;
     static constexpr uint8_t NeverImport = 0x04;
     static constexpr uint8_t Hidden = 0x08;
+    static constexpr uint8_t Changed = 0x10;
   };
   virtual SymbolTable& symbolTable() PURE;
   virtual const SymbolTable& constSymbolTable() const PURE;
@@ -162,6 +163,13 @@ public:
   }
   virtual uint64_t value() const PURE;
 
+  /**
+   * Returns whether the gauge was changed since the previous call and clears that state. This is
+   * used by stats flushes that only report changed stats.
+   * @return true if the gauge was changed since the last call.
+   */
+  virtual bool latchChanged() PURE;
+
   /**
    * Sets a value from a hot-restart parent. This parent contribution must be
    * kept distinct from the child value, so that when we erase the value it
@@ -107,6 +107,26 @@ public:
   virtual absl::Status onOrcaLoadReport(const OrcaLoadReport& /*report*/) {
     return absl::OkStatus();
   }
+
+  /**
+   * Invoked when the router receives a complete response from this upstream host.
+   * NOTE: this method may be called concurrently from multiple threads.
+   * Please ensure that the implementation is thread-safe.
+   *
+   * @param response_time supplies the time from the start of the upstream request until the end
+   *        of the response.
+   */
+  virtual void onUpstreamResponseTime(std::chrono::microseconds /*response_time*/) {}
+
+  /**
+   * Invoked when a request to this upstream host is reset or times out. The elapsed time of a
+   * failed request is not a response time: a host that fails fast would otherwise look fast.
+   * NOTE: this method may be called concurrently from multiple threads.
+   * Please ensure that the implementation is thread-safe.
+   *
+   * @param elapsed supplies the time from the start of the upstream request until the failure.
+   */
+  virtual void onUpstreamFailure(std::chrono::microseconds /*elapsed*/) {}
 };
 
 using HostLbPolicyDataPtr = std::unique_ptr<HostLbPolicyData>;
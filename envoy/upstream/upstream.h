@@ -705,6 +705,7 @@ public:
   COUNTER(upstream_cx_http1_total)                                                                 \
   COUNTER(upstream_cx_http2_total)                                                                 \
   COUNTER(upstream_cx_http3_total)                                                                 \
+  COUNTER(upstream_cx_idle_limit)                                                                  \
   COUNTER(upstream_cx_idle_timeout)                                                                \
   COUNTER(upstream_cx_max_duration_reached)                                                        \
   COUNTER(upstream_cx_max_requests)                                                                \
@@ -723,6 +724,8 @@ public:
   COUNTER(upstream_internal_redirect_succeeded_total)                                              \
   COUNTER(upstream_rq_cancelled)                                                                   \
   COUNTER(upstream_rq_completed)                                                                   \
+  COUNTER(upstream_rq_hedge_abandoned)                                                             \
+  COUNTER(upstream_rq_hedge_attempted)                                                             \
   COUNTER(upstream_rq_maintenance_mode)                                                            \
   COUNTER(upstream_rq_max_duration_reached)                                                        \
   COUNTER(upstream_rq_pending_failure_eject)                                                       \
@@ -731,6 +734,8 @@ public:
   COUNTER(upstream_rq_0rtt)                                                                        \
   COUNTER(upstream_rq_per_try_timeout)                                                             \
   COUNTER(upstream_rq_per_try_idle_timeout)                                                        \
+  COUNTER(upstream_rq_preconnect_hit)                                                              \
+  COUNTER(upstream_rq_preconnect_miss)                                                             \
   COUNTER(upstream_rq_retry)                                                                       \
   COUNTER(upstream_rq_retry_backoff_exponential)                                                   \
   COUNTER(upstream_rq_retry_backoff_ratelimited)                                                   \
@@ -949,6 +954,12 @@ public:
    */
   virtual float peekaheadRatio() const PURE;
 
+  /**
+   * @return the maximum number of streams adaptive preconnect keeps capacity for on each upstream,
+   *         or 0 if adaptive preconnect is disabled.
+   */
+  virtual uint32_t maxAdaptivePreconnectStreams() const PURE;
+
   /**
    * @return soft limit on size of the cluster's connections read and write buffers.
    */
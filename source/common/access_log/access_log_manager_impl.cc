@@ -67,14 +67,14 @@ AccessLogFileImpl::AccessLogFileImpl(Filesystem::FilePtr&& file, Event::Dispatch
 }
 
 void AccessLogFileImpl::reopen() {
-  Thread::LockGuard lock(write_lock_);
+  Thread::LockGuard lock(control_lock_);
   reopen_file_ = true;
   flush_event_.notifyOne();
 }
 
 AccessLogFileImpl::~AccessLogFileImpl() {
   {
-    Thread::LockGuard lock(write_lock_);
+    Thread::LockGuard lock(control_lock_);
     flush_thread_exit_ = true;
     flush_event_.notifyOne();
   }
@@ -83,15 +83,23 @@ AccessLogFileImpl::~AccessLogFileImpl() {
     flush_thread_->join();
   }
 
+  Thread::LockGuard flush_lock(flush_lock_);
+  collectWriteQueue();
+
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
   if (file_->isOpen()) {
-    if (flush_buffer_.length() > 0) {
-      doWrite(flush_buffer_);
+    if (about_to_write_buffer_.length() > 0) {
+      doWrite(about_to_write_buffer_);
     }
     const Api::IoCallBoolResult result = file_->close();
     ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
                                              result.err_->getErrorDetails()));
   }
+
+  // The last consumed entry is kept by the queue until now.
+  if (write_queue_tail_ != &write_queue_stub_) {
+    delete write_queue_tail_;
+  }
 }
 
 void AccessLogFileImpl::doWrite(Buffer::Instance& buffer) {
@@ -134,17 +142,17 @@ void AccessLogFileImpl::flushThreadFunc() {
     std::unique_lock<Thread::BasicLockable> flush_lock;
 
     {
-      Thread::LockGuard write_lock(write_lock_);
+      Thread::LockGuard control_lock(control_lock_);
 
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
+      // flush_event_ can be woken up either by a large enough write queue or by timer.
+      // In case it was timer, the write queue can be empty.
       //
       // Note: do not stop waiting when only `do_reopen` is true. In this case, we tried to
       // reopen and failed. We don't want to retry this in a tight loop, so wait for the next
       // event (timer or flush).
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_ && !reopen_file_) {
+      while (queued_bytes_ == 0 && !flush_thread_exit_ && !reopen_file_) {
         // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
-        flush_event_.wait(write_lock_);
+        flush_event_.wait(control_lock_);
       }
 
       if (flush_thread_exit_) {
@@ -152,8 +160,6 @@ void AccessLogFileImpl::flushThreadFunc() {
       }
 
       flush_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
 
       if (reopen_file_) {
         do_reopen = true;
@@ -161,6 +167,8 @@ void AccessLogFileImpl::flushThreadFunc() {
       }
     }
 
+    collectWriteQueue();
+
     if (do_reopen) {
       if (file_->isOpen()) {
         const Api::IoCallBoolResult result = file_->close();
@@ -180,40 +188,52 @@ void AccessLogFileImpl::flushThreadFunc() {
 }
 
 void AccessLogFileImpl::flush() {
-  std::unique_lock<Thread::BasicLockable> flush_buffer_lock;
-
-  {
-    Thread::LockGuard write_lock(write_lock_);
-
-    // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
-    // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
-    // but has not yet completed doWrite(). This would allow flush() to
-    // return before the pending data has actually been written to disk.
-    flush_buffer_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-
-    if (flush_buffer_.length() == 0) {
-      return;
-    }
-
-    about_to_write_buffer_.move(flush_buffer_);
-    ASSERT(flush_buffer_.length() == 0);
+  // flush_lock_ must be held while collecting the write queue or else it is
+  // possible that flushThreadFunc() has already moved data from the queue to
+  // about_to_write_buffer_ but has not yet completed doWrite(). This would
+  // allow flush() to return before the pending data has actually been written
+  // to disk.
+  Thread::LockGuard flush_lock(flush_lock_);
+  collectWriteQueue();
+  if (about_to_write_buffer_.length() == 0) {
+    return;
   }
 
   doWrite(about_to_write_buffer_);
 }
 
-void AccessLogFileImpl::write(absl::string_view data) {
-  Thread::LockGuard lock(write_lock_);
-
-  if (flush_thread_ == nullptr) {
-    createFlushStructures();
+void AccessLogFileImpl::collectWriteQueue() {
+  ASSERT(about_to_write_buffer_.length() == 0);
+  // A writer which exchanged the head but has not linked its entry yet stops the walk. Its entry,
+  // and those pushed after it, are collected by the next flush.
+  WriteEntry* next;
+  while ((next = write_queue_tail_->next_.load(std::memory_order_acquire)) != nullptr) {
+    about_to_write_buffer_.add(next->data_);
+    std::string().swap(next->data_);
+    if (write_queue_tail_ != &write_queue_stub_) {
+      delete write_queue_tail_;
+    }
+    write_queue_tail_ = next;
   }
+  queued_bytes_ -= about_to_write_buffer_.length();
+}
 
+void AccessLogFileImpl::write(absl::string_view data) {
   stats_.write_buffered_.inc();
   stats_.write_total_buffered_.add(data.length());
-  flush_buffer_.add(data.data(), data.size());
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
+  const uint64_t prev_bytes = queued_bytes_.fetch_add(data.size());
+  auto* entry = new WriteEntry(data);
+  WriteEntry* prev = write_queue_head_.exchange(entry, std::memory_order_acq_rel);
+  prev->next_.store(entry, std::memory_order_release);
+
+  // The flush thread is started after the first data is buffered, so that its
+  // first loop finds data to flush.
+  absl::call_once(flush_thread_once_, [this]() { createFlushStructures(); });
+
+  if (prev_bytes <= MIN_FLUSH_SIZE && prev_bytes + data.size() > MIN_FLUSH_SIZE) {
+    // The flush thread checks queued_bytes_ under control_lock_ before it waits,
+    // so taking the lock here ensures the wakeup cannot be lost.
+    Thread::LockGuard control_lock(control_lock_);
     flush_event_.notifyOne();
   }
 }
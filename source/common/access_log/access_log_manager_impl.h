@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include "envoy/access_log/access_log.h"
@@ -13,6 +14,7 @@
 #include "source/common/common/logger.h"
 #include "source/common/common/thread.h"
 
+#include "absl/base/call_once.h"
 #include "absl/container/node_hash_map.h"
 
 namespace Envoy {
@@ -62,6 +64,10 @@ private:
  * This implementation uses a flush thread per file, with the idea there aren't that many
  * files. If this turns out to be a good implementation we can potentially have a single flush
  * thread that flushes all files, but we will start with this.
+ *
+ * Writers push their entries onto a lock-free queue with a single atomic exchange, so worker
+ * threads logging to the same file never take a lock nor wait for disk I/O. The flush thread drains
+ * the queue in push order, so entries are written in the order their write() calls were made.
  */
 class AccessLogFileImpl : public AccessLogFile {
 public:
@@ -83,9 +89,22 @@ public:
   void flush() override;
 
 private:
+  // An entry of the write queue, which is a multi-producer single-consumer linked list. Writers
+  // exchange themselves into write_queue_head_ and then link the previous head to their entry. The
+  // consumer keeps the last entry it consumed as write_queue_tail_, and reads the entries linked
+  // after it.
+  struct WriteEntry {
+    explicit WriteEntry(absl::string_view data) : data_(data) {}
+
+    std::atomic<WriteEntry*> next_{nullptr};
+    std::string data_;
+  };
+
   void doWrite(Buffer::Instance& buffer);
   void flushThreadFunc();
   void createFlushStructures();
+  // Moves the queued entries into about_to_write_buffer_, in order. Requires flush_lock_.
+  void collectWriteQueue();
 
   // Minimum size before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
@@ -93,7 +112,7 @@ private:
   Filesystem::FilePtr file_;
 
   // These locks are always acquired in the following order if multiple locks are held:
-  //    1) write_lock_
+  //    1) control_lock_
   //    2) flush_lock_
   //    3) file_lock_
   Thread::BasicLockable& file_lock_;      // This lock is used only by the flush thread when writing
@@ -106,25 +125,26 @@ private:
                                           // and all other data used during flushing and file
                                           // re-opening.
   Thread::MutexBasicLockable
-      write_lock_; // The lock is used when filling the flush buffer. It allows
-                   // multiple threads to write to the same file at relatively
-                   // high performance. It is always local to the process.
+      control_lock_; // This lock guards the flush thread's wakeup conditions. Writers only take it
+                     // when the buffered data crosses MIN_FLUSH_SIZE.
+  WriteEntry write_queue_stub_{""};
+  std::atomic<WriteEntry*> write_queue_head_{&write_queue_stub_};
+  WriteEntry* write_queue_tail_{&write_queue_stub_}; // Only accessed under flush_lock_.
+  // Bytes held in the write queue, used to decide when to wake the flush thread. Writers count
+  // their bytes before pushing, so that collectWriteQueue() never subtracts uncounted bytes.
+  std::atomic<uint64_t> queued_bytes_{0};
+  absl::once_flag flush_thread_once_;
   Thread::ThreadPtr flush_thread_;
   Thread::CondVar flush_event_;
-  bool flush_thread_exit_ ABSL_GUARDED_BY(write_lock_){false};
-  bool reopen_file_ ABSL_GUARDED_BY(write_lock_){false};
-  Buffer::OwnedImpl
-      flush_buffer_ ABSL_GUARDED_BY(write_lock_); // This buffer is used by multiple threads. It
-                                                  // gets filled and then flushed either when max
-                                                  // size is reached or when a timer fires.
+  bool flush_thread_exit_ ABSL_GUARDED_BY(control_lock_){false};
+  bool reopen_file_ ABSL_GUARDED_BY(control_lock_){false};
   // TODO(jmarantz): this should be ABSL_GUARDED_BY(flush_lock_) but the analysis cannot poke
   // through the std::make_unique assignment. I do not believe it's possible to annotate this
   // properly now due to limitations in the clang thread annotation analysis.
-  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only by the flush thread. Data
-                                            // is moved from flush_buffer_ under lock, and then
-                                            // the lock is released so that flush_buffer_ can
-                                            // continue to fill. This buffer is then used for the
-                                            // final write to disk.
+  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only while flushing. Data is
+                                            // moved from the write queue, which writers continue
+                                            // to fill. This buffer is then used for the final
+                                            // write to disk.
   Event::TimerPtr flush_timer_;
   Thread::ThreadFactory& thread_factory_;
   const std::chrono::milliseconds flush_interval_msec_; // Time interval buffer gets flushed no
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include "source/common/common/assert.h"
+
+#include "absl/types/span.h"
+
+namespace Envoy {
+
+/**
+ * Bucketing of the small latency histograms which only need a cheap percentile estimate rather
+ * than a full Stats::Histogram. Values are bucketed logarithmically with four linear buckets per
+ * power of two, so that a bucket is at most 25% wider than its lower bound. The histograms own
+ * their counts, so that each can pick its own storage and decay.
+ *
+ * Methods are deliberately implemented in the header to hint to the compiler to inline.
+ */
+class LogLinearBuckets {
+public:
+  /**
+   * @return the index of the bucket holding the given value, clamped to the last of num_buckets.
+   */
+  static size_t index(uint64_t value, size_t num_buckets) {
+    if (value < 4) {
+      return std::min<size_t>(value, num_buckets - 1);
+    }
+    // The two bits below the most significant one select the bucket within the power of two.
+    const uint64_t exponent = std::bit_width(value) - 1;
+    const size_t index = (exponent - 1) * 4 + ((value >> (exponent - 2)) & 3);
+    return std::min(index, num_buckets - 1);
+  }
+
+  /**
+   * @return the largest value held by the bucket with the given index.
+   */
+  static uint64_t upperBound(size_t index) {
+    if (index < 4) {
+      return index;
+    }
+    const uint64_t exponent = index / 4 + 1;
+    const uint64_t lower_bound = (4 + index % 4) << (exponent - 2);
+    return lower_bound + (uint64_t(1) << (exponent - 2)) - 1;
+  }
+
+  /**
+   * @param counts the count of every bucket.
+   * @param total the sum of the counts, which must not be zero.
+   * @param quantile the quantile in [0, 1].
+   * @return the index of the bucket holding the given quantile.
+   */
+  static size_t quantileIndex(absl::Span<const uint64_t> counts, uint64_t total,
+                              double quantile) {
+    ASSERT(total > 0);
+    const uint64_t rank =
+        std::max<uint64_t>(std::ceil(quantile * static_cast<double>(total)), 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return i;
+      }
+    }
+    return counts.size() - 1;
+  }
+};
+
+} // namespace Envoy
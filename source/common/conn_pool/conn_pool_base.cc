@@ -1,5 +1,8 @@
 #include "source/common/conn_pool/conn_pool_base.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "source/common/common/assert.h"
 #include "source/common/common/debug_recursion_checker.h"
 #include "source/common/network/transport_socket_options_impl.h"
@@ -10,6 +13,13 @@
 namespace Envoy {
 namespace ConnectionPool {
 namespace {
+// The weight of a new sample in the adaptive preconnect moving averages.
+constexpr double AdaptivePreconnectSampleWeight = 0.1;
+
+void updateMovingAverage(double& average, double sample) {
+  average = average == 0 ? sample : average + AdaptivePreconnectSampleWeight * (sample - average);
+}
+
 int64_t currentUnusedCapacity(const std::list<ActiveClientPtr>& connecting_clients) {
   int64_t ret = 0;
   for (const auto& client : connecting_clients) {
@@ -44,7 +54,8 @@ ConnPoolImplBase::ConnPoolImplBase(
     Upstream::ClusterConnectivityState& state)
     : state_(state), host_(host), priority_(priority), dispatcher_(dispatcher),
       socket_options_(options), transport_socket_options_(transport_socket_options),
-      upstream_ready_cb_(dispatcher_.createSchedulableCallback([this]() { onUpstreamReady(); })) {}
+      upstream_ready_cb_(dispatcher_.createSchedulableCallback([this]() { onUpstreamReady(); })),
+      max_adaptive_preconnect_streams_(host_->cluster().maxAdaptivePreconnectStreams()) {}
 
 ConnPoolImplBase::~ConnPoolImplBase() {
   ASSERT(isIdleImpl());
@@ -125,15 +136,21 @@ bool ConnPoolImplBase::shouldCreateNewConnection(float global_preconnect_ratio)
     // Local preconnect does not need to anticipate a stream. It is called as
     // new streams are established or torn down and simply attempts to maintain
     // the correct ratio of streams and anticipated capacity.
+    //
+    // Adaptive preconnect additionally keeps capacity for the streams expected to arrive while a
+    // new connection is being established.
+    const uint32_t adaptive_streams = adaptivePreconnectStreams();
     bool result =
         shouldConnect(pending_streams_.size(), num_active_streams_,
-                      connecting_and_connected_stream_capacity_, perUpstreamPreconnectRatio());
+                      connecting_and_connected_stream_capacity_, perUpstreamPreconnectRatio()) ||
+        static_cast<int64_t>(pending_streams_.size() + adaptive_streams) >
+            connecting_and_connected_stream_capacity_;
     ENVOY_LOG(trace,
               "per-upstream shouldCreateNewConnection returns {} for pending {} active {} "
-              "connecting_and_connected_capacity {} connecting_capacity {} ratio {}",
+              "connecting_and_connected_capacity {} connecting_capacity {} ratio {} adaptive {}",
               result, pending_streams_.size(), num_active_streams_,
               connecting_and_connected_stream_capacity_, connecting_stream_capacity_,
-              perUpstreamPreconnectRatio());
+              perUpstreamPreconnectRatio(), adaptive_streams);
     return result;
   }
 }
@@ -142,6 +159,15 @@ float ConnPoolImplBase::perUpstreamPreconnectRatio() const {
   return host_->cluster().perUpstreamPreconnectRatio();
 }
 
+uint32_t ConnPoolImplBase::adaptivePreconnectStreams() const {
+  if (max_adaptive_preconnect_streams_ == 0 || mean_stream_interval_us_ == 0) {
+    return 0;
+  }
+  const double expected_streams = std::ceil(mean_connect_time_us_ / mean_stream_interval_us_);
+  return static_cast<uint32_t>(
+      std::min<double>(expected_streams, max_adaptive_preconnect_streams_));
+}
+
 ConnPoolImplBase::ConnectionResult ConnPoolImplBase::tryCreateNewConnections() {
   ConnPoolImplBase::ConnectionResult result;
   // Somewhat arbitrarily cap the number of connections preconnected due to new
@@ -289,6 +315,29 @@ void ConnPoolImplBase::onStreamClosed(Envoy::ConnectionPool::ActiveClient& clien
       }
     }
   }
+
+  if (isExcessIdleClient(client)) {
+    ENVOY_CONN_LOG(debug, "closing idle client, the pool keeps enough idle clients", client);
+    host_->cluster().trafficStats()->upstream_cx_idle_limit_.inc();
+    client.close();
+  }
+}
+
+bool ConnPoolImplBase::isExcessIdleClient(const ActiveClient& client) const {
+  const absl::optional<uint32_t> max_idle_clients = maxIdleClients();
+  // A pending stream would be attached to the client right away.
+  if (!max_idle_clients.has_value() || client.state() != ActiveClient::State::Ready ||
+      client.numActiveStreams() != 0 || !pending_streams_.empty()) {
+    return false;
+  }
+  uint32_t idle_clients = 0;
+  for (const auto& ready_client : ready_clients_) {
+    if (ready_client.get() != &client && ready_client->numActiveStreams() == 0 &&
+        ++idle_clients >= max_idle_clients.value()) {
+      return true;
+    }
+  }
+  return false;
 }
 
 ConnectionPool::Cancellable* ConnPoolImplBase::newStreamImpl(AttachContext& context,
@@ -297,6 +346,22 @@ ConnectionPool::Cancellable* ConnPoolImplBase::newStreamImpl(AttachContext& cont
   ASSERT(!deferred_deleting_);
   assertCapacityCountsAreCorrect();
 
+  if (max_adaptive_preconnect_streams_ > 0) {
+    const MonotonicTime now = dispatcher_.timeSource().monotonicTime();
+    if (last_stream_arrival_.has_value()) {
+      updateMovingAverage(
+          mean_stream_interval_us_,
+          std::chrono::duration_cast<std::chrono::microseconds>(now - *last_stream_arrival_)
+              .count());
+    }
+    last_stream_arrival_ = now;
+    if (ready_clients_.empty() && (!can_send_early_data || early_data_clients_.empty())) {
+      host_->cluster().trafficStats()->upstream_rq_preconnect_miss_.inc();
+    } else {
+      host_->cluster().trafficStats()->upstream_rq_preconnect_hit_.inc();
+    }
+  }
+
   if (!ready_clients_.empty()) {
     ActiveClient& client = *ready_clients_.front();
     ENVOY_CONN_LOG(debug, "using existing fully connected connection", client);
@@ -616,6 +681,12 @@ void ConnPoolImplBase::onConnectionEvent(ActiveClient& client, absl::string_view
     client.has_handshake_completed_ = true;
     client.conn_connect_ms_->complete();
     client.conn_connect_ms_.reset();
+    if (max_adaptive_preconnect_streams_ > 0) {
+      updateMovingAverage(mean_connect_time_us_,
+                          std::chrono::duration_cast<std::chrono::microseconds>(
+                              dispatcher_.timeSource().monotonicTime() - client.connect_start_time_)
+                              .count());
+    }
     if (client.state() == ActiveClient::State::Connecting ||
         client.state() == ActiveClient::State::ReadyForEarlyData) {
       transitionActiveClientState(client,
@@ -812,6 +883,7 @@ ActiveClient::ActiveClient(ConnPoolImplBase& parent, uint32_t lifetime_stream_li
     : parent_(parent), remaining_streams_(translateZeroToUnlimited(lifetime_stream_limit)),
       configured_stream_limit_(translateZeroToUnlimited(effective_concurrent_streams)),
       concurrent_stream_limit_(translateZeroToUnlimited(concurrent_stream_limit)),
+      connect_start_time_(parent_.dispatcher().timeSource().monotonicTime()),
       connect_timer_(parent_.dispatcher().createTimer([this]() { onConnectTimeout(); })) {
   conn_connect_ms_ = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
       parent_.host()->cluster().trafficStats()->upstream_cx_connect_ms_,
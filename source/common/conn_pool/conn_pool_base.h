@@ -144,6 +144,7 @@ public:
   Upstream::HostDescriptionConstSharedPtr real_host_description_;
   Stats::TimespanPtr conn_connect_ms_;
   Stats::TimespanPtr conn_length_;
+  const MonotonicTime connect_start_time_;
   Event::TimerPtr connect_timer_;
   Event::TimerPtr connection_duration_timer_;
   bool resources_released_{false};
@@ -347,6 +348,11 @@ protected:
 
   float perUpstreamPreconnectRatio() const;
 
+  // Returns the number of streams expected to arrive while a new connection to this upstream is
+  // being established, based on the observed stream arrival rate and connect time, capped by the
+  // configured adaptive preconnect limit. Returns 0 if adaptive preconnect is disabled.
+  uint32_t adaptivePreconnectStreams() const;
+
   ConnectionPool::Cancellable*
   addPendingStream(Envoy::ConnectionPool::PendingStreamPtr&& pending_stream) {
     LinkedList::moveIntoList(std::move(pending_stream), pending_streams_);
@@ -369,6 +375,10 @@ protected:
   // This will be false for the TCP pool, true otherwise.
   virtual bool enforceMaxRequests() const { return true; }
 
+  // The maximum number of idle clients the pool keeps open, or no limit if not set. A client that
+  // goes idle while the pool already has this many idle clients is closed.
+  virtual absl::optional<uint32_t> maxIdleClients() const { return absl::nullopt; }
+
   std::list<Instance::IdleCb> idle_callbacks_;
 
   // When calling purgePendingStreams, this list will be used to hold the streams we are about
@@ -400,6 +410,10 @@ private:
 
   void assertCapacityCountsAreCorrect();
 
+  // Returns true if the given client just went idle and the pool already keeps maxIdleClients()
+  // other idle clients.
+  bool isExcessIdleClient(const ActiveClient& client) const;
+
   std::list<PendingStreamPtr> pending_streams_;
 
   // The number of streams that can be immediately dispatched from the current
@@ -418,6 +432,13 @@ private:
 
   Event::SchedulableCallbackPtr upstream_ready_cb_;
   Common::DebugRecursionChecker recursion_checker_;
+
+  // Adaptive preconnect state. The stream arrival interval and connect time are moving averages in
+  // microseconds, zero until the first sample.
+  const uint32_t max_adaptive_preconnect_streams_;
+  absl::optional<MonotonicTime> last_stream_arrival_;
+  double mean_stream_interval_us_{0};
+  double mean_connect_time_us_{0};
 };
 
 } // namespace ConnectionPool
@@ -2,6 +2,25 @@
 
 namespace Envoy {
 namespace Formatter {
+namespace {
+
+// Appends a literal to a compiled format, merging it into the previous element if that is
+// a literal too.
+template <class ParsedFormatElements>
+void appendLiteral(ParsedFormatElements& elements, absl::string_view literal) {
+  if (literal.empty()) {
+    return;
+  }
+  if (!elements.empty()) {
+    if (auto* previous = absl::get_if<std::string>(&elements.back()); previous != nullptr) {
+      absl::StrAppend(previous, literal);
+      return;
+    }
+  }
+  elements.emplace_back(std::string(literal));
+}
+
+} // namespace
 
 const re2::RE2& commandWithArgsRegex() {
   // The following regex is used to check validity of the formatter command and to
@@ -363,12 +382,29 @@ FormatterImpl::create(absl::string_view format, bool omit_empty_values,
   return ret;
 }
 
+void FormatterImpl::compile(std::vector<FormatterProviderPtr>&& providers) {
+  for (FormatterProviderPtr& provider : providers) {
+    if (const auto* plain = dynamic_cast<const PlainStringFormatter*>(provider.get());
+        plain != nullptr) {
+      appendLiteral(parsed_elements_, plain->str());
+    } else {
+      parsed_elements_.emplace_back(std::move(provider));
+    }
+  }
+}
+
 std::string FormatterImpl::formatWithContext(const Context& context,
                                              const StreamInfo::StreamInfo& stream_info) const {
   std::string log_line;
   log_line.reserve(256);
 
-  for (const auto& provider : providers_) {
+  for (const ParsedFormatElement& element : parsed_elements_) {
+    if (const auto* literal = absl::get_if<std::string>(&element); literal != nullptr) {
+      log_line += *literal;
+      continue;
+    }
+
+    const FormatterProviderPtr& provider = absl::get<FormatterProviderPtr>(element);
     const absl::optional<std::string> bit = provider->formatWithContext(context, stream_info);
     // Add the formatted value if there is one. Otherwise add a default value
     // of "-" if omit_empty_values_ is not set.
@@ -382,36 +418,41 @@ std::string FormatterImpl::formatWithContext(const Context& context,
   return log_line;
 }
 
-void stringValueToLogLine(const JsonFormatterImpl::Formatters& formatters, const Context& context,
-                          const StreamInfo::StreamInfo& info, JsonStringSerializer& serializer,
-                          bool omit_empty_values) {
-
-  serializer.addRawString(Json::Constants::DoubleQuote); // Start the JSON string.
-  for (const JsonFormatterImpl::Formatter& formatter : formatters) {
-    const absl::optional<std::string> value = formatter->formatWithContext(context, info);
-    if (!value.has_value()) {
-      // Add the empty value. This needn't be sanitized.
-      serializer.addRawString(omit_empty_values ? EMPTY_STRING : DefaultUnspecifiedValueStringView);
-      continue;
-    }
-    // Sanitize the string value and add it to the buffer. The string value will not be quoted
-    // since we handle the quoting by ourselves at the outer level.
-    serializer.addSanitized({}, value.value(), {});
-  }
-  serializer.addRawString(Json::Constants::DoubleQuote); // End the JSON string.
-}
-
 JsonFormatterImpl::JsonFormatterImpl(const ProtobufWkt::Struct& struct_format,
                                      bool omit_empty_values, const CommandParsers& commands)
     : omit_empty_values_(omit_empty_values) {
+  std::string sanitize_buffer;
   for (JsonFormatBuilder::FormatElement& element : JsonFormatBuilder().fromStruct(struct_format)) {
-    if (element.is_template_) {
-      parsed_elements_.emplace_back(
-          THROW_OR_RETURN_VALUE(SubstitutionFormatParser::parse(element.value_, commands),
-                                std::vector<FormatterProviderPtr>));
-    } else {
-      parsed_elements_.emplace_back(std::move(element.value_));
+    if (!element.is_template_) {
+      // The raw JSON pieces are sanitized when loading the configuration.
+      appendLiteral(parsed_elements_, element.value_);
+      continue;
+    }
+
+    Formatters formatters =
+        THROW_OR_RETURN_VALUE(SubstitutionFormatParser::parse(element.value_, commands),
+                              std::vector<FormatterProviderPtr>);
+    ASSERT(!formatters.empty());
+
+    // A template with a single command keeps the type of the command's value.
+    if (formatters.size() == 1 &&
+        dynamic_cast<const PlainStringFormatter*>(formatters[0].get()) == nullptr) {
+      parsed_elements_.emplace_back(TypedProvider{std::move(formatters[0])});
+      continue;
+    }
+
+    // Otherwise the template is rendered as a JSON string. Its literal text is
+    // sanitized here, once, rather than for every log line.
+    appendLiteral(parsed_elements_, Json::Constants::DoubleQuote);
+    for (Formatter& formatter : formatters) {
+      if (const auto* plain = dynamic_cast<const PlainStringFormatter*>(formatter.get());
+          plain != nullptr) {
+        appendLiteral(parsed_elements_, Json::sanitize(sanitize_buffer, plain->str()));
+      } else {
+        parsed_elements_.emplace_back(StringProvider{std::move(formatter)});
+      }
     }
+    appendLiteral(parsed_elements_, Json::Constants::DoubleQuote);
   }
 }
 
@@ -422,27 +463,33 @@ std::string JsonFormatterImpl::formatWithContext(const Context& context,
   JsonStringSerializer serializer(log_line); // Helper to serialize the value to log line.
 
   for (const ParsedFormatElement& element : parsed_elements_) {
-    // 1. Handle the raw string element.
-    if (absl::holds_alternative<std::string>(element)) {
-      // The raw string element will be added to the buffer directly.
-      // It is sanitized when loading the configuration.
-      serializer.addRawString(absl::get<std::string>(element));
+    // 1. Handle the literal element, which was sanitized when compiling the format.
+    if (const auto* literal = absl::get_if<std::string>(&element); literal != nullptr) {
+      serializer.addRawString(*literal);
       continue;
     }
 
-    ASSERT(absl::holds_alternative<Formatters>(element));
-    const Formatters& formatters = absl::get<Formatters>(element);
-    ASSERT(!formatters.empty());
-
-    if (formatters.size() != 1) {
-      // 2. Handle the formatter element with multiple or zero providers.
-      stringValueToLogLine(formatters, context, info, serializer, omit_empty_values_);
-    } else {
-      // 3. Handle the formatter element with a single provider and value
-      //    type needs to be kept.
-      auto value = formatters[0]->formatValueWithContext(context, info);
-      Json::Utility::appendValueToString(value, log_line);
+    // 2. Handle a provider inside a JSON string.
+    if (const auto* string_provider = absl::get_if<StringProvider>(&element);
+        string_provider != nullptr) {
+      const absl::optional<std::string> value =
+          string_provider->provider_->formatWithContext(context, info);
+      if (!value.has_value()) {
+        // Add the empty value. This needn't be sanitized.
+        serializer.addRawString(omit_empty_values_ ? EMPTY_STRING
+                                                   : DefaultUnspecifiedValueStringView);
+        continue;
+      }
+      // Sanitize the string value and add it to the buffer. The string value will not be quoted
+      // since the quotes are literals of the compiled format.
+      serializer.addSanitized({}, value.value(), {});
+      continue;
     }
+
+    // 3. Handle a provider whose value type needs to be kept.
+    const auto value =
+        absl::get<TypedProvider>(element).provider_->formatValueWithContext(context, info);
+    Json::Utility::appendValueToString(value, log_line);
   }
 
   log_line.push_back('\n');
@@ -15,6 +15,7 @@
 #include "source/common/common/utility.h"
 #include "source/common/formatter/http_formatter_context.h"
 #include "source/common/json/json_loader.h"
+#include "source/common/json/json_sanitizer.h"
 #include "source/common/json/json_streamer.h"
 #include "source/common/json/json_utility.h"
 
@@ -32,6 +33,11 @@ class PlainStringFormatter : public FormatterProvider {
 public:
   PlainStringFormatter(absl::string_view str) { str_.set_string_value(str); }
 
+  /**
+   * @return the literal string this formatter produces.
+   */
+  absl::string_view str() const { return str_.string_value(); }
+
   // FormatterProvider
   absl::optional<std::string> formatWithContext(const Context&,
                                                 const StreamInfo::StreamInfo&) const override {
@@ -100,12 +106,17 @@ protected:
       : omit_empty_values_(omit_empty_values) {
     auto providers_or_error = SubstitutionFormatParser::parse(format, command_parsers);
     SET_AND_RETURN_IF_NOT_OK(providers_or_error.status(), creation_status);
-    providers_ = std::move(*providers_or_error);
+    compile(std::move(*providers_or_error));
   }
 
 private:
+  void compile(std::vector<FormatterProviderPtr>&& providers);
+
   const bool omit_empty_values_;
-  std::vector<FormatterProviderPtr> providers_;
+  // The compiled format: literal text, with adjacent literals merged, which is copied to the
+  // output without a virtual call, and the providers for the substitution commands in between.
+  using ParsedFormatElement = absl::variant<std::string, FormatterProviderPtr>;
+  std::vector<ParsedFormatElement> parsed_elements_;
 };
 
 class JsonFormatterImpl : public Formatter {
@@ -122,8 +133,20 @@ public:
                                 const StreamInfo::StreamInfo& info) const override;
 
 private:
+  // A provider whose output is sanitized and added inside a JSON string, or replaced by the
+  // placeholder for empty values.
+  struct StringProvider {
+    Formatter provider_;
+  };
+  // A provider which is the whole of a JSON value, serialized with its type kept.
+  struct TypedProvider {
+    Formatter provider_;
+  };
+
   const bool omit_empty_values_;
-  using ParsedFormatElement = absl::variant<std::string, Formatters>;
+  // The compiled format. Literal elements are pre-sanitized JSON: the keys, delimiters, quotes
+  // and the literal text of templates, with adjacent literals merged.
+  using ParsedFormatElement = absl::variant<std::string, StringProvider, TypedProvider>;
   std::vector<ParsedFormatElement> parsed_elements_;
 };
 
@@ -14,6 +14,7 @@
 #include "envoy/type/v3/percent.pb.h"
 
 #include "source/common/http/date_provider.h"
+#include "source/common/http/filter_latency_stats.h"
 #include "source/common/local_reply/local_reply.h"
 #include "source/common/network/utility.h"
 #include "source/common/stats/symbol_table.h"
@@ -560,6 +561,12 @@ public:
    *         Connection Lifetime.
    */
   virtual bool addProxyProtocolConnectionState() const PURE;
+
+  /**
+   * @return the histograms to record the time HTTP filters spend in their callbacks into. If
+   *         not set, filter latencies are not recorded.
+   */
+  virtual OptRef<const FilterLatencyStats> filterLatencyStats() const PURE;
 };
 
 using ConnectionManagerConfigSharedPtr = std::shared_ptr<ConnectionManagerConfig>;
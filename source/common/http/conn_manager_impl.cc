@@ -853,6 +853,11 @@ ConnectionManagerImpl::ActiveStream::ActiveStream(ConnectionManagerImpl& connect
   filter_manager_.streamInfo().setShouldSchemeMatchUpstream(
       connection_manager.config_->shouldSchemeMatchUpstream());
 
+  if (const auto filter_latency_stats = connection_manager_.config_->filterLatencyStats();
+      filter_latency_stats.has_value()) {
+    filter_manager_.recordFilterLatencies(*filter_latency_stats);
+  }
+
   // TODO(chaoqin-li1123): can this be moved to the on demand filter?
   auto factory = Envoy::Config::Utility::getFactoryByName<RouteConfigUpdateRequesterFactory>(
       kRouteFactoryName);
@@ -973,6 +978,7 @@ void ConnectionManagerImpl::ActiveStream::completeRequest() {
   if (state_.successful_upgrade_) {
     connection_manager_.stats_.named_.downstream_cx_upgrades_active_.dec();
   }
+  filter_manager_.emitFilterLatencies();
 }
 
 void ConnectionManagerImpl::ActiveStream::resetIdleTimer() {
@@ -1727,8 +1733,11 @@ void ConnectionManagerImpl::ActiveStream::refreshCachedRoute(const Router::Route
       snapScopedRouteConfig();
     }
     if (snapped_route_config_ != nullptr) {
+      const auto latency_timing = filter_manager_.startLatencyTiming();
       route = snapped_route_config_->route(cb, *request_headers_, filter_manager_.streamInfo(),
                                            stream_id_);
+      filter_manager_.recordPhaseLatency(StreamInfo::FilterLatencies::Phase::RouteMatch,
+                                         latency_timing);
     }
   }
 
@@ -1951,13 +1960,20 @@ void ConnectionManagerImpl::ActiveStream::encodeHeaders(ResponseHeaderMap& heade
       // modifications
       // TODO(yanavlasov): add handling for this case.
     } else if (result.new_headers) {
+      const auto latency_timing = filter_manager_.startLatencyTiming();
       response_encoder_->encodeHeaders(*result.new_headers, end_stream);
+      filter_manager_.recordPhaseLatency(StreamInfo::FilterLatencies::Phase::CodecEncode,
+                                         latency_timing);
       return;
     }
   }
 
-  // Now actually encode via the codec.
+  // Now actually encode via the codec. The codec may complete the stream, in which case its
+  // filter latencies are emitted once the encode time is added.
+  const auto latency_timing = filter_manager_.startLatencyTiming();
   response_encoder_->encodeHeaders(headers, end_stream);
+  filter_manager_.recordPhaseLatency(StreamInfo::FilterLatencies::Phase::CodecEncode,
+                                     latency_timing);
 }
 
 void ConnectionManagerImpl::ActiveStream::encodeData(Buffer::Instance& data, bool end_stream) {
@@ -1966,14 +1982,20 @@ void ConnectionManagerImpl::ActiveStream::encodeData(Buffer::Instance& data, boo
                    end_stream);
 
   filter_manager_.streamInfo().addBytesSent(data.length());
+  const auto latency_timing = filter_manager_.startLatencyTiming();
   response_encoder_->encodeData(data, end_stream);
+  filter_manager_.recordPhaseLatency(StreamInfo::FilterLatencies::Phase::CodecEncode,
+                                     latency_timing);
 }
 
 void ConnectionManagerImpl::ActiveStream::encodeTrailers(ResponseTrailerMap& trailers) {
   ENVOY_EXECUTION_SCOPE(trackedStream(), active_span_.get());
   ENVOY_STREAM_LOG(debug, "encoding trailers via codec:\n{}", *this, trailers);
 
+  const auto latency_timing = filter_manager_.startLatencyTiming();
   response_encoder_->encodeTrailers(trailers);
+  filter_manager_.recordPhaseLatency(StreamInfo::FilterLatencies::Phase::CodecEncode,
+                                     latency_timing);
 }
 
 void ConnectionManagerImpl::ActiveStream::encodeMetadata(MetadataMapPtr&& metadata) {
@@ -2289,9 +2311,11 @@ void ConnectionManagerImpl::ActiveStream::recreateStream(
   // FilterState that we inherit, we'll end up copying this every time even though we could get
   // away with just resetting it to the HCM filter_state_.
   if (filter_state->hasDataAtOrAboveLifeSpan(StreamInfo::FilterState::LifeSpan::Request)) {
-    (*connection_manager_.streams_.begin())->filter_manager_.streamInfo().filter_state_ =
-        std::make_shared<StreamInfo::FilterStateImpl>(
-            filter_state->parent(), StreamInfo::FilterState::LifeSpan::FilterChain);
+    FilterManager& new_filter_manager = (*connection_manager_.streams_.begin())->filter_manager_;
+    new_filter_manager.streamInfo().filter_state_ = std::make_shared<StreamInfo::FilterStateImpl>(
+        filter_state->parent(), StreamInfo::FilterState::LifeSpan::FilterChain);
+    // The new stream's filter latencies were added to the filter state just replaced.
+    new_filter_manager.restoreFilterLatencies();
   }
 
   // Make sure that relevant information makes it from the original stream info
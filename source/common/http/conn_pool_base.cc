@@ -41,6 +41,18 @@ wrapTransportSocketOptions(Network::TransportSocketOptionsConstSharedPtr transpo
   }
 }
 
+namespace {
+
+absl::optional<uint32_t> maxIdleConnectionsPerHost(const Upstream::ClusterInfo& cluster) {
+  const auto& options = cluster.commonHttpProtocolOptions();
+  if (!options.has_max_idle_connections_per_host()) {
+    return absl::nullopt;
+  }
+  return options.max_idle_connections_per_host().value();
+}
+
+} // namespace
+
 HttpConnPoolImplBase::HttpConnPoolImplBase(
     Upstream::HostConstSharedPtr host, Upstream::ResourcePriority priority,
     Event::Dispatcher& dispatcher, const Network::ConnectionSocket::OptionsSharedPtr& options,
@@ -50,7 +62,8 @@ HttpConnPoolImplBase::HttpConnPoolImplBase(
     : Envoy::ConnectionPool::ConnPoolImplBase(
           host, priority, dispatcher, options,
           wrapTransportSocketOptions(transport_socket_options, protocols), state),
-      random_generator_(random_generator) {
+      random_generator_(random_generator),
+      max_idle_clients_(maxIdleConnectionsPerHost(host_->cluster())) {
   ASSERT(!protocols.empty());
 }
 
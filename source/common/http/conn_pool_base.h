@@ -96,10 +96,14 @@ protected:
 
   void setOrigin(absl::optional<HttpServerPropertiesCache::Origin> origin) { origin_ = origin; }
 
+  // Envoy::ConnectionPool::ConnPoolImplBase
+  absl::optional<uint32_t> maxIdleClients() const override { return max_idle_clients_; }
+
   Random::RandomGenerator& random_generator_;
 
 private:
   absl::optional<HttpServerPropertiesCache::Origin> origin_;
+  const absl::optional<uint32_t> max_idle_clients_;
 };
 
 // An implementation of Envoy::ConnectionPool::ActiveClient for HTTP/1.1 and HTTP/2
@@ -0,0 +1,76 @@
+#include "source/common/http/filter_latency_stats.h"
+
+#include "source/common/stats/symbol_table.h"
+#include "source/common/stats/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+uint64_t toMicroseconds(std::chrono::nanoseconds time) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+}
+
+} // namespace
+
+FilterLatencyStats::FilterLatencyStats(Stats::Scope& scope, absl::string_view stat_prefix,
+                                       const std::vector<std::string>& filter_names) {
+  Stats::StatNamePool pool(scope.symbolTable());
+  const Stats::StatName prefix = pool.add(absl::StripSuffix(stat_prefix, "."));
+  const Stats::StatName filter_latency = pool.add("filter_latency");
+  const Stats::StatName decode_us = pool.add("decode_us");
+  const Stats::StatName encode_us = pool.add("encode_us");
+  for (const std::string& filter_name : filter_names) {
+    if (!filter_indexes_.try_emplace(filter_name, filter_names_.size()).second) {
+      continue;
+    }
+    filter_names_.push_back(filter_name);
+    const Stats::StatName filter = pool.add(filter_name);
+    filter_histograms_.push_back(
+        FilterHistograms{Stats::Utility::histogramFromElements(
+                             scope, {prefix, filter_latency, filter, decode_us},
+                             Stats::Histogram::Unit::Microseconds),
+                         Stats::Utility::histogramFromElements(
+                             scope, {prefix, filter_latency, filter, encode_us},
+                             Stats::Histogram::Unit::Microseconds)});
+  }
+
+  const Stats::StatName phase_latency = pool.add("phase_latency");
+  for (size_t i = 0; i < phase_histograms_.size(); i++) {
+    const auto phase = static_cast<StreamInfo::FilterLatencies::Phase>(i);
+    phase_histograms_[i] = &Stats::Utility::histogramFromElements(
+        scope,
+        {prefix, phase_latency,
+         pool.add(absl::StrCat(StreamInfo::FilterLatencies::phaseName(phase), "_us"))},
+        Stats::Histogram::Unit::Microseconds);
+  }
+}
+
+uint32_t FilterLatencyStats::filterIndex(absl::string_view filter_name) const {
+  const auto it = filter_indexes_.find(filter_name);
+  return it != filter_indexes_.end() ? it->second : StreamInfo::FilterLatencies::NoFilter;
+}
+
+void FilterLatencyStats::record(const StreamInfo::FilterLatencies& latencies) const {
+  for (size_t i = 0; i < filter_histograms_.size(); i++) {
+    const StreamInfo::FilterLatencies::FilterTimes& times = latencies.filterTimes(i);
+    if (!times.in_chain_) {
+      continue;
+    }
+    filter_histograms_[i].decode_us_.recordValue(toMicroseconds(times.decode_time_));
+    filter_histograms_[i].encode_us_.recordValue(toMicroseconds(times.encode_time_));
+  }
+  for (size_t i = 0; i < phase_histograms_.size(); i++) {
+    const auto time = latencies.phaseTime(static_cast<StreamInfo::FilterLatencies::Phase>(i));
+    if (time.has_value()) {
+      phase_histograms_[i]->recordValue(toMicroseconds(*time));
+    }
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats.h"
+
+#include "source/common/stream_info/filter_latencies.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Histograms of the time the HTTP filters configured on a connection manager spend in their
+ * decode and encode callbacks, named <stat_prefix>filter_latency.<filter name>.{decode,encode}_us,
+ * and of the time streams spend in the phases timed by StreamInfo::FilterLatencies, named
+ * <stat_prefix>phase_latency.<phase>_us.
+ */
+class FilterLatencyStats {
+public:
+  FilterLatencyStats(Stats::Scope& scope, absl::string_view stat_prefix,
+                     const std::vector<std::string>& filter_names);
+
+  /**
+   * @return the index of the named filter's histograms, or StreamInfo::FilterLatencies::NoFilter
+   *         if the filter has none, e.g. because it is only part of an upgrade filter chain.
+   */
+  uint32_t filterIndex(absl::string_view filter_name) const;
+
+  /**
+   * @return the names of the filters with histograms, indexed by filterIndex().
+   */
+  absl::Span<const std::string> filterNames() const { return filter_names_; }
+
+  /**
+   * Records the filter and phase latencies of a completed stream.
+   */
+  void record(const StreamInfo::FilterLatencies& latencies) const;
+
+private:
+  struct FilterHistograms {
+    Stats::Histogram& decode_us_;
+    Stats::Histogram& encode_us_;
+  };
+
+  std::vector<std::string> filter_names_;
+  std::vector<FilterHistograms> filter_histograms_;
+  absl::flat_hash_map<std::string, uint32_t> filter_indexes_;
+  std::array<Stats::Histogram*, StreamInfo::FilterLatencies::NumPhases> phase_histograms_;
+};
+
+using FilterLatencyStatsPtr = std::unique_ptr<FilterLatencyStats>;
+
+} // namespace Http
+} // namespace Envoy
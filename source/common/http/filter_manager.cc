@@ -517,6 +517,44 @@ void ActiveStreamDecoderFilter::requestDataTooLarge() {
   }
 }
 
+void FilterManager::recordFilterLatencies(const FilterLatencyStats& stats) {
+  ASSERT(filters_.empty());
+  filter_latency_stats_ = &stats;
+  filter_latencies_ = std::make_shared<StreamInfo::FilterLatencies>(stats.filterNames());
+  restoreFilterLatencies();
+}
+
+void FilterManager::restoreFilterLatencies() {
+  if (filter_latencies_ == nullptr) {
+    return;
+  }
+  // The latencies are per stream, so they are not carried over to the stream replacing this one on
+  // an internal redirect. They are mutable so that the router can add its phases.
+  streamInfo().filterState()->setData(StreamInfo::FilterLatencies::key(), filter_latencies_,
+                                      StreamInfo::FilterState::StateType::Mutable,
+                                      StreamInfo::FilterState::LifeSpan::FilterChain);
+}
+
+void FilterManager::emitFilterLatencies() {
+  if (filter_latencies_ == nullptr) {
+    return;
+  }
+  if (filter_latencies_->timing()) {
+    state_.emit_filter_latencies_ = true;
+    return;
+  }
+  filter_latency_stats_->record(*filter_latencies_);
+}
+
+void FilterManager::maybeEmitFilterLatencies() {
+  // A stream completed from within a timed callback emits its latencies once the outermost timed
+  // callback returns, so that they include it.
+  if (state_.emit_filter_latencies_ && !filter_latencies_->timing()) {
+    state_.emit_filter_latencies_ = false;
+    filter_latency_stats_->record(*filter_latencies_);
+  }
+}
+
 void FilterManager::applyFilterFactoryCb(FilterContext context, FilterFactoryCb& factory) {
   FilterChainFactoryCallbacksImpl callbacks(*this, context);
   factory(callbacks);
@@ -553,7 +591,9 @@ void FilterManager::decodeHeaders(ActiveStreamDecoderFilter* filter, RequestHead
       state_.filter_call_state_ |= FilterCallState::EndOfStream;
     }
     // 可以看到，会遍历decoder_filters进行解析
+    const auto latency_timing = startLatencyTiming();
     FilterHeadersStatus status = (*entry)->decodeHeaders(headers, (*entry)->end_stream_);
+    recordDecodeLatency(**entry, latency_timing);
     state_.filter_call_state_ &= ~FilterCallState::DecodeHeaders;
     if ((*entry)->end_stream_) {
       state_.filter_call_state_ &= ~FilterCallState::EndOfStream;
@@ -708,7 +748,9 @@ void FilterManager::decodeData(ActiveStreamDecoderFilter* filter, Buffer::Instan
 
     state_.filter_call_state_ |= FilterCallState::DecodeData;
     (*entry)->end_stream_ = end_stream && !filter_manager_callbacks_.requestTrailers();
+    const auto latency_timing = startLatencyTiming();
     FilterDataStatus status = (*entry)->handle_->decodeData(data, (*entry)->end_stream_);
+    recordDecodeLatency(**entry, latency_timing);
     if ((*entry)->end_stream_) {
       (*entry)->handle_->decodeComplete();
     }
@@ -815,7 +857,9 @@ void FilterManager::decodeTrailers(ActiveStreamDecoderFilter* filter, RequestTra
     }
     ASSERT(!(state_.filter_call_state_ & FilterCallState::DecodeTrailers));
     state_.filter_call_state_ |= FilterCallState::DecodeTrailers;
+    const auto latency_timing = startLatencyTiming();
     FilterTrailersStatus status = (*entry)->handle_->decodeTrailers(trailers);
+    recordDecodeLatency(**entry, latency_timing);
     (*entry)->handle_->decodeComplete();
     (*entry)->end_stream_ = true;
     state_.filter_call_state_ &= ~FilterCallState::DecodeTrailers;
@@ -863,7 +907,9 @@ void FilterManager::decodeMetadata(ActiveStreamDecoderFilter* filter, MetadataMa
       return;
     }
     state_.filter_call_state_ |= FilterCallState::DecodeMetadata;
+    const auto latency_timing = startLatencyTiming();
     FilterMetadataStatus status = (*entry)->handle_->decodeMetadata(metadata_map);
+    recordDecodeLatency(**entry, latency_timing);
     state_.filter_call_state_ &= ~FilterCallState::DecodeMetadata;
 
     ENVOY_STREAM_LOG(trace, "decode metadata called: filter={} status={}, metadata: {}", *this,
@@ -1191,7 +1237,9 @@ void FilterManager::encode1xxHeaders(ActiveStreamEncoderFilter* filter,
     ENVOY_EXECUTION_SCOPE(trackedStream(), &(*entry)->filter_context_);
     ASSERT(!(state_.filter_call_state_ & FilterCallState::Encode1xxHeaders));
     state_.filter_call_state_ |= FilterCallState::Encode1xxHeaders;
+    const auto latency_timing = startLatencyTiming();
     const Filter1xxHeadersStatus status = (*entry)->handle_->encode1xxHeaders(headers);
+    recordEncodeLatency(**entry, latency_timing);
     state_.filter_call_state_ &= ~FilterCallState::Encode1xxHeaders;
 
     ENVOY_STREAM_LOG(trace, "encode 1xx continue headers called: filter={} status={}", *this,
@@ -1244,7 +1292,9 @@ void FilterManager::encodeHeaders(ActiveStreamEncoderFilter* filter, ResponseHea
     if ((*entry)->end_stream_) {
       state_.filter_call_state_ |= FilterCallState::EndOfStream;
     }
+    const auto latency_timing = startLatencyTiming();
     FilterHeadersStatus status = (*entry)->handle_->encodeHeaders(headers, (*entry)->end_stream_);
+    recordEncodeLatency(**entry, latency_timing);
     if (state_.encoder_filter_chain_aborted_) {
       ENVOY_STREAM_LOG(trace,
                        "encodeHeaders filter iteration aborted due to local reply: filter={}",
@@ -1334,7 +1384,9 @@ void FilterManager::encodeMetadata(ActiveStreamEncoderFilter* filter,
 
     state_.filter_call_state_ |= FilterCallState::EncodeMetadata;
 
+    const auto latency_timing = startLatencyTiming();
     FilterMetadataStatus status = (*entry)->handle_->encodeMetadata(*metadata_map_ptr);
+    recordEncodeLatency(**entry, latency_timing);
 
     state_.filter_call_state_ &= ~FilterCallState::EncodeMetadata;
 
@@ -1434,7 +1486,9 @@ void FilterManager::encodeData(ActiveStreamEncoderFilter* filter, Buffer::Instan
     recordLatestDataFilter(entry, state_.latest_data_encoding_filter_, encoder_filters_);
 
     (*entry)->end_stream_ = end_stream && !filter_manager_callbacks_.responseTrailers();
+    const auto latency_timing = startLatencyTiming();
     FilterDataStatus status = (*entry)->handle_->encodeData(data, (*entry)->end_stream_);
+    recordEncodeLatency(**entry, latency_timing);
     if (state_.encoder_filter_chain_aborted_) {
       ENVOY_STREAM_LOG(trace, "encodeData filter iteration aborted due to local reply: filter={}",
                        *this, (*entry)->filter_context_.config_name);
@@ -1489,7 +1543,9 @@ void FilterManager::encodeTrailers(ActiveStreamEncoderFilter* filter,
     }
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeTrailers));
     state_.filter_call_state_ |= FilterCallState::EncodeTrailers;
+    const auto latency_timing = startLatencyTiming();
     FilterTrailersStatus status = (*entry)->handle_->encodeTrailers(trailers);
+    recordEncodeLatency(**entry, latency_timing);
     (*entry)->handle_->encodeComplete();
     (*entry)->end_stream_ = true;
     state_.filter_call_state_ &= ~FilterCallState::EncodeTrailers;
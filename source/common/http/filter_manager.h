@@ -18,6 +18,7 @@
 #include "source/common/common/linked_object.h"
 #include "source/common/common/logger.h"
 #include "source/common/grpc/common.h"
+#include "source/common/http/filter_latency_stats.h"
 #include "source/common/http/header_utility.h"
 #include "source/common/http/headers.h"
 #include "source/common/http/matching/data_impl.h"
@@ -26,6 +27,7 @@
 #include "source/common/matcher/matcher.h"
 #include "source/common/protobuf/utility.h"
 #include "source/common/runtime/runtime_features.h"
+#include "source/common/stream_info/filter_latencies.h"
 #include "source/common/stream_info/stream_info_impl.h"
 
 namespace Envoy {
@@ -232,6 +234,8 @@ struct ActiveStreamFilterBase : public virtual StreamFilterCallbacks,
   bool end_stream_{};
   // If true, the filter has processed headers.
   bool processed_headers_{};
+  // The index of the filter in the stream's filter latencies, if they are recorded.
+  uint32_t latency_index_{StreamInfo::FilterLatencies::NoFilter};
 };
 
 /**
@@ -853,6 +857,53 @@ public:
     state_.create_chain_result_ = CreateChainResult(true);
   }
 
+  /**
+   * Records the time each filter of the stream spends in its decode and encode callbacks into a
+   * StreamInfo::FilterLatencies object, which is also added to the stream's filter state. Must be
+   * called before the filter chain is created.
+   * @param stats supplies the histograms the latencies are emitted to. They must outlive the
+   *        stream.
+   */
+  void recordFilterLatencies(const FilterLatencyStats& stats);
+
+  /**
+   * Adds the filter latencies back to the stream's filter state after it was replaced, e.g. by an
+   * internal redirect.
+   */
+  void restoreFilterLatencies();
+
+  /**
+   * Emits the filter latencies of the completed stream to their histograms. If the stream
+   * completed from within a timed callback, they are emitted once it returns.
+   */
+  void emitFilterLatencies();
+
+  /**
+   * @return the filter latencies of the stream, or nullptr if they are not recorded.
+   */
+  const StreamInfo::FilterLatencies* filterLatencies() const { return filter_latencies_.get(); }
+
+  /**
+   * Starts timing a phase of the stream, if the filter latencies are recorded.
+   */
+  absl::optional<StreamInfo::FilterLatencies::Timing> startLatencyTiming() {
+    if (filter_latencies_ == nullptr) {
+      return absl::nullopt;
+    }
+    return filter_latencies_->startTiming(dispatcher_.timeSource().monotonicTime());
+  }
+
+  /**
+   * Adds the time since a timing started by startLatencyTiming() to a phase of the stream.
+   */
+  void recordPhaseLatency(StreamInfo::FilterLatencies::Phase phase,
+                          const absl::optional<StreamInfo::FilterLatencies::Timing>& timing) {
+    if (timing.has_value()) {
+      filter_latencies_->addPhaseTime(phase, finishLatencyTiming(*timing));
+      maybeEmitFilterLatencies();
+    }
+  }
+
   virtual StreamInfo::StreamInfo& streamInfo() PURE;
   virtual const StreamInfo::StreamInfo& streamInfo() const PURE;
 
@@ -961,6 +1012,9 @@ protected:
     bool saw_downstream_reset_{};
     // True when the stream was recreated.
     bool recreated_stream_{};
+    // True when the stream completed from within a timed filter callback and its filter latencies
+    // are yet to be emitted.
+    bool emit_filter_latencies_{};
 
     // The following 3 members are booleans rather than part of the space-saving bitfield as they
     // are passed as arguments to functions expecting bools. Extend State using the bitfield
@@ -991,6 +1045,7 @@ private:
 
       manager_.decoder_filters_.entries_.emplace_back(
           std::make_unique<ActiveStreamDecoderFilter>(manager_, std::move(filter), context_));
+      manager_.decoder_filters_.entries_.back()->latency_index_ = latencyIndex();
     }
 
     void addStreamEncoderFilter(Http::StreamEncoderFilterSharedPtr filter) override {
@@ -998,6 +1053,7 @@ private:
 
       manager_.encoder_filters_.entries_.emplace_back(
           std::make_unique<ActiveStreamEncoderFilter>(manager_, std::move(filter), context_));
+      manager_.encoder_filters_.entries_.back()->latency_index_ = latencyIndex();
     }
 
     void addStreamFilter(Http::StreamFilterSharedPtr filter) override {
@@ -1007,6 +1063,8 @@ private:
           std::make_unique<ActiveStreamDecoderFilter>(manager_, filter, context_));
       manager_.encoder_filters_.entries_.emplace_back(
           std::make_unique<ActiveStreamEncoderFilter>(manager_, std::move(filter), context_));
+      manager_.decoder_filters_.entries_.back()->latency_index_ = latencyIndex();
+      manager_.encoder_filters_.entries_.back()->latency_index_ = latencyIndex();
     }
 
     void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) override {
@@ -1016,8 +1074,21 @@ private:
     Event::Dispatcher& dispatcher() override { return manager_.dispatcher_; }
 
   private:
+    // All filters added by one factory share the latency entry of the factory's filter config.
+    uint32_t latencyIndex() {
+      if (manager_.filter_latencies_ == nullptr) {
+        return StreamInfo::FilterLatencies::NoFilter;
+      }
+      if (!latency_index_.has_value()) {
+        latency_index_ = manager_.filter_latency_stats_->filterIndex(context_.config_name);
+        manager_.filter_latencies_->addFilter(latency_index_.value());
+      }
+      return latency_index_.value();
+    }
+
     FilterManager& manager_;
     const Http::FilterContext& context_;
+    absl::optional<uint32_t> latency_index_;
   };
 
   class FilterChainOptionsImpl : public FilterChainOptions {
@@ -1098,6 +1169,26 @@ private:
 
   bool isTerminalDecoderFilter(const ActiveStreamDecoderFilter& filter) const;
 
+  // Brackets a filter callback to add its duration to the filter latencies, if they are recorded.
+  void recordDecodeLatency(const ActiveStreamFilterBase& filter,
+                           const absl::optional<StreamInfo::FilterLatencies::Timing>& timing) {
+    if (timing.has_value()) {
+      filter_latencies_->addDecodeTime(filter.latency_index_, finishLatencyTiming(*timing));
+      maybeEmitFilterLatencies();
+    }
+  }
+  void recordEncodeLatency(const ActiveStreamFilterBase& filter,
+                           const absl::optional<StreamInfo::FilterLatencies::Timing>& timing) {
+    if (timing.has_value()) {
+      filter_latencies_->addEncodeTime(filter.latency_index_, finishLatencyTiming(*timing));
+      maybeEmitFilterLatencies();
+    }
+  }
+  std::chrono::nanoseconds finishLatencyTiming(const StreamInfo::FilterLatencies::Timing& timing) {
+    return filter_latencies_->finishTiming(timing, dispatcher_.timeSource().monotonicTime());
+  }
+  void maybeEmitFilterLatencies();
+
   FilterManagerCallbacks& filter_manager_callbacks_;
   Event::Dispatcher& dispatcher_;
   // This is unset if there is no downstream connection, e.g. for health check or
@@ -1111,6 +1202,9 @@ private:
   StreamEncoderFilters encoder_filters_;
   std::vector<StreamFilterBase*> filters_;
   AccessLog::InstanceSharedPtrVector access_log_handlers_;
+  // Shared with the stream's filter state, which may be replaced while the stream is active.
+  std::shared_ptr<StreamInfo::FilterLatencies> filter_latencies_;
+  const FilterLatencyStats* filter_latency_stats_{};
 
   // Stores metadata added in the decoding filter that is being processed. Will be cleared before
   // processing the next filter. The storage is created on demand. We need to store metadata
@@ -18,6 +18,11 @@ struct NullHedgePolicy : public Router::HedgePolicy {
     return additional_request_chance_;
   }
   bool hedgeOnPerTryTimeout() const override { return false; }
+  bool hedgeOnLatency() const override { return false; }
+  absl::optional<std::chrono::milliseconds> latencyHedgeDelay() const override {
+    return absl::nullopt;
+  }
+  void recordUpstreamLatency(std::chrono::milliseconds) const override {}
 
   const envoy::type::v3::FractionalPercent additional_request_chance_;
 };
@@ -0,0 +1,303 @@
+#include <string>
+
+#include "source/common/common/hash.h"
+#include "source/common/common/logger.h"
+#include "source/common/common/macros.h"
+#include "source/common/common/thread.h"
+#include "source/common/profiler/profiler.h"
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <signal.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "absl/debugging/stacktrace.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+
+// Older glibc versions do not expose the thread id member of sigevent under its documented name.
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace Envoy {
+namespace Profiler {
+namespace {
+
+// 100Hz of CPU time per thread costs a few microseconds per 10ms of busy CPU, well below 1%.
+constexpr uint32_t SamplingFrequencyHz = 100;
+constexpr int MaxStackDepth = 64;
+// Samples are counted per distinct stack of each thread, so the profile covers all the CPU time
+// since the profiler started, however long it runs, until this many distinct stacks were seen.
+// Samples of further stacks are dropped. The table takes about 2MB.
+constexpr uint32_t MaxStacks = 4096;
+// The number of slots probed for a stack before its sample is dropped.
+constexpr uint32_t MaxProbes = 32;
+
+// A slot of the stack table, written from the signal handler and read from the main thread. A
+// handler claims an empty slot by setting its hash, writes the stack and then publishes it with a
+// non-zero count. Later samples of the same stack only increment the count, so the reader never
+// sees a published stack change and the handler never blocks.
+struct StackSlot {
+  std::atomic<uint64_t> hash_{0};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<int32_t> thread_id_{0};
+  std::atomic<int32_t> depth_{0};
+  std::atomic<uintptr_t> stack_[MaxStackDepth]{};
+};
+
+// An open addressing table of sample counts keyed by the hash of the thread id and the stack.
+struct StackTable {
+  StackSlot slots_[MaxStacks];
+  std::atomic<uint64_t> dropped_{0};
+};
+
+std::atomic<bool> started{false};
+// Allocated on the first start and never freed: a signal may still be in flight on another thread
+// while the profiler is being stopped.
+std::atomic<StackTable*> table{nullptr};
+
+std::vector<timer_t>& timers() { MUTABLE_CONSTRUCT_ON_FIRST_USE(std::vector<timer_t>); }
+
+bool isSameStack(const StackSlot& slot, int32_t thread_id, void* const* stack, int depth) {
+  if (slot.thread_id_.load(std::memory_order_relaxed) != thread_id ||
+      slot.depth_.load(std::memory_order_relaxed) != depth) {
+    return false;
+  }
+  for (int i = 0; i < depth; i++) {
+    if (slot.stack_[i].load(std::memory_order_relaxed) != reinterpret_cast<uintptr_t>(stack[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void recordSample(StackTable& stacks, int32_t thread_id, void* const* stack, int depth) {
+  // A zero hash marks an empty slot.
+  const uint64_t hash = std::max<uint64_t>(
+      HashUtil::xxHash64(
+          absl::string_view(reinterpret_cast<const char*>(stack), depth * sizeof(void*)),
+          thread_id),
+      1);
+  for (uint32_t probe = 0; probe < MaxProbes; probe++) {
+    StackSlot& slot = stacks.slots_[(hash + probe) % MaxStacks];
+    uint64_t slot_hash = slot.hash_.load(std::memory_order_acquire);
+    if (slot_hash == 0) {
+      if (slot.hash_.compare_exchange_strong(slot_hash, hash, std::memory_order_acq_rel)) {
+        slot.thread_id_.store(thread_id, std::memory_order_relaxed);
+        slot.depth_.store(depth, std::memory_order_relaxed);
+        for (int i = 0; i < depth; i++) {
+          slot.stack_[i].store(reinterpret_cast<uintptr_t>(stack[i]), std::memory_order_relaxed);
+        }
+        slot.count_.store(1, std::memory_order_release);
+        return;
+      }
+      // Another thread claimed the slot first, and slot_hash now holds the hash it set.
+    }
+    if (slot_hash != hash) {
+      continue;
+    }
+    // The count is zero while another thread writes the stack of the slot, which cannot be waited
+    // for in a signal handler.
+    if (slot.count_.load(std::memory_order_acquire) == 0) {
+      break;
+    }
+    if (isSameStack(slot, thread_id, stack, depth)) {
+      slot.count_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  stacks.dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void onProfilingSignal(int, siginfo_t* info, void* ucontext) {
+  if (info->si_code != SI_TIMER || !started.load(std::memory_order_acquire)) {
+    return;
+  }
+  const int saved_errno = errno;
+  void* stack[MaxStackDepth];
+  const int depth = absl::GetStackTraceWithContext(stack, MaxStackDepth, 1, ucontext, nullptr);
+  if (depth > 0) {
+    recordSample(*table.load(std::memory_order_acquire), info->si_value.sival_int, stack, depth);
+  }
+  errno = saved_errno;
+}
+
+bool armThreadTimer(pid_t thread_id) {
+  sigevent event{};
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGPROF;
+  event.sigev_value.sival_int = thread_id;
+  event.sigev_notify_thread_id = thread_id;
+  // The CPU time clock of another thread of this process, MAKE_THREAD_CPUCLOCK(tid, CPUCLOCK_SCHED)
+  // in the kernel. pthread_getcpuclockid() would need a pthread_t we do not have for foreign
+  // threads.
+  const clockid_t clock = static_cast<clockid_t>((~static_cast<uint32_t>(thread_id) << 3) | 6);
+  timer_t timer;
+  if (timer_create(clock, &event, &timer) != 0) {
+    return false;
+  }
+  itimerspec spec{};
+  spec.it_interval.tv_nsec = 1000000000 / SamplingFrequencyHz;
+  spec.it_value = spec.it_interval;
+  if (timer_settime(timer, 0, &spec, nullptr) != 0) {
+    timer_delete(timer);
+    return false;
+  }
+  timers().push_back(timer);
+  return true;
+}
+
+void appendWord(std::string& output, uintptr_t word) {
+  output.append(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+} // namespace
+
+bool ContinuousCpu::profilerEnabled() { return true; }
+
+bool ContinuousCpu::isProfilerStarted() { return started.load(std::memory_order_relaxed); }
+
+absl::Status ContinuousCpu::startProfiler() {
+  ASSERT_IS_MAIN_OR_TEST_THREAD();
+  if (isProfilerStarted()) {
+    return {absl::StatusCode::kFailedPrecondition, "Continuous CPU profiler has already started"};
+  }
+  // Both profilers are driven by SIGPROF.
+  if (Cpu::profilerEnabled()) {
+    return {absl::StatusCode::kFailedPrecondition, "The CPU profiler is running"};
+  }
+
+  StackTable* stacks = table.load(std::memory_order_relaxed);
+  if (stacks == nullptr) {
+    table.store(new StackTable(), std::memory_order_release);
+  } else {
+    // Start a fresh profile rather than mixing in samples from a previous run.
+    for (StackSlot& slot : stacks->slots_) {
+      slot.count_.store(0, std::memory_order_relaxed);
+      slot.hash_.store(0, std::memory_order_relaxed);
+    }
+    stacks->dropped_.store(0, std::memory_order_relaxed);
+  }
+
+  // The handler is installed on every start since the gperftools CPU profiler, which may have run
+  // since the last start, restores the default disposition of SIGPROF when it stops. It is never
+  // uninstalled: with the default disposition a signal still pending after stopProfiler() would
+  // terminate the process.
+  struct sigaction action {};
+  action.sa_sigaction = onProfilingSignal;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, nullptr) != 0) {
+    return {absl::StatusCode::kInternal, "Failed to install the SIGPROF handler"};
+  }
+  started.store(true, std::memory_order_release);
+
+  DIR* tasks = opendir("/proc/self/task");
+  if (tasks != nullptr) {
+    while (const dirent* entry = readdir(tasks)) {
+      int32_t thread_id;
+      if (absl::SimpleAtoi(entry->d_name, &thread_id)) {
+        // A thread may exit while we iterate, which just fails to create its timer.
+        armThreadTimer(thread_id);
+      }
+    }
+    closedir(tasks);
+  }
+  if (timers().empty()) {
+    stopProfiler();
+    return {absl::StatusCode::kInternal, "Failed to create the per thread CPU timers"};
+  }
+  return absl::OkStatus();
+}
+
+void ContinuousCpu::stopProfiler() {
+  ASSERT_IS_MAIN_OR_TEST_THREAD();
+  started.store(false, std::memory_order_release);
+  for (timer_t timer : timers()) {
+    timer_delete(timer);
+  }
+  timers().clear();
+}
+
+absl::StatusOr<std::string> ContinuousCpu::profile(absl::optional<uint32_t> thread_id) {
+  ASSERT_IS_MAIN_OR_TEST_THREAD();
+  const StackTable* stacks = table.load(std::memory_order_acquire);
+  if (stacks == nullptr) {
+    return absl::Status(absl::StatusCode::kFailedPrecondition,
+                        "Continuous CPU profiler is not started");
+  }
+  if (const uint64_t dropped = stacks->dropped_.load(std::memory_order_relaxed); dropped > 0) {
+    ENVOY_LOG_MISC(warn, "continuous CPU profiler dropped {} samples of stacks beyond its {} slots",
+                   dropped, MaxStacks);
+  }
+
+  // See https://github.com/google/pprof/blob/main/proto/README.md for the legacy format: a header,
+  // one record per distinct stack, a trailer and then the text of /proc/self/maps. Stacks sampled
+  // on several threads get one record per thread, which pprof merges.
+  std::string output;
+  for (const uintptr_t word : {0UL, 3UL, 0UL, 1000000UL / SamplingFrequencyHz, 0UL}) {
+    appendWord(output, word);
+  }
+  for (const StackSlot& slot : stacks->slots_) {
+    const uint64_t count = slot.count_.load(std::memory_order_acquire);
+    if (count == 0 ||
+        (thread_id.has_value() &&
+         static_cast<uint32_t>(slot.thread_id_.load(std::memory_order_relaxed)) !=
+             thread_id.value())) {
+      continue;
+    }
+    const int depth = std::min(slot.depth_.load(std::memory_order_relaxed), MaxStackDepth);
+    appendWord(output, count);
+    appendWord(output, depth);
+    for (int i = 0; i < depth; i++) {
+      appendWord(output, slot.stack_[i].load(std::memory_order_relaxed));
+    }
+  }
+  for (const uintptr_t word : {0UL, 1UL, 0UL}) {
+    appendWord(output, word);
+  }
+  std::ifstream maps("/proc/self/maps");
+  if (!maps.fail()) {
+    std::stringstream contents;
+    contents << maps.rdbuf();
+    output.append(contents.str());
+  }
+  return output;
+}
+
+} // namespace Profiler
+} // namespace Envoy
+
+#else
+
+namespace Envoy {
+namespace Profiler {
+
+bool ContinuousCpu::profilerEnabled() { return false; }
+bool ContinuousCpu::isProfilerStarted() { return false; }
+
+absl::Status ContinuousCpu::startProfiler() {
+  return {absl::StatusCode::kUnimplemented,
+          "Continuous CPU profiler is not implemented on this platform"};
+}
+
+void ContinuousCpu::stopProfiler() {}
+
+absl::StatusOr<std::string> ContinuousCpu::profile(absl::optional<uint32_t>) {
+  return absl::Status(absl::StatusCode::kUnimplemented,
+                      "Continuous CPU profiler is not implemented on this platform");
+}
+
+} // namespace Profiler
+} // namespace Envoy
+
+#endif // #ifdef __linux__
@@ -3,6 +3,7 @@
 #include <string>
 
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 
 // Profiling support is provided in the release tcmalloc of `gperftools`, but not in the library
 // that supplies the debug tcmalloc. So all the profiling code must be ifdef'd
@@ -36,6 +37,45 @@ public:
   static void stopProfiler();
 };
 
+/**
+ * Built-in continuous CPU profiling. Every thread alive when the profiler starts gets its own CPU
+ * time timer which delivers SIGPROF at a fixed frequency. The signal handler counts the samples of
+ * each distinct stack of the thread in a bounded in-memory table, so the profiler can be left
+ * running in production and the profile fetched at any time. Only supported on Linux.
+ */
+class ContinuousCpu {
+public:
+  /**
+   * @return whether continuous CPU profiling is supported in this build or not.
+   */
+  static bool profilerEnabled();
+
+  /**
+   * @return whether the continuous profiler is started or not.
+   */
+  static bool isProfilerStarted();
+
+  /**
+   * Start sampling all threads of the process.
+   * @return absl::Status whether the call to start the profiler succeeded.
+   */
+  static absl::Status startProfiler();
+
+  /**
+   * Stop sampling. The samples collected so far remain available through profile().
+   */
+  static void stopProfiler();
+
+  /**
+   * Serialize the sample counts of the stacks in the legacy CPU profile format understood by the
+   * ``pprof`` tool. Stacks are symbolized by ``pprof`` using the embedded process mappings.
+   * @param thread_id if set, only samples taken on the thread with this kernel thread id are
+   *        included.
+   * @return the serialized profile, or an error if the profiler was never started.
+   */
+  static absl::StatusOr<std::string> profile(absl::optional<uint32_t> thread_id);
+};
+
 /**
  * Process wide heap profiling
  */
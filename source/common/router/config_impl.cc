@@ -26,6 +26,7 @@
 #include "source/common/common/empty_string.h"
 #include "source/common/common/fmt.h"
 #include "source/common/common/hash.h"
+#include "source/common/common/log_linear_buckets.h"
 #include "source/common/common/logger.h"
 #include "source/common/common/regex.h"
 #include "source/common/common/utility.h"
@@ -253,13 +254,79 @@ std::string SslRedirector::newUri(const Http::RequestHeaderMap& headers) const {
   return Http::Utility::createSslRedirectPath(headers);
 }
 
+void UpstreamLatencyHistogram::record(std::chrono::milliseconds latency) {
+  buckets_[LogLinearBuckets::index(std::max<int64_t>(latency.count(), 0), NumBuckets)].fetch_add(
+      1, std::memory_order_relaxed);
+
+  // Only the worker that wins the reset of the interval decays, so latencies recorded by other
+  // workers in the meantime still count towards the next interval. Halving subtracts rather than
+  // stores, so that concurrent increments of a bucket are not lost.
+  uint64_t recorded = recorded_since_decay_.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (recorded >= DecayInterval &&
+      recorded_since_decay_.compare_exchange_strong(recorded, 0, std::memory_order_relaxed)) {
+    for (auto& bucket : buckets_) {
+      bucket.fetch_sub(bucket.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+    }
+  }
+}
+
+absl::optional<std::chrono::milliseconds>
+UpstreamLatencyHistogram::percentile(double percentile, uint64_t min_samples) const {
+  std::array<uint64_t, NumBuckets> counts;
+  uint64_t total = 0;
+  for (size_t i = 0; i < NumBuckets; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0 || total < min_samples) {
+    return absl::nullopt;
+  }
+
+  const size_t index = LogLinearBuckets::quantileIndex(counts, total, percentile / 100);
+  return std::chrono::milliseconds(LogLinearBuckets::upperBound(index));
+}
+
 HedgePolicyImpl::HedgePolicyImpl(const envoy::config::route::v3::HedgePolicy& hedge_policy)
     : additional_request_chance_(hedge_policy.additional_request_chance()),
+      latency_histogram_(hedge_policy.has_hedge_on_latency()
+                             ? std::make_unique<UpstreamLatencyHistogram>()
+                             : nullptr),
+      latency_hedge_percentile_(
+          hedge_policy.hedge_on_latency().has_percentile()
+              ? hedge_policy.hedge_on_latency().percentile().value()
+              : 95.0),
+      min_latency_hedge_delay_(
+          PROTOBUF_GET_MS_OR_DEFAULT(hedge_policy.hedge_on_latency(), min_delay, 1)),
+      max_latency_hedge_delay_(
+          PROTOBUF_GET_OPTIONAL_MS(hedge_policy.hedge_on_latency(), max_delay)),
+      latency_hedge_min_samples_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(hedge_policy.hedge_on_latency(), min_samples, 100)),
       initial_requests_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(hedge_policy, initial_requests, 1)),
       hedge_on_per_try_timeout_(hedge_policy.hedge_on_per_try_timeout()) {}
 
 HedgePolicyImpl::HedgePolicyImpl() : initial_requests_(1), hedge_on_per_try_timeout_(false) {}
 
+absl::optional<std::chrono::milliseconds> HedgePolicyImpl::latencyHedgeDelay() const {
+  if (latency_histogram_ == nullptr) {
+    return absl::nullopt;
+  }
+  absl::optional<std::chrono::milliseconds> delay =
+      latency_histogram_->percentile(latency_hedge_percentile_, latency_hedge_min_samples_);
+  if (!delay.has_value()) {
+    return absl::nullopt;
+  }
+  if (max_latency_hedge_delay_.has_value()) {
+    delay = std::min(*delay, *max_latency_hedge_delay_);
+  }
+  return std::max(*delay, min_latency_hedge_delay_);
+}
+
+void HedgePolicyImpl::recordUpstreamLatency(std::chrono::milliseconds latency) const {
+  if (latency_histogram_ != nullptr) {
+    latency_histogram_->record(latency);
+  }
+}
+
 absl::StatusOr<std::unique_ptr<RetryPolicyImpl>>
 RetryPolicyImpl::create(const envoy::config::route::v3::RetryPolicy& retry_policy,
                         ProtobufMessage::ValidationVisitor& validation_visitor,
@@ -635,6 +702,15 @@ RouteEntryImplBase::RouteEntryImplBase(const CommonVirtualHostSharedPtr& vhost,
   SET_AND_RETURN_IF_NOT_OK(policy_or_error.status(), creation_status);
   retry_policy_ = std::move(policy_or_error.value());
 
+  // An expiring per try timeout must not abort an attempt that a latency hedge raced against.
+  if (hedge_policy_ != nullptr && hedge_policy_->hedgeOnLatency() &&
+      !hedge_policy_->hedgeOnPerTryTimeout()) {
+    creation_status = absl::InvalidArgumentError(fmt::format(
+        "hedge_on_latency requires hedge_on_per_try_timeout in the hedge policy of route {}",
+        route_name_));
+    return;
+  }
+
   if (route.has_direct_response() && route.direct_response().has_body()) {
     auto provider_or_error = Envoy::Config::DataSource::DataSourceProvider::create(
         route.direct_response().body(), factory_context.mainThreadDispatcher(),
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <iterator>
@@ -522,6 +524,32 @@ private:
   const bool disable_shadow_host_suffix_append_;
 };
 
+/**
+ * Lock free histogram of the upstream response header latencies of a route, shared by all workers.
+ * The counts are halved periodically so that the percentiles follow the recent latencies.
+ */
+class UpstreamLatencyHistogram {
+public:
+  // Counts are halved every time this many latencies were recorded.
+  static constexpr uint64_t DecayInterval = 1024;
+
+  void record(std::chrono::milliseconds latency);
+
+  /**
+   * @return the upper bound of the bucket holding the given percentile, or absl::nullopt if fewer
+   *         than min_samples latencies are accounted for.
+   */
+  absl::optional<std::chrono::milliseconds> percentile(double percentile,
+                                                       uint64_t min_samples) const;
+
+private:
+  // LogLinearBuckets of milliseconds, which bound the error to 25%, up to about two minutes.
+  static constexpr size_t NumBuckets = 64;
+
+  std::array<std::atomic<uint64_t>, NumBuckets> buckets_{};
+  std::atomic<uint64_t> recorded_since_decay_{0};
+};
+
 /**
  * Implementation of HedgePolicy that reads from the proto route or virtual host config.
  */
@@ -537,9 +565,18 @@ public:
     return additional_request_chance_;
   }
   bool hedgeOnPerTryTimeout() const override { return hedge_on_per_try_timeout_; }
+  bool hedgeOnLatency() const override { return latency_histogram_ != nullptr; }
+  absl::optional<std::chrono::milliseconds> latencyHedgeDelay() const override;
+  void recordUpstreamLatency(std::chrono::milliseconds latency) const override;
 
 private:
   const envoy::type::v3::FractionalPercent additional_request_chance_;
+  // Only set if latency hedging is enabled.
+  const std::unique_ptr<UpstreamLatencyHistogram> latency_histogram_;
+  const double latency_hedge_percentile_{};
+  const std::chrono::milliseconds min_latency_hedge_delay_{};
+  const absl::optional<std::chrono::milliseconds> max_latency_hedge_delay_;
+  const uint32_t latency_hedge_min_samples_{};
   // Keep small members (bools and enums) at the end of class, to reduce alignment overhead.
   const uint32_t initial_requests_;
   const bool hedge_on_per_try_timeout_;
@@ -15,6 +15,8 @@
 #include "source/common/http/utility.h"
 #include "source/common/runtime/runtime_features.h"
 
+#include "absl/types/span.h"
+
 namespace Envoy {
 namespace Router {
 
@@ -66,15 +68,12 @@ RetryStateImpl::RetryStateImpl(const RetryPolicy& route_policy,
                                Server::Configuration::CommonFactoryContext& context,
                                Event::Dispatcher& dispatcher, Upstream::ResourcePriority priority,
                                bool auto_configured_for_http3)
-    : cluster_(cluster), vcluster_(vcluster), route_stats_context_(route_stats_context),
-      runtime_(context.runtime()), random_(context.api().randomGenerator()),
-      dispatcher_(dispatcher), time_source_(context.timeSource()),
+    : route_policy_(route_policy), cluster_(cluster), vcluster_(vcluster),
+      route_stats_context_(route_stats_context), runtime_(context.runtime()),
+      random_(context.api().randomGenerator()), dispatcher_(dispatcher),
+      time_source_(context.timeSource()),
       retry_host_predicates_(route_policy.retryHostPredicates()),
-      retry_priority_(route_policy.retryPriority()),
-      retriable_status_codes_(route_policy.retriableStatusCodes()),
-      retriable_headers_(route_policy.retriableHeaders()),
-      reset_headers_(route_policy.resetHeaders()),
-      reset_max_interval_(route_policy.resetMaxInterval()), retry_on_(route_policy.retryOn()),
+      retry_priority_(route_policy.retryPriority()), retry_on_(route_policy.retryOn()),
       retries_remaining_(route_policy.numRetries()), priority_(priority),
       auto_configured_for_http3_(auto_configured_for_http3) {
   if ((cluster.features() & Upstream::ClusterInfo::Features::HTTP3) &&
@@ -85,24 +84,20 @@ RetryStateImpl::RetryStateImpl(const RetryPolicy& route_policy,
     // traditionally shouldn't have body, automatically retrying them will not cause extra
     // buffering. This will also enable retry if they are reset during connect.
     retry_on_ |= RetryPolicy::RETRY_ON_RETRIABLE_STATUS_CODES;
-    retriable_status_codes_.push_back(static_cast<uint32_t>(Http::Code::TooEarly));
-  }
-  std::chrono::milliseconds base_interval(
-      runtime_.snapshot().getInteger("upstream.base_retry_backoff_ms", 25));
-  if (route_policy.baseInterval()) {
-    base_interval = *route_policy.baseInterval();
+    request_retriable_status_codes_.push_back(static_cast<uint32_t>(Http::Code::TooEarly));
   }
+  host_selection_max_attempts_ = route_policy.hostSelectionMaxAttempts();
 
+  // The backoff strategy is only built for the first retry, as most requests never back off, but
+  // with the runtime values of when the request started.
+  base_backoff_interval_ = route_policy.baseInterval().has_value()
+                               ? *route_policy.baseInterval()
+                               : std::chrono::milliseconds(runtime_.snapshot().getInteger(
+                                     "upstream.base_retry_backoff_ms", 25));
   // By default, cap the max interval to 10 times the base interval to ensure reasonable back-off
   // intervals.
-  std::chrono::milliseconds max_interval = base_interval * 10;
-  if (route_policy.maxInterval()) {
-    max_interval = *route_policy.maxInterval();
-  }
-
-  backoff_strategy_ = std::make_unique<JitteredExponentialBackOffStrategy>(
-      base_interval.count(), max_interval.count(), random_);
-  host_selection_max_attempts_ = route_policy.hostSelectionMaxAttempts();
+  max_backoff_interval_ = route_policy.maxInterval().has_value() ? *route_policy.maxInterval()
+                                                                 : base_backoff_interval_ * 10;
 
   // Merge in the headers.
   if (request_headers.EnvoyRetryOn()) {
@@ -140,7 +135,7 @@ RetryStateImpl::RetryStateImpl(const RetryPolicy& route_policy,
          StringUtil::splitToken(request_headers.getEnvoyRetriableStatusCodesValue(), ",")) {
       unsigned int out;
       if (absl::SimpleAtoi(code, &out)) {
-        retriable_status_codes_.emplace_back(out);
+        request_retriable_status_codes_.emplace_back(out);
       }
     }
   }
@@ -155,7 +150,7 @@ RetryStateImpl::RetryStateImpl(const RetryPolicy& route_policy,
              request_headers.EnvoyRetriableHeaderNames()->value().getStringView(), ",")) {
       envoy::config::route::v3::HeaderMatcher header_matcher;
       header_matcher.set_name(std::string(absl::StripAsciiWhitespace(header_name)));
-      retriable_headers_.emplace_back(
+      request_retriable_headers_.emplace_back(
           Http::HeaderUtility::createHeaderData(header_matcher, context));
     }
   }
@@ -181,6 +176,10 @@ void RetryStateImpl::enableBackoffTimer() {
 
   } else {
     // Otherwise we use a fully jittered exponential backoff algorithm.
+    if (backoff_strategy_ == nullptr) {
+      backoff_strategy_ = std::make_unique<JitteredExponentialBackOffStrategy>(
+          base_backoff_interval_.count(), max_backoff_interval_.count(), random_);
+    }
     retry_timer_->enableTimer(std::chrono::milliseconds(backoff_strategy_->nextBackOffMs()));
 
     cluster_.trafficStats()->upstream_rq_retry_backoff_exponential_.inc();
@@ -245,9 +244,9 @@ std::pair<uint32_t, bool> RetryStateImpl::parseRetryGrpcOn(absl::string_view ret
 
 absl::optional<std::chrono::milliseconds>
 RetryStateImpl::parseResetInterval(const Http::ResponseHeaderMap& response_headers) const {
-  for (const auto& reset_header : reset_headers_) {
+  for (const auto& reset_header : route_policy_.resetHeaders()) {
     const auto& interval = reset_header->parseInterval(time_source_, response_headers);
-    if (interval.has_value() && interval.value() <= reset_max_interval_) {
+    if (interval.has_value() && interval.value() <= route_policy_.resetMaxInterval()) {
       return interval;
     }
   }
@@ -345,7 +344,7 @@ RetryStatus RetryStateImpl::shouldRetryHeaders(const Http::ResponseHeaderMap& re
 
   // Yes, we will retry based on the headers - try to parse a rate limited reset interval from the
   // response.
-  if (retry_decision == RetryDecision::RetryWithBackoff && !reset_headers_.empty()) {
+  if (retry_decision == RetryDecision::RetryWithBackoff && !route_policy_.resetHeaders().empty()) {
     const auto backoff_interval = parseResetInterval(response_headers);
     if (backoff_interval.has_value() && (backoff_interval.value().count() > 1L)) {
       ratelimited_backoff_strategy_ = std::make_unique<JitteredLowerBoundBackOffStrategy>(
@@ -379,6 +378,11 @@ RetryStatus RetryStateImpl::shouldHedgeRetryPerTryTimeout(DoRetryCallback callba
   return shouldRetry(RetryState::RetryDecision::RetryWithBackoff, callback);
 }
 
+RetryStatus RetryStateImpl::shouldHedgeOnLatency(DoRetryCallback callback) {
+  // The request already waited for the hedge delay, so there is no point in backing off further.
+  return shouldRetry(RetryState::RetryDecision::RetryImmediately, callback);
+}
+
 RetryState::RetryDecision
 RetryStateImpl::wouldRetryFromHeaders(const Http::ResponseHeaderMap& response_headers,
                                       const Http::RequestHeaderMap& original_request,
@@ -412,26 +416,32 @@ RetryStateImpl::wouldRetryFromHeaders(const Http::ResponseHeaderMap& response_he
   }
 
   if ((retry_on_ & RetryPolicy::RETRY_ON_RETRIABLE_STATUS_CODES)) {
-    for (auto code : retriable_status_codes_) {
-      if (response_status == code) {
-        if (static_cast<Http::Code>(code) != Http::Code::TooEarly) {
-          return RetryDecision::RetryWithBackoff;
-        }
-        if (original_request.get(Http::Headers::get().EarlyData).empty()) {
-          // Retry if the downstream request wasn't received as early data. Otherwise, regardless if
-          // the request was sent as early data in upstream or not, don't retry. Instead, forward
-          // the response to downstream.
-          disable_early_data = true;
-          return RetryDecision::RetryImmediately;
+    for (const auto codes : {absl::MakeConstSpan(route_policy_.retriableStatusCodes()),
+                             absl::MakeConstSpan(request_retriable_status_codes_)}) {
+      for (auto code : codes) {
+        if (response_status == code) {
+          if (static_cast<Http::Code>(code) != Http::Code::TooEarly) {
+            return RetryDecision::RetryWithBackoff;
+          }
+          if (original_request.get(Http::Headers::get().EarlyData).empty()) {
+            // Retry if the downstream request wasn't received as early data. Otherwise, regardless
+            // if the request was sent as early data in upstream or not, don't retry. Instead,
+            // forward the response to downstream.
+            disable_early_data = true;
+            return RetryDecision::RetryImmediately;
+          }
         }
       }
     }
   }
 
   if (retry_on_ & RetryPolicy::RETRY_ON_RETRIABLE_HEADERS) {
-    for (const auto& retriable_header : retriable_headers_) {
-      if (retriable_header->matchesHeaders(response_headers)) {
-        return RetryDecision::RetryWithBackoff;
+    for (const auto matchers : {absl::MakeConstSpan(route_policy_.retriableHeaders()),
+                                absl::MakeConstSpan(request_retriable_headers_)}) {
+      for (const auto& retriable_header : matchers) {
+        if (retriable_header->matchesHeaders(response_headers)) {
+          return RetryDecision::RetryWithBackoff;
+        }
       }
     }
   }
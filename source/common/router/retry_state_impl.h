@@ -68,6 +68,7 @@ public:
                                DoRetryResetCallback callback,
                                bool upstream_request_started) override;
   RetryStatus shouldHedgeRetryPerTryTimeout(DoRetryCallback callback) override;
+  RetryStatus shouldHedgeOnLatency(DoRetryCallback callback) override;
 
   void onHostAttempted(Upstream::HostDescriptionConstSharedPtr host) override {
     std::for_each(retry_host_predicates_.begin(), retry_host_predicates_.end(),
@@ -117,6 +118,10 @@ private:
                                     bool upstream_request_started);
   RetryStatus shouldRetry(RetryDecision would_retry, DoRetryCallback callback);
 
+  // The retriable status codes, headers and reset headers the route policy compiled at config load
+  // are read in place rather than copied for every request. The router filter holds the route, and
+  // with it the policy, for as long as the retry state.
+  const RetryPolicy& route_policy_;
   const Upstream::ClusterInfo& cluster_;
   const VirtualCluster* vcluster_;
   RouteStatsContextOptRef route_stats_context_;
@@ -127,14 +132,16 @@ private:
   DoRetryCallback backoff_callback_;
   Event::SchedulableCallbackPtr next_loop_callback_;
   Event::TimerPtr retry_timer_;
+  // Created on the first backoff, with the intervals in effect when the request started.
   BackOffStrategyPtr backoff_strategy_;
+  std::chrono::milliseconds base_backoff_interval_;
+  std::chrono::milliseconds max_backoff_interval_;
   BackOffStrategyPtr ratelimited_backoff_strategy_{};
   std::vector<Upstream::RetryHostPredicateSharedPtr> retry_host_predicates_;
   Upstream::RetryPrioritySharedPtr retry_priority_;
-  std::vector<uint32_t> retriable_status_codes_;
-  std::vector<Http::HeaderMatcherSharedPtr> retriable_headers_;
-  std::vector<ResetHeaderParserSharedPtr> reset_headers_{};
-  std::chrono::milliseconds reset_max_interval_{};
+  // Status codes and header matchers added by request headers, in addition to the route's.
+  std::vector<uint32_t> request_retriable_status_codes_;
+  std::vector<Http::HeaderMatcherSharedPtr> request_retriable_headers_;
 
   // Keep small members (bools, enums and int32s) at the end of class, to reduce alignment overhead.
   uint32_t retry_on_{};
@@ -348,6 +348,12 @@ FilterUtility::finalHedgingParams(const RouteEntry& route,
     request_headers.removeEnvoyHedgeOnPerTryTimeout();
   }
 
+  // The config requires per try timeouts to hedge along with latency hedging, as a per try timeout
+  // must not abort a latency hedge that is still in flight. A request that opts out of per try
+  // timeout hedging therefore opts out of latency hedging as well.
+  hedging_params.hedge_on_latency_ =
+      route.hedgePolicy().hedgeOnLatency() && hedging_params.hedge_on_per_try_timeout_;
+
   return hedging_params;
 }
 
@@ -450,6 +456,8 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers,
   // upstream.
   const StreamInfo::FilterStateSharedPtr& filter_state = callbacks_->streamInfo().filterState();
   const DebugConfig* debug_config = filter_state->getDataReadOnly<DebugConfig>(DebugConfig::key());
+  filter_latencies_ =
+      filter_state->getDataMutable<StreamInfo::FilterLatencies>(StreamInfo::FilterLatencies::key());
 
   // TODO: Maybe add a filter API for this.
   grpc_request_ = Grpc::Common::isGrpcRequestHeaders(headers);
@@ -662,7 +670,7 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers,
   callbacks_->streamInfo().downstreamTiming().setValue(
       "envoy.router.host_selection_start_ms",
       callbacks_->dispatcher().timeSource().monotonicTime());
-  auto host_selection_response = cluster->chooseHost(this);
+  auto host_selection_response = chooseHost(*cluster);
   if (!host_selection_response.cancelable ||
       !Runtime::runtimeFeatureEnabled("envoy.reloadable_features.async_host_selection")) {
     if (host_selection_response.cancelable) {
@@ -1103,6 +1111,10 @@ void Filter::cleanup() {
     response_timeout_->disableTimer();
     response_timeout_.reset();
   }
+  if (latency_hedge_timer_) {
+    latency_hedge_timer_->disableTimer();
+    latency_hedge_timer_.reset();
+  }
 }
 
 absl::optional<absl::string_view> Filter::getShadowCluster(const ShadowPolicy& policy,
@@ -1181,6 +1193,18 @@ void Filter::onRequestComplete() {
         upstream_request->setupPerTryTimeout();
       }
     }
+
+    // Like per try timeouts, hedges are only sent once the request is complete so that there is
+    // a single upstream request while the request body is streamed.
+    if (hedging_params_.hedge_on_latency_ && retry_state_) {
+      const absl::optional<std::chrono::milliseconds> hedge_delay =
+          route_entry_->hedgePolicy().latencyHedgeDelay();
+      if (hedge_delay.has_value()) {
+        latency_hedge_timer_ =
+            dispatcher.createTimer([this]() -> void { onLatencyHedgeTimeout(); });
+        latency_hedge_timer_->enableTimer(hedge_delay.value());
+      }
+    }
   }
 }
 
@@ -1225,6 +1249,7 @@ void Filter::onResponseTimeout() {
     if (upstream_request->upstreamHost()) {
       upstream_request->upstreamHost()->stats().rq_timeout_.inc();
     }
+    reportUpstreamResponseTime(*upstream_request, true);
 
     if (upstream_request->awaitingHeaders()) {
       if (cluster_->timeoutBudgetStats().has_value()) {
@@ -1277,7 +1302,7 @@ void Filter::onSoftPerTryTimeout(UpstreamRequest& upstream_request) {
       // back.
       upstream_request.retried(true);
 
-      // TODO: cluster stat for hedge attempted.
+      cluster_->trafficStats()->upstream_rq_hedge_attempted_.inc();
     } else if (retry_status == RetryStatus::NoOverflow) {
       callbacks_->streamInfo().setResponseFlag(StreamInfo::CoreResponseFlag::UpstreamOverflow);
     } else if (retry_status == RetryStatus::NoRetryLimitExceeded) {
@@ -1287,6 +1312,39 @@ void Filter::onSoftPerTryTimeout(UpstreamRequest& upstream_request) {
   }
 }
 
+void Filter::onLatencyHedgeTimeout() {
+  // Only hedge the first attempt, retries after a failure already went to another host.
+  if (downstream_response_started_ || !retry_state_ || upstream_requests_.size() != 1 ||
+      pending_retries_ > 0) {
+    return;
+  }
+  UpstreamRequest& upstream_request = *upstream_requests_.front();
+  if (upstream_request.retried() || !upstream_request.awaitingHeaders()) {
+    return;
+  }
+
+  RetryStatus retry_status = retry_state_->shouldHedgeOnLatency(
+      [this, can_use_http3 = upstream_request.upstreamStreamOptions().can_use_http3_]() -> void {
+        doRetry(/*can_send_early_data*/ false, can_use_http3, TimeoutRetry::No);
+      });
+  if (retry_status == RetryStatus::Yes) {
+    ENVOY_STREAM_LOG(debug, "hedging request after latency hedge delay", *callbacks_);
+    runRetryOptionsPredicates(upstream_request);
+    pending_retries_++;
+    // An error response of the original request is discarded now that a hedge is in flight.
+    upstream_request.retried(true);
+    latency_hedge_sent_ = true;
+    cluster_->trafficStats()->upstream_rq_hedge_attempted_.inc();
+  }
+}
+
+bool Filter::hasUpstreamRequestTo(const Upstream::Host& host) const {
+  return std::any_of(upstream_requests_.begin(), upstream_requests_.end(),
+                     [&host](const UpstreamRequestPtr& upstream_request) {
+                       return upstream_request->upstreamHost().ptr() == &host;
+                     });
+}
+
 void Filter::onPerTryIdleTimeout(UpstreamRequest& upstream_request) {
   onPerTryTimeoutCommon(upstream_request,
                         cluster_->trafficStats()->upstream_rq_per_try_idle_timeout_,
@@ -1314,6 +1372,7 @@ void Filter::onPerTryTimeoutCommon(UpstreamRequest& upstream_request, Stats::Cou
 
   updateOutlierDetection(Upstream::Outlier::Result::LocalOriginTimeout, upstream_request,
                          absl::optional<uint64_t>(enumToInt(timeout_response_code_)));
+  reportUpstreamResponseTime(upstream_request, true);
 
   if (maybeRetryReset(Http::StreamResetReason::LocalReset, upstream_request, TimeoutRetry::Yes)) {
     return;
@@ -1360,6 +1419,25 @@ void Filter::updateOutlierDetection(Upstream::Outlier::Result result,
   }
 }
 
+void Filter::reportUpstreamResponseTime(UpstreamRequest& upstream_request, bool failed) {
+  if (!upstream_request.upstreamHost()) {
+    return;
+  }
+  OptRef<Upstream::HostLbPolicyData> host_lb_policy_data =
+      upstream_request.upstreamHost()->lbPolicyData();
+  if (!host_lb_policy_data.has_value()) {
+    return;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      callbacks_->dispatcher().timeSource().monotonicTime() -
+      upstream_request.streamInfo().startTimeMonotonic());
+  if (failed) {
+    host_lb_policy_data->onUpstreamFailure(elapsed);
+  } else {
+    host_lb_policy_data->onUpstreamResponseTime(elapsed);
+  }
+}
+
 void Filter::chargeUpstreamAbort(Http::Code code, bool dropped, UpstreamRequest& upstream_request) {
   if (downstream_response_started_) {
     if (upstream_request.grpcRqSuccessDeferred()) {
@@ -1494,6 +1572,7 @@ void Filter::onUpstreamReset(Http::StreamResetReason reset_reason,
     // config param set to true.
     updateOutlierDetection(Upstream::Outlier::Result::LocalOriginConnectFailed, upstream_request,
                            absl::nullopt);
+    reportUpstreamResponseTime(upstream_request, true);
   }
 
   if (maybeRetryReset(reset_reason, upstream_request, TimeoutRetry::No)) {
@@ -1637,9 +1716,18 @@ void Filter::resetOtherUpstreams(UpstreamRequest& upstream_request) {
     UpstreamRequestPtr upstream_request_tmp =
         upstream_requests_.back()->removeFromList(upstream_requests_);
     if (upstream_request_tmp.get() != &upstream_request) {
+      // A hedged attempt that lost the race is the slow tail the histogram needs to see. Its
+      // latency is unknown, but at least the time it has been in flight so far.
+      if (hedging_params_.hedge_on_latency_ && upstream_request_tmp->retried() &&
+          upstream_request_tmp->awaitingHeaders()) {
+        route_entry_->hedgePolicy().recordUpstreamLatency(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                callbacks_->dispatcher().timeSource().monotonicTime() -
+                upstream_request_tmp->streamInfo().startTimeMonotonic()));
+      }
       upstream_request_tmp->resetStream();
       // TODO: per-host stat for hedge abandoned.
-      // TODO: cluster stat for hedge abandoned.
+      cluster_->trafficStats()->upstream_rq_hedge_abandoned_.inc();
     } else {
       final_upstream_request = std::move(upstream_request_tmp);
     }
@@ -1793,6 +1881,13 @@ void Filter::onUpstreamHeaders(uint64_t response_code, Http::ResponseHeaderMapPt
   // provide finalizeResponseHeaders functions on the Router::Config and VirtualHost interfaces.
   route_entry_->finalizeResponseHeaders(*headers, callbacks_->streamInfo());
 
+  if (hedging_params_.hedge_on_latency_) {
+    route_entry_->hedgePolicy().recordUpstreamLatency(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            callbacks_->dispatcher().timeSource().monotonicTime() -
+            upstream_request.streamInfo().startTimeMonotonic()));
+  }
+
   downstream_response_started_ = true;
   final_upstream_request_ = &upstream_request;
   // Make sure that for request hedging, we end up with the correct final upstream info.
@@ -1863,6 +1958,8 @@ void Filter::onUpstreamComplete(UpstreamRequest& upstream_request) {
   std::chrono::milliseconds response_time = std::chrono::duration_cast<std::chrono::milliseconds>(
       dispatcher.timeSource().monotonicTime() - downstream_request_complete_time_);
 
+  reportUpstreamResponseTime(upstream_request, false);
+
   Upstream::ClusterTimeoutBudgetStatsOptRef tb_stats = cluster()->timeoutBudgetStats();
   if (tb_stats.has_value()) {
     tb_stats->get().upstream_rq_timeout_budget_percent_used_.recordValue(
@@ -2134,7 +2231,7 @@ void Filter::doRetry(bool can_send_early_data, bool can_use_http3, TimeoutRetry
   callbacks_->streamInfo().downstreamTiming().setValue(
       "envoy.router.host_selection_start_ms",
       callbacks_->dispatcher().timeSource().monotonicTime());
-  auto host_selection_response = cluster->chooseHost(this);
+  auto host_selection_response = chooseHost(*cluster);
   if (!host_selection_response.cancelable ||
       !Runtime::runtimeFeatureEnabled("envoy.reloadable_features.async_host_selection")) {
     if (host_selection_response.cancelable) {
@@ -2225,6 +2322,19 @@ uint32_t Filter::numRequestsAwaitingHeaders() {
                        [](const auto& req) -> bool { return req->awaitingHeaders(); });
 }
 
+Upstream::HostSelectionResponse Filter::chooseHost(Upstream::ThreadLocalCluster& cluster) {
+  if (filter_latencies_ == nullptr) {
+    return cluster.chooseHost(this);
+  }
+  TimeSource& time_source = callbacks_->dispatcher().timeSource();
+  const auto timing = filter_latencies_->startTiming(time_source.monotonicTime());
+  auto host_selection_response = cluster.chooseHost(this);
+  filter_latencies_->addPhaseTime(
+      StreamInfo::FilterLatencies::Phase::HostSelection,
+      filter_latencies_->finishTiming(timing, time_source.monotonicTime()));
+  return host_selection_response;
+}
+
 bool Filter::checkDropOverload(Upstream::ThreadLocalCluster& cluster,
                                std::function<void(Http::ResponseHeaderMap&)>& modify_headers) {
   if (cluster.dropOverload().value()) {
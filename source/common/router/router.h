@@ -42,6 +42,7 @@
 #include "source/common/router/context_impl.h"
 #include "source/common/router/upstream_request.h"
 #include "source/common/stats/symbol_table.h"
+#include "source/common/stream_info/filter_latencies.h"
 #include "source/common/stream_info/stream_info_impl.h"
 #include "source/common/upstream/load_balancer_context_base.h"
 #include "source/common/upstream/upstream_factory_context_impl.h"
@@ -61,6 +62,7 @@ class FilterUtility {
 public:
   struct HedgingParams {
     bool hedge_on_per_try_timeout_ : 1;
+    bool hedge_on_latency_ : 1;
   };
 
   class StrictHeaderChecker {
@@ -317,7 +319,8 @@ public:
                                                "envoy.reloadable_features.streaming_shadow")),
         allow_multiplexed_upstream_half_close_(Runtime::runtimeFeatureEnabled(
             "envoy.reloadable_features.allow_multiplexed_upstream_half_close")),
-        upstream_request_started_(false), orca_load_report_received_(false) {}
+        upstream_request_started_(false), orca_load_report_received_(false),
+        latency_hedge_sent_(false) {}
 
   ~Filter() override;
 
@@ -415,7 +418,8 @@ public:
     }
 
     ASSERT(retry_state_);
-    return retry_state_->shouldSelectAnotherHost(host);
+    return retry_state_->shouldSelectAnotherHost(host) ||
+           (latency_hedge_sent_ && hasUpstreamRequestTo(host));
   }
 
   const Upstream::HealthyAndDegradedLoad& determinePriorityLoad(
@@ -434,6 +438,10 @@ public:
     if (!is_retry_) {
       return 1;
     }
+    if (latency_hedge_sent_) {
+      // Give the load balancer a chance to pick a host other than the one being hedged.
+      return std::max(retry_state_->hostSelectionMaxAttempts(), LatencyHedgeHostSelectionAttempts);
+    }
     return retry_state_->hostSelectionMaxAttempts();
   }
 
@@ -526,6 +534,9 @@ protected:
 private:
   friend class UpstreamRequest;
 
+  // Host selection attempts used for a latency hedge, to steer it away from in-flight hosts.
+  static constexpr uint32_t LatencyHedgeHostSelectionAttempts = 3;
+
   enum class TimeoutRetry { Yes, No };
 
   void onPerTryTimeoutCommon(UpstreamRequest& upstream_request, Stats::Counter& error_counter,
@@ -562,6 +573,9 @@ private:
   // Handle an upstream request aborted due to a local timeout.
   void onSoftPerTryTimeout();
   void onSoftPerTryTimeout(UpstreamRequest& upstream_request);
+  // Send a hedged request if the only attempt is still waiting for response headers.
+  void onLatencyHedgeTimeout();
+  bool hasUpstreamRequestTo(const Upstream::Host& host) const;
   void onUpstreamTimeoutAbort(StreamInfo::CoreResponseFlag response_flag,
                               absl::string_view details);
   // Handle an "aborted" upstream request, meaning we didn't see response
@@ -584,6 +598,9 @@ private:
                                                 uint64_t status_code);
   void updateOutlierDetection(Upstream::Outlier::Result result, UpstreamRequest& upstream_request,
                               absl::optional<uint64_t> code);
+  // Reports the time elapsed since the start of the upstream request to the host's LB policy data,
+  // as a response time or, for requests that were reset or timed out, as a failure.
+  void reportUpstreamResponseTime(UpstreamRequest& upstream_request, bool failed);
   void doRetry(bool can_send_early_data, bool can_use_http3, TimeoutRetry is_timeout_retry);
   void continueDoRetry(bool can_send_early_data, bool can_use_http3, TimeoutRetry is_timeout_retry,
                        Upstream::HostConstSharedPtr&& host, Upstream::ThreadLocalCluster& cluster,
@@ -598,14 +615,18 @@ private:
   Http::Context& httpContext() { return config_->http_context_; }
   bool checkDropOverload(Upstream::ThreadLocalCluster& cluster,
                          std::function<void(Http::ResponseHeaderMap&)>& modify_headers);
+  // Chooses a host of the cluster, adding the time it takes to the stream's filter latencies if
+  // they are recorded.
+  Upstream::HostSelectionResponse chooseHost(Upstream::ThreadLocalCluster& cluster);
   // Process Orca Load Report if necessary (e.g. cluster has lrsReportMetricNames).
   void maybeProcessOrcaLoadReport(const Envoy::Http::HeaderMap& headers_or_trailers,
                                   UpstreamRequest& upstream_request);
 
-  RetryStatePtr retry_state_;
   const FilterConfigSharedPtr config_;
   Http::StreamDecoderFilterCallbacks* callbacks_{};
   RouteConstSharedPtr route_;
+  // Declared after route_, as it reads the retry policy of the route in place.
+  RetryStatePtr retry_state_;
   const RouteEntry* route_entry_{};
   Upstream::ClusterInfoConstSharedPtr cluster_;
   std::unique_ptr<Stats::StatNameDynamicStorage> alt_stat_prefix_;
@@ -614,6 +635,7 @@ private:
   std::function<void(Upstream::HostConstSharedPtr&& host, std::string details)> on_host_selected_;
   std::unique_ptr<Upstream::AsyncHostSelectionHandle> host_selection_cancelable_;
   Event::TimerPtr response_timeout_;
+  Event::TimerPtr latency_hedge_timer_;
   TimeoutData timeout_;
   std::list<UpstreamRequestPtr> upstream_requests_;
   FilterStats stats_;
@@ -622,6 +644,8 @@ private:
   UpstreamRequest* final_upstream_request_ = nullptr;
   Http::RequestHeaderMap* downstream_headers_{};
   Http::RequestTrailerMap* downstream_trailers_{};
+  // Owned by the stream's filter manager, set if the stream's filter latencies are recorded.
+  StreamInfo::FilterLatencies* filter_latencies_{};
   MonotonicTime downstream_request_complete_time_;
   MetadataMatchCriteriaConstPtr metadata_match_;
   std::function<void(Http::ResponseHeaderMap&)> modify_headers_;
@@ -659,6 +683,7 @@ private:
   // Indicate that ORCA report is received to process it only once in either response headers or
   // trailers.
   bool orca_load_report_received_ : 1;
+  bool latency_hedge_sent_ : 1;
 };
 
 class ProdFilter : public Filter {
@@ -35,6 +35,7 @@
 #include "source/common/router/debug_config.h"
 #include "source/common/router/router.h"
 #include "source/common/router/upstream_codec_filter.h"
+#include "source/common/stream_info/filter_latencies.h"
 #include "source/common/stream_info/uint32_accessor_impl.h"
 #include "source/common/tracing/http_tracer_impl.h"
 #include "source/extensions/common/proxy_protocol/proxy_protocol_header.h"
@@ -552,8 +553,15 @@ void UpstreamRequest::onPerTryTimeout() {
 }
 
 void UpstreamRequest::recordConnectionPoolCallbackLatency() {
-  upstreamTiming().recordConnectionPoolCallbackLatency(
-      start_time_, parent_.callbacks()->dispatcher().timeSource());
+  TimeSource& time_source = parent_.callbacks()->dispatcher().timeSource();
+  upstreamTiming().recordConnectionPoolCallbackLatency(start_time_, time_source);
+  auto* filter_latencies =
+      parent_.callbacks()->streamInfo().filterState()->getDataMutable<StreamInfo::FilterLatencies>(
+          StreamInfo::FilterLatencies::key());
+  if (filter_latencies != nullptr) {
+    filter_latencies->addPhaseTime(StreamInfo::FilterLatencies::Phase::PoolWait,
+                                   time_source.monotonicTime() - start_time_);
+  }
 }
 
 void UpstreamRequest::onPoolFailure(ConnectionPool::PoolFailureReason reason,
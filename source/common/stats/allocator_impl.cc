@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <new>
 
 #include "envoy/stats/sink.h"
 #include "envoy/stats/stats.h"
@@ -23,6 +24,67 @@ namespace Stats {
 
 const char AllocatorImpl::DecrementToZeroSyncPoint[] = "decrement-zero";
 
+StatSlabs::StatSlabs(size_t slot_size, size_t slot_align)
+    : slot_size_((slot_size + slot_align - 1) / slot_align * slot_align) {
+  // Slab storage comes from operator new[], which only guarantees the default alignment.
+  RELEASE_ASSERT(slot_align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned stat slot");
+}
+
+void* StatSlabs::allocate() {
+  char* slot;
+  if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    if (slabs_.empty() || slabs_.back().num_used_ == SlotsPerSlab) {
+      Slab& slab = slabs_.emplace_back();
+      slab.storage_ = std::make_unique<char[]>(SlotsPerSlab * slot_size_);
+      slab.states_.fill(SlotState::Free);
+      slab_index_[slab.storage_.get()] = slabs_.size() - 1;
+    }
+    Slab& slab = slabs_.back();
+    slot = slab.storage_.get() + slab.num_used_++ * slot_size_;
+  }
+  SlotState& state = stateFor(slot);
+  ASSERT(state == SlotState::Free);
+  state = SlotState::Listed;
+  ++num_allocated_;
+  return slot;
+}
+
+void StatSlabs::release(void* slot) {
+  SlotState& state = stateFor(slot);
+  ASSERT(state != SlotState::Free);
+  state = SlotState::Free;
+  free_slots_.push_back(static_cast<char*>(slot));
+  --num_allocated_;
+}
+
+void StatSlabs::unlist(const void* slot) {
+  auto iter = slab_index_.upper_bound(static_cast<const char*>(slot));
+  if (iter == slab_index_.begin()) {
+    return;
+  }
+  --iter;
+  const auto offset = static_cast<size_t>(static_cast<const char*>(slot) - iter->first);
+  if (offset >= SlotsPerSlab * slot_size_) {
+    return;
+  }
+  SlotState& state = slabs_[iter->second].states_[offset / slot_size_];
+  if (state == SlotState::Listed) {
+    state = SlotState::Unlisted;
+  }
+}
+
+StatSlabs::SlotState& StatSlabs::stateFor(const void* slot) {
+  auto iter = slab_index_.upper_bound(static_cast<const char*>(slot));
+  ASSERT(iter != slab_index_.begin());
+  --iter;
+  const auto offset = static_cast<size_t>(static_cast<const char*>(slot) - iter->first);
+  ASSERT(offset < SlotsPerSlab * slot_size_ && offset % slot_size_ == 0);
+  return slabs_[iter->second].states_[offset / slot_size_];
+}
+
 AllocatorImpl::~AllocatorImpl() {
   ASSERT(counters_.empty());
   ASSERT(gauges_.empty());
@@ -106,7 +168,16 @@ public:
     if (--ref_count_ == 0) {
       alloc_.sync().syncPoint(AllocatorImpl::DecrementToZeroSyncPoint);
       removeFromSetLockHeld();
-      return true;
+      StatSlabs* slabs = slabsLockHeld();
+      if (slabs == nullptr) {
+        return true;
+      }
+      // A slab-allocated stat is destroyed in place and its slot returned to
+      // the slab, leaving nothing for the caller to delete. No members may be
+      // touched after the destructor runs.
+      void* slot = dynamic_cast<void*>(this);
+      this->~StatsSharedImpl();
+      slabs->release(slot);
     }
     return false;
   }
@@ -119,7 +190,39 @@ public:
    */
   virtual void removeFromSetLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) PURE;
 
+  /**
+   * @return the slabs holding this stat, or nullptr if it was allocated with new.
+   */
+  virtual StatSlabs* slabsLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) PURE;
+
+  /**
+   * Clears the Changed flag, so that the next change marks the stat changed again.
+   * @return whether the flag was set.
+   */
+  bool latchChangedFlag() {
+    return (flags_.fetch_and(~Metric::Flags::Changed) & Metric::Flags::Changed) != 0;
+  }
+
+  /**
+   * Sets the Changed flag for good, so that a stat marked for deletion is never marked changed.
+   */
+  void stopChangeTracking() { flags_ |= Metric::Flags::Changed; }
+
 protected:
+  // The flags are only set once per stats flush interval, so most updates find them already set
+  // and get away with a load instead of a read-modify-write. A load that still sees the Changed
+  // bit is ordered before it is cleared, so the flush that clears it reads the new value. The
+  // update that sets the Changed bit records the stat with the allocator.
+  void setFlags(uint16_t flags) {
+    if ((flags_ & flags) == flags) {
+      return;
+    }
+    const uint16_t previous = flags_.fetch_or(flags);
+    if ((flags & ~previous & Metric::Flags::Changed) != 0) {
+      alloc_.markChanged(static_cast<BaseClass&>(*this));
+    }
+  }
+
   AllocatorImpl& alloc_;
 
   // ref_count_ can be incremented as an atomic, without taking a new lock, as
@@ -136,7 +239,7 @@ protected:
   std::atomic<uint16_t> flags_{0};
 };
 
-class CounterImpl : public StatsSharedImpl<Counter> {
+class CounterImpl final : public StatsSharedImpl<Counter> {
 public:
   CounterImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
               const StatNameTagVector& stat_name_tags)
@@ -146,6 +249,11 @@ public:
     const size_t count = alloc_.counters_.erase(statName());
     ASSERT(count == 1);
     alloc_.sinked_counters_.erase(this);
+    Thread::LockGuard lock(alloc_.changed_mutex_);
+    alloc_.changed_counters_.erase(this);
+  }
+  StatSlabs* slabsLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) override {
+    return alloc_.counter_slabs_.get();
   }
 
   // Stats::Counter
@@ -154,7 +262,10 @@ public:
     // used(). From a system perspective this should be eventually consistent.
     value_ += amount;
     pending_increment_ += amount;
-    flags_ |= Flags::Used;
+    // Counters only carry the Changed flag while changes are tracked. An increment that still
+    // sees tracking disabled is ordered before the first tracking flush, which visits and latches
+    // every counter.
+    setFlags(alloc_.track_changed_counters_ ? Flags::Used | Flags::Changed : Flags::Used);
   }
   void inc() override { add(1); }
   uint64_t latch() override { return pending_increment_.exchange(0); }
@@ -166,7 +277,7 @@ private:
   std::atomic<uint64_t> pending_increment_{0};
 };
 
-class GaugeImpl : public StatsSharedImpl<Gauge> {
+class GaugeImpl final : public StatsSharedImpl<Gauge> {
 public:
   GaugeImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
             const StatNameTagVector& stat_name_tags, ImportMode import_mode)
@@ -195,25 +306,32 @@ public:
     const size_t count = alloc_.gauges_.erase(statName());
     ASSERT(count == 1);
     alloc_.sinked_gauges_.erase(this);
+    Thread::LockGuard lock(alloc_.changed_mutex_);
+    alloc_.changed_gauges_.erase(this);
+  }
+  StatSlabs* slabsLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) override {
+    return alloc_.gauge_slabs_.get();
   }
 
   // Stats::Gauge
   void add(uint64_t amount) override {
     child_value_ += amount;
-    flags_ |= Flags::Used;
+    setFlags(Flags::Used | Flags::Changed);
   }
   void dec() override { sub(1); }
   void inc() override { add(1); }
   void set(uint64_t value) override {
     child_value_ = value;
-    flags_ |= Flags::Used;
+    setFlags(Flags::Used | Flags::Changed);
   }
   void sub(uint64_t amount) override {
     ASSERT(child_value_ >= amount);
     ASSERT(used() || amount == 0);
     child_value_ -= amount;
+    setFlags(Flags::Changed);
   }
   uint64_t value() const override { return child_value_ + parent_value_; }
+  bool latchChanged() override { return latchChangedFlag(); }
 
   // TODO(diazalan): Rename importMode and to more generic name
   ImportMode importMode() const override {
@@ -260,7 +378,12 @@ public:
     }
   }
 
-  void setParentValue(uint64_t value) override { parent_value_ = value; }
+  void setParentValue(uint64_t value) override {
+    // The parent values are merged on every hot restart stats transfer, usually unchanged.
+    if (parent_value_.exchange(value) != value) {
+      setFlags(Flags::Changed);
+    }
+  }
 
 private:
   std::atomic<uint64_t> parent_value_{0};
@@ -278,6 +401,9 @@ public:
     ASSERT(count == 1);
     alloc_.sinked_text_readouts_.erase(this);
   }
+  StatSlabs* slabsLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) override {
+    return nullptr;
+  }
 
   // Stats::TextReadout
   void set(absl::string_view value) override {
@@ -296,6 +422,25 @@ private:
   std::string value_ ABSL_GUARDED_BY(mutex_);
 };
 
+AllocatorImpl::AllocatorImpl(SymbolTable& symbol_table, bool slab_allocation)
+    : symbol_table_(symbol_table),
+      counter_slabs_(slab_allocation ? std::make_unique<StatSlabs>(sizeof(CounterImpl),
+                                                                   alignof(CounterImpl))
+                                     : nullptr),
+      gauge_slabs_(slab_allocation
+                       ? std::make_unique<StatSlabs>(sizeof(GaugeImpl), alignof(GaugeImpl))
+                       : nullptr) {}
+
+uint64_t AllocatorImpl::slabBytes() const {
+  if (counter_slabs_ == nullptr) {
+    return 0;
+  }
+  Thread::LockGuard lock(mutex_);
+  return (counter_slabs_->numSlabs() * counter_slabs_->slotSize() +
+          gauge_slabs_->numSlabs() * gauge_slabs_->slotSize()) *
+         StatSlabs::SlotsPerSlab;
+}
+
 CounterSharedPtr AllocatorImpl::makeCounter(StatName name, StatName tag_extracted_name,
                                             const StatNameTagVector& stat_name_tags) {
   Thread::LockGuard lock(mutex_);
@@ -325,8 +470,14 @@ GaugeSharedPtr AllocatorImpl::makeGauge(StatName name, StatName tag_extracted_na
   if (iter != gauges_.end()) {
     return {*iter};
   }
-  auto gauge =
-      GaugeSharedPtr(new GaugeImpl(name, *this, tag_extracted_name, stat_name_tags, import_mode));
+  Gauge* gauge_ptr;
+  if (gauge_slabs_ != nullptr) {
+    gauge_ptr = new (gauge_slabs_->allocate())
+        GaugeImpl(name, *this, tag_extracted_name, stat_name_tags, import_mode);
+  } else {
+    gauge_ptr = new GaugeImpl(name, *this, tag_extracted_name, stat_name_tags, import_mode);
+  }
+  auto gauge = GaugeSharedPtr(gauge_ptr);
   gauges_.insert(gauge.get());
   // Add gauge to sinked_gauges_ if it matches the sink predicate.
   if (sink_predicates_ != nullptr && sink_predicates_->includeGauge(*gauge)) {
@@ -366,6 +517,11 @@ bool AllocatorImpl::isMutexLockedForTest() {
 
 Counter* AllocatorImpl::makeCounterInternal(StatName name, StatName tag_extracted_name,
                                             const StatNameTagVector& stat_name_tags) {
+  // The caller, makeCounter(), holds mutex_.
+  if (counter_slabs_ != nullptr) {
+    return new (counter_slabs_->allocate())
+        CounterImpl(name, *this, tag_extracted_name, stat_name_tags);
+  }
   return new CounterImpl(name, *this, tag_extracted_name, stat_name_tags);
 }
 
@@ -374,6 +530,14 @@ void AllocatorImpl::forEachCounter(SizeFn f_size, StatFn<Counter> f_stat) const
   if (f_size != nullptr) {
     f_size(counters_.size());
   }
+  if (counter_slabs_ != nullptr) {
+    // Walking the slabs visits the counters in address order, rather than
+    // chasing the scattered pointers held in counters_.
+    ASSERT(counter_slabs_->numAllocated() == counters_.size() + deleted_counters_.size());
+    counter_slabs_->forEachListed(
+        [&f_stat](void* slot) { f_stat(*std::launder(static_cast<CounterImpl*>(slot))); });
+    return;
+  }
   for (auto& counter : counters_) {
     f_stat(*counter);
   }
@@ -384,6 +548,11 @@ void AllocatorImpl::forEachGauge(SizeFn f_size, StatFn<Gauge> f_stat) const {
   if (f_size != nullptr) {
     f_size(gauges_.size());
   }
+  if (gauge_slabs_ != nullptr) {
+    gauge_slabs_->forEachListed(
+        [&f_stat](void* slot) { f_stat(*std::launder(static_cast<GaugeImpl*>(slot))); });
+    return;
+  }
   for (auto& gauge : gauges_) {
     f_stat(*gauge);
   }
@@ -427,6 +596,74 @@ void AllocatorImpl::forEachSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) cons
   }
 }
 
+void AllocatorImpl::markChanged(Counter& counter) {
+  if (track_changed_counters_) {
+    Thread::LockGuard lock(changed_mutex_);
+    changed_counters_.insert(&counter);
+  }
+}
+
+void AllocatorImpl::markChanged(Gauge& gauge) {
+  // A gauge changed before tracking started is found by its flag on the first tracking flush.
+  if (track_changed_gauges_) {
+    Thread::LockGuard lock(changed_mutex_);
+    changed_gauges_.insert(&gauge);
+  }
+}
+
+void AllocatorImpl::forEachChangedSinkedCounter(SizeFn f_size, StatFn<Counter> f_stat) {
+  if (!track_changed_counters_.exchange(true)) {
+    // Increments before this point were not recorded, so the first call visits every counter.
+    forEachSinkedCounter(f_size, f_stat);
+    return;
+  }
+  Thread::LockGuard lock(mutex_);
+  StatPointerSet<Counter> changed;
+  {
+    Thread::LockGuard changed_lock(changed_mutex_);
+    changed.swap(changed_counters_);
+  }
+  if (f_size != nullptr) {
+    f_size(changed.size());
+  }
+  for (Counter* counter : changed) {
+    // Only CounterImpl records itself as changed. The flag is cleared before the callback
+    // latches the counter, so that a concurrent increment marks it changed again.
+    static_cast<CounterImpl*>(counter)->latchChangedFlag();
+    if (sink_predicates_ == nullptr || sinked_counters_.contains(counter)) {
+      f_stat(*counter);
+    }
+  }
+}
+
+void AllocatorImpl::forEachChangedSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) {
+  if (!track_changed_gauges_.exchange(true)) {
+    // Gauges changed before this point were not recorded, so the first call finds them by their
+    // flag instead.
+    forEachSinkedGauge(f_size, [&f_stat](Gauge& gauge) {
+      if (gauge.latchChanged()) {
+        f_stat(gauge);
+      }
+    });
+    return;
+  }
+  Thread::LockGuard lock(mutex_);
+  StatPointerSet<Gauge> changed;
+  {
+    Thread::LockGuard changed_lock(changed_mutex_);
+    changed.swap(changed_gauges_);
+  }
+  if (f_size != nullptr) {
+    f_size(changed.size());
+  }
+  for (Gauge* gauge : changed) {
+    gauge->latchChanged();
+    if (sink_predicates_ != nullptr ? sinked_gauges_.contains(gauge) : !gauge->hidden()) {
+      f_stat(*gauge);
+    }
+  }
+}
+
 void AllocatorImpl::forEachSinkedTextReadout(SizeFn f_size, StatFn<TextReadout> f_stat) const {
   if (sink_predicates_ != nullptr) {
     Thread::LockGuard lock(mutex_);
@@ -477,7 +714,17 @@ void AllocatorImpl::markCounterForDeletion(const CounterSharedPtr& counter) {
   // Duplicates are ASSERTed in ~AllocatorImpl.
   deleted_counters_.emplace_back(*iter);
   counters_.erase(iter);
+  if (counter_slabs_ != nullptr) {
+    counter_slabs_->unlist(dynamic_cast<const void*>(counter.get()));
+  }
   sinked_counters_.erase(counter.get());
+  // The counter stays alive for its holders, which may still increment it.
+  auto* counter_impl = dynamic_cast<CounterImpl*>(counter.get());
+  if (counter_impl != nullptr) {
+    counter_impl->stopChangeTracking();
+    Thread::LockGuard changed_lock(changed_mutex_);
+    changed_counters_.erase(counter_impl);
+  }
 }
 
 void AllocatorImpl::markGaugeForDeletion(const GaugeSharedPtr& gauge) {
@@ -491,7 +738,13 @@ void AllocatorImpl::markGaugeForDeletion(const GaugeSharedPtr& gauge) {
   // Duplicates are ASSERTed in ~AllocatorImpl.
   deleted_gauges_.emplace_back(*iter);
   gauges_.erase(iter);
+  if (gauge_slabs_ != nullptr) {
+    gauge_slabs_->unlist(dynamic_cast<const void*>(gauge.get()));
+  }
   sinked_gauges_.erase(gauge.get());
+  static_cast<GaugeImpl*>(gauge.get())->stopChangeTracking();
+  Thread::LockGuard changed_lock(changed_mutex_);
+  changed_gauges_.erase(gauge.get());
 }
 
 void AllocatorImpl::markTextReadoutForDeletion(const TextReadoutSharedPtr& text_readout) {
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "envoy/common/optref.h"
@@ -10,17 +13,100 @@
 #include "source/common/common/thread_synchronizer.h"
 #include "source/common/stats/metric_impl.h"
 
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
 namespace Stats {
 
+/**
+ * Fixed-size slot storage for stat objects. Slots are carved out of contiguous
+ * slabs, so stats created together (typically by one scope) end up adjacent in
+ * memory, and released slots are reused before a new slab is allocated. Slabs
+ * are never returned to the heap until the StatSlabs is destroyed.
+ *
+ * This class is not thread-safe; AllocatorImpl calls it with its mutex held.
+ */
+class StatSlabs {
+public:
+  static constexpr uint32_t SlotsPerSlab = 256;
+
+  /**
+   * @param slot_size the size of each slot, e.g. sizeof(CounterImpl).
+   * @param slot_align the alignment of each slot, which must not exceed the
+   *        default operator new alignment.
+   */
+  StatSlabs(size_t slot_size, size_t slot_align);
+
+  /**
+   * @return uninitialized storage for one object; the slot is considered listed.
+   */
+  void* allocate();
+
+  /**
+   * Returns a slot to the free list. The object in it must already be destroyed.
+   */
+  void release(void* slot);
+
+  /**
+   * Excludes a live slot from forEachListed, e.g. when its stat has been
+   * marked for deletion but must remain allocated. A no-op for addresses not
+   * owned by these slabs.
+   */
+  void unlist(const void* slot);
+
+  /**
+   * Calls fn for every listed slot, in address order within each slab and in
+   * creation order across slabs.
+   */
+  template <class Fn> void forEachListed(Fn fn) const {
+    for (const Slab& slab : slabs_) {
+      for (uint32_t i = 0; i < slab.num_used_; ++i) {
+        if (slab.states_[i] == SlotState::Listed) {
+          fn(slab.storage_.get() + i * slot_size_);
+        }
+      }
+    }
+  }
+
+  size_t numSlabs() const { return slabs_.size(); }
+  size_t numAllocated() const { return num_allocated_; }
+  size_t slotSize() const { return slot_size_; }
+
+private:
+  enum class SlotState : uint8_t { Free, Listed, Unlisted };
+
+  struct Slab {
+    std::unique_ptr<char[]> storage_;
+    std::array<SlotState, SlotsPerSlab> states_;
+    // Slots at or beyond num_used_ have never been handed out.
+    uint32_t num_used_{0};
+  };
+
+  SlotState& stateFor(const void* slot);
+
+  const size_t slot_size_;
+  std::vector<Slab> slabs_;
+  // Indexes slabs_ by the address of their storage, for mapping a slot back to its slab.
+  absl::btree_map<const char*, uint32_t> slab_index_;
+  std::vector<char*> free_slots_;
+  size_t num_allocated_{0};
+};
+
 class AllocatorImpl : public Allocator {
 public:
   static const char DecrementToZeroSyncPoint[];
 
-  AllocatorImpl(SymbolTable& symbol_table) : symbol_table_(symbol_table) {}
+  /**
+   * @param symbol_table the symbol table used to encode and decode stat names.
+   * @param slab_allocation when true, counters and gauges are placed in
+   *        contiguous slabs rather than allocated individually on the heap, and
+   *        forEachCounter/forEachGauge scan the slabs in address order. This is
+   *        not compatible with subclasses that wrap the counters returned by
+   *        makeCounterInternal.
+   */
+  AllocatorImpl(SymbolTable& symbol_table, bool slab_allocation = false);
   ~AllocatorImpl() override;
 
   // Allocator
@@ -44,6 +130,9 @@ public:
   void forEachSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) const override;
   void forEachSinkedTextReadout(SizeFn f_size, StatFn<TextReadout> f_stat) const override;
 
+  void forEachChangedSinkedCounter(SizeFn f_size, StatFn<Counter> f_stat) override;
+  void forEachChangedSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) override;
+
   void setSinkPredicates(std::unique_ptr<SinkPredicates>&& sink_predicates) override;
 #ifndef ENVOY_CONFIG_COVERAGE
   void debugPrint();
@@ -63,6 +152,17 @@ public:
   void markGaugeForDeletion(const GaugeSharedPtr& gauge) override;
   void markTextReadoutForDeletion(const TextReadoutSharedPtr& text_readout) override;
 
+  /**
+   * @return whether counters and gauges are slab-allocated.
+   */
+  bool slabAllocation() const { return counter_slabs_ != nullptr; }
+
+  /**
+   * @return the number of bytes of slab storage reserved for counters and gauges,
+   *         or 0 if slab allocation is disabled.
+   */
+  uint64_t slabBytes() const;
+
 protected:
   virtual Counter* makeCounterInternal(StatName name, StatName tag_extracted_name,
                                        const StatNameTagVector& stat_name_tags);
@@ -74,6 +174,11 @@ private:
   friend class TextReadoutImpl;
   friend class NotifyingAllocatorImpl;
 
+  // Records a counter or gauge that changed for the first time since it was last visited by
+  // forEachChangedSinkedCounter or forEachChangedSinkedGauge.
+  void markChanged(Counter& counter);
+  void markChanged(Gauge& gauge);
+
   // A mutex is needed here to protect both the stats_ object from both
   // alloc() and free() operations. Although alloc() operations are called under existing locking,
   // free() operations are made from the destructors of the individual stat objects, which are not
@@ -90,12 +195,31 @@ private:
   StatPointerSet<Gauge> sinked_gauges_ ABSL_GUARDED_BY(mutex_);
   StatPointerSet<TextReadout> sinked_text_readouts_ ABSL_GUARDED_BY(mutex_);
 
+  // Counters and gauges changed since they were last visited by forEachChangedSinkedCounter or
+  // forEachChangedSinkedGauge. Stats are marked changed from any thread, at most once per flush,
+  // so these have their own mutex rather than contending on mutex_. When both are held, mutex_
+  // is acquired first.
+  Thread::MutexBasicLockable changed_mutex_;
+  StatPointerSet<Counter> changed_counters_ ABSL_GUARDED_BY(changed_mutex_);
+  StatPointerSet<Gauge> changed_gauges_ ABSL_GUARDED_BY(changed_mutex_);
+  // Changes are only tracked once a flush asks for them, so that the sets above are not filled
+  // when only full flushes are done.
+  std::atomic<bool> track_changed_counters_{false};
+  std::atomic<bool> track_changed_gauges_{false};
+
   // Predicates used to filter stats to be flushed.
   std::unique_ptr<SinkPredicates> sink_predicates_;
   SymbolTable& symbol_table_;
 
   Thread::ThreadSynchronizer sync_;
 
+  // Slot storage for counters and gauges, null unless slab allocation was
+  // requested. The slabs themselves are only accessed with mutex_ held. These
+  // are declared ahead of deleted_counters_ and deleted_gauges_, whose stats
+  // release their slots when destroyed.
+  const std::unique_ptr<StatSlabs> counter_slabs_;
+  const std::unique_ptr<StatSlabs> gauge_slabs_;
+
   // Retain storage for deleted stats; these are no longer in maps because
   // the matcher-pattern was established after they were created. Since the
   // stats are held by reference in code that expects them to be there, we
@@ -215,6 +215,14 @@ public:
     forEachTextReadout(f_size, f_stat);
   }
 
+  void forEachChangedSinkedCounter(SizeFn f_size, StatFn<Counter> f_stat) override {
+    alloc_.forEachChangedSinkedCounter(f_size, f_stat);
+  }
+
+  void forEachChangedSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) override {
+    alloc_.forEachChangedSinkedGauge(f_size, f_stat);
+  }
+
   void forEachSinkedHistogram(SizeFn f_size, StatFn<ParentHistogram> f_stat) const override {
     UNREFERENCED_PARAMETER(f_size);
     UNREFERENCED_PARAMETER(f_stat);
@@ -3,12 +3,15 @@
 #include <algorithm>
 #include <iostream>
 #include <memory>
+#include <tuple>
 #include <vector>
 
 #include "source/common/common/assert.h"
 #include "source/common/common/logger.h"
+#include "source/common/common/macros.h"
 #include "source/common/common/utility.h"
 
+#include "absl/hash/hash.h"
 #include "absl/strings/str_cat.h"
 
 namespace Envoy {
@@ -261,11 +264,8 @@ bool StatName::startsWith(StatName prefix) const {
 
 std::vector<absl::string_view> SymbolTable::decodeStrings(StatName stat_name) const {
   std::vector<absl::string_view> strings;
-  Thread::LockGuard lock(lock_);
   Encoding::decodeTokens(
-      stat_name,
-      [this, &strings](Symbol symbol)
-          ABSL_NO_THREAD_SAFETY_ANALYSIS { strings.push_back(fromSymbol(symbol)); },
+      stat_name, [this, &strings](Symbol symbol) { strings.push_back(fromSymbol(symbol)); },
       [&strings](absl::string_view str) { strings.push_back(str); });
   return strings;
 }
@@ -298,6 +298,19 @@ SymbolTable::~SymbolTable() {
   ASSERT(numSymbols() == 0);
 }
 
+SymbolTable::Shard::Shard() : table_(new EncodeTable(MinEncodeTableCapacity)) {}
+
+SymbolTable::Shard::~Shard() {
+  EncodeTable* table = table_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < table->capacity_; ++i) {
+    SharedSymbol* shared_symbol = table->slots_[i].load(std::memory_order_relaxed);
+    if (shared_symbol != nullptr && shared_symbol != &tombstone()) {
+      delete shared_symbol;
+    }
+  }
+  delete table;
+}
+
 // TODO(ambuc): There is a possible performance optimization here for avoiding
 // the encoding of IPs / numbers if they appear in stat names. We don't want to
 // waste time symbolizing an integer as an integer, if we can help it.
@@ -312,18 +325,20 @@ void SymbolTable::addTokensToEncoding(const absl::string_view name, Encoding& en
   std::vector<Symbol> symbols;
   symbols.reserve(tokens.size());
 
-  // Now take the lock and populate the Symbol objects, which involves bumping
-  // ref-counts in this.
-  {
+  num_lookups_.fetch_add(1, std::memory_order_relaxed);
+  if (track_recent_lookups_.load(std::memory_order_relaxed)) {
     Thread::LockGuard lock(lock_);
     recent_lookups_.lookup(name);
-    for (auto& token : tokens) {
-      // TODO(jmarantz): consider using StatNameDynamicStorage for tokens with
-      // length below some threshold, say 4 bytes. It might be preferable not to
-      // reserve Symbols for every 3 digit number found (for example) in ipv4
-      // addresses.
-      symbols.push_back(toSymbol(token));
-    }
+  }
+
+  // Now populate the Symbol objects, which involves bumping ref-counts, and only
+  // takes the lock of the shard of a token to create its symbol.
+  for (auto& token : tokens) {
+    // TODO(jmarantz): consider using StatNameDynamicStorage for tokens with
+    // length below some threshold, say 4 bytes. It might be preferable not to
+    // reserve Symbols for every 3 digit number found (for example) in ipv4
+    // addresses.
+    symbols.push_back(toSymbol(token));
   }
 
   // Now efficiently encode the array of 32-bit symbols into a uint8_t array.
@@ -331,9 +346,12 @@ void SymbolTable::addTokensToEncoding(const absl::string_view name, Encoding& en
 }
 
 uint64_t SymbolTable::numSymbols() const {
-  Thread::LockGuard lock(lock_);
-  ASSERT(encode_map_.size() == decode_map_.size());
-  return encode_map_.size();
+  uint64_t num_symbols = 0;
+  for (const Shard& shard : shards_) {
+    Thread::LockGuard lock(shard.lock_);
+    num_symbols += shard.num_symbols_;
+  }
+  return num_symbols;
 }
 
 std::string SymbolTable::toString(const StatName& stat_name) const {
@@ -341,49 +359,41 @@ std::string SymbolTable::toString(const StatName& stat_name) const {
 }
 
 void SymbolTable::incRefCount(const StatName& stat_name) {
-  // Before taking the lock, decode the array of symbols from the SymbolTable::Storage.
+  // Before taking any lock, decode the array of symbols from the SymbolTable::Storage.
   const SymbolVec symbols = Encoding::decodeSymbols(stat_name);
 
-  Thread::LockGuard lock(lock_);
   for (Symbol symbol : symbols) {
-    auto decode_search = decode_map_.find(symbol);
-
-    ASSERT(decode_search != decode_map_.end(),
-           "Please see "
-           "https://github.com/envoyproxy/envoy/blob/main/source/docs/stats.md#"
-           "debugging-symbol-table-assertions");
-    auto encode_search = encode_map_.find(decode_search->second->toStringView());
-    ASSERT(encode_search != encode_map_.end(),
+    // The caller holds a reference on the symbol, so it can be found and
+    // referenced without locking.
+    SharedSymbol* shared_symbol = decodeEntry(symbol).load(std::memory_order_acquire);
+    ASSERT(shared_symbol != nullptr,
            "Please see "
            "https://github.com/envoyproxy/envoy/blob/main/source/docs/stats.md#"
            "debugging-symbol-table-assertions");
-
-    ++encode_search->second.ref_count_;
+    ASSERT(shared_symbol->ref_count_.load(std::memory_order_relaxed) > 0);
+    shared_symbol->ref_count_.fetch_add(1, std::memory_order_relaxed);
   }
 }
 
 void SymbolTable::free(const StatName& stat_name) {
-  // Before taking the lock, decode the array of symbols from the SymbolTable::Storage.
+  // Before taking any lock, decode the array of symbols from the SymbolTable::Storage.
   const SymbolVec symbols = Encoding::decodeSymbols(stat_name);
 
-  Thread::LockGuard lock(lock_);
   for (Symbol symbol : symbols) {
-    auto decode_search = decode_map_.find(symbol);
-    ASSERT(decode_search != decode_map_.end());
-
-    auto encode_search = encode_map_.find(decode_search->second->toStringView());
-    ASSERT(encode_search != encode_map_.end());
-
-    // If that was the last remaining client usage of the symbol, erase the
-    // current mappings and add the now-unused symbol to the reuse pool.
-    //
-    // The "if (--EXPR.ref_count_)" pattern speeds up BM_CreateRace by 20% in
-    // symbol_table_speed_test.cc, relative to breaking out the decrement into a
-    // separate step, likely due to the non-trivial dereferences in EXPR.
-    if (--encode_search->second.ref_count_ == 0) {
-      decode_map_.erase(decode_search);
-      encode_map_.erase(encode_search);
-      pool_.push(symbol);
+    SharedSymbol* shared_symbol = decodeEntry(symbol).load(std::memory_order_acquire);
+    ASSERT(shared_symbol != nullptr);
+    Shard& shard = shardFor(shared_symbol->hash_);
+
+    // Once the count drops to zero, another thread may reference the symbol
+    // again, free it and remove it, so the read guard must be taken before
+    // decrementing to keep it from being deleted under us.
+    ReadGuard guard(shard);
+    if (shared_symbol->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // That was the last remaining client usage of the symbol: erase the
+      // current mappings and add the now-unused symbol to the reuse pool.
+      Thread::LockGuard lock(shard.lock_);
+      removeSymbol(shard, *shared_symbol);
+      reclaimRetired(shard, 1);
     }
   }
 }
@@ -399,7 +409,7 @@ uint64_t SymbolTable::getRecentLookups(const RecentLookupsFn& iter) const {
     recent_lookups_.forEach(
         [&name_count_map](absl::string_view str, uint64_t count)
             ABSL_NO_THREAD_SAFETY_ANALYSIS { name_count_map[std::string(str)] += count; });
-    total += recent_lookups_.total();
+    total += num_lookups_.load(std::memory_order_relaxed);
   }
 
   // Now we have the collated name-count map data: we need to vectorize and
@@ -446,11 +456,13 @@ DynamicSpans SymbolTable::getDynamicSpans(StatName stat_name) const {
 void SymbolTable::setRecentLookupCapacity(uint64_t capacity) {
   Thread::LockGuard lock(lock_);
   recent_lookups_.setCapacity(capacity);
+  track_recent_lookups_.store(capacity > 0, std::memory_order_relaxed);
 }
 
 void SymbolTable::clearRecentLookups() {
   Thread::LockGuard lock(lock_);
   recent_lookups_.clear();
+  num_lookups_.store(0, std::memory_order_relaxed);
 }
 
 uint64_t SymbolTable::recentLookupCapacity() const {
@@ -464,40 +476,201 @@ StatNameSetPtr SymbolTable::makeSet(absl::string_view name) {
   return stat_name_set;
 }
 
+SymbolTable::SharedSymbol& SymbolTable::tombstone() {
+  MUTABLE_CONSTRUCT_ON_FIRST_USE(SharedSymbol, 0, 0, nullptr);
+}
+
+SymbolTable::SharedSymbol* SymbolTable::findSymbol(const EncodeTable& table, size_t hash,
+                                                   absl::string_view sv) {
+  // The table is never more than half full, so the probe ends at an empty slot.
+  // Slot loads are sequentially consistent, pairing with the check of readers_
+  // in reclaimRetired().
+  const size_t mask = table.capacity_ - 1;
+  for (size_t i = (hash / NumShards) & mask;; i = (i + 1) & mask) {
+    SharedSymbol* shared_symbol = table.slots_[i].load();
+    if (shared_symbol == nullptr) {
+      return nullptr;
+    }
+    if (shared_symbol != &tombstone() && shared_symbol->hash_ == hash &&
+        shared_symbol->str_->toStringView() == sv) {
+      return shared_symbol;
+    }
+  }
+}
+
+bool SymbolTable::tryIncRefCount(SharedSymbol& shared_symbol) {
+  uint32_t ref_count = shared_symbol.ref_count_.load(std::memory_order_relaxed);
+  while (ref_count != 0) {
+    if (shared_symbol.ref_count_.compare_exchange_weak(ref_count, ref_count + 1,
+                                                       std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Symbol SymbolTable::toSymbol(absl::string_view sv) {
-  Symbol result;
-  auto encode_find = encode_map_.find(sv);
-  // If the string segment doesn't already exist,
-  if (encode_find == encode_map_.end()) {
-    // We create the actual string, place it in the decode_map_, and then insert
-    // a string_view pointing to it in the encode_map_. This allows us to only
-    // store the string once. We use unique_ptr so copies are not made as
-    // flat_hash_map moves values around.
-    InlineStringPtr str = InlineString::create(sv);
-    auto encode_insert = encode_map_.insert({str->toStringView(), SharedSymbol(next_symbol_)});
-    ASSERT(encode_insert.second);
-    auto decode_insert = decode_map_.insert({next_symbol_, std::move(str)});
-    ASSERT(decode_insert.second);
-
-    result = next_symbol_;
-    newSymbol();
-  } else {
-    // If the insertion didn't take place, return the actual value at that location and up the
-    // refcount at that location
-    result = encode_find->second.symbol_;
-    ++(encode_find->second.ref_count_);
+  const size_t hash = absl::Hash<absl::string_view>()(sv);
+  Shard& shard = shardFor(hash);
+  {
+    // Existing symbols are found and referenced without locking. A symbol whose
+    // count dropped to zero is being freed, and is left to the locked path.
+    ReadGuard guard(shard);
+    SharedSymbol* shared_symbol = findSymbol(*shard.table_.load(), hash, sv);
+    if (shared_symbol != nullptr && tryIncRefCount(*shared_symbol)) {
+      return shared_symbol->symbol_;
+    }
+  }
+
+  Thread::LockGuard lock(shard.lock_);
+  SharedSymbol* shared_symbol = findSymbol(*shard.table_.load(), hash, sv);
+  if (shared_symbol != nullptr) {
+    // A symbol still in the table whose count dropped to zero is referenced
+    // again. The thread which freed its last reference will find it in use when
+    // it gets the lock, and leave it.
+    shared_symbol->ref_count_.fetch_add(1, std::memory_order_relaxed);
+    return shared_symbol->symbol_;
+  }
+
+  // If the string segment doesn't already exist, we create the actual string
+  // once, owned by its SharedSymbol, and publish the symbol in both tables.
+  const Symbol symbol = allocateSymbol();
+  auto new_symbol = std::make_unique<SharedSymbol>(symbol, hash, InlineString::create(sv));
+  decodeEntry(symbol).store(new_symbol.get(), std::memory_order_release);
+  insertSymbol(shard, std::move(new_symbol));
+  return symbol;
+}
+
+void SymbolTable::insertSymbol(Shard& shard, SharedSymbolPtr shared_symbol) {
+  EncodeTable* table = shard.table_.load(std::memory_order_relaxed);
+  if ((shard.num_used_slots_ + 1) * 2 > table->capacity_) {
+    // Copy the symbols to a table at most a quarter full, dropping tombstones,
+    // and retire the previous table which readers may still be probing.
+    size_t capacity = MinEncodeTableCapacity;
+    while (capacity < (shard.num_symbols_ + 1) * 4) {
+      capacity *= 2;
+    }
+    auto new_table = std::make_unique<EncodeTable>(capacity);
+    const size_t new_mask = capacity - 1;
+    for (size_t i = 0; i < table->capacity_; ++i) {
+      SharedSymbol* moved = table->slots_[i].load(std::memory_order_relaxed);
+      if (moved != nullptr && moved != &tombstone()) {
+        for (size_t j = (moved->hash_ / NumShards) & new_mask;; j = (j + 1) & new_mask) {
+          if (new_table->slots_[j].load(std::memory_order_relaxed) == nullptr) {
+            new_table->slots_[j].store(moved, std::memory_order_relaxed);
+            break;
+          }
+        }
+      }
+    }
+    shard.retired_tables_.emplace_back(table);
+    table = new_table.release();
+    shard.table_.store(table);
+    shard.num_used_slots_ = shard.num_symbols_;
+    reclaimRetired(shard, 0);
+  }
+
+  // The caller found no symbol for the string, so the first empty or tombstoned
+  // slot of its probe sequence is free for it.
+  const size_t mask = table->capacity_ - 1;
+  for (size_t i = (shared_symbol->hash_ / NumShards) & mask;; i = (i + 1) & mask) {
+    SharedSymbol* slot = table->slots_[i].load(std::memory_order_relaxed);
+    if (slot == nullptr || slot == &tombstone()) {
+      shard.num_used_slots_ += slot == nullptr ? 1 : 0;
+      ++shard.num_symbols_;
+      table->slots_[i].store(shared_symbol.release(), std::memory_order_release);
+      return;
+    }
   }
-  return result;
 }
 
-absl::string_view SymbolTable::fromSymbol(const Symbol symbol) const
-    ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
-  auto search = decode_map_.find(symbol);
-  RELEASE_ASSERT(search != decode_map_.end(), "no such symbol");
-  return search->second->toStringView();
+void SymbolTable::removeSymbol(Shard& shard, SharedSymbol& shared_symbol) {
+  if (shared_symbol.ref_count_.load(std::memory_order_relaxed) != 0) {
+    return; // Referenced again by toSymbol() before we got the lock.
+  }
+
+  // The symbol may also have been referenced again, freed and removed by
+  // another thread. It cannot have been deleted, as the caller holds a read
+  // guard, so it is still in the table if and only if its slot is found.
+  EncodeTable& table = *shard.table_.load(std::memory_order_relaxed);
+  const size_t mask = table.capacity_ - 1;
+  for (size_t i = (shared_symbol.hash_ / NumShards) & mask;; i = (i + 1) & mask) {
+    SharedSymbol* slot = table.slots_[i].load(std::memory_order_relaxed);
+    if (slot == nullptr) {
+      return;
+    }
+    if (slot == &shared_symbol) {
+      table.slots_[i].store(&tombstone());
+      break;
+    }
+  }
+  --shard.num_symbols_;
+  releaseSymbol(shared_symbol.symbol_);
+  shard.retired_symbols_.emplace_back(&shared_symbol);
+}
+
+void SymbolTable::reclaimRetired(Shard& shard, uint32_t own_readers) {
+  // Retired objects were unpublished before this sequentially consistent load,
+  // so if no other reader is registered, any later reader will not find them.
+  // Otherwise they are left for a later insertion or removal.
+  if (shard.readers_.load() == own_readers) {
+    shard.retired_tables_.clear();
+    shard.retired_symbols_.clear();
+  }
+}
+
+std::atomic<SymbolTable::SharedSymbol*>& SymbolTable::decodeEntry(Symbol symbol) const {
+  const DecodeIndex* index = decode_index_.load(std::memory_order_acquire);
+  const uint32_t block_index = symbol >> DecodeBlockBits;
+  RELEASE_ASSERT(index != nullptr && block_index < index->num_blocks_, "no such symbol");
+  DecodeBlock* block = index->blocks_[block_index].load(std::memory_order_acquire);
+  RELEASE_ASSERT(block != nullptr, "no such symbol");
+  return (*block)[symbol & (DecodeBlockSize - 1)];
 }
 
-void SymbolTable::newSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+absl::string_view SymbolTable::fromSymbol(const Symbol symbol) const {
+  const SharedSymbol* shared_symbol = decodeEntry(symbol).load(std::memory_order_acquire);
+  RELEASE_ASSERT(shared_symbol != nullptr, "no such symbol");
+  return shared_symbol->str_->toStringView();
+}
+
+Symbol SymbolTable::allocateSymbol() {
+  Thread::LockGuard lock(alloc_lock_);
+  const Symbol symbol = next_symbol_;
+  const uint32_t block_index = symbol >> DecodeBlockBits;
+  DecodeIndex* index = decode_index_.load(std::memory_order_relaxed);
+  if (index == nullptr || block_index >= index->num_blocks_) {
+    // Publish a copy of the index with twice as many blocks. Readers of the
+    // previous index only decode symbols of the blocks it already has.
+    size_t num_blocks = index == nullptr ? MinDecodeBlocks : index->num_blocks_ * 2;
+    while (block_index >= num_blocks) {
+      num_blocks *= 2;
+    }
+    auto new_index = std::make_unique<DecodeIndex>(num_blocks);
+    for (size_t i = 0; index != nullptr && i < index->num_blocks_; ++i) {
+      new_index->blocks_[i].store(index->blocks_[i].load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+    }
+    index = new_index.get();
+    decode_indexes_.push_back(std::move(new_index));
+    decode_index_.store(index, std::memory_order_release);
+  }
+  std::atomic<DecodeBlock*>& block = index->blocks_[block_index];
+  if (block.load(std::memory_order_relaxed) == nullptr) {
+    decode_blocks_.push_back(std::make_unique<DecodeBlock>());
+    block.store(decode_blocks_.back().get(), std::memory_order_release);
+  }
+  newSymbol();
+  return symbol;
+}
+
+void SymbolTable::releaseSymbol(Symbol symbol) {
+  Thread::LockGuard lock(alloc_lock_);
+  decodeEntry(symbol).store(nullptr, std::memory_order_relaxed);
+  pool_.push(symbol);
+}
+
+void SymbolTable::newSymbol() {
   if (pool_.empty()) {
     next_symbol_ = ++monotonic_counter_;
   } else {
@@ -509,15 +682,6 @@ void SymbolTable::newSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
 }
 
 bool SymbolTable::lessThan(const StatName& a, const StatName& b) const {
-  // Proactively take the table lock in anticipation that we'll need to
-  // convert at least one symbol to a string_view, and it's easier not to
-  // bother to lazily take the lock.
-  Thread::LockGuard lock(lock_);
-  return lessThanLockHeld(a, b);
-}
-
-bool SymbolTable::lessThanLockHeld(const StatName& a, const StatName& b) const
-    ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
   Encoding::TokenIter a_iter(a), b_iter(b);
   while (true) {
     Encoding::TokenIter::TokenType a_type = a_iter.next();
@@ -547,16 +711,21 @@ bool SymbolTable::lessThanLockHeld(const StatName& a, const StatName& b) const
 
 #ifndef ENVOY_CONFIG_COVERAGE
 void SymbolTable::debugPrint() const {
-  Thread::LockGuard lock(lock_);
-  std::vector<Symbol> symbols;
-  for (const auto& p : decode_map_) {
-    symbols.push_back(p.first);
+  std::vector<std::tuple<Symbol, std::string, uint32_t>> symbols;
+  for (const Shard& shard : shards_) {
+    Thread::LockGuard lock(shard.lock_);
+    const EncodeTable& table = *shard.table_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < table.capacity_; ++i) {
+      const SharedSymbol* shared_symbol = table.slots_[i].load(std::memory_order_relaxed);
+      if (shared_symbol != nullptr && shared_symbol != &tombstone()) {
+        symbols.emplace_back(shared_symbol->symbol_, shared_symbol->str_->toString(),
+                             shared_symbol->ref_count_.load(std::memory_order_relaxed));
+      }
+    }
   }
   std::sort(symbols.begin(), symbols.end());
-  for (Symbol symbol : symbols) {
-    const InlineString& token = *decode_map_.find(symbol)->second;
-    const SharedSymbol& shared_symbol = encode_map_.find(token.toStringView())->second;
-    ENVOY_LOG_MISC(info, "{}: '{}' ({})", symbol, token.toStringView(), shared_symbol.ref_count_);
+  for (const auto& [symbol, token, ref_count] : symbols) {
+    ENVOY_LOG_MISC(info, "{}: '{}' ({})", symbol, token, ref_count);
   }
 }
 #endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <stack>
 #include <string>
@@ -14,6 +16,7 @@
 #include "source/common/common/utility.h"
 #include "source/common/stats/recent_lookups.h"
 
+#include "absl/base/optimization.h"
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
@@ -72,6 +75,15 @@ using SymbolVec = std::vector<Symbol>;
  * that if a string is encoded, the resulting stat is destroyed, and then that
  * same string is re-encoded, it may or may not encode to the same underlying
  * symbol.
+ *
+ * Symbols are sharded by the hash of their string. Encoding names made of
+ * existing tokens takes no lock: each shard's hash table is probed without
+ * locking and reference counts are atomic. A shard's lock is only taken to
+ * create or remove a symbol.
+ * Decoding symbols to strings, as done by toString() and the comparisons, takes
+ * no lock at all: each live symbol's string is published in a decode table
+ * which is read without synchronization, as any StatName being decoded holds a
+ * reference on its symbols, keeping them alive.
  */
 class SymbolTable final {
 public:
@@ -324,8 +336,6 @@ public:
    */
   DynamicSpans getDynamicSpans(StatName stat_name) const;
 
-  bool lessThanLockHeld(const StatName& a, const StatName& b) const;
-
   template <class GetStatName, class Obj> struct StatNameCompare {
     StatNameCompare(const SymbolTable& symbol_table, GetStatName getter)
         : symbol_table_(symbol_table), getter_(getter) {}
@@ -337,9 +347,8 @@ public:
   };
 
   /**
-   * Sorts a range by StatName. This API is more efficient than
-   * calling std::sort directly as it takes a single lock for the
-   * entire sort, rather than locking on each comparison.
+   * Sorts a range by StatName. Comparisons decode symbols without locking, so
+   * this is equivalent to calling std::sort with StatNameLessThan.
    *
    * @param begin the beginning of the range to sort
    * @param end the end of the range to sort
@@ -347,9 +356,6 @@ public:
    */
   template <class Obj, class Iter, class GetStatName>
   void sortByStatNames(Iter begin, Iter end, GetStatName get_stat_name) const {
-    // Grab the lock once before sorting begins, so we don't have to re-take
-    // it on every comparison.
-    Thread::LockGuard lock(lock_);
     StatNameCompare<GetStatName, Obj> compare(*this, get_stat_name);
     std::sort(begin, end, compare);
   }
@@ -395,14 +401,90 @@ private:
    */
   void incRefCount(const StatName& stat_name);
 
+  // The symbol, reference count and string of a token. Symbols are allocated
+  // on the heap so that they can be found and referenced without locking, from
+  // both the encode table of their shard and the decode table.
   struct SharedSymbol {
-    SharedSymbol(Symbol symbol) : symbol_(symbol) {}
+    SharedSymbol(Symbol symbol, size_t hash, InlineStringPtr str)
+        : symbol_(symbol), hash_(hash), str_(std::move(str)) {}
+
+    const Symbol symbol_;
+    const size_t hash_; // Hash of the string, selecting the shard and the encode table slot.
+    const InlineStringPtr str_;
+    // Once the count drops to zero, it is only raised again under the shard lock.
+    std::atomic<uint32_t> ref_count_{1};
+  };
+  using SharedSymbolPtr = std::unique_ptr<SharedSymbol>;
+
+  // An open-addressing hash table of the symbols of a shard, probed linearly
+  // from the hash of their string. It is only written under the shard lock, and
+  // is read without locking to find existing symbols. A slot is only ever
+  // filled, or replaced by the tombstone when its symbol is removed, so that
+  // concurrent probes are never cut short. The table is replaced by a compacted
+  // copy, rather than rehashed in place, when it fills up.
+  struct EncodeTable {
+    explicit EncodeTable(size_t capacity)
+        : capacity_(capacity), slots_(new std::atomic<SharedSymbol*>[capacity]()) {}
+
+    const size_t capacity_; // A power of two.
+    const std::unique_ptr<std::atomic<SharedSymbol*>[]> slots_;
+  };
+  using EncodeTablePtr = std::unique_ptr<EncodeTable>;
+  static constexpr size_t MinEncodeTableCapacity = 16;
+
+  // A shard of the symbols, selected by the hash of their string. Existing
+  // symbols are found and referenced without locking. The shard's lock must be
+  // held to create a symbol, to reference a symbol whose count dropped to zero,
+  // and to remove one.
+  //
+  // Readers announce themselves in readers_ while they may hold pointers into
+  // the encode table. Tables and symbols removed by writers are retired rather
+  // than deleted, and only freed once no reader may still see them.
+  struct ABSL_CACHELINE_ALIGNED Shard {
+    Shard();
+    ~Shard();
+
+    mutable Thread::MutexBasicLockable lock_;
+    std::atomic<EncodeTable*> table_;
+    mutable std::atomic<uint32_t> readers_{0};
+    size_t num_symbols_ ABSL_GUARDED_BY(lock_){0};
+    size_t num_used_slots_ ABSL_GUARDED_BY(lock_){0}; // Symbols plus tombstones.
+    std::vector<EncodeTablePtr> retired_tables_ ABSL_GUARDED_BY(lock_);
+    std::vector<SharedSymbolPtr> retired_symbols_ ABSL_GUARDED_BY(lock_);
+  };
+  static constexpr uint32_t NumShards = 16;
+
+  // Registers a reader of a shard for its lifetime.
+  class ReadGuard {
+  public:
+    explicit ReadGuard(const Shard& shard) : shard_(shard) { shard_.readers_.fetch_add(1); }
+    ~ReadGuard() { shard_.readers_.fetch_sub(1, std::memory_order_release); }
+
+  private:
+    const Shard& shard_;
+  };
 
-    Symbol symbol_;
-    uint32_t ref_count_{1};
+  // The decode table maps symbols to their SharedSymbol. It is a two-level
+  // array, as symbols are dense, whose blocks are allocated as the symbol
+  // counter grows. The index of blocks is replaced by a copy twice its size
+  // when it fills up; previous indexes are kept until the table is destroyed,
+  // which at most doubles their footprint, so that readers never need a lock.
+  // An entry is set when its symbol is created, before any StatName refers to
+  // it, and cleared when the last reference to its symbol is freed. So it can be
+  // read without locking by any thread holding a reference on the symbol.
+  static constexpr uint32_t DecodeBlockBits = 11;
+  static constexpr uint32_t DecodeBlockSize = 1 << DecodeBlockBits;
+  static constexpr uint32_t MinDecodeBlocks = 16;
+  using DecodeBlock = std::array<std::atomic<SharedSymbol*>, DecodeBlockSize>;
+  struct DecodeIndex {
+    explicit DecodeIndex(size_t num_blocks)
+        : num_blocks_(num_blocks), blocks_(new std::atomic<DecodeBlock*>[num_blocks]()) {}
+
+    const size_t num_blocks_;
+    const std::unique_ptr<std::atomic<DecodeBlock*>[]> blocks_;
   };
 
-  // This must be held during both encode() and free().
+  // Guards recent_lookups_.
   mutable Thread::MutexBasicLockable lock_;
 
   /**
@@ -426,20 +508,94 @@ private:
    * @param sv the individual string to be encoded as a symbol.
    * @return Symbol the encoded string.
    */
-  Symbol toSymbol(absl::string_view sv) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  Symbol toSymbol(absl::string_view sv);
 
   /**
-   * Convenience function for decode(), decoding one symbol at a time.
+   * Convenience function for decode(), decoding one symbol at a time. This does
+   * not lock, and must only be called with a reference held on the symbol.
    *
    * @param symbol the individual symbol to be decoded.
    * @return absl::string_view the decoded string.
    */
-  absl::string_view fromSymbol(Symbol symbol) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  absl::string_view fromSymbol(Symbol symbol) const;
+
+  /**
+   * @return the shard holding the symbols whose string has the given hash.
+   */
+  Shard& shardFor(size_t hash) const { return shards_[hash % NumShards]; }
+
+  /**
+   * @return the marker of the encode table slots whose symbol was removed.
+   */
+  static SharedSymbol& tombstone();
+
+  /**
+   * Finds the symbol of a string in an encode table. Must be called either with
+   * the shard lock held, or with a ReadGuard on the shard.
+   *
+   * @param table the encode table of the shard.
+   * @param hash the hash of the string.
+   * @param sv the string.
+   * @return the symbol, or nullptr if the string has none.
+   */
+  static SharedSymbol* findSymbol(const EncodeTable& table, size_t hash, absl::string_view sv);
+
+  /**
+   * Adds a reference to a symbol, unless its count has dropped to zero.
+   *
+   * @return whether a reference was added.
+   */
+  static bool tryIncRefCount(SharedSymbol& shared_symbol);
+
+  /**
+   * Adds a new symbol to the encode table of its shard, growing or compacting
+   * the table as needed.
+   */
+  void insertSymbol(Shard& shard, SharedSymbolPtr shared_symbol)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.lock_);
+
+  /**
+   * Removes a symbol whose count dropped to zero from the encode table of its
+   * shard, and releases it, unless it was referenced again or already removed.
+   */
+  void removeSymbol(Shard& shard, SharedSymbol& shared_symbol)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.lock_);
+
+  /**
+   * Frees the retired tables and symbols of a shard if no other thread is
+   * reading it.
+   *
+   * @param shard the shard.
+   * @param own_readers the number of ReadGuards held on the shard by the caller.
+   */
+  static void reclaimRetired(Shard& shard, uint32_t own_readers)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.lock_);
+
+  /**
+   * Reserves the symbol for a new string, allocating its decode table entry.
+   * The caller publishes the symbol in the entry.
+   *
+   * @return the new symbol.
+   */
+  Symbol allocateSymbol();
+
+  /**
+   * Clears the decode entry of a symbol whose last reference was freed, and
+   * makes it available for re-use.
+   *
+   * @param symbol the symbol to release.
+   */
+  void releaseSymbol(Symbol symbol);
+
+  /**
+   * @return the decode table entry of a symbol, whose block must be allocated.
+   */
+  std::atomic<SharedSymbol*>& decodeEntry(Symbol symbol) const;
 
   /**
    * Stages a new symbol for use. To be called after a successful insertion.
    */
-  void newSymbol();
+  void newSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_lock_);
 
   /**
    * Tokenizes name, finds or allocates symbols for each token, and adds them
@@ -451,29 +607,39 @@ private:
   void addTokensToEncoding(absl::string_view name, Encoding& encoding);
 
   Symbol monotonicCounter() {
-    Thread::LockGuard lock(lock_);
+    Thread::LockGuard lock(alloc_lock_);
     return monotonic_counter_;
   }
 
+  mutable std::array<Shard, NumShards> shards_;
+
+  // Guards the allocation and release of symbols. This is only taken while
+  // holding a shard lock, when a string is first encoded or its last reference
+  // is freed.
+  Thread::MutexBasicLockable alloc_lock_;
+
   // Stores the symbol to be used at next insertion. This should exist ahead of insertion time so
   // that if insertion succeeds, the value written is the correct one.
-  Symbol next_symbol_ ABSL_GUARDED_BY(lock_);
+  Symbol next_symbol_ ABSL_GUARDED_BY(alloc_lock_);
 
   // If the free pool is exhausted, we monotonically increase this counter.
-  Symbol monotonic_counter_;
-
-  // Bitmap implementation.
-  // The encode map stores both the symbol and the ref count of that symbol.
-  // Using absl::string_view lets us only store the complete string once, in the decode map.
-  using EncodeMap = absl::flat_hash_map<absl::string_view, SharedSymbol>;
-  using DecodeMap = absl::flat_hash_map<Symbol, InlineStringPtr>;
-  EncodeMap encode_map_ ABSL_GUARDED_BY(lock_);
-  DecodeMap decode_map_ ABSL_GUARDED_BY(lock_);
+  Symbol monotonic_counter_ ABSL_GUARDED_BY(alloc_lock_);
 
   // Free pool of symbols for re-use.
   // TODO(ambuc): There might be an optimization here relating to storing ranges of freed symbols
   // using an Envoy::IntervalSet.
-  std::stack<Symbol> pool_ ABSL_GUARDED_BY(lock_);
+  std::stack<Symbol> pool_ ABSL_GUARDED_BY(alloc_lock_);
+
+  // Blocks and indexes are only added, under alloc_lock_, and are freed with the
+  // table. decode_index_ points to the latest index.
+  std::vector<std::unique_ptr<DecodeBlock>> decode_blocks_ ABSL_GUARDED_BY(alloc_lock_);
+  std::vector<std::unique_ptr<DecodeIndex>> decode_indexes_ ABSL_GUARDED_BY(alloc_lock_);
+  std::atomic<DecodeIndex*> decode_index_{nullptr};
+
+  // Counts all lookups, while recent_lookups_ only remembers them when its
+  // capacity is non-zero, so that lookups only take lock_ when tracking them.
+  std::atomic<uint64_t> num_lookups_{0};
+  std::atomic<bool> track_recent_lookups_{false};
   RecentLookups recent_lookups_ ABSL_GUARDED_BY(lock_);
 };
 
@@ -1065,7 +1231,7 @@ template <class GetStatName, class Obj>
 bool SymbolTable::StatNameCompare<GetStatName, Obj>::operator()(const Obj& a, const Obj& b) const {
   StatName a_stat_name = getter_(a);
   StatName b_stat_name = getter_(b);
-  return symbol_table_.lessThanLockHeld(a_stat_name, b_stat_name);
+  return symbol_table_.lessThan(a_stat_name, b_stat_name);
 }
 
 using SymbolTablePtr = std::unique_ptr<SymbolTable>;
@@ -37,7 +37,11 @@ public:
                            const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table);
   ~ThreadLocalHistogramImpl() override;
 
-  void merge(histogram_t* target);
+  /**
+   * Merges the buffer that was swapped out by beginMerge() into target and clears it.
+   * @return true if the buffer held any values.
+   */
+  bool merge(histogram_t* target);
 
   /**
    * Called in the beginning of merge process. Swaps the histogram used for collection so that we do
@@ -67,6 +71,10 @@ private:
   uint64_t otherHistogramIndex() const { return 1 - current_active_; }
   uint64_t current_active_{0};
   histogram_t* histograms_[2];
+  // Whether each buffer received values since it was last merged. Like histograms_, these are
+  // written by the worker while the buffer is active and read by the main thread once
+  // beginMerge() has swapped it out, so idle histograms can skip the merge entirely.
+  bool has_values_[2]{false, false};
   std::atomic<bool> used_;
   std::thread::id created_thread_id_;
   SymbolTable& symbol_table_;
@@ -138,6 +146,8 @@ private:
   histogram_t* cumulative_histogram_;
   HistogramStatisticsImpl interval_statistics_;
   HistogramStatisticsImpl cumulative_statistics_;
+  // Whether the last merge added any values to interval_histogram_.
+  bool interval_has_values_{false};
   mutable Thread::MutexBasicLockable merge_lock_;
   std::list<TlsHistogramSharedPtr> tls_histograms_ ABSL_GUARDED_BY(merge_lock_);
   bool merged_{false};
@@ -203,6 +213,8 @@ public:
   void forEachSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) const override;
   void forEachSinkedTextReadout(SizeFn f_size, StatFn<TextReadout> f_stat) const override;
   void forEachSinkedHistogram(SizeFn f_size, StatFn<ParentHistogram> f_stat) const override;
+  void forEachChangedSinkedCounter(SizeFn f_size, StatFn<Counter> f_stat) override;
+  void forEachChangedSinkedGauge(SizeFn f_size, StatFn<Gauge> f_stat) override;
 
   void setSinkPredicates(std::unique_ptr<SinkPredicates>&& sink_predicates) override;
   OptRef<SinkPredicates> sinkPredicates() override { return sink_predicates_; }
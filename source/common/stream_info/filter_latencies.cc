@@ -0,0 +1,105 @@
+#include "source/common/stream_info/filter_latencies.h"
+
+#include "source/common/common/assert.h"
+#include "source/common/protobuf/protobuf.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace StreamInfo {
+
+namespace {
+
+int64_t toMicroseconds(std::chrono::nanoseconds time) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+}
+
+constexpr std::array<FilterLatencies::Phase, FilterLatencies::NumPhases> AllPhases{
+    FilterLatencies::Phase::RouteMatch, FilterLatencies::Phase::HostSelection,
+    FilterLatencies::Phase::PoolWait, FilterLatencies::Phase::CodecEncode};
+
+} // namespace
+
+absl::string_view FilterLatencies::phaseName(Phase phase) {
+  switch (phase) {
+  case Phase::RouteMatch:
+    return "route_match";
+  case Phase::HostSelection:
+    return "host_selection";
+  case Phase::PoolWait:
+    return "pool_wait";
+  case Phase::CodecEncode:
+    return "codec_encode";
+  }
+  PANIC_DUE_TO_CORRUPT_ENUM;
+}
+
+absl::optional<std::chrono::nanoseconds>
+FilterLatencies::filterTime(absl::string_view filter_name) const {
+  for (size_t i = 0; i < filter_names_.size(); i++) {
+    if (filter_times_[i].in_chain_ && filter_names_[i] == filter_name) {
+      return filter_times_[i].decode_time_ + filter_times_[i].encode_time_;
+    }
+  }
+  return absl::nullopt;
+}
+
+ProtobufTypes::MessagePtr FilterLatencies::serializeAsProto() const {
+  auto message = std::make_unique<ProtobufWkt::Struct>();
+  auto& filters = *(*message->mutable_fields())["filters"].mutable_struct_value()->mutable_fields();
+  for (size_t i = 0; i < filter_names_.size(); i++) {
+    if (!filter_times_[i].in_chain_) {
+      continue;
+    }
+    auto& fields = *filters[filter_names_[i]].mutable_struct_value()->mutable_fields();
+    fields["decode_us"].set_number_value(toMicroseconds(filter_times_[i].decode_time_));
+    fields["encode_us"].set_number_value(toMicroseconds(filter_times_[i].encode_time_));
+  }
+  auto& phases = *(*message->mutable_fields())["phases"].mutable_struct_value()->mutable_fields();
+  for (const Phase phase : AllPhases) {
+    if (const auto time = phaseTime(phase); time.has_value()) {
+      phases[absl::StrCat(phaseName(phase), "_us")].set_number_value(toMicroseconds(*time));
+    }
+  }
+  return message;
+}
+
+absl::optional<std::string> FilterLatencies::serializeAsString() const {
+  // Formatted as a list of NAME:DECODE_US:ENCODE_US entries in filter chain order, followed by a
+  // list of PHASE:US entries for the phases the stream reached.
+  std::string out;
+  for (size_t i = 0; i < filter_names_.size(); i++) {
+    if (filter_times_[i].in_chain_) {
+      absl::StrAppend(&out, out.empty() ? "" : ",", filter_names_[i], ":",
+                      toMicroseconds(filter_times_[i].decode_time_), ":",
+                      toMicroseconds(filter_times_[i].encode_time_));
+    }
+  }
+  absl::string_view separator = ";";
+  for (const Phase phase : AllPhases) {
+    if (const auto time = phaseTime(phase); time.has_value()) {
+      absl::StrAppend(&out, separator, phaseName(phase), ":", toMicroseconds(*time));
+      separator = ",";
+    }
+  }
+  return out;
+}
+
+FilterState::Object::FieldType FilterLatencies::getField(absl::string_view field_name) const {
+  if (const auto time = filterTime(field_name); time.has_value()) {
+    return toMicroseconds(time.value());
+  }
+  for (const Phase phase : AllPhases) {
+    if (field_name == phaseName(phase)) {
+      const auto time = phaseTime(phase);
+      if (!time.has_value()) {
+        return absl::monostate{};
+      }
+      return toMicroseconds(time.value());
+    }
+  }
+  return absl::monostate{};
+}
+
+} // namespace StreamInfo
+} // namespace Envoy
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/stream_info/filter_state.h"
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+
+namespace Envoy {
+namespace StreamInfo {
+
+/*
+ * A FilterState object that records how long each HTTP filter of a stream spent in its decode and
+ * encode callbacks, and how long the stream spent in a few phases outside of the filters. Time
+ * spent in callbacks and phases nested in another filter's callback, e.g. the encode callbacks run
+ * by a local reply, is subtracted from the outer filter's time.
+ */
+class FilterLatencies : public FilterState::Object {
+public:
+  // The phases of a stream which are timed besides the filter callbacks.
+  enum class Phase : uint8_t {
+    RouteMatch,
+    HostSelection,
+    PoolWait,
+    CodecEncode,
+  };
+  static constexpr size_t NumPhases = 4;
+
+  // The index of a filter whose latencies are not recorded.
+  static constexpr uint32_t NoFilter = std::numeric_limits<uint32_t>::max();
+
+  struct FilterTimes {
+    std::chrono::nanoseconds decode_time_{};
+    std::chrono::nanoseconds encode_time_{};
+    // Whether the filter is part of the stream's filter chain.
+    bool in_chain_{};
+  };
+
+  // The start of a timed filter callback or phase.
+  struct Timing {
+    MonotonicTime start_;
+    std::chrono::nanoseconds outer_nested_time_;
+  };
+
+  /**
+   * @param filter_names supplies the names of the filters which may be timed, indexed by the
+   *        filter indexes passed to the other methods. They must outlive this object.
+   */
+  explicit FilterLatencies(absl::Span<const std::string> filter_names)
+      : filter_names_(filter_names), filter_times_(filter_names.size()) {}
+
+  static const std::string& key() {
+    CONSTRUCT_ON_FIRST_USE(std::string, "envoy.http.filter_latencies");
+  }
+
+  /**
+   * @return the name of the given stream phase.
+   */
+  static absl::string_view phaseName(Phase phase);
+
+  /**
+   * Marks a filter as part of the stream's filter chain.
+   */
+  void addFilter(uint32_t index) {
+    if (index != NoFilter) {
+      filter_times_[index].in_chain_ = true;
+    }
+  }
+
+  void addDecodeTime(uint32_t index, std::chrono::nanoseconds time) {
+    if (index != NoFilter) {
+      filter_times_[index].decode_time_ += time;
+    }
+  }
+  void addEncodeTime(uint32_t index, std::chrono::nanoseconds time) {
+    if (index != NoFilter) {
+      filter_times_[index].encode_time_ += time;
+    }
+  }
+  void addPhaseTime(Phase phase, std::chrono::nanoseconds time) {
+    auto& phase_time = phase_times_[static_cast<size_t>(phase)];
+    phase_time = phase_time.value_or(std::chrono::nanoseconds(0)) + time;
+  }
+
+  /**
+   * Starts timing a filter callback or phase. The time of the timings started and finished before
+   * it finishes is subtracted from its own.
+   */
+  Timing startTiming(MonotonicTime now) {
+    const Timing timing{now, nested_time_};
+    nested_time_ = {};
+    open_timings_++;
+    return timing;
+  }
+
+  /**
+   * @return the time since the timing started, less the time of the timings nested in it.
+   */
+  std::chrono::nanoseconds finishTiming(const Timing& timing, MonotonicTime now) {
+    const std::chrono::nanoseconds elapsed = now - timing.start_;
+    const std::chrono::nanoseconds own_time = elapsed - nested_time_;
+    nested_time_ = timing.outer_nested_time_ + elapsed;
+    open_timings_--;
+    return own_time;
+  }
+
+  /**
+   * @return whether a timing has been started and not finished yet.
+   */
+  bool timing() const { return open_timings_ > 0; }
+
+  absl::Span<const std::string> filterNames() const { return filter_names_; }
+  const FilterTimes& filterTimes(uint32_t index) const { return filter_times_[index]; }
+
+  /**
+   * @return the time the stream spent in the given phase, or nullopt if it did not reach it.
+   */
+  absl::optional<std::chrono::nanoseconds> phaseTime(Phase phase) const {
+    return phase_times_[static_cast<size_t>(phase)];
+  }
+
+  /**
+   * @return the total time the named filter spent in its decode and encode callbacks, or nullopt
+   *         if the filter is not part of the stream's filter chain.
+   */
+  absl::optional<std::chrono::nanoseconds> filterTime(absl::string_view filter_name) const;
+
+  // From FilterState::Object
+  ProtobufTypes::MessagePtr serializeAsProto() const override;
+  absl::optional<std::string> serializeAsString() const override;
+  bool hasFieldSupport() const override { return true; }
+  FieldType getField(absl::string_view field_name) const override;
+
+private:
+  const absl::Span<const std::string> filter_names_;
+  absl::InlinedVector<FilterTimes, 8> filter_times_;
+  std::array<absl::optional<std::chrono::nanoseconds>, NumPhases> phase_times_;
+  // The time of the finished timings nested in the innermost open one.
+  std::chrono::nanoseconds nested_time_{};
+  uint32_t open_timings_{};
+};
+
+} // namespace StreamInfo
+} // namespace Envoy
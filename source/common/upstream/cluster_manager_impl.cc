@@ -5,6 +5,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "envoy/admin/v3/config_dump.pb.h"
@@ -43,6 +44,8 @@
 #include "source/common/upstream/load_balancer_context_base.h"
 #include "source/common/upstream/priority_conn_pool_map_impl.h"
 
+#include "absl/container/flat_hash_set.h"
+
 #ifdef ENVOY_ENABLE_QUIC
 #include "source/common/http/conn_pool_grid.h"
 #include "source/common/http/http3/conn_pool.h"
@@ -336,6 +339,12 @@ ClusterManagerImpl::ClusterManagerImpl(
       init_helper_(*this,
                    [this](ClusterManagerCluster& cluster) { return onClusterInit(cluster); }),
       time_source_(main_thread_dispatcher.timeSource()), dispatcher_(main_thread_dispatcher),
+      thread_local_update_batch_window_(PROTOBUF_GET_MS_OR_DEFAULT(
+          bootstrap.cluster_manager(), thread_local_update_batch_window, 0)),
+      deferred_cluster_idle_timeout_(
+          deferred_cluster_creation_ ? PROTOBUF_GET_MS_OR_DEFAULT(bootstrap.cluster_manager(),
+                                                                  deferred_cluster_idle_timeout, 0)
+                                     : 0),
       http_context_(http_context), validation_context_(validation_context),
       router_context_(router_context), cluster_stat_names_(stats.symbolTable()),
       cluster_config_update_stat_names_(stats.symbolTable()),
@@ -350,6 +359,10 @@ ClusterManagerImpl::ClusterManagerImpl(
               const envoy::config::cluster::v3::Cluster::CommonLbConfig, MessageUtil, MessageUtil>>(
               main_thread_dispatcher)),
       shutdown_(false) {
+  if (thread_local_update_batch_window_.count() > 0) {
+    thread_local_update_batch_timer_ =
+        dispatcher_.createTimer([this]() -> void { flushThreadLocalClusterUpdates(); });
+  }
   if (admin.has_value()) {
     config_tracker_entry_ = admin->getConfigTracker().add(
         "clusters", [this](const Matchers::StringMatcher& name_matcher) {
@@ -701,7 +714,8 @@ ThreadLocalClusterManagerStats
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::generateStats(Stats::Scope& scope,
                                                                  const std::string& thread_name) {
   const std::string final_prefix = absl::StrCat("thread_local_cluster_manager.", thread_name);
-  return {ALL_THREAD_LOCAL_CLUSTER_MANAGER_STATS(POOL_GAUGE_PREFIX(scope, final_prefix))};
+  return {ALL_THREAD_LOCAL_CLUSTER_MANAGER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                                 POOL_GAUGE_PREFIX(scope, final_prefix))};
 }
 
 absl::Status ClusterManagerImpl::onClusterInit(ClusterManagerCluster& cm_cluster) {
@@ -965,6 +979,7 @@ void ClusterManagerImpl::clusterWarmingToActive(const std::string& cluster_name)
   // If the cluster is being updated, we need to cancel any pending merged updates.
   // Otherwise, applyUpdates() will fire with a dangling cluster reference.
   updates_map_.erase(cluster_name);
+  cancelPendingThreadLocalClusterUpdate(cluster_name);
 
   active_clusters_[cluster_name] = std::move(warming_it->second);
   warming_clusters_.erase(warming_it);
@@ -1016,6 +1031,7 @@ bool ClusterManagerImpl::removeCluster(const std::string& cluster_name, const bo
     updateClusterCounts();
     // Cancel any pending merged updates.
     updates_map_.erase(cluster_name);
+    cancelPendingThreadLocalClusterUpdate(cluster_name);
   }
 
   return removed;
@@ -1146,6 +1162,7 @@ ThreadLocalCluster* ClusterManagerImpl::getThreadLocalCluster(absl::string_view
   // 确认这个cluster是否存在
   auto entry = cluster_manager.thread_local_clusters_.find(cluster);
   if (entry != cluster_manager.thread_local_clusters_.end()) {
+    entry->second->used_since_last_sweep_ = true;
     return entry->second.get();
   } else {
     // 如果不存在就创建一个
@@ -1322,8 +1339,142 @@ bool ClusterManagerImpl::deferralIsSupportedForCluster(
   return true;
 }
 
+void ClusterManagerImpl::ThreadLocalClusterUpdateParams::merge(
+    ThreadLocalClusterUpdateParams&& other) {
+  // Removes from `pending` every host that is also in `incoming` and appends the rest of
+  // `incoming` to `accumulated`.
+  const auto cancel_or_append = [](HostVector& pending, const HostVector& incoming,
+                                   HostVector& accumulated) {
+    if (incoming.empty()) {
+      return;
+    }
+    absl::flat_hash_set<const Host*> cancelled;
+    if (!pending.empty()) {
+      absl::flat_hash_set<const Host*> incoming_set;
+      incoming_set.reserve(incoming.size());
+      for (const auto& host : incoming) {
+        incoming_set.insert(host.get());
+      }
+      pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                   [&](const HostSharedPtr& host) {
+                                     if (incoming_set.contains(host.get())) {
+                                       cancelled.insert(host.get());
+                                       return true;
+                                     }
+                                     return false;
+                                   }),
+                    pending.end());
+    }
+    for (const auto& host : incoming) {
+      if (!cancelled.contains(host.get())) {
+        accumulated.push_back(host);
+      }
+    }
+  };
+
+  for (auto& incoming : other.per_priority_update_params_) {
+    auto existing = std::find_if(
+        per_priority_update_params_.begin(), per_priority_update_params_.end(),
+        [&incoming](const PerPriority& p) { return p.priority_ == incoming.priority_; });
+    if (existing == per_priority_update_params_.end()) {
+      per_priority_update_params_.push_back(std::move(incoming));
+      continue;
+    }
+    cancel_or_append(existing->hosts_added_, incoming.hosts_removed_, existing->hosts_removed_);
+    cancel_or_append(existing->hosts_removed_, incoming.hosts_added_, existing->hosts_added_);
+  }
+}
+
 void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_cluster,
                                                       ThreadLocalClusterUpdateParams&& params) {
+  // Only membership updates of clusters that already exist on the workers are batched. Adding or
+  // updating a cluster replaces the whole thread local cluster, so it supersedes anything pending.
+  if (thread_local_update_batch_timer_ != nullptr) {
+    if (cm_cluster.addedOrUpdated()) {
+      batchThreadLocalClusterUpdate(cm_cluster, std::move(params));
+      return;
+    }
+    cancelPendingThreadLocalClusterUpdate(cm_cluster.cluster().info()->name());
+  }
+
+  tls_.runOnAllThreads(prepareThreadLocalClusterUpdate(cm_cluster, std::move(params)));
+
+  // By this time, the main thread has received the cluster initialization update, so we can start
+  // the ADS mux if the ADS mux is dependent on this cluster's initialization.
+  if (cm_cluster.requiredForAds() && !ads_mux_initialized_) {
+    ads_mux_->start();
+    ads_mux_initialized_ = true;
+  }
+}
+
+void ClusterManagerImpl::batchThreadLocalClusterUpdate(ClusterManagerCluster& cm_cluster,
+                                                       ThreadLocalClusterUpdateParams&& params) {
+  cm_stats_.update_batched_.inc();
+  const std::string& cluster_name = cm_cluster.cluster().info()->name();
+  auto index = pending_thread_local_update_index_.find(cluster_name);
+  if (index != pending_thread_local_update_index_.end()) {
+    auto& pending = pending_thread_local_updates_[index->second].second;
+    ASSERT(pending.cm_cluster_ == &cm_cluster);
+    pending.params_.merge(std::move(params));
+    cm_stats_.update_batch_coalesced_.inc();
+    return;
+  }
+
+  pending_thread_local_update_index_.emplace(cluster_name, pending_thread_local_updates_.size());
+  auto& pending = pending_thread_local_updates_
+                      .emplace_back(cluster_name, PendingThreadLocalClusterUpdate(cm_cluster))
+                      .second;
+  pending.params_ = std::move(params);
+  if (!thread_local_update_batch_timer_->enabled()) {
+    thread_local_update_batch_timer_->enableTimer(thread_local_update_batch_window_);
+  }
+}
+
+void ClusterManagerImpl::cancelPendingThreadLocalClusterUpdate(const std::string& cluster_name) {
+  auto index = pending_thread_local_update_index_.find(cluster_name);
+  if (index == pending_thread_local_update_index_.end()) {
+    return;
+  }
+  pending_thread_local_updates_.erase(pending_thread_local_updates_.begin() + index->second);
+  pending_thread_local_update_index_.erase(index);
+  // Cancellation only happens on cluster removal or replacement, so rebuilding the index is fine.
+  for (size_t i = 0; i < pending_thread_local_updates_.size(); ++i) {
+    pending_thread_local_update_index_[pending_thread_local_updates_[i].first] = i;
+  }
+}
+
+void ClusterManagerImpl::flushThreadLocalClusterUpdates() {
+  if (pending_thread_local_updates_.empty()) {
+    return;
+  }
+  if (thread_local_update_batch_timer_ != nullptr) {
+    thread_local_update_batch_timer_->disableTimer();
+  }
+
+  std::vector<ThreadLocalClusterUpdateCb> updates;
+  updates.reserve(pending_thread_local_updates_.size());
+  // Swap the pending updates out first: preparing an update must not observe a partially
+  // consumed batch.
+  PendingThreadLocalClusterUpdates pending_updates;
+  pending_updates.swap(pending_thread_local_updates_);
+  pending_thread_local_update_index_.clear();
+  for (auto& [cluster_name, pending] : pending_updates) {
+    updates.push_back(
+        prepareThreadLocalClusterUpdate(*pending.cm_cluster_, std::move(pending.params_)));
+  }
+
+  cm_stats_.update_batch_posted_.inc();
+  tls_.runOnAllThreads(
+      [updates = std::move(updates)](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+        for (const auto& update : updates) {
+          update(cluster_manager);
+        }
+      });
+}
+
+ClusterManagerImpl::ThreadLocalClusterUpdateCb
+ClusterManagerImpl::prepareThreadLocalClusterUpdate(ClusterManagerCluster& cm_cluster,
+                                                    ThreadLocalClusterUpdateParams&& params) {
   bool add_or_update_cluster = false;
   if (!cm_cluster.addedOrUpdated()) {
     add_or_update_cluster = true;
@@ -1356,11 +1507,11 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_
                                                         load_balancer_factory, host_map,
                                                         drop_overload, drop_category);
 
-  tls_.runOnAllThreads([info = cm_cluster.cluster().info(), params = std::move(params),
-                        add_or_update_cluster, load_balancer_factory, map = std::move(host_map),
-                        cluster_initialization_object = std::move(cluster_initialization_object),
-                        drop_overload, drop_category = std::move(drop_category)](
-                           OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+  return [info = cm_cluster.cluster().info(), params = std::move(params), add_or_update_cluster,
+          load_balancer_factory, map = std::move(host_map),
+          cluster_initialization_object = std::move(cluster_initialization_object), drop_overload,
+          drop_category = std::move(drop_category)](
+             OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
     ASSERT(cluster_manager.has_value(),
            "Expected the ThreadLocalClusterManager to be set during ClusterManagerImpl creation.");
 
@@ -1375,30 +1526,7 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_
       ENVOY_LOG(debug, "Deferring add or update for TLS cluster {}", info->name());
       cluster_manager->thread_local_deferred_clusters_[info->name()] =
           cluster_initialization_object;
-
-      // Invoke similar logic of onClusterAddOrUpdate.
-      ThreadLocalClusterCommand command = [&cluster_manager,
-                                           cluster_name = info->name()]() -> ThreadLocalCluster& {
-        // If we have multiple callbacks only the first one needs to use the
-        // command to initialize the cluster.
-        auto existing_cluster_entry = cluster_manager->thread_local_clusters_.find(cluster_name);
-        if (existing_cluster_entry != cluster_manager->thread_local_clusters_.end()) {
-          return *existing_cluster_entry->second;
-        }
-
-        auto* cluster_entry = cluster_manager->initializeClusterInlineIfExists(cluster_name);
-        ASSERT(cluster_entry != nullptr, "Deferred clusters initiailization should not fail.");
-        return *cluster_entry;
-      };
-      for (auto cb_it = cluster_manager->update_callbacks_.begin();
-           cb_it != cluster_manager->update_callbacks_.end();) {
-        // The current callback may remove itself from the list, so a handle for
-        // the next item is fetched before calling the callback.
-        auto curr_cb_it = cb_it;
-        ++cb_it;
-        (*curr_cb_it)->onClusterAddOrUpdate(info->name(), command);
-      }
-
+      cluster_manager->onDeferredClusterAddOrUpdate(info->name());
     } else {
       // Broadcast
       ThreadLocalClusterManagerImpl::ClusterEntry* new_cluster = nullptr;
@@ -1419,6 +1547,10 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_
       if (cluster_manager->thread_local_clusters_[info->name()]) {
         cluster_manager->thread_local_clusters_[info->name()]->setDropOverload(drop_overload);
         cluster_manager->thread_local_clusters_[info->name()]->setDropCategory(drop_category);
+        if (cluster_initialization_object != nullptr) {
+          cluster_manager->thread_local_clusters_[info->name()]->initialization_object_ =
+              cluster_initialization_object;
+        }
       }
       for (const auto& per_priority : params.per_priority_update_params_) {
         cluster_manager->updateClusterMembership(
@@ -1441,14 +1573,7 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_
         }
       }
     }
-  });
-
-  // By this time, the main thread has received the cluster initialization update, so we can start
-  // the ADS mux if the ADS mux is dependent on this cluster's initialization.
-  if (cm_cluster.requiredForAds() && !ads_mux_initialized_) {
-    ads_mux_->start();
-    ads_mux_initialized_ = true;
-  }
+  };
 }
 
 ClusterManagerImpl::ClusterInitializationObjectConstSharedPtr
@@ -1527,6 +1652,7 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::initializeClusterInlineIfExis
   }
   thread_local_clusters_[cluster]->setDropOverload(initialization_object->drop_overload_);
   thread_local_clusters_[cluster]->setDropCategory(initialization_object->drop_category_);
+  cluster_entry_ptr->initialization_object_ = initialization_object;
 
   // Remove the CIO as we've initialized the cluster.
   thread_local_deferred_clusters_.erase(entry);
@@ -1534,6 +1660,59 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::initializeClusterInlineIfExis
   return cluster_entry_ptr;
 }
 
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onDeferredClusterAddOrUpdate(
+    const std::string& cluster) {
+  // Invoke similar logic of onClusterAddOrUpdate.
+  ThreadLocalClusterCommand command = [this, cluster_name = cluster]() -> ThreadLocalCluster& {
+    // If we have multiple callbacks only the first one needs to use the
+    // command to initialize the cluster.
+    auto existing_cluster_entry = thread_local_clusters_.find(cluster_name);
+    if (existing_cluster_entry != thread_local_clusters_.end()) {
+      return *existing_cluster_entry->second;
+    }
+
+    auto* cluster_entry = initializeClusterInlineIfExists(cluster_name);
+    ASSERT(cluster_entry != nullptr, "Deferred clusters initiailization should not fail.");
+    return *cluster_entry;
+  };
+  for (auto cb_it = update_callbacks_.begin(); cb_it != update_callbacks_.end();) {
+    // The current callback may remove itself from the list, so a handle for
+    // the next item is fetched before calling the callback.
+    auto curr_cb_it = cb_it;
+    ++cb_it;
+    (*curr_cb_it)->onClusterAddOrUpdate(cluster, command);
+  }
+}
+
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::evictIdleClusters() {
+  std::vector<std::string> idle_clusters;
+  for (const auto& [name, cluster_entry] : thread_local_clusters_) {
+    const bool used = std::exchange(cluster_entry->used_since_last_sweep_, false);
+    if (!used && !cluster_entry->pinned_ && cluster_entry->isIdle()) {
+      idle_clusters.push_back(name);
+    }
+  }
+
+  for (const std::string& name : idle_clusters) {
+    auto entry = thread_local_clusters_.find(name);
+    ENVOY_LOG(debug, "evicting idle TLS cluster {}", name);
+    // Keep the entry alive until the callbacks had a chance to drop their references to it.
+    ClusterEntryPtr evicted = std::move(entry->second);
+    thread_local_clusters_.erase(entry);
+    thread_local_deferred_clusters_[name] = evicted->initialization_object_;
+    local_stats_.clusters_inflated_.set(thread_local_clusters_.size());
+    local_stats_.clusters_evicted_.inc();
+
+    onDeferredClusterAddOrUpdate(name);
+    auto reinitialized = thread_local_clusters_.find(name);
+    if (reinitialized != thread_local_clusters_.end()) {
+      reinitialized->second->pinned_ = true;
+    }
+  }
+
+  idle_cluster_eviction_timer_->enableTimer(parent_.deferred_cluster_idle_timeout_);
+}
+
 ClusterManagerImpl::ClusterInitializationObject::ClusterInitializationObject(
     const ThreadLocalClusterUpdateParams& params, ClusterInfoConstSharedPtr cluster_info,
     LoadBalancerFactorySharedPtr load_balancer_factory, HostMapConstSharedPtr map,
@@ -1905,6 +2084,13 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
     local_priority_set_ = &thread_local_clusters_[local_cluster_name]->prioritySet();
     local_stats_.clusters_inflated_.set(thread_local_clusters_.size());
   }
+
+  // The main thread never defers clusters, so it has nothing to evict either.
+  if (parent.deferred_cluster_idle_timeout_.count() > 0 &&
+      !Envoy::Thread::MainThread::isMainThread()) {
+    idle_cluster_eviction_timer_ = dispatcher.createTimer([this]() { evictIdleClusters(); });
+    idle_cluster_eviction_timer_->enableTimer(parent.deferred_cluster_idle_timeout_);
+  }
 }
 
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImpl() {
@@ -2101,6 +2287,24 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::~ClusterEntry()
   drainConnPools();
 }
 
+bool ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::isIdle() const {
+  // The async client may have streams in flight, which it would reset when destroyed.
+  if (initialization_object_ == nullptr || lazy_http_async_client_ != nullptr ||
+      &priority_set_ == parent_.local_priority_set_) {
+    return false;
+  }
+  for (const HostSetPtr& host_set : priority_set_.hostSetsPerPriority()) {
+    for (const HostSharedPtr& host : host_set->hosts()) {
+      if (parent_.host_http_conn_pool_map_.contains(host) ||
+          parent_.host_tcp_conn_pool_map_.contains(host) ||
+          parent_.host_tcp_conn_map_.contains(host)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 Http::ConnectionPool::Instance*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImpl(
     HostConstSharedPtr host, ResourcePriority priority,
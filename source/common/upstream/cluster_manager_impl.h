@@ -213,6 +213,9 @@ private:
   COUNTER(cluster_updated_via_merge)                                                               \
   COUNTER(update_merge_cancelled)                                                                  \
   COUNTER(update_out_of_merge_window)                                                              \
+  COUNTER(update_batched)                                                                          \
+  COUNTER(update_batch_coalesced)                                                                  \
+  COUNTER(update_batch_posted)                                                                     \
   GAUGE(active_clusters, NeverImport)                                                              \
   GAUGE(warming_clusters, NeverImport)
 
@@ -226,13 +229,15 @@ struct ClusterManagerStats {
 /**
  * All thread local cluster manager stats. @see stats_macros.h
  */
-#define ALL_THREAD_LOCAL_CLUSTER_MANAGER_STATS(GAUGE) GAUGE(clusters_inflated, NeverImport)
+#define ALL_THREAD_LOCAL_CLUSTER_MANAGER_STATS(COUNTER, GAUGE)                                     \
+  COUNTER(clusters_evicted)                                                                        \
+  GAUGE(clusters_inflated, NeverImport)
 
 /**
  * Struct definition for all cluster manager stats. @see stats_macros.h
  */
 struct ThreadLocalClusterManagerStats {
-  ALL_THREAD_LOCAL_CLUSTER_MANAGER_STATS(GENERATE_GAUGE_STRUCT)
+  ALL_THREAD_LOCAL_CLUSTER_MANAGER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
 /**
@@ -296,6 +301,11 @@ public:
     cds_api_.reset();
     ads_mux_.reset();
     xds_manager_.shutdown();
+    if (thread_local_update_batch_timer_ != nullptr) {
+      thread_local_update_batch_timer_->disableTimer();
+    }
+    pending_thread_local_update_index_.clear();
+    pending_thread_local_updates_.clear();
     active_clusters_.clear();
     warming_clusters_.clear();
     updateClusterCounts();
@@ -404,11 +414,11 @@ protected:
     struct PerPriority {
       PerPriority(uint32_t priority, const HostVector& hosts_added, const HostVector& hosts_removed)
           : hosts_added_(hosts_added), hosts_removed_(hosts_removed), priority_(priority) {}
-      // TODO(kbaichoo): make the hosts_added_ vector const and have the
-      // cluster initialization object have a stripped down version of this
-      // struct.
+      // TODO(kbaichoo): have the cluster initialization object have a stripped down version of
+      // this struct.
+      // The added/removed vectors are not const so that batched updates can be merged in place.
       HostVector hosts_added_;
-      const HostVector hosts_removed_;
+      HostVector hosts_removed_;
       PrioritySet::UpdateHostsParams update_hosts_params_;
       LocalityWeightsConstSharedPtr locality_weights_;
       // Keep small members (bools and enums) at the end of class, to reduce alignment overhead.
@@ -422,6 +432,14 @@ protected:
                                    const HostVector& hosts_removed)
         : per_priority_update_params_{{priority, hosts_added, hosts_removed}} {}
 
+    /**
+     * Merges a later update for the same cluster into this one. Hosts added and removed are
+     * accumulated per priority, and a host that is added and later removed (or vice versa) within
+     * the merged updates cancels out so that workers never see it. The remaining per priority
+     * fields are populated from the current host sets when the merged update is posted.
+     */
+    void merge(ThreadLocalClusterUpdateParams&& other);
+
     std::vector<PerPriority> per_priority_update_params_;
   };
 
@@ -489,6 +507,14 @@ protected:
   virtual void postThreadLocalClusterUpdate(ClusterManagerCluster& cm_cluster,
                                             ThreadLocalClusterUpdateParams&& params);
 
+  /**
+   * Posts all thread local cluster updates that are pending in the current batch to the workers
+   * as a single cross-thread update. This is a no-op if nothing is pending.
+   *
+   * It's protected, so the tests can use it.
+   */
+  void flushThreadLocalClusterUpdates();
+
   /**
    * Notifies cluster discovery managers in each worker thread that the discovery process for the
    * cluster with a passed name has timed out.
@@ -627,6 +653,18 @@ private:
       void setDropCategory(absl::string_view drop_category) override {
         drop_category_ = drop_category;
       }
+      // Whether the cluster can be returned to its deferred state: it supports deferral and the
+      // worker holds no connection pools, connections or async client for it.
+      bool isIdle() const;
+
+      // The latest CIO of the cluster, used to return it to the deferred state once idle. It is
+      // null if the cluster does not support deferred initialization.
+      ClusterInitializationObjectConstSharedPtr initialization_object_;
+      // Set on every lookup of the cluster and cleared by each idle cluster sweep.
+      bool used_since_last_sweep_{true};
+      // Set if an update callback initialized the cluster again while it was being evicted. Such
+      // a callback keeps the cluster referenced, so evicting it again would only cause churn.
+      bool pinned_{false};
 
     private:
       Http::ConnectionPool::Instance*
@@ -717,6 +755,18 @@ private:
      */
     ClusterEntry* initializeClusterInlineIfExists(absl::string_view cluster);
 
+    /**
+     * Notify the update callbacks of a cluster that is in `thread_local_deferred_clusters_`. The
+     * command passed to the callbacks initializes the cluster inline.
+     */
+    void onDeferredClusterAddOrUpdate(const std::string& cluster);
+
+    /**
+     * Return the clusters that have not been used since the previous sweep and are idle to their
+     * deferred state, then re-arm the sweep timer.
+     */
+    void evictIdleClusters();
+
     OptRef<Quic::EnvoyQuicNetworkObserverRegistry> getNetworkObserverRegistry() {
       return makeOptRefFromPtr(network_observer_registry_.get());
     }
@@ -750,6 +800,7 @@ private:
     bool destroying_{};
     ClusterDiscoveryManager cdm_;
     ThreadLocalClusterManagerStats local_stats_;
+    Event::TimerPtr idle_cluster_eviction_timer_;
 
   private:
     static ThreadLocalClusterManagerStats generateStats(Stats::Scope& scope,
@@ -864,11 +915,38 @@ private:
 
   using ClusterCreationsMap = absl::flat_hash_map<std::string, ClusterCreation>;
 
+  /**
+   * A thread local cluster update that is waiting for the current batch window to expire. All
+   * updates received for the same cluster within the window are merged into a single entry.
+   */
+  struct PendingThreadLocalClusterUpdate {
+    PendingThreadLocalClusterUpdate(ClusterManagerCluster& cm_cluster) : cm_cluster_(&cm_cluster) {}
+
+    ClusterManagerCluster* cm_cluster_;
+    ThreadLocalClusterUpdateParams params_;
+  };
+
+  // Ordered by arrival so that batched updates are applied on the workers in the same order as
+  // they would have been without batching.
+  using PendingThreadLocalClusterUpdates =
+      std::vector<std::pair<std::string, PendingThreadLocalClusterUpdate>>;
+  using ThreadLocalClusterUpdateCb = std::function<void(OptRef<ThreadLocalClusterManagerImpl>)>;
+
   void applyUpdates(ClusterManagerCluster& cluster, uint32_t priority, PendingUpdates& updates);
   bool scheduleUpdate(ClusterManagerCluster& cluster, uint32_t priority, bool mergeable,
                       const uint64_t timeout);
   ProtobufTypes::MessagePtr dumpClusterConfigs(const Matchers::StringMatcher& name_matcher);
   static ClusterManagerStats generateStats(Stats::Scope& scope);
+  /**
+   * Snapshots the state of the cluster for the given update and returns the callback that applies
+   * it on a thread local cluster manager.
+   */
+  ThreadLocalClusterUpdateCb
+  prepareThreadLocalClusterUpdate(ClusterManagerCluster& cm_cluster,
+                                  ThreadLocalClusterUpdateParams&& params);
+  void batchThreadLocalClusterUpdate(ClusterManagerCluster& cm_cluster,
+                                     ThreadLocalClusterUpdateParams&& params);
+  void cancelPendingThreadLocalClusterUpdate(const std::string& cluster_name);
 
   /**
    * @return ClusterDataPtr contains the previous cluster in the cluster_map, or
@@ -939,6 +1017,11 @@ private:
   TimeSource& time_source_;
   ClusterUpdatesMap updates_map_;
   Event::Dispatcher& dispatcher_;
+  const std::chrono::milliseconds thread_local_update_batch_window_;
+  const std::chrono::milliseconds deferred_cluster_idle_timeout_;
+  PendingThreadLocalClusterUpdates pending_thread_local_updates_;
+  absl::flat_hash_map<std::string, size_t> pending_thread_local_update_index_;
+  Event::TimerPtr thread_local_update_batch_timer_;
   Http::Context& http_context_;
   ProtobufMessage::ValidationContext& validation_context_;
   Router::Context& router_context_;
@@ -1178,6 +1178,11 @@ ClusterInfoImpl::ClusterInfoImpl(
           config.preconnect_policy(), per_upstream_preconnect_ratio, 1.0)),
       peekahead_ratio_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.preconnect_policy(),
                                                        predictive_preconnect_ratio, 0)),
+      max_adaptive_preconnect_streams_(
+          config.preconnect_policy().has_adaptive_preconnect()
+              ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.preconnect_policy().adaptive_preconnect(),
+                                                max_preconnected_streams, 3)
+              : 0),
       socket_matcher_(std::move(socket_matcher)), stats_scope_(std::move(stats_scope)),
       traffic_stats_(generateStats(
           stats_scope_, factory_context.serverFactoryContext().clusterManager().clusterStatNames(),
@@ -1729,6 +1734,102 @@ ClusterImplBase::partitionHostsPerLocality(const HostsPerLocality& hosts) {
                          std::move(filtered_clones[2]));
 }
 
+namespace {
+
+// Returns a copy of `view`, a subsequence of `hosts`, with `host` added or removed. An added host
+// is inserted at its position in `hosts`, so that the result is the same as re-filtering `hosts`.
+// A host that is not part of `hosts` anymore is not added.
+HostVector moveHost(const HostVector& view, const HostVector& hosts, const HostSharedPtr& host,
+                    bool add) {
+  HostVector result;
+  result.reserve(view.size() + (add ? 1 : 0));
+  if (!add) {
+    for (const auto& view_host : view) {
+      if (view_host != host) {
+        result.push_back(view_host);
+      }
+    }
+    return result;
+  }
+
+  // Only pointers are compared to find the position, the hosts are not re-filtered.
+  auto next = view.begin();
+  auto it = hosts.begin();
+  for (; it != hosts.end() && *it != host; ++it) {
+    if (next != view.end() && *next == *it) {
+      ++next;
+    }
+  }
+  result.insert(result.end(), view.begin(), next);
+  if (it != hosts.end()) {
+    result.push_back(host);
+  }
+  result.insert(result.end(), next, view.end());
+  return result;
+}
+
+// Selects the view of a host set that should follow a health change of `changed_host`. If the host
+// neither enters nor leaves the view, the current view is shared as is. Otherwise the host is moved
+// into or out of a copy of the view: the copy is required since the current view is shared with
+// the workers, but no other host is re-evaluated. In the per locality view only the bucket of the
+// host's locality, found by locality rather than by scanning the hosts, is changed.
+template <class ViewT>
+std::pair<std::shared_ptr<const ViewT>, HostsPerLocalityConstSharedPtr>
+viewOnHealthChange(const HostSet& host_set, const HostSharedPtr& changed_host,
+                   const std::shared_ptr<const ViewT>& current_view,
+                   const HostsPerLocalityConstSharedPtr& current_view_per_locality,
+                   const std::function<bool(const Host&)>& predicate) {
+  const auto& view_hosts = current_view->get();
+  const bool in_view =
+      std::find(view_hosts.begin(), view_hosts.end(), changed_host) != view_hosts.end();
+  const bool add = predicate(*changed_host);
+  if (in_view == add) {
+    return {current_view, current_view_per_locality};
+  }
+
+  auto view = std::make_shared<ViewT>(moveHost(view_hosts, host_set.hosts(), changed_host, add));
+
+  const auto& all_buckets = host_set.hostsPerLocality().get();
+  const auto& current_buckets = current_view_per_locality->get();
+  if (all_buckets.size() != current_buckets.size()) {
+    // The per locality view does not mirror the host set, so rebuild it in full.
+    return {std::move(view), host_set.hostsPerLocality().filter({predicate})[0]};
+  }
+
+  std::vector<HostVector> buckets = current_buckets;
+  for (size_t i = 0; i < all_buckets.size(); ++i) {
+    if (!all_buckets[i].empty() &&
+        LocalityEqualTo()(all_buckets[i].front()->locality(), changed_host->locality())) {
+      buckets[i] = moveHost(current_buckets[i], all_buckets[i], changed_host, add);
+      break;
+    }
+  }
+  return {std::move(view),
+          std::make_shared<HostsPerLocalityImpl>(std::move(buckets),
+                                                 current_view_per_locality->hasLocalLocality())};
+}
+
+} // namespace
+
+PrioritySet::UpdateHostsParams
+HostSetImpl::partitionHostsOnHealthChange(const HostSet& host_set,
+                                          const HostSharedPtr& changed_host) {
+  auto healthy = viewOnHealthChange<HealthyHostVector>(
+      host_set, changed_host, host_set.healthyHostsPtr(), host_set.healthyHostsPerLocalityPtr(),
+      [](const Host& host) { return host.coarseHealth() == Host::Health::Healthy; });
+  auto degraded = viewOnHealthChange<DegradedHostVector>(
+      host_set, changed_host, host_set.degradedHostsPtr(), host_set.degradedHostsPerLocalityPtr(),
+      [](const Host& host) { return host.coarseHealth() == Host::Health::Degraded; });
+  auto excluded = viewOnHealthChange<ExcludedHostVector>(
+      host_set, changed_host, host_set.excludedHostsPtr(), host_set.excludedHostsPerLocalityPtr(),
+      [](const Host& host) { return excludeBasedOnHealthFlag(host); });
+
+  return updateHostsParams(host_set.hostsPtr(), host_set.hostsPerLocalityPtr(),
+                           std::move(healthy.first), std::move(healthy.second),
+                           std::move(degraded.first), std::move(degraded.second),
+                           std::move(excluded.first), std::move(excluded.second));
+}
+
 bool ClusterInfoImpl::maintenanceMode() const {
   return runtime_.snapshot().featureEnabled(maintenance_mode_runtime_key_, 0);
 }
@@ -1902,8 +2003,23 @@ void ClusterImplBase::reloadHealthyHosts(const HostSharedPtr& host) {
   reloadHealthyHostsHelper(host);
 }
 
-void ClusterImplBase::reloadHealthyHostsHelper(const HostSharedPtr&) {
+void ClusterImplBase::reloadHealthyHostsHelper(const HostSharedPtr& host) {
   const auto& host_sets = prioritySet().hostSetsPerPriority();
+
+  // A health change of a single host only affects the priority that contains it, and within it
+  // only the views the host enters or leaves. A host that was removed from its host set in the
+  // meantime leaves every view unchanged, so its membership is not checked here.
+  if (host != nullptr && host->priority() < host_sets.size() &&
+      Runtime::runtimeFeatureEnabled(
+          "envoy.reloadable_features.single_priority_host_health_update")) {
+    const auto& host_set = *host_sets[host->priority()];
+    prioritySet().updateHosts(host->priority(),
+                              HostSetImpl::partitionHostsOnHealthChange(host_set, host),
+                              host_set.localityWeights(), {}, {}, random_.random(), absl::nullopt,
+                              absl::nullopt);
+    return;
+  }
+
   for (size_t priority = 0; priority < host_sets.size(); ++priority) {
     const auto& host_set = host_sets[priority];
     // TODO(htuch): Can we skip these copies by exporting out const shared_ptr from HostSet?
@@ -618,6 +618,17 @@ public:
   static PrioritySet::UpdateHostsParams updateHostsParams(const HostSet& host_set);
   static PrioritySet::UpdateHostsParams
   partitionHosts(HostVectorConstSharedPtr hosts, HostsPerLocalityConstSharedPtr hosts_per_locality);
+  /**
+   * Re-partitions an existing host set after the health of one of its hosts changed. Membership
+   * is unchanged, so the hosts and hosts per locality are shared with the current host set, as is
+   * every healthy/degraded/excluded view that the changed host neither enters nor leaves. The host
+   * is moved into or out of a copy of every other view, without re-evaluating the other hosts, and
+   * in the per locality form only the bucket of the host's locality changes.
+   * @param host_set supplies the host set containing the host.
+   * @param changed_host supplies the host whose health changed.
+   */
+  static PrioritySet::UpdateHostsParams
+  partitionHostsOnHealthChange(const HostSet& host_set, const HostSharedPtr& changed_host);
 
   void updateHosts(PrioritySet::UpdateHostsParams&& update_hosts_params,
                    LocalityWeightsConstSharedPtr locality_weights, const HostVector& hosts_added,
@@ -897,6 +908,9 @@ public:
 
   float perUpstreamPreconnectRatio() const override { return per_upstream_preconnect_ratio_; }
   float peekaheadRatio() const override { return peekahead_ratio_; }
+  uint32_t maxAdaptivePreconnectStreams() const override {
+    return max_adaptive_preconnect_streams_;
+  }
   uint32_t perConnectionBufferLimitBytes() const override {
     return per_connection_buffer_limit_bytes_;
   }
@@ -1116,6 +1130,7 @@ private:
   OptionalTimeouts optional_timeouts_;
   const float per_upstream_preconnect_ratio_;
   const float peekahead_ratio_;
+  const uint32_t max_adaptive_preconnect_streams_;
   TransportSocketMatcherPtr socket_matcher_;
   Stats::ScopeSharedPtr stats_scope_;
   mutable DeferredCreationCompatibleClusterTrafficStats traffic_stats_;
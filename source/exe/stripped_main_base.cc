@@ -46,7 +46,8 @@ StrippedMainBase::StrippedMainBase(const Server::Options& options,
                                    std::unique_ptr<Server::Platform> platform_impl,
                                    Random::RandomGenerator& random_generator)
     : platform_impl_(std::move(platform_impl)), options_(options),
-      component_factory_(component_factory), stats_allocator_(symbol_table_) {
+      component_factory_(component_factory),
+      stats_allocator_(symbol_table_, options.statsSlabAllocationEnabled()) {
   // Process the option to disable extensions as early as possible,
   // before we do any configuration loading.
   OptionsImplBase::disableExtensions(options_.disabledExtensions());
@@ -56,6 +56,14 @@ public:
    * @param entry supplies the access log to send.
    */
   virtual void log(TcpLogProto&& entry) PURE;
+
+  /**
+   * @return the arena on which http entries can be allocated before they are passed to log(), so
+   *         that the logger can add them to its batch without copying them, or nullptr if the
+   *         logger has no arena. An entry allocated on the arena must be logged before this
+   *         method is called again.
+   */
+  virtual Protobuf::Arena* entryArena() { return nullptr; }
 };
 
 /**
@@ -0,0 +1,184 @@
+#include "source/extensions/access_loggers/filters/adaptive_sampling/adaptive_sampling.h"
+
+#include <algorithm>
+
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/protobuf/utility.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Filters {
+namespace AdaptiveSampling {
+
+namespace {
+
+constexpr std::chrono::seconds SampleWindow{1};
+constexpr uint64_t SamplingPrecision = 1000000;
+constexpr uint64_t DefaultMinLatencySamples = 50;
+constexpr double DefaultSlowRequestQuantile = 0.99;
+
+absl::string_view clusterName(const StreamInfo::StreamInfo& stream_info) {
+  const auto cluster_info = stream_info.upstreamClusterInfo();
+  return cluster_info.has_value() && cluster_info.value() != nullptr
+             ? absl::string_view(cluster_info.value()->name())
+             : absl::string_view();
+}
+
+} // namespace
+
+void LatencyHistogram::decay() {
+  count_ = 0;
+  for (uint64_t& bucket : buckets_) {
+    bucket /= 2;
+    count_ += bucket;
+  }
+}
+
+AdaptiveSamplingFilter::AdaptiveSamplingFilter(
+    const envoy::extensions::access_loggers::filters::adaptive_sampling::v3::
+        AdaptiveSamplingFilter& config,
+    uint32_t concurrency, ThreadLocal::SlotAllocator& tls, TimeSource& time_source,
+    Random::RandomGenerator& random)
+    : thread_logs_per_second_(static_cast<double>(config.healthy_logs_per_second()) /
+                              std::max<uint32_t>(concurrency, 1)),
+      slow_request_quantile_(config.has_slow_request_percentile()
+                                 ? config.slow_request_percentile().value() / 100.0
+                                 : DefaultSlowRequestQuantile),
+      min_latency_samples_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, min_latency_samples, DefaultMinLatencySamples)),
+      time_source_(time_source), random_(random),
+      tls_(ThreadLocal::TypedSlot<ThreadLocalState>::makeUnique(tls)) {
+  tls_->set([](Event::Dispatcher&) { return std::make_shared<ThreadLocalState>(); });
+}
+
+bool AdaptiveSamplingFilter::evaluate(const Formatter::HttpFormatterContext&,
+                                      const StreamInfo::StreamInfo& stream_info) const {
+  // Failed requests are always logged.
+  const absl::optional<uint32_t> response_code = stream_info.responseCode();
+  if ((response_code.has_value() && response_code.value() >= 500) ||
+      stream_info.hasAnyResponseFlag()) {
+    return true;
+  }
+
+  ThreadLocalState& state = **tls_;
+  const MonotonicTime now = time_source_.monotonicTime();
+  RouteState& route_state = routeState(state, stream_info, now);
+
+  if (isSlow(route_state, stream_info, now)) {
+    return true;
+  }
+  return sampleHealthy(state, route_state, stream_info, now);
+}
+
+AdaptiveSamplingFilter::RouteState&
+AdaptiveSamplingFilter::routeState(ThreadLocalState& state,
+                                   const StreamInfo::StreamInfo& stream_info,
+                                   MonotonicTime now) const {
+  const Router::RouteConstSharedPtr route = stream_info.route();
+  if (route == nullptr) {
+    const absl::string_view cluster_name = clusterName(stream_info);
+    auto it = state.clusters_.find(cluster_name);
+    if (it == state.clusters_.end()) {
+      it = state.clusters_.try_emplace(std::string(cluster_name), RouteState{{}, now}).first;
+    }
+    return it->second;
+  }
+
+  // Routes are deleted by configuration updates, so their states are dropped once per decay
+  // interval rather than kept forever.
+  if (now - state.last_sweep_ >= LatencyDecayInterval) {
+    absl::erase_if(state.routes_, [](const auto& entry) { return entry.second.route_.expired(); });
+    state.last_sweep_ = now;
+  }
+  auto [it, inserted] = state.routes_.try_emplace(route.get());
+  if (inserted || it->second.route_.expired()) {
+    // A route allocated at the address of a deleted one starts with a state of its own.
+    it->second = RouteState{route, now};
+  }
+  return it->second;
+}
+
+bool AdaptiveSamplingFilter::isSlow(RouteState& route_state,
+                                    const StreamInfo::StreamInfo& stream_info,
+                                    MonotonicTime now) const {
+  absl::optional<std::chrono::nanoseconds> duration = stream_info.requestComplete();
+  if (!duration.has_value()) {
+    duration = stream_info.currentDuration();
+  }
+  if (!duration.has_value()) {
+    return false;
+  }
+  const int64_t duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration.value()).count();
+  const size_t bucket = LatencyHistogram::bucketIndex(std::max<int64_t>(duration_us, 0));
+
+  // Halve the counts once for every interval elapsed since the last decay, so that a route which
+  // was idle for a while doesn't judge new requests by old durations.
+  const int64_t intervals = (now - route_state.last_decay_) / LatencyDecayInterval;
+  for (int64_t i = 0; i < intervals && route_state.histogram_.count() > 0; i++) {
+    route_state.histogram_.decay();
+  }
+  route_state.last_decay_ += intervals * LatencyDecayInterval;
+
+  // A request is slow if it falls in a bucket above the one holding the percentile, which ignores
+  // durations within the bucket resolution of the percentile.
+  const bool slow = route_state.histogram_.count() > 0 &&
+                    route_state.histogram_.count() >= min_latency_samples_ &&
+                    bucket > route_state.histogram_.quantileBucket(slow_request_quantile_);
+  route_state.histogram_.record(bucket);
+  return slow;
+}
+
+bool AdaptiveSamplingFilter::sampleHealthy(ThreadLocalState& state, RouteState& route_state,
+                                           const StreamInfo::StreamInfo& stream_info,
+                                           MonotonicTime now) const {
+  const uint32_t response_class = stream_info.responseCode().value_or(0) / 100;
+
+  state.key_buffer_.clear();
+  absl::StrAppend(&state.key_buffer_, clusterName(stream_info), "\n", response_class);
+  auto it = route_state.sample_groups_.find(state.key_buffer_);
+  if (it == route_state.sample_groups_.end()) {
+    it = route_state.sample_groups_
+             .try_emplace(state.key_buffer_,
+                          SampleGroup{now, 0, 1.0, std::max(thread_logs_per_second_, 1.0)})
+             .first;
+  }
+  SampleGroup& group = it->second;
+
+  const auto elapsed = now - group.window_start_;
+  if (elapsed >= SampleWindow) {
+    // The entries can't be held back until the end of the window to pick a uniform sample, so
+    // the budget is spread over the window by logging each request with the probability that
+    // would log the budget out of as many requests as the previous window had.
+    const int64_t windows = elapsed / SampleWindow;
+    group.log_probability_ =
+        windows == 1 && group.window_requests_ > thread_logs_per_second_
+            ? thread_logs_per_second_ / static_cast<double>(group.window_requests_)
+            : 1.0;
+    group.credit_ = std::min(group.credit_ + windows * thread_logs_per_second_,
+                             std::max(thread_logs_per_second_, 1.0));
+    group.window_requests_ = 0;
+    group.window_start_ = now;
+  }
+  group.window_requests_++;
+
+  if (group.credit_ < 1.0) {
+    return false;
+  }
+  if (group.log_probability_ < 1.0 &&
+      random_.random() % SamplingPrecision >= group.log_probability_ * SamplingPrecision) {
+    return false;
+  }
+  group.credit_ -= 1.0;
+  return true;
+}
+
+} // namespace AdaptiveSampling
+} // namespace Filters
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
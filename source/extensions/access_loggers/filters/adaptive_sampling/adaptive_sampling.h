@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/common/random_generator.h"
+#include "envoy/common/time.h"
+#include "envoy/extensions/access_loggers/filters/adaptive_sampling/v3/adaptive_sampling.pb.h"
+#include "envoy/router/router.h"
+#include "envoy/stream_info/stream_info.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/common/log_linear_buckets.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Filters {
+namespace AdaptiveSampling {
+
+/**
+ * A per thread histogram of durations in microseconds, bucketed by LogLinearBuckets. The counts
+ * are halved by decay() so that percentiles follow the recent durations.
+ */
+class LatencyHistogram {
+public:
+  // Enough buckets for durations of up to 2^40 microseconds.
+  static constexpr size_t NumBuckets = 160;
+
+  /**
+   * @return the index of the bucket holding the given duration in microseconds.
+   */
+  static size_t bucketIndex(uint64_t value) { return LogLinearBuckets::index(value, NumBuckets); }
+
+  void record(size_t bucket) {
+    buckets_[bucket]++;
+    count_++;
+  }
+  void decay();
+  uint64_t count() const { return count_; }
+
+  /**
+   * @return the index of the bucket holding the given quantile of the recorded durations. Must
+   *         not be called when the histogram is empty.
+   */
+  size_t quantileBucket(double quantile) const {
+    return LogLinearBuckets::quantileIndex(buckets_, count_, quantile);
+  }
+
+private:
+  std::array<uint64_t, NumBuckets> buckets_{};
+  uint64_t count_{};
+};
+
+class AdaptiveSamplingFilter : public AccessLog::Filter {
+public:
+  // The durations of requests on a route are halved at this interval.
+  static constexpr std::chrono::seconds LatencyDecayInterval{10};
+
+  AdaptiveSamplingFilter(
+      const envoy::extensions::access_loggers::filters::adaptive_sampling::v3::
+          AdaptiveSamplingFilter& config,
+      uint32_t concurrency, ThreadLocal::SlotAllocator& tls, TimeSource& time_source,
+      Random::RandomGenerator& random);
+
+  // AccessLog::Filter
+  bool evaluate(const Formatter::HttpFormatterContext& log_context,
+                const StreamInfo::StreamInfo& stream_info) const override;
+
+private:
+  // The sampling state of the healthy requests of one upstream cluster and response code class.
+  struct SampleGroup {
+    MonotonicTime window_start_;
+    // The number of healthy requests seen in the current one second window.
+    uint64_t window_requests_{};
+    // The probability of logging a healthy request in the current window, derived from the
+    // number of requests in the previous window.
+    double log_probability_{1.0};
+    // The number of requests which can still be logged. Grows by the per thread budget every
+    // window.
+    double credit_{};
+  };
+
+  // The state of the requests on one route, or of the requests without a route to one upstream
+  // cluster.
+  struct RouteState {
+    // Only set for routes, to tell the route apart from a later one at the same address.
+    std::weak_ptr<const Router::Route> route_;
+    MonotonicTime last_decay_;
+    LatencyHistogram histogram_;
+    // Keyed by upstream cluster name and response code class.
+    absl::flat_hash_map<std::string, SampleGroup> sample_groups_;
+  };
+
+  struct ThreadLocalState : public ThreadLocal::ThreadLocalObject {
+    // Keyed by the identity of the route rather than its name, which is optional and usually
+    // empty.
+    absl::flat_hash_map<const Router::Route*, RouteState> routes_;
+    // The requests without a route, such as those of the TCP proxy, by upstream cluster name.
+    absl::flat_hash_map<std::string, RouteState> clusters_;
+    // When the states of deleted routes were last dropped.
+    MonotonicTime last_sweep_;
+    // Reused to build the sample group keys without allocating.
+    std::string key_buffer_;
+  };
+
+  RouteState& routeState(ThreadLocalState& state, const StreamInfo::StreamInfo& stream_info,
+                         MonotonicTime now) const;
+  bool isSlow(RouteState& route_state, const StreamInfo::StreamInfo& stream_info,
+              MonotonicTime now) const;
+  bool sampleHealthy(ThreadLocalState& state, RouteState& route_state,
+                     const StreamInfo::StreamInfo& stream_info, MonotonicTime now) const;
+
+  // The number of healthy requests each thread logs per second and per sample group.
+  const double thread_logs_per_second_;
+  const double slow_request_quantile_;
+  const uint64_t min_latency_samples_;
+  TimeSource& time_source_;
+  Random::RandomGenerator& random_;
+  const ThreadLocal::TypedSlotPtr<ThreadLocalState> tls_;
+};
+
+} // namespace AdaptiveSampling
+} // namespace Filters
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
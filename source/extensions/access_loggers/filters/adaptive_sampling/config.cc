@@ -0,0 +1,45 @@
+#include "source/extensions/access_loggers/filters/adaptive_sampling/config.h"
+
+#include "envoy/extensions/access_loggers/filters/adaptive_sampling/v3/adaptive_sampling.pb.h"
+#include "envoy/extensions/access_loggers/filters/adaptive_sampling/v3/adaptive_sampling.pb.validate.h"
+
+#include "source/common/config/utility.h"
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/access_loggers/filters/adaptive_sampling/adaptive_sampling.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Filters {
+namespace AdaptiveSampling {
+
+Envoy::AccessLog::FilterPtr AdaptiveSamplingFilterFactory::createFilter(
+    const envoy::config::accesslog::v3::ExtensionFilter& config,
+    Server::Configuration::FactoryContext& context) {
+  auto factory_config =
+      Config::Utility::translateToFactoryConfig(config, context.messageValidationVisitor(), *this);
+  const auto& sampling_config = MessageUtil::downcastAndValidate<
+      const envoy::extensions::access_loggers::filters::adaptive_sampling::v3::
+          AdaptiveSamplingFilter&>(*factory_config, context.messageValidationVisitor());
+
+  Server::Configuration::ServerFactoryContext& server_context = context.serverFactoryContext();
+  return std::make_unique<AdaptiveSamplingFilter>(
+      sampling_config, server_context.options().concurrency(), server_context.threadLocal(),
+      server_context.timeSource(), server_context.api().randomGenerator());
+}
+
+ProtobufTypes::MessagePtr AdaptiveSamplingFilterFactory::createEmptyConfigProto() {
+  return std::make_unique<
+      envoy::extensions::access_loggers::filters::adaptive_sampling::v3::AdaptiveSamplingFilter>();
+}
+
+/**
+ * Static registration for the AdaptiveSamplingFilter. @see RegisterFactory.
+ */
+REGISTER_FACTORY(AdaptiveSamplingFilterFactory, Envoy::AccessLog::ExtensionFilterFactory);
+
+} // namespace AdaptiveSampling
+} // namespace Filters
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/registry/registry.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Filters {
+namespace AdaptiveSampling {
+
+class AdaptiveSamplingFilterFactory : public Envoy::AccessLog::ExtensionFilterFactory {
+public:
+  Envoy::AccessLog::FilterPtr
+  createFilter(const envoy::config::accesslog::v3::ExtensionFilter& config,
+               Server::Configuration::FactoryContext& context) override;
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+  std::string name() const override {
+    return "envoy.access_loggers.extension_filters.adaptive_sampling";
+  }
+};
+
+} // namespace AdaptiveSampling
+} // namespace Filters
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
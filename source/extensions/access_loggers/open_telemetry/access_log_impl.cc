@@ -42,12 +42,6 @@ packBody(const ::opentelemetry::proto::common::v1::AnyValue& body) {
   return output;
 }
 
-::opentelemetry::proto::common::v1::AnyValue
-unpackBody(const ::opentelemetry::proto::common::v1::KeyValueList& value) {
-  ASSERT(value.values().size() == 1 && value.values(0).key() == BODY_KEY);
-  return value.values(0).value();
-}
-
 } // namespace
 
 Http::RegisterCustomInlineHeader<Http::CustomInlineHeaderRegistry::Type::RequestHeaders>
@@ -80,18 +74,29 @@ AccessLog::AccessLog(
 
 void AccessLog::emitLog(const Formatter::HttpFormatterContext& log_context,
                         const StreamInfo::StreamInfo& stream_info) {
-  opentelemetry::proto::logs::v1::LogRecord log_entry;
+  const GrpcAccessLoggerSharedPtr& logger = tls_slot_->getTyped<ThreadLocalLogger>().logger_;
+
+  // The entry is built in place on the arena of the logger when it has one, so that it is added
+  // to the batch without being copied, and freed together with the batch.
+  opentelemetry::proto::logs::v1::LogRecord heap_entry;
+  Protobuf::Arena* arena = logger->entryArena();
+  opentelemetry::proto::logs::v1::LogRecord& log_entry =
+      arena != nullptr ? *Protobuf::Arena::Create<opentelemetry::proto::logs::v1::LogRecord>(arena)
+                       : heap_entry;
   log_entry.set_time_unix_nano(std::chrono::duration_cast<std::chrono::nanoseconds>(
                                    stream_info.startTime().time_since_epoch())
                                    .count());
 
-  // Unpacking the body "KeyValueList" to "AnyValue".
+  auto* attributes = log_entry.mutable_attributes();
   if (body_formatter_) {
-    const auto formatted_body = unpackBody(body_formatter_->format(log_context, stream_info));
-    *log_entry.mutable_body() = formatted_body;
+    // Unpacking the body "KeyValueList" to "AnyValue". The attributes are used to hold the packed
+    // body so that it is allocated next to the entry, and the body is swapped out of them.
+    body_formatter_->format(log_context, stream_info, *attributes);
+    ASSERT(attributes->size() == 1 && attributes->Get(0).key() == BODY_KEY);
+    log_entry.mutable_body()->Swap(attributes->Mutable(0)->mutable_value());
+    attributes->Clear();
   }
-  const auto formatted_attributes = attributes_formatter_->format(log_context, stream_info);
-  *log_entry.mutable_attributes() = formatted_attributes.values();
+  attributes_formatter_->format(log_context, stream_info, *attributes);
 
   // Setting the trace id if available.
   // OpenTelemetry trace id is a [16]byte array, backend(e.g. OTel-collector) will reject the
@@ -109,7 +114,7 @@ void AccessLog::emitLog(const Formatter::HttpFormatterContext& log_context,
     *log_entry.mutable_span_id() = absl::HexStringToBytes(span_id_hex);
   }
 
-  tls_slot_->getTyped<ThreadLocalLogger>().logger_->log(std::move(log_entry));
+  logger->log(std::move(log_entry));
 }
 
 } // namespace OpenTelemetry
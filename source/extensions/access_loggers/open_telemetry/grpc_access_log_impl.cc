@@ -1,5 +1,7 @@
 #include "source/extensions/access_loggers/open_telemetry/grpc_access_log_impl.h"
 
+#include <algorithm>
+
 #include "envoy/extensions/access_loggers/grpc/v3/als.pb.h"
 #include "envoy/extensions/access_loggers/open_telemetry/v3/logs_service.pb.h"
 #include "envoy/grpc/async_client_manager.h"
@@ -53,6 +55,29 @@ GrpcAccessLoggerImpl::GrpcAccessLoggerImpl(
   initMessageRoot(config, local_info);
 }
 
+GrpcAccessLoggerImpl::~GrpcAccessLoggerImpl() {
+  // The arena is destroyed before `message_` of the base class, which must not be left holding
+  // the unflushed records.
+  releaseLogRecords();
+  ASSERT(isEmpty());
+}
+
+Protobuf::Arena* GrpcAccessLoggerImpl::entryArena() {
+  // The records of the flushed batches are freed before the first record of the next batch is
+  // built, which is when no record on the arena can still be pending.
+  if (isEmpty()) {
+    resetArena();
+  }
+  return &arena_;
+}
+
+void GrpcAccessLoggerImpl::resetArena() {
+  ASSERT(isEmpty(), "resetting the arena would free the records of the batch");
+  if (arena_.SpaceUsed() > 0) {
+    arena_.Reset();
+  }
+}
+
 std::function<GrpcAccessLoggerImpl::OTelLogRequestCallbacks&()>
 GrpcAccessLoggerImpl::genOTelCallbacksFactory() {
   return [this]() -> OTelLogRequestCallbacks& {
@@ -83,14 +108,39 @@ void GrpcAccessLoggerImpl::initMessageRoot(
     *resource->add_attributes() = getStringKeyValue("node_name", local_info.nodeName());
   }
 
+  // A configured resource attribute replaces a built-in label or an earlier attribute with the
+  // same key, so that every key is sent once per batch.
+  absl::flat_hash_map<std::string, int> attribute_indexes;
+  for (int i = 0; i < resource->attributes_size(); i++) {
+    attribute_indexes.emplace(resource->attributes(i).key(), i);
+  }
   for (const auto& pair : config.resource_attributes().values()) {
-    *resource->add_attributes() = pair;
+    const auto it = attribute_indexes.find(pair.key());
+    if (it != attribute_indexes.end()) {
+      *resource->mutable_attributes(it->second) = pair;
+    } else {
+      attribute_indexes.emplace(pair.key(), resource->attributes_size());
+      *resource->add_attributes() = pair;
+    }
   }
 }
 
 void GrpcAccessLoggerImpl::addEntry(opentelemetry::proto::logs::v1::LogRecord&& entry) {
   batched_log_entries_++;
-  root_->mutable_log_records()->Add(std::move(entry));
+  opentelemetry::proto::logs::v1::LogRecord* record = &entry;
+  if (entry.GetArena() != &arena_) {
+    // The entry wasn't built on the arena, so it is copied to it. The arena can be reset first if
+    // the batch is empty since no pending record can be on it.
+    if (isEmpty()) {
+      resetArena();
+    }
+    record = Protobuf::Arena::Create<opentelemetry::proto::logs::v1::LogRecord>(&arena_);
+    *record = std::move(entry);
+  }
+  // Only records on the arena may be attached to the heap allocated batch, since they are
+  // released rather than deleted with it.
+  ASSERT(record->GetArena() == &arena_);
+  root_->mutable_log_records()->UnsafeArenaAddAllocated(record);
 }
 
 bool GrpcAccessLoggerImpl::isEmpty() { return root_->log_records().empty(); }
@@ -98,7 +148,14 @@ bool GrpcAccessLoggerImpl::isEmpty() { return root_->log_records().empty(); }
 // The message is already initialized in the c'tor, and only the logs are cleared.
 void GrpcAccessLoggerImpl::initMessage() {}
 
-void GrpcAccessLoggerImpl::clearMessage() { root_->clear_log_records(); }
+void GrpcAccessLoggerImpl::clearMessage() { releaseLogRecords(); }
+
+void GrpcAccessLoggerImpl::releaseLogRecords() {
+  // The records are owned by the arena, so they are released without being deleted.
+  ASSERT(std::all_of(root_->log_records().begin(), root_->log_records().end(),
+                     [this](const auto& record) { return record.GetArena() == &arena_; }));
+  root_->mutable_log_records()->UnsafeArenaExtractSubrange(0, root_->log_records_size(), nullptr);
+}
 
 GrpcAccessLoggerCacheImpl::GrpcAccessLoggerCacheImpl(Grpc::AsyncClientManager& async_client_manager,
                                                      Stats::Scope& scope,
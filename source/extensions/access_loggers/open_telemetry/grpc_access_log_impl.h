@@ -41,6 +41,10 @@ public:
       const envoy::extensions::access_loggers::open_telemetry::v3::OpenTelemetryAccessLogConfig&
           config,
       Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
+  ~GrpcAccessLoggerImpl() override;
+
+  // Common::GrpcAccessLogger
+  Protobuf::Arena* entryArena() override;
 
 private:
   class OTelLogRequestCallbacks
@@ -95,8 +99,16 @@ private:
 
   std::function<OTelLogRequestCallbacks&()> genOTelCallbacksFactory();
 
+  // Frees the records of the flushed batches. Must only be called when the batch is empty.
+  void resetArena();
+  // Detaches the records from the batch without deleting them.
+  void releaseLogRecords();
+
   opentelemetry::proto::logs::v1::ScopeLogs* root_;
   Common::GrpcAccessLoggerStats stats_;
+  // Owns the log records of the batch. The records are only borrowed by `root_`, so that a batch
+  // is freed at once, and records built on the arena are added to it without copying.
+  Protobuf::Arena arena_;
 
   // Hold the ownership of `OTelLogRequestCallbacks` and `OTelLogRequestCallbacks.deletion_` called
   // in the callback time will be responsible to remove itself from map for deletion. If
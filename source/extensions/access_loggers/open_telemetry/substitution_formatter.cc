@@ -10,7 +10,6 @@
 #include "source/common/common/assert.h"
 #include "source/common/formatter/substitution_formatter.h"
 
-#include "absl/strings/str_join.h"
 #include "opentelemetry/proto/common/v1/common.pb.h"
 
 static const std::string DefaultUnspecifiedValueString = "-";
@@ -82,65 +81,59 @@ OpenTelemetryFormatter::FormatBuilder::toFormatStringValue(const std::string& st
                                std::vector<Formatter::FormatterProviderPtr>);
 }
 
-::opentelemetry::proto::common::v1::AnyValue OpenTelemetryFormatter::providersCallback(
-    const std::vector<Formatter::FormatterProviderPtr>& providers,
-    const Formatter::HttpFormatterContext& context, const StreamInfo::StreamInfo& info) const {
-  ASSERT(!providers.empty());
-  ::opentelemetry::proto::common::v1::AnyValue output;
-  std::vector<std::string> bits(providers.size());
+void OpenTelemetryFormatter::formatValue(const OpenTelemetryFormatValue& value_format,
+                                         const Formatter::HttpFormatterContext& context,
+                                         const StreamInfo::StreamInfo& info,
+                                         ::opentelemetry::proto::common::v1::AnyValue& output)
+    const {
+  if (const auto* providers = absl::get_if<const std::vector<Formatter::FormatterProviderPtr>>(
+          &value_format);
+      providers != nullptr) {
+    ASSERT(!providers->empty());
+    std::string* string_value = output.mutable_string_value();
+    for (const Formatter::FormatterProviderPtr& provider : *providers) {
+      const absl::optional<std::string> bit = provider->formatWithContext(context, info);
+      string_value->append(bit.has_value() ? bit.value() : DefaultUnspecifiedValueString);
+    }
+    return;
+  }
 
-  std::transform(
-      providers.begin(), providers.end(), bits.begin(),
-      [&](const Formatter::FormatterProviderPtr& provider) {
-        return provider->formatWithContext(context, info).value_or(DefaultUnspecifiedValueString);
-      });
+  if (const auto* format_map = absl::get_if<const OpenTelemetryFormatMapWrapper>(&value_format);
+      format_map != nullptr) {
+    formatMap(*format_map, context, info, *output.mutable_kvlist_value()->mutable_values());
+    return;
+  }
 
-  output.set_string_value(absl::StrJoin(bits, ""));
-  return output;
+  const auto& format_list = absl::get<const OpenTelemetryFormatListWrapper>(value_format);
+  auto* array_values = output.mutable_array_value()->mutable_values();
+  for (const auto& value : *format_list.value_) {
+    formatValue(value, context, info, *array_values->Add());
+  }
 }
 
-::opentelemetry::proto::common::v1::AnyValue OpenTelemetryFormatter::openTelemetryFormatMapCallback(
-    const OpenTelemetryFormatter::OpenTelemetryFormatMapWrapper& format_map,
-    const OpenTelemetryFormatter::OpenTelemetryFormatMapVisitor& visitor) const {
-  ::opentelemetry::proto::common::v1::AnyValue output;
-  auto* kv_list = output.mutable_kvlist_value();
+void OpenTelemetryFormatter::formatMap(
+    const OpenTelemetryFormatMapWrapper& format_map, const Formatter::HttpFormatterContext& context,
+    const StreamInfo::StreamInfo& info,
+    Protobuf::RepeatedPtrField<::opentelemetry::proto::common::v1::KeyValue>& output) const {
   for (const auto& pair : *format_map.value_) {
-    ::opentelemetry::proto::common::v1::AnyValue value = absl::visit(visitor, pair.second);
-    auto* kv = kv_list->add_values();
+    auto* kv = output.Add();
     kv->set_key(pair.first);
-    *kv->mutable_value() = value;
+    formatValue(pair.second, context, info, *kv->mutable_value());
   }
-  return output;
-}
-
-::opentelemetry::proto::common::v1::AnyValue
-OpenTelemetryFormatter::openTelemetryFormatListCallback(
-    const OpenTelemetryFormatter::OpenTelemetryFormatListWrapper& format_list,
-    const OpenTelemetryFormatter::OpenTelemetryFormatMapVisitor& visitor) const {
-  ::opentelemetry::proto::common::v1::AnyValue output;
-  auto* array_value = output.mutable_array_value();
-  for (const auto& val : *format_list.value_) {
-    ::opentelemetry::proto::common::v1::AnyValue value = absl::visit(visitor, val);
-    *array_value->add_values() = value;
-  }
-  return output;
 }
 
 ::opentelemetry::proto::common::v1::KeyValueList
 OpenTelemetryFormatter::format(const Formatter::HttpFormatterContext& context,
                                const StreamInfo::StreamInfo& info) const {
-  OpenTelemetryFormatMapVisitor visitor{
-      [&](const std::vector<Formatter::FormatterProviderPtr>& providers) {
-        return providersCallback(providers, context, info);
-      },
-      [&, this](const OpenTelemetryFormatter::OpenTelemetryFormatMapWrapper& format_map) {
-        return openTelemetryFormatMapCallback(format_map, visitor);
-      },
-      [&, this](const OpenTelemetryFormatter::OpenTelemetryFormatListWrapper& format_list) {
-        return openTelemetryFormatListCallback(format_list, visitor);
-      },
-  };
-  return openTelemetryFormatMapCallback(kv_list_output_format_, visitor).kvlist_value();
+  ::opentelemetry::proto::common::v1::KeyValueList output;
+  formatMap(kv_list_output_format_, context, info, *output.mutable_values());
+  return output;
+}
+
+void OpenTelemetryFormatter::format(
+    const Formatter::HttpFormatterContext& context, const StreamInfo::StreamInfo& info,
+    Protobuf::RepeatedPtrField<::opentelemetry::proto::common::v1::KeyValue>& output) const {
+  formatMap(kv_list_output_format_, context, info, output);
 }
 
 } // namespace OpenTelemetry
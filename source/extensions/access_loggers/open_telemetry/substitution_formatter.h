@@ -7,6 +7,8 @@
 #include "envoy/formatter/substitution_formatter.h"
 #include "envoy/stream_info/stream_info.h"
 
+#include "source/common/protobuf/protobuf.h"
+
 #include "opentelemetry/proto/common/v1/common.pb.h"
 
 namespace Envoy {
@@ -14,13 +16,6 @@ namespace Extensions {
 namespace AccessLoggers {
 namespace OpenTelemetry {
 
-// Helper classes for OpenTelemetryFormatter::OpenTelemetryMapFormatVisitor.
-template <class... Ts> struct OpenTelemetryFormatMapVisitorHelper : Ts... {
-  using Ts::operator()...;
-};
-template <class... Ts>
-OpenTelemetryFormatMapVisitorHelper(Ts...) -> OpenTelemetryFormatMapVisitorHelper<Ts...>;
-
 /**
  * A formatter for OpenTelemetry logs, which returns a KeyValueList proto.
  */
@@ -32,6 +27,14 @@ public:
   ::opentelemetry::proto::common::v1::KeyValueList
   format(const Formatter::HttpFormatterContext& context, const StreamInfo::StreamInfo& info) const;
 
+  /**
+   * Formats the key value pairs and appends them to the given field, which may belong to a
+   * message allocated on an arena, without building an intermediate KeyValueList.
+   */
+  void format(const Formatter::HttpFormatterContext& context, const StreamInfo::StreamInfo& info,
+              Protobuf::RepeatedPtrField<::opentelemetry::proto::common::v1::KeyValue>& output)
+      const;
+
 private:
   struct OpenTelemetryFormatMapWrapper;
   struct OpenTelemetryFormatListWrapper;
@@ -52,14 +55,6 @@ private:
     OpenTelemetryFormatListPtr value_;
   };
 
-  using OpenTelemetryFormatMapVisitor = OpenTelemetryFormatMapVisitorHelper<
-      const std::function<::opentelemetry::proto::common::v1::AnyValue(
-          const std::vector<Formatter::FormatterProviderPtr>&)>,
-      const std::function<::opentelemetry::proto::common::v1::AnyValue(
-          const OpenTelemetryFormatter::OpenTelemetryFormatMapWrapper&)>,
-      const std::function<::opentelemetry::proto::common::v1::AnyValue(
-          const OpenTelemetryFormatter::OpenTelemetryFormatListWrapper&)>>;
-
   // Methods for building the format map.
   class FormatBuilder {
   public:
@@ -76,17 +71,16 @@ private:
     const std::vector<Formatter::CommandParserPtr>& commands_;
   };
 
-  // Methods for doing the actual formatting.
-  ::opentelemetry::proto::common::v1::AnyValue
-  providersCallback(const std::vector<Formatter::FormatterProviderPtr>& providers,
-                    const Formatter::HttpFormatterContext& context,
-                    const StreamInfo::StreamInfo& info) const;
-  ::opentelemetry::proto::common::v1::AnyValue openTelemetryFormatMapCallback(
-      const OpenTelemetryFormatter::OpenTelemetryFormatMapWrapper& format_map,
-      const OpenTelemetryFormatMapVisitor& visitor) const;
-  ::opentelemetry::proto::common::v1::AnyValue openTelemetryFormatListCallback(
-      const OpenTelemetryFormatter::OpenTelemetryFormatListWrapper& format_list,
-      const OpenTelemetryFormatMapVisitor& visitor) const;
+  // Methods for doing the actual formatting. The values are written into the output in place
+  // rather than returned, so that nested values aren't copied into their parents.
+  void formatValue(const OpenTelemetryFormatValue& value_format,
+                   const Formatter::HttpFormatterContext& context,
+                   const StreamInfo::StreamInfo& info,
+                   ::opentelemetry::proto::common::v1::AnyValue& output) const;
+  void formatMap(const OpenTelemetryFormatMapWrapper& format_map,
+                 const Formatter::HttpFormatterContext& context, const StreamInfo::StreamInfo& info,
+                 Protobuf::RepeatedPtrField<::opentelemetry::proto::common::v1::KeyValue>& output)
+      const;
 
   const OpenTelemetryFormatMapWrapper kv_list_output_format_;
 };
@@ -371,8 +371,9 @@ void EdsClusterImpl::reloadHealthyHostsHelper(const HostSharedPtr& host) {
       host_to_exclude->healthFlagGet(Host::HealthFlag::PENDING_DYNAMIC_REMOVAL)) {
     // Empty for clarity.
   } else {
-    // Do not exclude and remove the host during the update.
-    host_to_exclude = nullptr;
+    // Nothing to exclude and remove, so this is a plain health update.
+    ClusterImplBase::reloadHealthyHostsHelper(host);
+    return;
   }
 
   const auto& host_sets = prioritySet().hostSetsPerPriority();
@@ -733,6 +733,16 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
       helper.processFilters(config.http_filters(), "http", "http", filter_factories_),
       creation_status);
 
+  if (config.record_filter_latency()) {
+    std::vector<std::string> filter_names;
+    filter_names.reserve(config.http_filters_size());
+    for (const auto& http_filter : config.http_filters()) {
+      filter_names.push_back(http_filter.name());
+    }
+    filter_latency_stats_ = std::make_unique<Http::FilterLatencyStats>(
+        context_.scope(), stats_prefix_, filter_names);
+  }
+
   for (const auto& upgrade_config : config.upgrade_configs()) {
     const std::string& name = upgrade_config.upgrade_type();
     const bool enabled = upgrade_config.has_enabled() ? upgrade_config.enabled().value() : true;
@@ -274,6 +274,9 @@ public:
   bool addProxyProtocolConnectionState() const override {
     return add_proxy_protocol_connection_state_;
   }
+  OptRef<const Http::FilterLatencyStats> filterLatencyStats() const override {
+    return makeOptRefFromPtr<const Http::FilterLatencyStats>(filter_latency_stats_.get());
+  }
 
 private:
   enum class CodecType { HTTP1, HTTP2, HTTP3, AUTO };
@@ -370,6 +373,7 @@ private:
   const bool append_local_overload_;
   const bool append_x_forwarded_port_;
   const bool add_proxy_protocol_connection_state_;
+  Http::FilterLatencyStatsPtr filter_latency_stats_;
 };
 
 /**
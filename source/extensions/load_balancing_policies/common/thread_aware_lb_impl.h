@@ -33,7 +33,7 @@ public:
   public:
     virtual ~HashingLoadBalancer() = default;
     virtual HostSelectionResponse chooseHost(uint64_t hash, uint32_t attempt) const PURE;
-    const absl::string_view hashKey(HostConstSharedPtr host, bool use_hostname) const {
+    static absl::string_view hashKey(const HostConstSharedPtr& host, bool use_hostname) {
       const ProtobufWkt::Value& val = Config::Metadata::metadataValue(
           host->metadata().get(), Config::MetadataFilters::get().ENVOY_LB,
           Config::MetadataEnvoyLbKeys::get().HASH_KEY);
@@ -163,8 +163,13 @@ private:
     std::shared_ptr<DegradedLoad> degraded_per_priority_load_ ABSL_GUARDED_BY(mutex_);
   };
 
+  /**
+   * Build the hashing load balancer for a single priority. Called on the main thread for every
+   * priority on each refresh, so implementations may keep per priority state from the previous
+   * build in order to update incrementally.
+   */
   virtual HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
+  createLoadBalancer(uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
                      double min_normalized_weight, double max_normalized_weight) PURE;
   absl::Status refresh();
 
@@ -70,19 +70,49 @@ LegacyMaglevLbConfig::LegacyMaglevLbConfig(const ClusterProto& cluster) {
 TypedMaglevLbConfig::TypedMaglevLbConfig(const MaglevLbProto& lb_config) : lb_config_(lb_config) {}
 
 ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
-MaglevLoadBalancer::createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
+MaglevLoadBalancer::createLoadBalancer(uint32_t priority,
+                                       const NormalizedHostWeightVector& normalized_host_weights,
                                        double /* min_normalized_weight */,
                                        double max_normalized_weight) {
+  if (built_tables_.size() <= priority) {
+    built_tables_.resize(priority + 1);
+  }
+  BuiltTable& built_table = built_tables_[priority];
+  if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.incremental_hash_lb_rebuild")) {
+    const auto same_input = [this](const auto& input, const auto& host_weight) {
+      return std::get<1>(input) == host_weight.first && std::get<2>(input) == host_weight.second &&
+             std::get<0>(input) ==
+                 HashingLoadBalancer::hashKey(host_weight.first, use_hostname_for_hashing_);
+    };
+    if (built_table.lb_ != nullptr && built_table.max_normalized_weight_ == max_normalized_weight &&
+        built_table.inputs_.size() == normalized_host_weights.size() &&
+        std::equal(built_table.inputs_.begin(), built_table.inputs_.end(),
+                   normalized_host_weights.begin(), same_input)) {
+      ENVOY_LOG(debug, "maglev: hash keys and weights of priority {} unchanged, reusing table",
+                priority);
+      return built_table.lb_;
+    }
+  }
+
   HashingLoadBalancerSharedPtr maglev_lb =
       MaglevFactory::createMaglevTable(normalized_host_weights, max_normalized_weight, table_size_,
                                        use_hostname_for_hashing_, stats_);
 
-  if (hash_balance_factor_ == 0) {
-    return maglev_lb;
+  if (hash_balance_factor_ != 0) {
+    maglev_lb = std::make_shared<BoundedLoadHashingLoadBalancer>(
+        maglev_lb, std::move(normalized_host_weights), hash_balance_factor_);
   }
 
-  return std::make_shared<BoundedLoadHashingLoadBalancer>(
-      maglev_lb, std::move(normalized_host_weights), hash_balance_factor_);
+  built_table.inputs_.clear();
+  built_table.inputs_.reserve(normalized_host_weights.size());
+  for (const auto& host_weight : normalized_host_weights) {
+    built_table.inputs_.emplace_back(
+        HashingLoadBalancer::hashKey(host_weight.first, use_hostname_for_hashing_),
+        host_weight.first, host_weight.second);
+  }
+  built_table.max_normalized_weight_ = max_normalized_weight;
+  built_table.lb_ = maglev_lb;
+  return maglev_lb;
 }
 
 void MaglevTable::constructMaglevTableInternal(
@@ -194,10 +194,21 @@ public:
 private:
   // ThreadAwareLoadBalancerBase
   HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
+  createLoadBalancer(uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
                      double /* min_normalized_weight */, double max_normalized_weight) override;
   static MaglevLoadBalancerStats generateStats(Stats::Scope& scope);
 
+  // The inputs and result of the last table build of a priority. The Maglev population order
+  // depends on every host, so slots can't be patched in place without making the table depend on
+  // the update history. Instead a refresh that leaves the hash keys and weights of a priority
+  // unchanged (e.g. a change in another priority) reuses its table.
+  struct BuiltTable {
+    std::vector<std::tuple<std::string, HostConstSharedPtr, double>> inputs_;
+    double max_normalized_weight_{};
+    HashingLoadBalancerSharedPtr lb_;
+  };
+  std::vector<BuiltTable> built_tables_;
+
   Stats::ScopeSharedPtr scope_;
   MaglevLoadBalancerStats stats_;
   const uint64_t table_size_;
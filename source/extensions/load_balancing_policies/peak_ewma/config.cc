@@ -0,0 +1,16 @@
+#include "source/extensions/load_balancing_policies/peak_ewma/config.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolices {
+namespace PeakEwma {
+
+/**
+ * Static registration for the Factory. @see RegisterFactory.
+ */
+REGISTER_FACTORY(Factory, Upstream::TypedLoadBalancerFactory);
+
+} // namespace PeakEwma
+} // namespace LoadBalancingPolices
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,166 @@
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "source/common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Upstream {
+
+PeakEwmaLbConfig::PeakEwmaLbConfig(const PeakEwmaLbProto& lb_proto)
+    : lb_proto_(lb_proto), decay_time_(std::chrono::milliseconds(
+                               PROTOBUF_GET_MS_OR_DEFAULT(lb_proto, decay_time, 10000))),
+      default_rtt_(
+          std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(lb_proto, default_rtt, 10))),
+      choice_count_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(lb_proto, choice_count, 2)) {}
+
+PeakEwmaHostLbPolicyData::PeakEwmaHostLbPolicyData(std::chrono::nanoseconds decay_time,
+                                                   std::chrono::nanoseconds default_rtt,
+                                                   TimeSource& time_source)
+    : decay_time_ns_(static_cast<double>(decay_time.count())), time_source_(time_source),
+      ewma_ns_(static_cast<double>(default_rtt.count())),
+      last_update_time_(time_source.monotonicTime()) {}
+
+void PeakEwmaHostLbPolicyData::onUpstreamResponseTime(std::chrono::microseconds response_time) {
+  observe(response_time, time_source_.monotonicTime());
+}
+
+void PeakEwmaHostLbPolicyData::onUpstreamFailure(std::chrono::microseconds elapsed) {
+  const MonotonicTime now = time_source_.monotonicTime();
+  // Repeated failures grow the penalty geometrically. It is capped at the decay time, past which a
+  // host is avoided anyway, so that it recovers within a few decay times once it stops failing.
+  const double penalty_ns = std::max(
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+      std::min(latency(now) * FailurePenaltyFactor, decay_time_ns_));
+  observe(std::chrono::nanoseconds(static_cast<int64_t>(penalty_ns)), now);
+}
+
+double PeakEwmaHostLbPolicyData::decayFactor(MonotonicTime last, MonotonicTime now) const {
+  // Observations from different workers may race, so a negative elapsed time means no decay.
+  if (now <= last) {
+    return 1.0;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last);
+  return std::exp(-static_cast<double>(elapsed.count()) / decay_time_ns_);
+}
+
+void PeakEwmaHostLbPolicyData::observe(std::chrono::nanoseconds rtt, MonotonicTime now) {
+  const double rtt_ns = static_cast<double>(rtt.count());
+  const double weight = decayFactor(last_update_time_.exchange(now), now);
+
+  double current = ewma_ns_.load(std::memory_order_relaxed);
+  double updated;
+  do {
+    updated = rtt_ns > current ? rtt_ns : current * weight + rtt_ns * (1.0 - weight);
+  } while (!ewma_ns_.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+}
+
+double PeakEwmaHostLbPolicyData::latency(MonotonicTime now) const {
+  return ewma_ns_.load(std::memory_order_relaxed) *
+         decayFactor(last_update_time_.load(std::memory_order_relaxed), now);
+}
+
+PeakEwmaLoadBalancer::PeakEwmaLoadBalancer(const PrioritySet& priority_set,
+                                           const PrioritySet* local_priority_set,
+                                           ClusterLbStats& stats, Runtime::Loader& runtime,
+                                           Random::RandomGenerator& random,
+                                           uint32_t healthy_panic_threshold,
+                                           const PeakEwmaLbConfig& config, TimeSource& time_source)
+    : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
+                                healthy_panic_threshold,
+                                LoadBalancerConfigHelper::localityLbConfigFromProto(
+                                    config.lb_proto_)),
+      default_rtt_ns_(static_cast<double>(config.default_rtt_.count())),
+      choice_count_(config.choice_count_), time_source_(time_source) {}
+
+HostConstSharedPtr PeakEwmaLoadBalancer::peekAnotherHost(LoadBalancerContext* context) {
+  if (tooManyPreconnects(stashed_random_.size(), total_healthy_hosts_)) {
+    return nullptr;
+  }
+  return peekOrChoose(context, true);
+}
+
+HostConstSharedPtr PeakEwmaLoadBalancer::chooseHostOnce(LoadBalancerContext* context) {
+  return peekOrChoose(context, false);
+}
+
+double PeakEwmaLoadBalancer::cost(const Host& host, MonotonicTime now) const {
+  const auto data = host.typedLbPolicyData<PeakEwmaHostLbPolicyData>();
+  const double latency = data.has_value() ? data->latency(now) : default_rtt_ns_;
+  return latency * (host.stats().rq_active_.value() + 1);
+}
+
+HostConstSharedPtr PeakEwmaLoadBalancer::peekOrChoose(LoadBalancerContext* context, bool peek) {
+  const uint64_t random_hash = random(peek);
+  const absl::optional<HostsSource> hosts_source = hostSourceToUse(context, random_hash);
+  if (!hosts_source) {
+    return nullptr;
+  }
+
+  const HostVector& hosts_to_use = hostSourceToHosts(*hosts_source);
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  const MonotonicTime now = time_source_.monotonicTime();
+  HostSharedPtr candidate_host = hosts_to_use[random_hash % hosts_to_use.size()];
+  if (hosts_to_use.size() == 1) {
+    return candidate_host;
+  }
+
+  double candidate_cost = cost(*candidate_host, now);
+  for (uint32_t choice_idx = 1; choice_idx < choice_count_; ++choice_idx) {
+    const HostSharedPtr& sampled_host = hosts_to_use[random_.random() % hosts_to_use.size()];
+    const double sampled_cost = cost(*sampled_host, now);
+    if (sampled_cost < candidate_cost) {
+      candidate_host = sampled_host;
+      candidate_cost = sampled_cost;
+    }
+  }
+
+  return candidate_host;
+}
+
+PeakEwmaThreadAwareLoadBalancer::PeakEwmaThreadAwareLoadBalancer(
+    OptRef<const LoadBalancerConfig> lb_config, const ClusterInfo& cluster_info,
+    const PrioritySet& priority_set, Runtime::Loader& runtime, Random::RandomGenerator& random,
+    TimeSource& time_source)
+    : config_(dynamic_cast<const PeakEwmaLbConfig&>(*lb_config)), priority_set_(priority_set),
+      time_source_(time_source),
+      factory_(std::make_shared<LbFactory>(config_, cluster_info, runtime, random, time_source)) {}
+
+LoadBalancerPtr PeakEwmaThreadAwareLoadBalancer::LbFactory::create(LoadBalancerParams params) {
+  return std::make_unique<PeakEwmaLoadBalancer>(
+      params.priority_set, params.local_priority_set, cluster_info_.lbStats(), runtime_, random_,
+      PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(cluster_info_.lbConfig(),
+                                                     healthy_panic_threshold, 100, 50),
+      config_, time_source_);
+}
+
+void PeakEwmaThreadAwareLoadBalancer::addPeakEwmaDataToHosts(const HostVector& hosts) {
+  for (const auto& host : hosts) {
+    if (!host->lbPolicyData().has_value()) {
+      host->setLbPolicyData(std::make_unique<PeakEwmaHostLbPolicyData>(
+          config_.decay_time_, config_.default_rtt_, time_source_));
+    }
+  }
+}
+
+absl::Status PeakEwmaThreadAwareLoadBalancer::initialize() {
+  // Attach the latency average to all hosts before the workers start to pick them.
+  for (const HostSetPtr& host_set : priority_set_.hostSetsPerPriority()) {
+    addPeakEwmaDataToHosts(host_set->hosts());
+  }
+
+  priority_update_cb_ = priority_set_.addPriorityUpdateCb(
+      [this](uint32_t, const HostVector& hosts_added, const HostVector&) -> absl::Status {
+        addPeakEwmaDataToHosts(hosts_added);
+        return absl::OkStatus();
+      });
+
+  return absl::OkStatus();
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/callback.h"
+#include "envoy/common/time.h"
+#include "envoy/extensions/load_balancing_policies/peak_ewma/v3/peak_ewma.pb.h"
+#include "envoy/upstream/load_balancer.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/extensions/load_balancing_policies/common/load_balancer_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+using PeakEwmaLbProto = envoy::extensions::load_balancing_policies::peak_ewma::v3::PeakEwma;
+
+/**
+ * Load balancer config used to wrap the peak EWMA config proto.
+ */
+class PeakEwmaLbConfig : public Upstream::LoadBalancerConfig {
+public:
+  PeakEwmaLbConfig(const PeakEwmaLbProto& lb_proto);
+
+  const PeakEwmaLbProto lb_proto_;
+  const std::chrono::nanoseconds decay_time_;
+  const std::chrono::nanoseconds default_rtt_;
+  const uint32_t choice_count_;
+};
+
+/**
+ * Per host peak EWMA of the upstream response time. Responses are reported by the router on all
+ * workers, so the average is shared by every worker local load balancer of the cluster.
+ */
+class PeakEwmaHostLbPolicyData : public HostLbPolicyData {
+public:
+  PeakEwmaHostLbPolicyData(std::chrono::nanoseconds decay_time,
+                           std::chrono::nanoseconds default_rtt, TimeSource& time_source);
+
+  // Upstream::HostLbPolicyData
+  void onUpstreamResponseTime(std::chrono::microseconds response_time) override;
+  void onUpstreamFailure(std::chrono::microseconds elapsed) override;
+
+  // A failed request counts as a response this many times slower than the current average, or as
+  // the time elapsed until the failure if that is slower.
+  static constexpr double FailurePenaltyFactor = 5.0;
+
+  /**
+   * Fold a response time into the average. A response time above the current average replaces
+   * it, otherwise the average moves towards the response time based on the time elapsed since
+   * the previous observation.
+   */
+  void observe(std::chrono::nanoseconds rtt, MonotonicTime now);
+
+  /**
+   * @return the average in nanoseconds decayed up to now. Decaying on read makes a host that
+   *         stopped receiving traffic after a slow response recover over time.
+   */
+  double latency(MonotonicTime now) const;
+
+private:
+  double decayFactor(MonotonicTime last, MonotonicTime now) const;
+
+  const double decay_time_ns_;
+  TimeSource& time_source_;
+  std::atomic<double> ewma_ns_;
+  std::atomic<MonotonicTime> last_update_time_;
+};
+
+/**
+ * Worker local load balancer that samples a number of random hosts and picks the one with the
+ * lowest peak EWMA latency multiplied by its active requests plus one.
+ */
+class PeakEwmaLoadBalancer : public ZoneAwareLoadBalancerBase {
+public:
+  PeakEwmaLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
+                       ClusterLbStats& stats, Runtime::Loader& runtime,
+                       Random::RandomGenerator& random, uint32_t healthy_panic_threshold,
+                       const PeakEwmaLbConfig& config, TimeSource& time_source);
+
+  // Upstream::ZoneAwareLoadBalancerBase
+  HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
+  HostConstSharedPtr peekAnotherHost(LoadBalancerContext* context) override;
+
+private:
+  HostConstSharedPtr peekOrChoose(LoadBalancerContext* context, bool peek);
+  double cost(const Host& host, MonotonicTime now) const;
+
+  const double default_rtt_ns_;
+  const uint32_t choice_count_;
+  TimeSource& time_source_;
+};
+
+/**
+ * Thread aware load balancer that attaches the peak EWMA data to the hosts on the main thread and
+ * creates the worker local load balancers.
+ */
+class PeakEwmaThreadAwareLoadBalancer : public ThreadAwareLoadBalancer {
+public:
+  PeakEwmaThreadAwareLoadBalancer(OptRef<const LoadBalancerConfig> lb_config,
+                                  const ClusterInfo& cluster_info,
+                                  const PrioritySet& priority_set, Runtime::Loader& runtime,
+                                  Random::RandomGenerator& random, TimeSource& time_source);
+
+  // Upstream::ThreadAwareLoadBalancer
+  LoadBalancerFactorySharedPtr factory() override { return factory_; }
+  absl::Status initialize() override;
+
+private:
+  class LbFactory : public LoadBalancerFactory {
+  public:
+    LbFactory(const PeakEwmaLbConfig& config, const ClusterInfo& cluster_info,
+              Runtime::Loader& runtime, Random::RandomGenerator& random,
+              TimeSource& time_source)
+        : config_(config), cluster_info_(cluster_info), runtime_(runtime), random_(random),
+          time_source_(time_source) {}
+
+    // Upstream::LoadBalancerFactory
+    LoadBalancerPtr create(LoadBalancerParams params) override;
+    bool recreateOnHostChange() const override { return false; }
+
+  private:
+    const PeakEwmaLbConfig& config_;
+    const ClusterInfo& cluster_info_;
+    Runtime::Loader& runtime_;
+    Random::RandomGenerator& random_;
+    TimeSource& time_source_;
+  };
+
+  void addPeakEwmaDataToHosts(const HostVector& hosts);
+
+  const PeakEwmaLbConfig& config_;
+  const PrioritySet& priority_set_;
+  TimeSource& time_source_;
+  std::shared_ptr<LbFactory> factory_;
+  Common::CallbackHandlePtr priority_update_cb_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
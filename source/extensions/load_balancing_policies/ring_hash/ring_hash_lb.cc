@@ -2,13 +2,16 @@
 
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
 #include "source/common/common/assert.h"
+#include "source/common/runtime/runtime_features.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/strings/string_view.h"
 
@@ -89,60 +92,96 @@ RingHashLoadBalancerStats RingHashLoadBalancer::generateStats(Stats::Scope& scop
   return {ALL_RING_HASH_LOAD_BALANCER_STATS(POOL_GAUGE(scope))};
 }
 
-HostSelectionResponse RingHashLoadBalancer::Ring::chooseHost(uint64_t h, uint32_t attempt) const {
-  if (ring_.empty()) {
-    return {nullptr};
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+RingHashLoadBalancer::createLoadBalancer(uint32_t priority,
+                                         const NormalizedHostWeightVector& normalized_host_weights,
+                                         double min_normalized_weight,
+                                         double /* max_normalized_weight */) {
+  if (rings_per_priority_.size() <= priority) {
+    rings_per_priority_.resize(priority + 1);
+  }
+  const Ring* previous_ring = nullptr;
+  if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.incremental_hash_lb_rebuild")) {
+    previous_ring = rings_per_priority_[priority].get();
   }
 
-  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c (ketama_get_server)
-  // I've generally kept the variable names to make the code easier to compare.
-  // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
-  //       change them!
-  int64_t lowp = 0;
-  int64_t highp = ring_.size();
-  int64_t midp = 0;
-  while (true) {
-    midp = (lowp + highp) / 2;
-
-    if (midp == static_cast<int64_t>(ring_.size())) {
-      midp = 0;
-      break;
-    }
-
-    uint64_t midval = ring_[midp].hash_;
-    uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
+  auto ring = std::make_shared<Ring>(normalized_host_weights, min_normalized_weight,
+                                     min_ring_size_, max_ring_size_, hash_function_,
+                                     use_hostname_for_hashing_, stats_, previous_ring,
+                                     &ring_build_buffer_);
+  rings_per_priority_[priority] = ring;
 
-    if (h <= midval && h > midval1) {
-      break;
-    }
+  if (hash_balance_factor_ == 0) {
+    return ring;
+  }
 
-    if (midval < h) {
-      lowp = midp + 1;
-    } else {
-      highp = midp - 1;
-    }
+  return std::make_shared<BoundedLoadHashingLoadBalancer>(
+      ring, std::move(normalized_host_weights), hash_balance_factor_);
+}
 
-    if (lowp > highp) {
-      midp = 0;
-      break;
-    }
+HostSelectionResponse RingHashLoadBalancer::Ring::chooseHost(uint64_t h, uint32_t attempt) const {
+  if (size() == 0) {
+    return {nullptr};
   }
 
+  size_t point = findPoint(h);
+
   // If a retry host predicate is being applied, behave as if this host was not in the ring.
-  // Note that this does not guarantee a different host: e.g., attempt == ring_.size() or
+  // Note that this does not guarantee a different host: e.g., attempt == size() or
   // when the offset causes us to select the same host at another location in the ring.
   if (attempt > 0) {
-    midp = (midp + attempt) % ring_.size();
+    point = (point + attempt) % size();
   }
 
-  return ring_[midp].host_;
+  return {hosts_[host_indices_[point]]};
+}
+
+size_t RingHashLoadBalancer::Ring::findPoint(uint64_t h) const {
+  // This selects the same point as ketama_get_server() from
+  // https://github.com/RJ/ketama/blob/master/libketama/ketama.c, i.e. the first point whose hash is
+  // >= h, wrapping around to the first point. First find the block that contains it with a
+  // branchless binary search over the largest hash of each block.
+  const uint64_t* base = block_hashes_.data();
+  size_t length = block_hashes_.size();
+  while (length > 1) {
+    const size_t half = length / 2;
+    base += base[half - 1] < h ? half : 0;
+    length -= half;
+  }
+  const size_t block = (base - block_hashes_.data()) + (*base < h);
+  if (block == block_hashes_.size()) {
+    return 0;
+  }
+
+  // Then count the hashes below h in that block. The block is full thanks to the padding, so this
+  // is a fixed length loop over a single cache line which the compiler can vectorize.
+  const uint64_t* block_hashes = hashes_.data() + block * PointsPerBlock;
+  size_t point = block * PointsPerBlock;
+  for (size_t i = 0; i < PointsPerBlock; ++i) {
+    point += block_hashes[i] < h;
+  }
+  ASSERT(point < size());
+  return point;
+}
+
+void RingHashLoadBalancer::Ring::buildBlockIndex() {
+  // Pad the hashes to a whole number of blocks. The padding is never below any h, so the scan in
+  // findPoint() never moves past the last real point of a block.
+  hashes_.resize((size() + PointsPerBlock - 1) / PointsPerBlock * PointsPerBlock,
+                 std::numeric_limits<uint64_t>::max());
+  block_hashes_.clear();
+  block_hashes_.reserve(hashes_.size() / PointsPerBlock);
+  for (size_t block_end = 0; block_end < size(); block_end += PointsPerBlock) {
+    block_hashes_.push_back(hashes_[std::min(block_end + PointsPerBlock, size()) - 1]);
+  }
 }
 
 using HashFunction = envoy::config::cluster::v3::Cluster::RingHashLbConfig::HashFunction;
 RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_host_weights,
                                  double min_normalized_weight, uint64_t min_ring_size,
                                  uint64_t max_ring_size, HashFunction hash_function,
-                                 bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats)
+                                 bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats,
+                                 const Ring* previous_ring, std::vector<RingEntry>* build_buffer)
     : stats_(stats) {
   ENVOY_LOG(trace, "ring hash: building ring");
 
@@ -162,7 +201,8 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
 
   // Reserve memory for the entire ring up front.
   const uint64_t ring_size = std::ceil(scale);
-  ring_.reserve(ring_size);
+  hashes_.reserve(ring_size + PointsPerBlock);
+  host_indices_.reserve(ring_size);
 
   // Populate the hash ring by walking through the (host, weight) pairs in
   // normalized_host_weights, and generating (scale * weight) hashes for each host. Since these
@@ -181,26 +221,84 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
   // For stats reporting, keep track of the minimum and maximum actual number of hashes per host.
   // Users should hopefully pay attention to these numbers and alert if min_hashes_per_host is too
   // low, since that implies an inaccurate request distribution.
-
-  absl::InlinedVector<char, 196> hash_key_buffer;
+  //
+  // When a previous ring is available, a host that keeps both its hash key and its number of hashes
+  // contributes exactly the same points as before. Only the points of new or changed hosts are
+  // then hashed and sorted, and merged with the surviving points of the previous ring. Since the
+  // number of hashes follows from the running sums above, this only pays off when hosts are
+  // replaced without changing the number or weights of the hosts; adding or removing a host shifts
+  // the number of hashes of most other hosts. Duplicate hash keys would make the order of equal
+  // hashes depend on the merge, so they force a full build.
+
+  // First pass: compute the number of hashes per host without hashing anything.
   double current_hashes = 0.0;
   double target_hashes = 0.0;
   uint64_t min_hashes_per_host = ring_size;
   uint64_t max_hashes_per_host = 0;
+  bool incremental = previous_ring != nullptr && previous_ring->size() > 0;
+  absl::flat_hash_set<absl::string_view> hash_keys;
+  std::vector<uint64_t> hash_counts;
+  hash_counts.reserve(normalized_host_weights.size());
+  hosts_.reserve(normalized_host_weights.size());
+  host_hashes_.reserve(normalized_host_weights.size());
   for (const auto& entry : normalized_host_weights) {
     const auto& host = entry.first;
     const absl::string_view key_to_hash = hashKey(host, use_hostname_for_hashing);
     ASSERT(!key_to_hash.empty());
 
+    // As noted above: maintain current_hashes and target_hashes as running sums across the entire
+    // host set.
+    target_hashes += scale * entry.second;
+    uint64_t count = 0;
+    while (current_hashes < target_hashes) {
+      ++count;
+      ++current_hashes;
+    }
+    min_hashes_per_host = std::min(count, min_hashes_per_host);
+    max_hashes_per_host = std::max(count, max_hashes_per_host);
+    if (count > 0) {
+      host_hashes_[host.get()] = {std::string(key_to_hash), count,
+                                  static_cast<uint32_t>(hosts_.size())};
+      hosts_.push_back(host);
+      hash_counts.push_back(count);
+      incremental = incremental && hash_keys.insert(key_to_hash).second;
+    }
+  }
+
+  // Second pass: hash the points of every host that can't be copied from the previous ring.
+  // previous_host_indices maps the index of a host in the previous ring to its index in this one,
+  // or to NoHost if its points can't be reused.
+  constexpr uint32_t NoHost = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> previous_host_indices;
+  if (incremental) {
+    previous_host_indices.resize(previous_ring->hosts_.size(), NoHost);
+  }
+  std::vector<RingEntry> local_build_buffer;
+  std::vector<RingEntry>& new_entries =
+      build_buffer != nullptr ? *build_buffer : local_build_buffer;
+  new_entries.clear();
+  uint64_t reused_hosts = 0;
+  absl::InlinedVector<char, 196> hash_key_buffer;
+  for (uint32_t host_index = 0; host_index < hosts_.size(); ++host_index) {
+    const auto& host = hosts_[host_index];
+    const uint64_t count = hash_counts[host_index];
+    const std::string& key_to_hash = host_hashes_[host.get()].key_;
+    if (incremental) {
+      const auto it = previous_ring->host_hashes_.find(host.get());
+      if (it != previous_ring->host_hashes_.end() && it->second.count_ == count &&
+          it->second.key_ == key_to_hash) {
+        previous_host_indices[it->second.index_] = host_index;
+        ++reused_hosts;
+        continue;
+      }
+    }
+
     hash_key_buffer.assign(key_to_hash.begin(), key_to_hash.end());
     hash_key_buffer.emplace_back('_');
     auto offset_start = hash_key_buffer.end();
 
-    // As noted above: maintain current_hashes and target_hashes as running sums across the entire
-    // host set. `i` is needed only to construct the hash key, and tally min/max hashes per host.
-    target_hashes += scale * entry.second;
-    uint64_t i = 0;
-    while (current_hashes < target_hashes) {
+    // `i` is needed only to construct the hash key.
+    for (uint64_t i = 0; i < count; ++i) {
       const std::string i_str = absl::StrCat("", i);
       hash_key_buffer.insert(offset_start, i_str.begin(), i_str.end());
 
@@ -213,22 +311,46 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
               : HashUtil::xxHash64(hash_key);
 
       ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key, hash);
-      ring_.push_back({hash, host});
-      ++i;
-      ++current_hashes;
+      new_entries.push_back({hash, host_index});
       hash_key_buffer.erase(offset_start, hash_key_buffer.end());
     }
-    min_hashes_per_host = std::min(i, min_hashes_per_host);
-    max_hashes_per_host = std::max(i, max_hashes_per_host);
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
-    return lhs.hash_ < rhs.hash_;
-  });
+  std::sort(new_entries.begin(), new_entries.end(),
+            [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
+              return lhs.hash_ < rhs.hash_;
+            });
+  const auto add_point = [this](uint64_t hash, uint32_t host_index) {
+    hashes_.push_back(hash);
+    host_indices_.push_back(host_index);
+  };
+  auto new_it = new_entries.begin();
+  if (reused_hosts > 0) {
+    ENVOY_LOG(trace, "ring hash: reusing the points of {} of {} hosts", reused_hosts,
+              hosts_.size());
+    for (size_t i = 0; i < previous_ring->size(); ++i) {
+      const uint32_t host_index = previous_host_indices[previous_ring->host_indices_[i]];
+      if (host_index == NoHost) {
+        continue;
+      }
+      const uint64_t hash = previous_ring->hashes_[i];
+      for (; new_it != new_entries.end() && new_it->hash_ < hash; ++new_it) {
+        add_point(new_it->hash_, new_it->host_index_);
+      }
+      add_point(hash, host_index);
+    }
+  }
+  for (; new_it != new_entries.end(); ++new_it) {
+    add_point(new_it->hash_, new_it->host_index_);
+  }
+  new_entries.clear();
+  buildBlockIndex();
+
   if (ENVOY_LOG_CHECK_LEVEL(trace)) {
-    for (const auto& entry : ring_) {
-      const absl::string_view key_to_hash = hashKey(entry.host_, use_hostname_for_hashing);
-      ENVOY_LOG(trace, "ring hash: host={} hash={}", key_to_hash, entry.hash_);
+    for (size_t i = 0; i < size(); ++i) {
+      const absl::string_view key_to_hash =
+          hashKey(hosts_[host_indices_[i]], use_hostname_for_hashing);
+      ENVOY_LOG(trace, "ring hash: host={} hash={}", key_to_hash, hashes_[i]);
     }
   }
 
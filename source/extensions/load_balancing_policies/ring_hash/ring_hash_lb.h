@@ -13,6 +13,8 @@
 #include "source/common/common/logger.h"
 #include "source/extensions/load_balancing_policies/common/thread_aware_lb_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -89,20 +91,49 @@ public:
 private:
   using HashFunction = envoy::config::cluster::v3::Cluster::RingHashLbConfig::HashFunction;
 
+  // A ring point while the ring is being built. host_index_ indexes Ring::hosts_.
   struct RingEntry {
     uint64_t hash_;
-    HostConstSharedPtr host_;
+    uint32_t host_index_;
   };
 
   struct Ring : public HashingLoadBalancer {
+    // If previous_ring is set, the ring points of hosts whose hash key and number of hashes are
+    // unchanged are copied from it instead of being rehashed and resorted. build_buffer is scratch
+    // space for the newly hashed points which is reused across builds.
     Ring(const NormalizedHostWeightVector& normalized_host_weights, double min_normalized_weight,
          uint64_t min_ring_size, uint64_t max_ring_size, HashFunction hash_function,
-         bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats);
+         bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats,
+         const Ring* previous_ring = nullptr, std::vector<RingEntry>* build_buffer = nullptr);
 
     // ThreadAwareLoadBalancerBase::HashingLoadBalancer
     HostSelectionResponse chooseHost(uint64_t hash, uint32_t attempt) const override;
 
-    std::vector<RingEntry> ring_;
+    // Number of points scanned linearly at the end of a lookup: one cache line of hashes.
+    static constexpr size_t PointsPerBlock = 8;
+
+    struct HostHashes {
+      std::string key_;
+      uint64_t count_;
+      uint32_t index_;
+    };
+
+    size_t size() const { return host_indices_.size(); }
+    // Returns the index of the first point whose hash is >= hash, or 0 if there is none.
+    size_t findPoint(uint64_t hash) const;
+    void buildBlockIndex();
+
+    // The ring is kept as a structure of arrays so that a lookup only touches hashes. hashes_ is
+    // sorted and padded with the maximum hash to a whole number of blocks, host_indices_ holds the
+    // index into hosts_ of each point, and block_hashes_ the largest hash of each block. A lookup
+    // binary searches the small block_hashes_ and then scans a single block of hashes_.
+    std::vector<uint64_t> hashes_;
+    std::vector<uint32_t> host_indices_;
+    std::vector<uint64_t> block_hashes_;
+    std::vector<HostConstSharedPtr> hosts_;
+    // The hash key, number of ring points and index in hosts_ of every host on the ring. The hosts
+    // are kept alive by hosts_, so the raw pointers can't be reused while the ring exists.
+    absl::flat_hash_map<const Host*, HostHashes> host_hashes_;
 
     RingHashLoadBalancerStats& stats_;
   };
@@ -110,18 +141,8 @@ private:
 
   // ThreadAwareLoadBalancerBase
   HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
-                     double min_normalized_weight, double /* max_normalized_weight */) override {
-    HashingLoadBalancerSharedPtr ring_hash_lb =
-        std::make_shared<Ring>(normalized_host_weights, min_normalized_weight, min_ring_size_,
-                               max_ring_size_, hash_function_, use_hostname_for_hashing_, stats_);
-    if (hash_balance_factor_ == 0) {
-      return ring_hash_lb;
-    }
-
-    return std::make_shared<BoundedLoadHashingLoadBalancer>(
-        ring_hash_lb, std::move(normalized_host_weights), hash_balance_factor_);
-  }
+  createLoadBalancer(uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
+                     double min_normalized_weight, double /* max_normalized_weight */) override;
 
   static RingHashLoadBalancerStats generateStats(Stats::Scope& scope);
 
@@ -135,6 +156,9 @@ private:
   const HashFunction hash_function_;
   const bool use_hostname_for_hashing_;
   const uint32_t hash_balance_factor_;
+  // The last ring built for each priority, used as the base for incremental rebuilds.
+  std::vector<RingConstSharedPtr> rings_per_priority_;
+  std::vector<RingEntry> ring_build_buffer_;
 };
 
 } // namespace Upstream
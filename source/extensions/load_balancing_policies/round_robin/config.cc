@@ -15,8 +15,12 @@ LegacyRoundRobinLbConfig::LegacyRoundRobinLbConfig(const ClusterProto& cluster)
   }
 }
 
-TypedRoundRobinLbConfig::TypedRoundRobinLbConfig(const RoundRobinLbProto& lb_config)
-    : lb_config_(lb_config) {}
+TypedRoundRobinLbConfig::TypedRoundRobinLbConfig(const RoundRobinLbProto& lb_config,
+                                                 uint64_t seed)
+    : lb_config_(lb_config),
+      shared_state_(lb_config.share_rotation_across_workers()
+                        ? std::make_shared<Upstream::RoundRobinSharedState>(seed)
+                        : nullptr) {}
 
 Upstream::LoadBalancerPtr RoundRobinCreator::operator()(
     Upstream::LoadBalancerParams params, OptRef<const Upstream::LoadBalancerConfig> lb_config,
@@ -32,7 +36,8 @@ Upstream::LoadBalancerPtr RoundRobinCreator::operator()(
         params.priority_set, params.local_priority_set, cluster_info.lbStats(), runtime, random,
         PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(cluster_info.lbConfig(),
                                                        healthy_panic_threshold, 100, 50),
-        active_or_legacy.active()->lb_config_, time_source);
+        active_or_legacy.active()->lb_config_, time_source,
+        active_or_legacy.active()->shared_state_);
   } else {
     return std::make_unique<Upstream::RoundRobinLoadBalancer>(
         params.priority_set, params.local_priority_set, cluster_info.lbStats(), runtime, random,
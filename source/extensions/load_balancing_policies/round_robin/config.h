@@ -6,6 +6,7 @@
 
 #include "source/common/common/logger.h"
 #include "source/extensions/load_balancing_policies/common/factory_base.h"
+#include "source/extensions/load_balancing_policies/round_robin/round_robin_lb.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -39,9 +40,11 @@ private:
  */
 class TypedRoundRobinLbConfig : public Upstream::LoadBalancerConfig {
 public:
-  TypedRoundRobinLbConfig(const RoundRobinLbProto& lb_config);
+  TypedRoundRobinLbConfig(const RoundRobinLbProto& lb_config, uint64_t seed = 0);
 
   const RoundRobinLbProto lb_config_;
+  // Rotation shared by the load balancers of all workers, if share_rotation_across_workers is set.
+  const Upstream::RoundRobinSharedStateSharedPtr shared_state_;
 };
 
 struct RoundRobinCreator : public Logger::Loggable<Logger::Id::upstream> {
@@ -58,12 +61,13 @@ public:
   Factory() : FactoryBase("envoy.load_balancing_policies.round_robin") {}
 
   absl::StatusOr<Upstream::LoadBalancerConfigPtr>
-  loadConfig(Server::Configuration::ServerFactoryContext&,
+  loadConfig(Server::Configuration::ServerFactoryContext& context,
              const Protobuf::Message& config) override {
     ASSERT(dynamic_cast<const RoundRobinLbProto*>(&config) != nullptr);
     const RoundRobinLbProto& typed_config = dynamic_cast<const RoundRobinLbProto&>(config);
     // TODO(wbocode): to merge the legacy and typed config and related constructors into one.
-    return Upstream::LoadBalancerConfigPtr{new TypedRoundRobinLbConfig(typed_config)};
+    return Upstream::LoadBalancerConfigPtr{
+        new TypedRoundRobinLbConfig(typed_config, context.api().randomGenerator().random())};
   }
 
   absl::StatusOr<Upstream::LoadBalancerConfigPtr>
@@ -1,10 +1,64 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
+
 #include "source/extensions/load_balancing_policies/common/load_balancer_impl.h"
 
+#include "absl/base/optimization.h"
+
 namespace Envoy {
 namespace Upstream {
 
+/**
+ * Round robin rotations shared by the load balancers of all the workers of a cluster. Each
+ * unweighted pick on any worker advances a single lock free cursor, so the hosts are visited in
+ * one global rotation instead of one independent rotation per worker. Cursors are selected by a
+ * hash of the host source; sources that hash to the same cursor merely interleave their rotations.
+ */
+class RoundRobinSharedState {
+public:
+  explicit RoundRobinSharedState(uint64_t seed) {
+    for (auto& cursor : cursors_) {
+      cursor.value_.store(seed, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @param source_hash supplies the hash of the host source being picked from.
+   * @return the rotation index to use for the next pick from the source.
+   */
+  uint64_t next(size_t source_hash) {
+    return cursor(source_hash).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @param source_hash supplies the hash of the host source being peeked at.
+   * @param ahead supplies how many picks ahead of the next one to peek.
+   * @return the rotation index that pick is expected to use.
+   */
+  uint64_t peek(size_t source_hash, uint64_t ahead) {
+    return cursor(source_hash).load(std::memory_order_relaxed) + ahead;
+  }
+
+private:
+  static constexpr size_t NumCursors = 16;
+
+  // Each cursor lives on its own cache line so that distinct sources do not contend.
+  struct alignas(ABSL_CACHELINE_SIZE) Cursor {
+    std::atomic<uint64_t> value_{};
+  };
+
+  std::atomic<uint64_t>& cursor(size_t source_hash) {
+    return cursors_[source_hash % NumCursors].value_;
+  }
+
+  std::array<Cursor, NumCursors> cursors_;
+};
+
+using RoundRobinSharedStateSharedPtr = std::shared_ptr<RoundRobinSharedState>;
+
 /**
  * A round robin load balancer. When in weighted mode, EDF scheduling is used. When in not
  * weighted mode, simple RR index selection is used.
@@ -34,11 +88,12 @@ public:
       Runtime::Loader& runtime, Random::RandomGenerator& random, uint32_t healthy_panic_threshold,
       const envoy::extensions::load_balancing_policies::round_robin::v3::RoundRobin&
           round_robin_config,
-      TimeSource& time_source)
+      TimeSource& time_source, RoundRobinSharedStateSharedPtr shared_state = nullptr)
       : EdfLoadBalancerBase(
             priority_set, local_priority_set, stats, runtime, random, healthy_panic_threshold,
             LoadBalancerConfigHelper::localityLbConfigFromProto(round_robin_config),
-            LoadBalancerConfigHelper::slowStartConfigFromProto(round_robin_config), time_source) {
+            LoadBalancerConfigHelper::slowStartConfigFromProto(round_robin_config), time_source),
+        shared_state_(std::move(shared_state)) {
     initialize();
   }
 
@@ -65,6 +120,10 @@ private:
     if (i == rr_indexes_.end()) {
       return nullptr;
     }
+    if (shared_state_ != nullptr) {
+      return hosts_to_use[shared_state_->peek(HostsSourceHash()(source), peekahead_index_++) %
+                          hosts_to_use.size()];
+    }
     return hosts_to_use[(i->second + (peekahead_index_)++) % hosts_to_use.size()];
   }
 
@@ -77,9 +136,14 @@ private:
     // host source as the key. This means that each LB decision will require two map lookups in
     // the unweighted case. We might consider trying to optimize this in the future.
     ASSERT(rr_indexes_.find(source) != rr_indexes_.end());
+    if (shared_state_ != nullptr) {
+      return hosts_to_use[shared_state_->next(HostsSourceHash()(source)) % hosts_to_use.size()];
+    }
     return hosts_to_use[rr_indexes_[source]++ % hosts_to_use.size()];
   }
 
+  // Set if the rotation is shared with the load balancers of the other workers.
+  const RoundRobinSharedStateSharedPtr shared_state_;
   uint64_t peekahead_index_{};
   absl::flat_hash_map<HostsSource, uint64_t, HostsSourceHash> rr_indexes_;
 };
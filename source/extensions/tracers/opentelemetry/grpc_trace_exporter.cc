@@ -1,5 +1,6 @@
 #include "source/extensions/tracers/opentelemetry/grpc_trace_exporter.h"
 
+#include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/logger.h"
 #include "source/common/grpc/status.h"
 #include "source/extensions/tracers/opentelemetry/otlp_utils.h"
@@ -11,7 +12,7 @@ namespace OpenTelemetry {
 
 OpenTelemetryGrpcTraceExporter::OpenTelemetryGrpcTraceExporter(
     const Grpc::RawAsyncClientSharedPtr& client)
-    : client_(client),
+    : raw_client_(client), client_(client),
       service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
           "opentelemetry.proto.collector.trace.v1.TraceService.Export")) {}
 
@@ -46,6 +47,15 @@ bool OpenTelemetryGrpcTraceExporter::log(const ExportTraceServiceRequest& reques
   return true;
 }
 
+bool OpenTelemetryGrpcTraceExporter::logSerialized(std::string&& request) {
+  auto buffer = std::make_unique<Buffer::OwnedImpl>(request);
+  raw_client_->sendRaw(service_method_.service()->full_name(), service_method_.name(),
+                       std::move(buffer), *this, Tracing::NullSpan::instance(),
+                       Http::AsyncClient::RequestOptions());
+  ENVOY_LOG(debug, "Exported a trace request of {} bytes", request.size());
+  return true;
+}
+
 } // namespace OpenTelemetry
 } // namespace Tracers
 } // namespace Extensions
@@ -26,7 +26,9 @@ public:
                  Tracing::Span&) override;
 
   bool log(const ExportTraceServiceRequest& request) override;
+  bool logSerialized(std::string&& request) override;
 
+  const Grpc::RawAsyncClientSharedPtr raw_client_;
   Grpc::AsyncClient<ExportTraceServiceRequest, ExportTraceServiceResponse> client_;
   const Protobuf::MethodDescriptor& service_method_;
 };
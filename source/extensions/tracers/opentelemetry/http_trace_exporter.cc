@@ -36,6 +36,11 @@ bool OpenTelemetryHttpTraceExporter::log(const ExportTraceServiceRequest& reques
     return false;
   }
 
+  OpenTelemetryTraceExporter::logExportedSpans(request);
+  return logSerialized(std::move(request_body));
+}
+
+bool OpenTelemetryHttpTraceExporter::logSerialized(std::string&& request) {
   const auto thread_local_cluster =
       cluster_manager_.getThreadLocalCluster(http_service_.http_uri().cluster());
   if (thread_local_cluster == nullptr) {
@@ -59,7 +64,7 @@ bool OpenTelemetryHttpTraceExporter::log(const ExportTraceServiceRequest& reques
   for (const auto& header_pair : parsed_headers_to_add_) {
     message->headers().setReference(header_pair.first, header_pair.second);
   }
-  message->body().add(request_body);
+  message->body().add(request);
 
   const auto options =
       Http::AsyncClient::RequestOptions()
@@ -70,8 +75,6 @@ bool OpenTelemetryHttpTraceExporter::log(const ExportTraceServiceRequest& reques
   Http::AsyncClient::Request* in_flight_request =
       thread_local_cluster->httpAsyncClient().send(std::move(message), *this, options);
 
-  OpenTelemetryTraceExporter::logExportedSpans(request);
-
   if (in_flight_request == nullptr) {
     return false;
   }
@@ -30,6 +30,15 @@ public:
    */
   virtual bool log(const ExportTraceServiceRequest& request) = 0;
 
+  /**
+   * @brief Exports a trace request which was already serialized, e.g. off the worker thread.
+   *
+   * @param request The serialized OTLP trace request.
+   * @return true When the request was sent.
+   * @return false When sending the request failed.
+   */
+  virtual bool logSerialized(std::string&& request) = 0;
+
   /**
    * @brief Logs as debug the number of exported spans.
    *
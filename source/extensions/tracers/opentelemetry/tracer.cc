@@ -1,5 +1,6 @@
 #include "source/extensions/tracers/opentelemetry/tracer.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 
@@ -7,6 +8,8 @@
 
 #include "source/common/common/empty_string.h"
 #include "source/common/common/hex.h"
+#include "source/common/common/lock_guard.h"
+#include "source/common/protobuf/utility.h"
 #include "source/common/tracing/common_values.h"
 #include "source/common/tracing/trace_context_impl.h"
 #include "source/common/version/version.h"
@@ -58,6 +61,91 @@ void callSampler(SamplerSharedPtr sampler, const StreamInfo::StreamInfo& stream_
 
 } // namespace
 
+TailSamplingConfig::TailSamplingConfig(
+    const envoy::config::trace::v3::OpenTelemetryConfig::TailSampling& config)
+    : latency_threshold_(
+          config.has_latency_threshold()
+              ? absl::make_optional(std::chrono::milliseconds(
+                    DurationUtil::durationToMilliseconds(config.latency_threshold())))
+              : absl::nullopt),
+      healthy_sample_rate_(PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(
+          config, healthy_sample_percentage, 10000, 0)),
+      max_healthy_traces_per_second_(
+          config.has_max_healthy_traces_per_second()
+              ? absl::make_optional(config.max_healthy_traces_per_second().value())
+              : absl::nullopt),
+      max_buffered_spans_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_buffered_spans, 1024)) {}
+
+ExportBatch::ExportBatch(const ::opentelemetry::proto::trace::v1::ResourceSpans& resource_spans) {
+  ::opentelemetry::proto::trace::v1::ResourceSpans* batch_resource_spans =
+      request_.add_resource_spans();
+  *batch_resource_spans = resource_spans;
+  scope_spans_ = batch_resource_spans->mutable_scope_spans(0);
+}
+
+ExportSerializer::ExportSerializer(Thread::ThreadFactory& thread_factory)
+    : thread_(thread_factory.createThread([this]() -> void { threadRoutine(); },
+                                          Thread::Options{"OTelTraceExport"})) {}
+
+ExportSerializer::~ExportSerializer() {
+  {
+    Thread::LockGuard lock(lock_);
+    exit_ = true;
+    job_event_.notifyOne();
+  }
+  thread_->join();
+}
+
+void ExportSerializer::serialize(const void* owner, ExportBatchPtr batch,
+                                 Event::Dispatcher& dispatcher, DoneCb done) {
+  Thread::LockGuard lock(lock_);
+  jobs_.push_back(Job{owner, std::move(batch), &dispatcher, std::move(done)});
+  job_event_.notifyOne();
+}
+
+void ExportSerializer::cancel(const void* owner) {
+  Thread::LockGuard lock(lock_);
+  jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+                             [owner](const Job& job) { return job.owner_ == owner; }),
+              jobs_.end());
+  while (active_owner_ == owner) {
+    // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+    done_event_.wait(lock_);
+  }
+}
+
+void ExportSerializer::threadRoutine() {
+  while (true) {
+    Job job;
+    {
+      Thread::LockGuard lock(lock_);
+      while (jobs_.empty() && !exit_) {
+        job_event_.wait(lock_);
+      }
+      if (exit_) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+      active_owner_ = job.owner_;
+    }
+
+    std::string request;
+    if (job.batch_->request_.SerializeToString(&request)) {
+      job.dispatcher_->post([done = std::move(job.done_), request = std::move(request)]() mutable {
+        done(std::move(request));
+      });
+    } else {
+      ENVOY_LOG(warn, "Error while serializing the binary proto ExportTraceServiceRequest.");
+    }
+    job.batch_.reset();
+
+    Thread::LockGuard lock(lock_);
+    active_owner_ = nullptr;
+    done_event_.notifyAll();
+  }
+}
+
 Span::Span(const std::string& name, const StreamInfo::StreamInfo& stream_info,
            SystemTime start_time, Envoy::TimeSource& time_source, Tracer& parent_tracer,
            OTelSpanKind span_kind)
@@ -74,19 +162,52 @@ Tracing::SpanPtr Span::spawnChild(const Tracing::Config&, const std::string& nam
                                   SystemTime start_time) {
   // Build span_context from the current span, then generate the child span from that context.
   SpanContext span_context(kDefaultVersion, getTraceId(), spanId(), sampled(), tracestate());
-  return parent_tracer_.startSpan(name, stream_info_, start_time, span_context, {},
-                                  ::opentelemetry::proto::trace::v1::Span::SPAN_KIND_CLIENT);
+  auto child = parent_tracer_.createSpan(name, stream_info_, start_time, span_context, {},
+                                         ::opentelemetry::proto::trace::v1::Span::SPAN_KIND_CLIENT);
+  if (parent_tracer_.tailSampling()) {
+    if (tail_trace_ == nullptr) {
+      tail_trace_ = parent_tracer_.newTailSampledTrace();
+    }
+    child->joinTailSampledTrace(tail_trace_);
+  }
+  return child;
 }
 
 void Span::finishSpan() {
   // Call into the parent tracer so we can access the shared exporter.
   span_.set_end_time_unix_nano(
       std::chrono::nanoseconds(time_source_.systemTime().time_since_epoch()).count());
-  if (sampled()) {
-    parent_tracer_.sendSpan(span_);
+  if (!sampled()) {
+    return;
+  }
+  if (!parent_tracer_.tailSampling()) {
+    parent_tracer_.sendSpan(releaseSpan());
+    return;
+  }
+
+  const bool errored = errored_ || span_.status().code() ==
+                                       ::opentelemetry::proto::trace::v1::Status::STATUS_CODE_ERROR;
+  if (tail_root_) {
+    parent_tracer_.finishTailSampledTrace(tail_trace_.get(), releaseSpan(), errored);
+    return;
+  }
+  // A child span that finishes after its root span follows the decision made for the trace.
+  tail_trace_->errored_ |= errored;
+  if (!tail_trace_->keep_.has_value()) {
+    parent_tracer_.holdSpan(*tail_trace_, releaseSpan());
+  } else if (tail_trace_->keep_.value()) {
+    parent_tracer_.sendSpan(releaseSpan());
   }
 }
 
+::opentelemetry::proto::trace::v1::Span Span::releaseSpan() {
+  ::opentelemetry::proto::trace::v1::Span span = std::move(span_);
+  span_.set_trace_id(span.trace_id());
+  span_.set_span_id(span.span_id());
+  span_.set_trace_state(span.trace_state());
+  return span;
+}
+
 void Span::setOperation(absl::string_view operation) { span_.set_name(operation); };
 
 void Span::injectContext(Tracing::TraceContext& trace_context, const Tracing::UpstreamContext&) {
@@ -116,14 +237,9 @@ void Span::setAttribute(absl::string_view name, const OTelAttribute& attribute_v
     }
   }
   // If we haven't found an existing match already, we can add a new key/value.
-  opentelemetry::proto::common::v1::KeyValue key_value =
-      opentelemetry::proto::common::v1::KeyValue();
-  opentelemetry::proto::common::v1::AnyValue value_proto =
-      opentelemetry::proto::common::v1::AnyValue();
-  OtlpUtils::populateAnyValue(value_proto, attribute_value);
-  key_value.set_key(std::string{name});
-  *key_value.mutable_value() = value_proto;
-  *span_.add_attributes() = key_value;
+  opentelemetry::proto::common::v1::KeyValue* key_value = span_.add_attributes();
+  key_value->set_key(std::string{name});
+  OtlpUtils::populateAnyValue(*key_value->mutable_value(), attribute_value);
 }
 
 ::opentelemetry::proto::trace::v1::Status_StatusCode
@@ -177,6 +293,8 @@ void Span::setTag(absl::string_view name, absl::string_view value) {
             ::opentelemetry::proto::trace::v1::Status::STATUS_CODE_ERROR);
       }
     }
+  } else if (name == Tracing::Tags::get().Error) {
+    errored_ = value == Tracing::Tags::get().True;
   }
   setAttribute(name, value);
 }
@@ -184,9 +302,30 @@ void Span::setTag(absl::string_view name, absl::string_view value) {
 Tracer::Tracer(OpenTelemetryTraceExporterPtr exporter, Envoy::TimeSource& time_source,
                Random::RandomGenerator& random, Runtime::Loader& runtime,
                Event::Dispatcher& dispatcher, OpenTelemetryTracerStats tracing_stats,
-               const ResourceConstSharedPtr resource, SamplerSharedPtr sampler)
+               const ResourceConstSharedPtr resource, SamplerSharedPtr sampler,
+               TailSamplingConfigConstSharedPtr tail_sampling,
+               ExportSerializerSharedPtr export_serializer)
     : exporter_(std::move(exporter)), time_source_(time_source), random_(random), runtime_(runtime),
-      tracing_stats_(tracing_stats), resource_(resource), sampler_(sampler) {
+      dispatcher_(dispatcher), export_serializer_(std::move(export_serializer)),
+      tracing_stats_(tracing_stats), resource_(resource), sampler_(sampler),
+      tail_sampling_(std::move(tail_sampling)) {
+  // A request consists of ResourceSpans.
+  resource_spans_.set_schema_url(resource_->schema_url_);
+
+  // add resource attributes
+  for (auto const& att : resource_->attributes_) {
+    opentelemetry::proto::common::v1::KeyValue* key_value =
+        resource_spans_.mutable_resource()->add_attributes();
+    key_value->set_key(std::string{att.first});
+    key_value->mutable_value()->set_string_value(std::string{att.second});
+  }
+
+  // set the instrumentation scope name and version
+  ::opentelemetry::proto::trace::v1::ScopeSpans* scope_spans = resource_spans_.add_scope_spans();
+  scope_spans->mutable_scope()->set_name("envoy");
+  scope_spans->mutable_scope()->set_version(Envoy::VersionInfo::version());
+  batch_ = std::make_unique<ExportBatch>(resource_spans_);
+
   flush_timer_ = dispatcher.createTimer([this]() -> void {
     tracing_stats_.timer_flushed_.inc();
     flushSpans();
@@ -195,6 +334,13 @@ Tracer::Tracer(OpenTelemetryTraceExporterPtr exporter, Envoy::TimeSource& time_s
   enableTimer();
 }
 
+Tracer::~Tracer() {
+  // The serializer may outlive this tracer's dispatcher, so it must not post to it anymore.
+  if (export_serializer_ != nullptr) {
+    export_serializer_->cancel(this);
+  }
+}
+
 void Tracer::enableTimer() {
   const uint64_t flush_interval =
       runtime_.snapshot().getInteger("tracing.opentelemetry.flush_interval_ms", 5000U);
@@ -202,75 +348,131 @@ void Tracer::enableTimer() {
 }
 
 void Tracer::flushSpans() {
-  if (span_buffer_.empty()) {
+  if (batch_->scope_spans_->spans().empty()) {
     return;
   }
 
-  ExportTraceServiceRequest request;
-  // A request consists of ResourceSpans.
-  ::opentelemetry::proto::trace::v1::ResourceSpans* resource_span = request.add_resource_spans();
-  resource_span->set_schema_url(resource_->schema_url_);
-
-  // add resource attributes
-  for (auto const& att : resource_->attributes_) {
-    opentelemetry::proto::common::v1::KeyValue key_value =
-        opentelemetry::proto::common::v1::KeyValue();
-    opentelemetry::proto::common::v1::AnyValue value_proto =
-        opentelemetry::proto::common::v1::AnyValue();
-    value_proto.set_string_value(std::string{att.second});
-    key_value.set_key(std::string{att.first});
-    *key_value.mutable_value() = value_proto;
-    (*resource_span->mutable_resource()->add_attributes()) = key_value;
-  }
-
-  ::opentelemetry::proto::trace::v1::ScopeSpans* scope_span = resource_span->add_scope_spans();
-
-  // set the instrumentation scope name and version
-  *scope_span->mutable_scope()->mutable_name() = "envoy";
-  *scope_span->mutable_scope()->mutable_version() = Envoy::VersionInfo::version();
-
-  for (const auto& pending_span : span_buffer_) {
-    (*scope_span->add_spans()) = pending_span;
-  }
   if (exporter_) {
-    tracing_stats_.spans_sent_.add(span_buffer_.size());
-    if (!exporter_->log(request)) {
+    tracing_stats_.spans_sent_.add(batch_->scope_spans_->spans_size());
+    if (export_serializer_ != nullptr) {
+      // The batch is serialized off this worker, and only the serialized request is sent from it.
+      export_serializer_->serialize(
+          this, std::move(batch_), dispatcher_,
+          [this, alive = std::weak_ptr<bool>(alive_)](std::string&& request) {
+            if (!alive.expired() && !exporter_->logSerialized(std::move(request))) {
+              ENVOY_LOG(trace, "Unsuccessful log request to OpenTelemetry trace collector.");
+            }
+          });
+    } else if (!exporter_->log(batch_->request_)) {
       // TODO: should there be any sort of retry or reporting here?
       ENVOY_LOG(trace, "Unsuccessful log request to OpenTelemetry trace collector.");
     }
   } else {
     ENVOY_LOG(info, "Skipping log request to OpenTelemetry: no exporter configured");
   }
-  span_buffer_.clear();
+  batch_ = std::make_unique<ExportBatch>(resource_spans_);
 }
 
-void Tracer::sendSpan(::opentelemetry::proto::trace::v1::Span& span) {
-  span_buffer_.push_back(span);
+void Tracer::sendSpan(::opentelemetry::proto::trace::v1::Span&& span) {
+  // The batch can be bounded so that a high min_flush_spans cannot grow it without limit between
+  // timer flushes. It is unbounded by default.
+  const uint64_t max_pending_spans =
+      runtime_.snapshot().getInteger("tracing.opentelemetry.max_pending_spans", 0U);
+  if (max_pending_spans > 0 &&
+      static_cast<uint64_t>(batch_->scope_spans_->spans_size()) >= max_pending_spans) {
+    tracing_stats_.spans_dropped_.inc();
+    return;
+  }
+
+  // Both messages are on the heap, so moving swaps their fields rather than copying them.
+  *batch_->scope_spans_->add_spans() = std::move(span);
+
   const uint64_t min_flush_spans =
       runtime_.snapshot().getInteger("tracing.opentelemetry.min_flush_spans", 5U);
-  if (span_buffer_.size() >= min_flush_spans) {
+  if (static_cast<uint64_t>(batch_->scope_spans_->spans_size()) >= min_flush_spans) {
     flushSpans();
   }
 }
 
+void Tracer::holdSpan(TailSampledTrace& trace, ::opentelemetry::proto::trace::v1::Span&& span) {
+  if (tail_buffered_spans_ >= tail_sampling_->max_buffered_spans_) {
+    tracing_stats_.spans_dropped_.inc();
+    return;
+  }
+  trace.held_spans_.push_back(std::move(span));
+  tail_buffered_spans_++;
+}
+
+void Tracer::finishTailSampledTrace(TailSampledTrace* trace,
+                                    ::opentelemetry::proto::trace::v1::Span&& root_span,
+                                    bool errored) {
+  bool keep = errored || (trace != nullptr && trace->errored_);
+  if (!keep && tail_sampling_->latency_threshold_.has_value()) {
+    const std::chrono::nanoseconds duration(root_span.end_time_unix_nano() -
+                                            root_span.start_time_unix_nano());
+    keep = duration >= tail_sampling_->latency_threshold_.value();
+  }
+  if (!keep) {
+    keep = sampleHealthyTrace();
+  }
+
+  std::vector<::opentelemetry::proto::trace::v1::Span> held_spans;
+  if (trace != nullptr) {
+    trace->keep_ = keep;
+    tail_buffered_spans_ -= trace->held_spans_.size();
+    held_spans.swap(trace->held_spans_);
+  }
+  if (!keep) {
+    tracing_stats_.tail_sampling_traces_dropped_.inc();
+    return;
+  }
+  tracing_stats_.tail_sampling_traces_kept_.inc();
+  for (auto& held_span : held_spans) {
+    sendSpan(std::move(held_span));
+  }
+  sendSpan(std::move(root_span));
+}
+
+bool Tracer::sampleHealthyTrace() {
+  if (tail_sampling_->healthy_sample_rate_ == 0 ||
+      random_.random() % 10000 >= tail_sampling_->healthy_sample_rate_) {
+    return false;
+  }
+  if (!tail_sampling_->max_healthy_traces_per_second_.has_value()) {
+    return true;
+  }
+  const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+      time_source_.monotonicTime().time_since_epoch());
+  if (now != healthy_traces_window_) {
+    healthy_traces_window_ = now;
+    healthy_traces_kept_ = 0;
+  }
+  if (healthy_traces_kept_ >= tail_sampling_->max_healthy_traces_per_second_.value()) {
+    return false;
+  }
+  healthy_traces_kept_++;
+  return true;
+}
+
 Tracing::SpanPtr Tracer::startSpan(const std::string& operation_name,
                                    const StreamInfo::StreamInfo& stream_info, SystemTime start_time,
                                    Tracing::Decision tracing_decision,
                                    OptRef<const Tracing::TraceContext> trace_context,
                                    OTelSpanKind span_kind) {
   // Create an Tracers::OpenTelemetry::Span class that will contain the OTel span.
-  Span new_span(operation_name, stream_info, start_time, time_source_, *this, span_kind);
+  auto new_span = std::make_unique<Span>(operation_name, stream_info, start_time, time_source_,
+                                         *this, span_kind);
   uint64_t trace_id_high = random_.random();
   uint64_t trace_id = random_.random();
-  new_span.setTraceId(absl::StrCat(Hex::uint64ToHex(trace_id_high), Hex::uint64ToHex(trace_id)));
+  new_span->setTraceId(absl::StrCat(Hex::uint64ToHex(trace_id_high), Hex::uint64ToHex(trace_id)));
   uint64_t span_id = random_.random();
-  new_span.setId(Hex::uint64ToHex(span_id));
+  new_span->setId(Hex::uint64ToHex(span_id));
   if (sampler_) {
-    callSampler(sampler_, stream_info, absl::nullopt, new_span, operation_name, trace_context);
+    callSampler(sampler_, stream_info, absl::nullopt, *new_span, operation_name, trace_context);
   } else {
-    new_span.setSampled(tracing_decision.traced);
+    new_span->setSampled(tracing_decision.traced);
   }
-  return std::make_unique<Span>(new_span);
+  return new_span;
 }
 
 Tracing::SpanPtr Tracer::startSpan(const std::string& operation_name,
@@ -278,27 +480,38 @@ Tracing::SpanPtr Tracer::startSpan(const std::string& operation_name,
                                    const SpanContext& previous_span_context,
                                    OptRef<const Tracing::TraceContext> trace_context,
                                    OTelSpanKind span_kind) {
+  return createSpan(operation_name, stream_info, start_time, previous_span_context, trace_context,
+                    span_kind);
+}
+
+std::unique_ptr<Span> Tracer::createSpan(const std::string& operation_name,
+                                         const StreamInfo::StreamInfo& stream_info,
+                                         SystemTime start_time,
+                                         const SpanContext& previous_span_context,
+                                         OptRef<const Tracing::TraceContext> trace_context,
+                                         OTelSpanKind span_kind) {
   // Create a new span and populate details from the span context.
-  Span new_span(operation_name, stream_info, start_time, time_source_, *this, span_kind);
-  new_span.setTraceId(previous_span_context.traceId());
+  auto new_span = std::make_unique<Span>(operation_name, stream_info, start_time, time_source_,
+                                         *this, span_kind);
+  new_span->setTraceId(previous_span_context.traceId());
   if (!previous_span_context.parentId().empty()) {
-    new_span.setParentId(previous_span_context.parentId());
+    new_span->setParentId(previous_span_context.parentId());
   }
   // Generate a new identifier for the span id.
   uint64_t span_id = random_.random();
-  new_span.setId(Hex::uint64ToHex(span_id));
+  new_span->setId(Hex::uint64ToHex(span_id));
   if (sampler_) {
     // Sampler should make a sampling decision and set tracestate
-    callSampler(sampler_, stream_info, previous_span_context, new_span, operation_name,
+    callSampler(sampler_, stream_info, previous_span_context, *new_span, operation_name,
                 trace_context);
   } else {
     // Respect the previous span's sampled flag.
-    new_span.setSampled(previous_span_context.sampled());
+    new_span->setSampled(previous_span_context.sampled());
     if (!previous_span_context.tracestate().empty()) {
-      new_span.setTracestate(std::string{previous_span_context.tracestate()});
+      new_span->setTracestate(std::string{previous_span_context.tracestate()});
     }
   }
-  return std::make_unique<Span>(new_span);
+  return new_span;
 }
 
 } // namespace OpenTelemetry
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "envoy/api/api.h"
 #include "envoy/common/optref.h"
@@ -10,6 +16,8 @@
 #include "envoy/tracing/trace_driver.h"
 
 #include "source/common/common/logger.h"
+#include "source/common/common/thread.h"
+#include "source/common/protobuf/protobuf.h"
 #include "source/extensions/tracers/common/factory_base.h"
 #include "source/extensions/tracers/opentelemetry/grpc_trace_exporter.h"
 #include "source/extensions/tracers/opentelemetry/resource_detectors/resource_detector.h"
@@ -17,6 +25,7 @@
 #include "source/extensions/tracers/opentelemetry/span_context.h"
 
 #include "absl/strings/escaping.h"
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -24,13 +33,115 @@ namespace Tracers {
 namespace OpenTelemetry {
 
 #define OPENTELEMETRY_TRACER_STATS(COUNTER)                                                        \
+  COUNTER(spans_dropped)                                                                           \
   COUNTER(spans_sent)                                                                              \
+  COUNTER(tail_sampling_traces_dropped)                                                            \
+  COUNTER(tail_sampling_traces_kept)                                                               \
   COUNTER(timer_flushed)
 
 struct OpenTelemetryTracerStats {
   OPENTELEMETRY_TRACER_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+/**
+ * Tail sampling settings shared by the tracers of all workers.
+ */
+struct TailSamplingConfig {
+  TailSamplingConfig(const envoy::config::trace::v3::OpenTelemetryConfig::TailSampling& config);
+
+  const absl::optional<std::chrono::milliseconds> latency_threshold_;
+  // Out of 10000.
+  const uint64_t healthy_sample_rate_;
+  const absl::optional<uint32_t> max_healthy_traces_per_second_;
+  const uint32_t max_buffered_spans_;
+};
+
+using TailSamplingConfigConstSharedPtr = std::shared_ptr<const TailSamplingConfig>;
+
+/**
+ * The finished spans of one request, held by the tail sampler until the local root span of the
+ * request finishes and decides whether they are exported.
+ */
+struct TailSampledTrace {
+  TailSampledTrace(uint64_t& buffered_spans) : buffered_spans_(buffered_spans) {}
+  ~TailSampledTrace() { buffered_spans_ -= held_spans_.size(); }
+
+  // The number of spans held by all traces of the owning tracer.
+  uint64_t& buffered_spans_;
+  std::vector<::opentelemetry::proto::trace::v1::Span> held_spans_;
+  bool errored_{false};
+  // Set once the local root span has finished.
+  absl::optional<bool> keep_;
+};
+
+using TailSampledTraceSharedPtr = std::shared_ptr<TailSampledTrace>;
+
+/**
+ * The finished spans of a tracer waiting to be exported, in an export request whose resource and
+ * instrumentation scope are copied from the tracer's prebuilt blocks.
+ */
+struct ExportBatch {
+  ExportBatch(const ::opentelemetry::proto::trace::v1::ResourceSpans& resource_spans);
+
+  ExportTraceServiceRequest request_;
+  ::opentelemetry::proto::trace::v1::ScopeSpans* scope_spans_;
+};
+
+using ExportBatchPtr = std::unique_ptr<ExportBatch>;
+
+/**
+ * Serializes the export requests of the tracers of all workers on a dedicated thread, so that a
+ * worker only hands its batch over when flushing. Each serialized request is posted back to the
+ * dispatcher of its worker, whose exporter sends it.
+ */
+class ExportSerializer : Logger::Loggable<Logger::Id::tracing> {
+public:
+  using DoneCb = std::function<void(std::string&& request)>;
+
+  ExportSerializer(Thread::ThreadFactory& thread_factory);
+  ~ExportSerializer();
+
+  /**
+   * Queues a batch for serialization.
+   * @param owner supplies the tracer queuing the batch, whose batches may be cancelled.
+   * @param batch supplies the batch.
+   * @param dispatcher supplies the dispatcher the serialized request is posted to.
+   * @param done supplies the callback run on the dispatcher with the serialized request. It is not
+   *        run if serialization fails.
+   */
+  void serialize(const void* owner, ExportBatchPtr batch, Event::Dispatcher& dispatcher,
+                 DoneCb done);
+
+  /**
+   * Drops the queued batches of an owner, and waits for its batch being serialized, if any, to be
+   * posted. Must be called before the owner's dispatcher is destroyed.
+   */
+  void cancel(const void* owner);
+
+private:
+  struct Job {
+    const void* owner_{};
+    ExportBatchPtr batch_;
+    Event::Dispatcher* dispatcher_{};
+    DoneCb done_;
+  };
+
+  void threadRoutine();
+
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar job_event_;
+  Thread::CondVar done_event_;
+  std::deque<Job> jobs_ ABSL_GUARDED_BY(lock_);
+  // The owner of the job being serialized and posted, if any.
+  const void* active_owner_ ABSL_GUARDED_BY(lock_){nullptr};
+  bool exit_ ABSL_GUARDED_BY(lock_){false};
+  Thread::ThreadPtr thread_;
+};
+
+using ExportSerializerSharedPtr = std::shared_ptr<ExportSerializer>;
+
+class Span;
+
 /**
  * OpenTelemetry Tracer. It is stored in TLS and contains the exporter.
  */
@@ -39,9 +150,51 @@ public:
   Tracer(OpenTelemetryTraceExporterPtr exporter, Envoy::TimeSource& time_source,
          Random::RandomGenerator& random, Runtime::Loader& runtime, Event::Dispatcher& dispatcher,
          OpenTelemetryTracerStats tracing_stats, const ResourceConstSharedPtr resource,
-         SamplerSharedPtr sampler);
+         SamplerSharedPtr sampler, TailSamplingConfigConstSharedPtr tail_sampling,
+         ExportSerializerSharedPtr export_serializer);
+  ~Tracer();
+
+  /**
+   * Adds a finished span to the pending batch, moving it in.
+   */
+  void sendSpan(::opentelemetry::proto::trace::v1::Span&& span);
 
-  void sendSpan(::opentelemetry::proto::trace::v1::Span& span);
+  /**
+   * @return whether finished spans go through the tail sampler rather than straight to sendSpan.
+   */
+  bool tailSampling() const { return tail_sampling_ != nullptr; }
+
+  /**
+   * @return a new, empty trace for the tail sampler to hold the spans of a request in.
+   */
+  TailSampledTraceSharedPtr newTailSampledTrace() {
+    return std::make_shared<TailSampledTrace>(tail_buffered_spans_);
+  }
+
+  /**
+   * Holds a finished span until the local root span of its trace finishes. The span is dropped if
+   * the tracer already holds the configured maximum number of spans. The span is moved in.
+   */
+  void holdSpan(TailSampledTrace& trace, ::opentelemetry::proto::trace::v1::Span&& span);
+
+  /**
+   * Decides whether a trace is kept once its local root span has finished, and exports the root
+   * span together with the spans held for the trace if it is.
+   * @param trace supplies the held spans of the trace, or nullptr if the root span has no children.
+   * @param root_span supplies the finished local root span.
+   * @param errored supplies whether the root span recorded an error.
+   */
+  void finishTailSampledTrace(TailSampledTrace* trace,
+                              ::opentelemetry::proto::trace::v1::Span&& root_span, bool errored);
+
+  /**
+   * Creates a span from an existing span context, as startSpan does, without erasing its type.
+   */
+  std::unique_ptr<Span> createSpan(const std::string& operation_name,
+                                   const StreamInfo::StreamInfo& stream_info,
+                                   SystemTime start_time, const SpanContext& previous_span_context,
+                                   OptRef<const Tracing::TraceContext> trace_context,
+                                   OTelSpanKind span_kind);
 
   Tracing::SpanPtr startSpan(const std::string& operation_name,
                              const StreamInfo::StreamInfo& stream_info, SystemTime start_time,
@@ -61,19 +214,35 @@ private:
    */
   void enableTimer();
   /*
-   * Removes all spans from the span buffer and sends them to the collector.
+   * Removes all spans from the span buffer and sends them to the collector. The batch is serialized
+   * and sent by the export serializer if there is one.
    */
   void flushSpans();
+  /**
+   * @return whether a trace that is neither failed nor slow is picked by the random sample.
+   */
+  bool sampleHealthyTrace();
 
   OpenTelemetryTraceExporterPtr exporter_;
   Envoy::TimeSource& time_source_;
   Random::RandomGenerator& random_;
-  std::vector<::opentelemetry::proto::trace::v1::Span> span_buffer_;
+  // The resource and instrumentation scope blocks are populated once, and copied into each batch.
+  ::opentelemetry::proto::trace::v1::ResourceSpans resource_spans_;
+  ExportBatchPtr batch_;
   Runtime::Loader& runtime_;
+  Event::Dispatcher& dispatcher_;
+  const ExportSerializerSharedPtr export_serializer_;
+  // Expires with the tracer, so that serialized requests posted after it is destroyed are dropped.
+  const std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
   Event::TimerPtr flush_timer_;
   OpenTelemetryTracerStats tracing_stats_;
   const ResourceConstSharedPtr resource_;
   SamplerSharedPtr sampler_;
+  const TailSamplingConfigConstSharedPtr tail_sampling_;
+  uint64_t tail_buffered_spans_{};
+  // The second in which healthy_traces_kept_ traces were kept by the random sample.
+  std::chrono::seconds healthy_traces_window_{};
+  uint32_t healthy_traces_kept_{};
 };
 
 /**
@@ -164,12 +333,30 @@ public:
    */
   const ::opentelemetry::proto::trace::v1::Span& spanForTest() const { return span_; }
 
+  /**
+   * Makes the span a child of the trace held by the tail sampler for its parent span.
+   */
+  void joinTailSampledTrace(TailSampledTraceSharedPtr trace) {
+    tail_trace_ = std::move(trace);
+    tail_root_ = false;
+  }
+
 private:
+  /**
+   * Moves the span's protobuf out for export. The ids and tracestate, which may still be read once
+   * the span has finished, are kept.
+   */
+  ::opentelemetry::proto::trace::v1::Span releaseSpan();
+
   ::opentelemetry::proto::trace::v1::Span span_;
   const StreamInfo::StreamInfo& stream_info_;
   Tracer& parent_tracer_;
   Envoy::TimeSource& time_source_;
   bool sampled_;
+  // Tail sampling state. The trace is created when the first child span is spawned.
+  TailSampledTraceSharedPtr tail_trace_;
+  bool tail_root_{true};
+  bool errored_{false};
 };
 
 using TracerPtr = std::unique_ptr<Tracer>;
@@ -157,6 +157,19 @@ AdminImpl::AdminImpl(const std::string& profile_path, Server::Instance& server,
                         "enable",
                         "enables the CPU profiler",
                         {"y", "n"}}}),
+          makeHandler("/continuous_cpuprofiler", "enable/disable the continuous CPU profiler",
+                      MAKE_ADMIN_HANDLER(profiling_handler_.handlerContinuousCpuProfiler), false,
+                      true,
+                      {{Admin::ParamDescriptor::Type::Enum,
+                        "enable",
+                        "enable/disable the continuous CPU profiler",
+                        {"y", "n"}}}),
+          makeHandler("/continuous_cpuprofiler/profile",
+                      "dump the samples of the continuous CPU profiler in pprof format",
+                      MAKE_ADMIN_HANDLER(profiling_handler_.handlerContinuousCpuProfile), false,
+                      false,
+                      {{Admin::ParamDescriptor::Type::String, "thread_id",
+                        "Only include samples taken on the thread with this kernel thread id"}}),
           makeHandler("/heapprofiler", "enable/disable the heap profiler",
                       MAKE_ADMIN_HANDLER(profiling_handler_.handlerHeapProfiler), false, true,
                       {{Admin::ParamDescriptor::Type::Enum,
@@ -223,19 +236,37 @@ AdminImpl::AdminImpl(const std::string& profile_path, Server::Instance& server,
           makeHandler("/ready", "print server state, return 200 if LIVE, otherwise return 503",
                       MAKE_ADMIN_HANDLER(server_info_handler_.handlerReady), false, false),
           stats_handler_.statsHandler(false /* not active mode */),
-          makeHandler("/stats/prometheus", "print server stats in prometheus format",
-                      MAKE_ADMIN_HANDLER(stats_handler_.handlerPrometheusStats), false, false,
+          {"/stats/prometheus", "print server stats in prometheus format",
+           [this](AdminStream& admin_stream) -> Admin::RequestPtr {
+             return stats_handler_.makePrometheusRequest(admin_stream);
+           },
+           false,
+           false,
+           {{ParamDescriptor::Type::Boolean, "usedonly",
+             "Only include stats that have been written by system since restart"},
+            {ParamDescriptor::Type::Boolean, "text_readouts",
+             "Render text_readouts as new gaugues with value 0 (increases Prometheus "
+             "data size)"},
+            {ParamDescriptor::Type::String, "filter",
+             "Regular expression (Google re2) for filtering stats"},
+            {ParamDescriptor::Type::Enum,
+             "histogram_buckets",
+             "Histogram bucket display mode",
+             {"cumulative", "summary"}}}},
+          makeHandler("/stats/snapshot", "print server stats as a binary StatsSnapshot proto",
+                      MAKE_ADMIN_HANDLER(stats_handler_.handlerStatsSnapshot), false, false,
                       {{ParamDescriptor::Type::Boolean, "usedonly",
                         "Only include stats that have been written by system since restart"},
-                       {ParamDescriptor::Type::Boolean, "text_readouts",
-                        "Render text_readouts as new gaugues with value 0 (increases Prometheus "
-                        "data size)"},
                        {ParamDescriptor::Type::String, "filter",
                         "Regular expression (Google re2) for filtering stats"},
                        {ParamDescriptor::Type::Enum,
-                        "histogram_buckets",
-                        "Histogram bucket display mode",
-                        {"cumulative", "summary"}}}),
+                        "type",
+                        "Stat types to include.",
+                        {"All", "Counters", "Histograms", "Gauges"}},
+                       {ParamDescriptor::Type::String, "dictionary_id",
+                        "Id of the dictionary of names known by the collector"},
+                       {ParamDescriptor::Type::String, "known_names",
+                        "Number of names of the dictionary known by the collector"}}),
           makeHandler("/stats/recentlookups", "Show recent stat-name lookups",
                       MAKE_ADMIN_HANDLER(stats_handler_.handlerStatsRecentLookups), false, false),
           makeHandler("/stats/recentlookups/clear", "clear list of stat-name lookups and counter",
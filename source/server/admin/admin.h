@@ -239,6 +239,7 @@ public:
   bool appendLocalOverload() const override { return false; }
   bool appendXForwardedPort() const override { return false; }
   bool addProxyProtocolConnectionState() const override { return true; }
+  OptRef<const Http::FilterLatencyStats> filterLatencyStats() const override { return {}; }
 
 private:
   friend class AdminTestingPeer;
@@ -3,6 +3,8 @@
 #include "source/common/profiler/profiler.h"
 #include "source/server/admin/utils.h"
 
+#include "absl/strings/numbers.h"
+
 namespace Envoy {
 namespace Server {
 
@@ -21,6 +23,11 @@ Http::Code ProfilingHandler::handlerCpuProfiler(Http::ResponseHeaderMap&,
 
   bool enable = enableVal.value() == "y";
   if (enable && !Profiler::Cpu::profilerEnabled()) {
+    // Both profilers are driven by SIGPROF.
+    if (Profiler::ContinuousCpu::isProfilerStarted()) {
+      response.add("failure to start the profiler: the continuous CPU profiler is running");
+      return Http::Code::BadRequest;
+    }
     if (!Profiler::Cpu::startProfiler(profile_path_)) {
       response.add("failure to start the profiler");
       return Http::Code::InternalServerError;
@@ -80,6 +87,64 @@ Http::Code ProfilingHandler::handlerHeapProfiler(Http::ResponseHeaderMap&,
   return res;
 }
 
+Http::Code ProfilingHandler::handlerContinuousCpuProfiler(Http::ResponseHeaderMap&,
+                                                          Buffer::Instance& response,
+                                                          AdminStream& admin_stream) {
+  if (!Profiler::ContinuousCpu::profilerEnabled()) {
+    response.add("The current platform does not support the continuous CPU profiler");
+    return Http::Code::NotImplemented;
+  }
+
+  Http::Utility::QueryParamsMulti query_params = admin_stream.queryParams();
+  const auto enableVal = query_params.getFirstValue("enable");
+  if (query_params.data().size() != 1 || !enableVal.has_value() ||
+      (enableVal.value() != "y" && enableVal.value() != "n")) {
+    response.add("?enable=<y|n>\n");
+    return Http::Code::BadRequest;
+  }
+
+  const bool enable = enableVal.value() == "y";
+  if (enable && !Profiler::ContinuousCpu::isProfilerStarted()) {
+    const absl::Status started = Profiler::ContinuousCpu::startProfiler();
+    if (!started.ok()) {
+      response.add(started.message());
+      return started.code() == absl::StatusCode::kFailedPrecondition
+                 ? Http::Code::BadRequest
+                 : Http::Code::InternalServerError;
+    }
+  } else if (!enable && Profiler::ContinuousCpu::isProfilerStarted()) {
+    Profiler::ContinuousCpu::stopProfiler();
+  }
+
+  response.add("OK\n");
+  return Http::Code::OK;
+}
+
+Http::Code ProfilingHandler::handlerContinuousCpuProfile(Http::ResponseHeaderMap&,
+                                                         Buffer::Instance& response,
+                                                         AdminStream& admin_stream) {
+  Http::Utility::QueryParamsMulti query_params = admin_stream.queryParams();
+  absl::optional<uint32_t> thread_id;
+  const auto thread_id_val = query_params.getFirstValue("thread_id");
+  if (thread_id_val.has_value()) {
+    uint32_t value;
+    if (!absl::SimpleAtoi(thread_id_val.value(), &value)) {
+      response.add("?thread_id=<kernel thread id>\n");
+      return Http::Code::BadRequest;
+    }
+    thread_id = value;
+  }
+
+  const auto profile = Profiler::ContinuousCpu::profile(thread_id);
+  if (!profile.ok()) {
+    response.add(profile.status().message());
+    return profile.status().code() == absl::StatusCode::kUnimplemented ? Http::Code::NotImplemented
+                                                                       : Http::Code::BadRequest;
+  }
+  response.add(profile.value());
+  return Http::Code::OK;
+}
+
 Http::Code TcmallocProfilingHandler::handlerHeapDump(Http::ResponseHeaderMap&,
                                                      Buffer::Instance& response, AdminStream&) {
   auto dump_result = Profiler::TcmallocProfiler::tcmallocHeapProfile();
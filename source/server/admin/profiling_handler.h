@@ -21,6 +21,12 @@ public:
   Http::Code handlerHeapProfiler(Http::ResponseHeaderMap& response_headers,
                                  Buffer::Instance& response, AdminStream&);
 
+  Http::Code handlerContinuousCpuProfiler(Http::ResponseHeaderMap& response_headers,
+                                          Buffer::Instance& response, AdminStream&);
+
+  Http::Code handlerContinuousCpuProfile(Http::ResponseHeaderMap& response_headers,
+                                         Buffer::Instance& response, AdminStream&);
+
 private:
   const std::string profile_path_;
 };
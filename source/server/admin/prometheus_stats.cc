@@ -1,11 +1,16 @@
 #include "source/server/admin/prometheus_stats.h"
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
 
 #include "source/common/common/empty_string.h"
 #include "source/common/common/macros.h"
 #include "source/common/common/regex.h"
 #include "source/common/stats/histogram_impl.h"
+#include "source/common/stats/symbol_table.h"
 #include "source/common/upstream/host_utility.h"
 
 #include "absl/strings/str_cat.h"
@@ -58,9 +63,9 @@ struct MetricLessThan {
 };
 
 struct PrimitiveMetricSnapshotLessThan {
-  bool operator()(const Stats::PrimitiveMetricMetadata* a,
-                  const Stats::PrimitiveMetricMetadata* b) {
-    return a->name() < b->name();
+  bool operator()(const Stats::PrimitiveMetricMetadata& a,
+                  const Stats::PrimitiveMetricMetadata& b) {
+    return a.name() < b.name();
   }
 };
 
@@ -131,150 +136,236 @@ std::string generateHistogramOutput(const Stats::ParentHistogram& histogram,
 };
 
 /**
- * Processes a stat type (counter, gauge, histogram) by generating all output lines, sorting
- * them by tag-extracted metric name, and then outputting them in the correct sorted order into
- * response.
- *
- * @param response The buffer to put the output into.
- * @param used_only Whether to only output stats that are used.
- * @param regex A filter on which stats to output.
- * @param metrics The metrics to output stats for. This must contain all stats of the given type
- *        to be included in the same output.
- * @param generate_output A function which returns the output text for this metric.
- * @param type The name of the prometheus metric type for used in TYPE annotations.
+ * The groups of metrics sharing a key that follow a cursor, collected in key order in one pass
+ * over the metrics of a type. At most max_metrics metrics are held: once the batch is full, the
+ * groups with the largest keys are dropped to make room for smaller ones. A group is never split,
+ * so a single group larger than max_metrics is held whole.
  */
-template <class StatType>
-uint64_t outputStatType(
-    Buffer::Instance& response, const StatsParams& params,
-    const std::vector<Stats::RefcountPtr<StatType>>& metrics,
-    const std::function<std::string(
-        const StatType& metric, const std::string& prefixed_tag_extracted_name)>& generate_output,
-    absl::string_view type, const Stats::CustomStatNamespaces& custom_namespaces) {
-
-  /*
-   * From
-   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
-   *
-   * All lines for a given metric must be provided as one single group, with the optional HELP and
-   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
-   * expositions is preferred but not required, i.e. do not sort if the computational cost is
-   * prohibitive.
-   */
+template <class Key, class Metric, class KeyLessThan> class GroupBatch {
+public:
+  using Groups = std::map<Key, std::vector<Metric>, KeyLessThan>;
 
-  // This is an unsorted collection of dumb-pointers (no need to increment then decrement every
-  // refcount; ownership is held throughout by `metrics`). It is unsorted for efficiency, but will
-  // be sorted before producing the final output to satisfy the "preferred" ordering from the
-  // prometheus spec: metrics will be sorted by their tags' textual representation, which will be
-  // consistent across calls.
-  using StatTypeUnsortedCollection = std::vector<const StatType*>;
-
-  // Return early to avoid crashing when getting the symbol table from the first metric.
-  if (metrics.empty()) {
-    return 0;
+  GroupBatch(KeyLessThan key_less_than, uint64_t max_metrics)
+      : groups_(key_less_than), key_less_than_(key_less_than), max_metrics_(max_metrics) {
+    ASSERT(max_metrics > 0);
   }
 
-  // There should only be one symbol table for all of the stats in the admin
-  // interface. If this assumption changes, the name comparisons in this function
-  // will have to change to compare to convert all StatNames to strings before
-  // comparison.
-  const Stats::SymbolTable& global_symbol_table = metrics.front()->constSymbolTable();
-
-  // Sorted collection of metrics sorted by their tagExtractedName, to satisfy the requirements
-  // of the exposition format.
-  std::map<Stats::StatName, StatTypeUnsortedCollection, Stats::StatNameLessThan> groups(
-      global_symbol_table);
-
-  for (const auto& metric : metrics) {
-    ASSERT(&global_symbol_table == &metric->constSymbolTable());
-    if (!params.shouldShowMetric(*metric)) {
-      continue;
+  void add(const Key& key, Metric metric) {
+    if (num_metrics_ >= max_metrics_ && key_less_than_(groups_.rbegin()->first, key)) {
+      truncated_ = true;
+      return;
+    }
+    groups_[key].push_back(std::move(metric));
+    ++num_metrics_;
+    while (num_metrics_ > max_metrics_ && groups_.size() > 1) {
+      auto last = std::prev(groups_.end());
+      num_metrics_ -= last->second.size();
+      groups_.erase(last);
+      truncated_ = true;
     }
-    groups[metric->tagExtractedStatName()].push_back(metric.get());
   }
 
-  auto result = groups.size();
-  for (auto& group : groups) {
-    const absl::optional<std::string> prefixed_tag_extracted_name =
-        PrometheusStatsFormatter::metricName(global_symbol_table.toString(group.first),
-                                             custom_namespaces);
-    if (!prefixed_tag_extracted_name.has_value()) {
-      --result;
-      continue;
-    }
-    response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name.value(), type));
+  Groups& groups() { return groups_; }
 
-    // Sort before producing the final output to satisfy the "preferred" ordering from the
-    // prometheus spec: metrics will be sorted by their tags' textual representation, which will
-    // be consistent across calls.
-    std::sort(group.second.begin(), group.second.end(), MetricLessThan());
+  /**
+   * @return whether groups following the collected ones were left out of the batch.
+   */
+  bool truncated() const { return truncated_; }
+
+private:
+  Groups groups_;
+  const KeyLessThan key_less_than_;
+  const uint64_t max_metrics_;
+  uint64_t num_metrics_{0};
+  bool truncated_{false};
+};
 
-    for (const auto& metric : group.second) {
-      response.add(generate_output(*metric, prefixed_tag_extracted_name.value()));
+/**
+ * Renders a stat type (counter, gauge, histogram) by grouping the metrics by tag-extracted
+ * metric name, and then rendering the groups in sorted order, one at a time. Rather than grouping
+ * all metrics up front, the groups are collected in bounded batches, each one a pass over the
+ * metrics which resumes after the last group rendered.
+ */
+template <class StatType> class StatGroupRenderer : public PrometheusGroupRenderer {
+public:
+  using SharedPtr = Stats::RefcountPtr<StatType>;
+  using GenerateOutputFn = std::function<std::string(
+      const StatType& metric, const std::string& prefixed_tag_extracted_name)>;
+  // Calls the given function for every metric of the type. A metric may be visited more than
+  // once, e.g. when it is held by overlapping scopes.
+  using ForEachFn = std::function<void(const std::function<void(const SharedPtr&)>&)>;
+
+  /**
+   * @param params the query parameters, used to filter the metrics. These must outlive the
+   *        renderer.
+   * @param symbol_table the symbol table of the metrics, used to order them.
+   * @param for_each the function visiting the metrics, called once per batch.
+   * @param max_batch_metrics the number of metrics held by a batch, see GroupBatch.
+   * @param generate_output a function which returns the output text for a metric.
+   * @param type the name of the prometheus metric type for used in TYPE annotations.
+   */
+  StatGroupRenderer(const StatsParams& params, Stats::SymbolTable& symbol_table,
+                    ForEachFn for_each, uint64_t max_batch_metrics,
+                    GenerateOutputFn generate_output, absl::string_view type,
+                    const Stats::CustomStatNamespaces& custom_namespaces)
+      : params_(params), symbol_table_(symbol_table), for_each_(std::move(for_each)),
+        max_batch_metrics_(max_batch_metrics), generate_output_(std::move(generate_output)),
+        type_(type), custom_namespaces_(custom_namespaces) {}
+
+  // PrometheusGroupRenderer
+  bool renderNextGroup(Buffer::Instance& response) override {
+    /*
+     * From
+     * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
+     *
+     * All lines for a given metric must be provided as one single group, with the optional HELP
+     * and TYPE lines first (in no particular order). Beyond that, reproducible sorting in
+     * repeated expositions is preferred but not required, i.e. do not sort if the computational
+     * cost is prohibitive.
+     */
+    while ((batch_ != nullptr && next_group_ != batch_->groups().end()) || nextBatch()) {
+      auto& group = *next_group_++;
+      const absl::optional<std::string> prefixed_tag_extracted_name =
+          PrometheusStatsFormatter::metricName(symbol_table_.toString(group.first),
+                                               custom_namespaces_);
+      if (!prefixed_tag_extracted_name.has_value()) {
+        continue;
+      }
+      response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name.value(), type_));
+
+      // Sort before producing the final output to satisfy the "preferred" ordering from the
+      // prometheus spec: metrics will be sorted by their tags' textual representation, which will
+      // be consistent across calls. A metric visited more than once then ends up next to itself.
+      std::vector<SharedPtr>& metrics = group.second;
+      std::sort(metrics.begin(), metrics.end(), [](const SharedPtr& a, const SharedPtr& b) {
+        return MetricLessThan()(a.get(), b.get());
+      });
+      metrics.erase(std::unique(metrics.begin(), metrics.end(),
+                                [](const SharedPtr& a, const SharedPtr& b) {
+                                  return a.get() == b.get();
+                                }),
+                    metrics.end());
+
+      for (const auto& metric : metrics) {
+        response.add(generate_output_(*metric, prefixed_tag_extracted_name.value()));
+      }
+      ++group_count_;
+      return true;
     }
+    return false;
   }
-  return result;
-}
 
-template <class StatType>
-uint64_t outputPrimitiveStatType(Buffer::Instance& response, const StatsParams& params,
-                                 const std::vector<StatType>& metrics, absl::string_view type,
-                                 const Stats::CustomStatNamespaces& custom_namespaces) {
-
-  /*
-   * From
-   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
-   *
-   * All lines for a given metric must be provided as one single group, with the optional HELP and
-   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
-   * expositions is preferred but not required, i.e. do not sort if the computational cost is
-   * prohibitive.
-   */
-
-  // This is an unsorted collection of dumb-pointers (no need to increment then decrement every
-  // refcount; ownership is held throughout by `metrics`). It is unsorted for efficiency, but will
-  // be sorted before producing the final output to satisfy the "preferred" ordering from the
-  // prometheus spec: metrics will be sorted by their tags' textual representation, which will be
-  // consistent across calls.
-  using StatTypeUnsortedCollection = std::vector<const StatType*>;
-
-  // Return early to avoid crashing when getting the symbol table from the first metric.
-  if (metrics.empty()) {
-    return 0;
+private:
+  using Batch = GroupBatch<Stats::StatName, SharedPtr, Stats::StatNameLessThan>;
+
+  // Collects the groups following the last batch, releasing its metrics.
+  // @return false if there are none.
+  bool nextBatch() {
+    if (batch_ != nullptr) {
+      if (!batch_->truncated()) {
+        return false;
+      }
+      // The key is copied out as the metrics holding it are released with the batch.
+      cursor_.emplace(batch_->groups().rbegin()->first, symbol_table_);
+    }
+    batch_ = std::make_unique<Batch>(Stats::StatNameLessThan(symbol_table_), max_batch_metrics_);
+    for_each_([this](const SharedPtr& metric) {
+      if (!params_.shouldShowMetric(*metric)) {
+        return;
+      }
+      const Stats::StatName tag_extracted_name = metric->tagExtractedStatName();
+      if (cursor_.has_value() && !symbol_table_.lessThan(cursor_->statName(), tag_extracted_name)) {
+        return;
+      }
+      batch_->add(tag_extracted_name, metric);
+    });
+    next_group_ = batch_->groups().begin();
+    return next_group_ != batch_->groups().end();
   }
 
-  // Sorted collection of metrics sorted by their tagExtractedName, to satisfy the requirements
-  // of the exposition format.
-  std::map<std::string, StatTypeUnsortedCollection> groups;
+  const StatsParams& params_;
+  Stats::SymbolTable& symbol_table_;
+  const ForEachFn for_each_;
+  const uint64_t max_batch_metrics_;
+  const GenerateOutputFn generate_output_;
+  const absl::string_view type_;
+  const Stats::CustomStatNamespaces& custom_namespaces_;
+  // The tag-extracted name of the last group of the previous batch.
+  absl::optional<Stats::StatNameManagedStorage> cursor_;
+  std::unique_ptr<Batch> batch_;
+  typename Batch::Groups::iterator next_group_;
+};
 
-  for (const auto& metric : metrics) {
-    if (!params.shouldShowMetric(metric)) {
-      continue;
+/**
+ * Same as StatGroupRenderer, for the per-host primitive stats.
+ */
+template <class StatType> class PrimitiveStatGroupRenderer : public PrometheusGroupRenderer {
+public:
+  // Calls the given function for every metric of the type.
+  using ForEachFn = std::function<void(const std::function<void(StatType&&)>&)>;
+
+  PrimitiveStatGroupRenderer(const StatsParams& params, ForEachFn for_each,
+                             uint64_t max_batch_metrics, absl::string_view type,
+                             const Stats::CustomStatNamespaces& custom_namespaces)
+      : params_(params), for_each_(std::move(for_each)), max_batch_metrics_(max_batch_metrics),
+        type_(type), custom_namespaces_(custom_namespaces) {}
+
+  // PrometheusGroupRenderer
+  bool renderNextGroup(Buffer::Instance& response) override {
+    while ((batch_ != nullptr && next_group_ != batch_->groups().end()) || nextBatch()) {
+      auto& group = *next_group_++;
+      const absl::optional<std::string> prefixed_tag_extracted_name =
+          PrometheusStatsFormatter::metricName(group.first, custom_namespaces_);
+      if (!prefixed_tag_extracted_name.has_value()) {
+        continue;
+      }
+      response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name.value(), type_));
+
+      std::sort(group.second.begin(), group.second.end(), PrimitiveMetricSnapshotLessThan());
+
+      for (const auto& metric : group.second) {
+        response.add(generateNumericOutput(metric.value(), metric.tags(),
+                                           prefixed_tag_extracted_name.value()));
+      }
+      ++group_count_;
+      return true;
     }
-    groups[metric.tagExtractedName()].push_back(&metric);
+    return false;
   }
 
-  auto result = groups.size();
-  for (auto& group : groups) {
-    const absl::optional<std::string> prefixed_tag_extracted_name =
-        PrometheusStatsFormatter::metricName(group.first, custom_namespaces);
-    if (!prefixed_tag_extracted_name.has_value()) {
-      --result;
-      continue;
-    }
-    response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name.value(), type));
+private:
+  using Batch = GroupBatch<std::string, StatType, std::less<std::string>>;
 
-    // Sort before producing the final output to satisfy the "preferred" ordering from the
-    // prometheus spec: metrics will be sorted by their tags' textual representation, which will
-    // be consistent across calls.
-    std::sort(group.second.begin(), group.second.end(), PrimitiveMetricSnapshotLessThan());
-
-    for (const auto& metric : group.second) {
-      response.add(generateNumericOutput(metric->value(), metric->tags(),
-                                         prefixed_tag_extracted_name.value()));
+  // Same as StatGroupRenderer::nextBatch().
+  bool nextBatch() {
+    if (batch_ != nullptr) {
+      if (!batch_->truncated()) {
+        return false;
+      }
+      cursor_ = batch_->groups().rbegin()->first;
     }
+    batch_ = std::make_unique<Batch>(std::less<std::string>(), max_batch_metrics_);
+    for_each_([this](StatType&& metric) {
+      if (!params_.shouldShowMetric(metric) ||
+          (cursor_.has_value() && metric.tagExtractedName() <= *cursor_)) {
+        return;
+      }
+      const std::string tag_extracted_name = metric.tagExtractedName();
+      batch_->add(tag_extracted_name, std::move(metric));
+    });
+    next_group_ = batch_->groups().begin();
+    return next_group_ != batch_->groups().end();
   }
-  return result;
-}
+
+  const StatsParams& params_;
+  const ForEachFn for_each_;
+  const uint64_t max_batch_metrics_;
+  const absl::string_view type_;
+  const Stats::CustomStatNamespaces& custom_namespaces_;
+  absl::optional<std::string> cursor_;
+  std::unique_ptr<Batch> batch_;
+  typename Batch::Groups::iterator next_group_;
+};
 
 /*
  * Returns the prometheus output for a summary. The output is a multi-line string (with embedded
@@ -305,6 +396,133 @@ std::string generateSummaryOutput(const Stats::ParentHistogram& histogram,
   return output;
 };
 
+uint64_t renderAllGroups(PrometheusGroupRenderer& renderer, Buffer::Instance& response) {
+  while (renderer.renderNextGroup(response)) {
+  }
+  return renderer.groupCount();
+}
+
+/**
+ * @return a function visiting metrics that were already collected.
+ */
+template <class StatType>
+typename StatGroupRenderer<StatType>::ForEachFn
+forEachCollected(const std::vector<Stats::RefcountPtr<StatType>>& metrics) {
+  return [&metrics](const std::function<void(const Stats::RefcountPtr<StatType>&)>& fn) {
+    for (const auto& metric : metrics) {
+      fn(metric);
+    }
+  };
+}
+
+/**
+ * @return a function visiting the metrics of a type held by the scopes of a store. Unlike the
+ * forEach* methods of the store, this does not hold the allocator lock, so that the metrics
+ * dropped from a batch can be released during the walk.
+ */
+template <class StatType>
+typename StatGroupRenderer<StatType>::ForEachFn forEachInStore(const Stats::Store& stats) {
+  return [&stats](const std::function<void(const Stats::RefcountPtr<StatType>&)>& fn) {
+    stats.iterate(Stats::IterateFn<StatType>([&fn](const Stats::RefcountPtr<StatType>& metric) {
+      fn(metric);
+      return true;
+    }));
+  };
+}
+
+StatGroupRenderer<Stats::ParentHistogram>::ForEachFn
+forEachHistogramInStore(const Stats::Store& stats) {
+  return [&stats](const std::function<void(const Stats::ParentHistogramSharedPtr&)>& fn) {
+    stats.iterate(
+        Stats::IterateFn<Stats::Histogram>([&fn](const Stats::HistogramSharedPtr& histogram) {
+          // Only the histograms merged across threads have statistics to render.
+          auto* parent_histogram = dynamic_cast<Stats::ParentHistogram*>(histogram.get());
+          if (parent_histogram != nullptr) {
+            fn(Stats::ParentHistogramSharedPtr(parent_histogram));
+          }
+          return true;
+        }));
+  };
+}
+
+PrometheusGroupRendererPtr counterRenderer(const StatsParams& params,
+                                           Stats::SymbolTable& symbol_table,
+                                           StatGroupRenderer<Stats::Counter>::ForEachFn for_each,
+                                           uint64_t max_batch_metrics,
+                                           const Stats::CustomStatNamespaces& custom_namespaces) {
+  return std::make_unique<StatGroupRenderer<Stats::Counter>>(
+      params, symbol_table, std::move(for_each), max_batch_metrics,
+      generateStatNumericOutput<Stats::Counter>, "counter", custom_namespaces);
+}
+
+PrometheusGroupRendererPtr gaugeRenderer(const StatsParams& params,
+                                         Stats::SymbolTable& symbol_table,
+                                         StatGroupRenderer<Stats::Gauge>::ForEachFn for_each,
+                                         uint64_t max_batch_metrics,
+                                         const Stats::CustomStatNamespaces& custom_namespaces) {
+  return std::make_unique<StatGroupRenderer<Stats::Gauge>>(
+      params, symbol_table, std::move(for_each), max_batch_metrics,
+      generateStatNumericOutput<Stats::Gauge>, "gauge", custom_namespaces);
+}
+
+PrometheusGroupRendererPtr
+textReadoutRenderer(const StatsParams& params, Stats::SymbolTable& symbol_table,
+                    StatGroupRenderer<Stats::TextReadout>::ForEachFn for_each,
+                    uint64_t max_batch_metrics,
+                    const Stats::CustomStatNamespaces& custom_namespaces) {
+  // TextReadout stats are returned in gauge format, so "gauge" type is set intentionally.
+  return std::make_unique<StatGroupRenderer<Stats::TextReadout>>(
+      params, symbol_table, std::move(for_each), max_batch_metrics, generateTextReadoutOutput,
+      "gauge", custom_namespaces);
+}
+
+PrometheusGroupRendererPtr
+histogramRenderer(const StatsParams& params, Stats::SymbolTable& symbol_table,
+                  StatGroupRenderer<Stats::ParentHistogram>::ForEachFn for_each,
+                  uint64_t max_batch_metrics,
+                  const Stats::CustomStatNamespaces& custom_namespaces) {
+  // validation of bucket modes is handled separately
+  switch (params.histogram_buckets_mode_) {
+  case Utility::HistogramBucketsMode::Summary:
+    return std::make_unique<StatGroupRenderer<Stats::ParentHistogram>>(
+        params, symbol_table, std::move(for_each), max_batch_metrics, generateSummaryOutput,
+        "summary", custom_namespaces);
+  case Utility::HistogramBucketsMode::Unset:
+  case Utility::HistogramBucketsMode::Cumulative:
+    return std::make_unique<StatGroupRenderer<Stats::ParentHistogram>>(
+        params, symbol_table, std::move(for_each), max_batch_metrics, generateHistogramOutput,
+        "histogram", custom_namespaces);
+  // "Detailed" and "Disjoint" don't make sense for prometheus histogram semantics
+  case Utility::HistogramBucketsMode::Detailed:
+  case Utility::HistogramBucketsMode::Disjoint:
+    IS_ENVOY_BUG("unsupported prometheus histogram bucket mode");
+    break;
+  }
+  return std::make_unique<StatGroupRenderer<Stats::ParentHistogram>>(
+      params, symbol_table, [](const auto&) {}, max_batch_metrics, generateHistogramOutput,
+      "histogram", custom_namespaces);
+}
+
+/**
+ * @return a function visiting the per-host counters or gauges of the clusters.
+ */
+PrimitiveStatGroupRenderer<Stats::PrimitiveCounterSnapshot>::ForEachFn
+forEachHostCounter(const Upstream::ClusterManager& cluster_manager) {
+  return [&cluster_manager](
+             const std::function<void(Stats::PrimitiveCounterSnapshot&&)>& counter_fn) {
+    Upstream::HostUtility::forEachHostMetric(cluster_manager, counter_fn,
+                                             [](Stats::PrimitiveGaugeSnapshot&&) {});
+  };
+}
+
+PrimitiveStatGroupRenderer<Stats::PrimitiveGaugeSnapshot>::ForEachFn
+forEachHostGauge(const Upstream::ClusterManager& cluster_manager) {
+  return [&cluster_manager](const std::function<void(Stats::PrimitiveGaugeSnapshot&&)>& gauge_fn) {
+    Upstream::HostUtility::forEachHostMetric(
+        cluster_manager, [](Stats::PrimitiveCounterSnapshot&&) {}, gauge_fn);
+  };
+}
+
 } // namespace
 
 std::string PrometheusStatsFormatter::formattedTags(const std::vector<Stats::Tag>& tags) {
@@ -365,57 +583,119 @@ uint64_t PrometheusStatsFormatter::statsAsPrometheus(
     const std::vector<Stats::TextReadoutSharedPtr>& text_readouts,
     const Upstream::ClusterManager& cluster_manager, Buffer::Instance& response,
     const StatsParams& params, const Stats::CustomStatNamespaces& custom_namespaces) {
-
+  // The stats were already collected, so each type is grouped in a single batch.
+  constexpr uint64_t Unbounded = std::numeric_limits<uint64_t>::max();
   uint64_t metric_name_count = 0;
-  metric_name_count += outputStatType<Stats::Counter>(response, params, counters,
-                                                      generateStatNumericOutput<Stats::Counter>,
-                                                      "counter", custom_namespaces);
-
-  metric_name_count += outputStatType<Stats::Gauge>(response, params, gauges,
-                                                    generateStatNumericOutput<Stats::Gauge>,
-                                                    "gauge", custom_namespaces);
-
-  // TextReadout stats are returned in gauge format, so "gauge" type is set intentionally.
-  metric_name_count += outputStatType<Stats::TextReadout>(
-      response, params, text_readouts, generateTextReadoutOutput, "gauge", custom_namespaces);
-
-  // validation of bucket modes is handled separately
-  switch (params.histogram_buckets_mode_) {
-  case Utility::HistogramBucketsMode::Summary:
-    metric_name_count += outputStatType<Stats::ParentHistogram>(
-        response, params, histograms, generateSummaryOutput, "summary", custom_namespaces);
-    break;
-  case Utility::HistogramBucketsMode::Unset:
-  case Utility::HistogramBucketsMode::Cumulative:
-    metric_name_count += outputStatType<Stats::ParentHistogram>(
-        response, params, histograms, generateHistogramOutput, "histogram", custom_namespaces);
-    break;
-  // "Detailed" and "Disjoint" don't make sense for prometheus histogram semantics
-  case Utility::HistogramBucketsMode::Detailed:
-  case Utility::HistogramBucketsMode::Disjoint:
-    IS_ENVOY_BUG("unsupported prometheus histogram bucket mode");
-    break;
+  if (!counters.empty()) {
+    metric_name_count += renderAllGroups(
+        *counterRenderer(params, counters.front()->symbolTable(), forEachCollected(counters),
+                         Unbounded, custom_namespaces),
+        response);
+  }
+  if (!gauges.empty()) {
+    metric_name_count += renderAllGroups(
+        *gaugeRenderer(params, gauges.front()->symbolTable(), forEachCollected(gauges), Unbounded,
+                       custom_namespaces),
+        response);
+  }
+  if (!text_readouts.empty()) {
+    metric_name_count += renderAllGroups(
+        *textReadoutRenderer(params, text_readouts.front()->symbolTable(),
+                             forEachCollected(text_readouts), Unbounded, custom_namespaces),
+        response);
+  }
+  if (!histograms.empty()) {
+    metric_name_count += renderAllGroups(
+        *histogramRenderer(params, histograms.front()->symbolTable(),
+                           forEachCollected(histograms), Unbounded, custom_namespaces),
+        response);
   }
 
   // Note: This assumes that there is no overlap in stat name between per-endpoint stats and all
   // other stats. If this is not true, then the counters/gauges for per-endpoint need to be combined
   // with the above counter/gauge calls so that stats can be properly grouped.
-  std::vector<Stats::PrimitiveCounterSnapshot> host_counters;
-  std::vector<Stats::PrimitiveGaugeSnapshot> host_gauges;
-  Upstream::HostUtility::forEachHostMetric(
-      cluster_manager,
-      [&](Stats::PrimitiveCounterSnapshot&& metric) {
-        host_counters.emplace_back(std::move(metric));
-      },
-      [&](Stats::PrimitiveGaugeSnapshot&& metric) { host_gauges.emplace_back(std::move(metric)); });
+  PrimitiveStatGroupRenderer<Stats::PrimitiveCounterSnapshot> host_counter_renderer(
+      params, forEachHostCounter(cluster_manager), Unbounded, "counter", custom_namespaces);
+  metric_name_count += renderAllGroups(host_counter_renderer, response);
+  PrimitiveStatGroupRenderer<Stats::PrimitiveGaugeSnapshot> host_gauge_renderer(
+      params, forEachHostGauge(cluster_manager), Unbounded, "gauge", custom_namespaces);
+  metric_name_count += renderAllGroups(host_gauge_renderer, response);
 
-  metric_name_count +=
-      outputPrimitiveStatType(response, params, host_counters, "counter", custom_namespaces);
+  return metric_name_count;
+}
 
-  metric_name_count +=
-      outputPrimitiveStatType(response, params, host_gauges, "gauge", custom_namespaces);
+PrometheusStatsRequest::PrometheusStatsRequest(Stats::Store& stats, const StatsParams& params,
+                                               const Upstream::ClusterManager& cluster_manager,
+                                               const Stats::CustomStatNamespaces& custom_namespaces)
+    : stats_(stats), params_(params), cluster_manager_(cluster_manager),
+      custom_namespaces_(custom_namespaces) {}
 
-  return metric_name_count;
+Http::Code PrometheusStatsRequest::start(Http::ResponseHeaderMap&) {
+  renderer_ = counterRenderer(params_, stats_.symbolTable(), forEachInStore<Stats::Counter>(stats_),
+                              max_batch_metrics_, custom_namespaces_);
+  return Http::Code::OK;
+}
+
+bool PrometheusStatsRequest::nextChunk(Buffer::Instance& response) {
+  // nextChunk's contract is to add up to chunk_size_ additional bytes. The
+  // caller is not required to drain the bytes after each call to nextChunk.
+  const uint64_t starting_response_length = response.length();
+  while (response.length() - starting_response_length < chunk_size_) {
+    if (!renderer_->renderNextGroup(response)) {
+      nextPhase();
+      if (phase_ == Phase::Done) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void PrometheusStatsRequest::nextPhase() {
+  // Each phase walks the store again for every batch of groups, so only one batch of stats is
+  // referenced at a time.
+  switch (phase_) {
+  case Phase::Counters:
+    phase_ = Phase::Gauges;
+    renderer_ = gaugeRenderer(params_, stats_.symbolTable(), forEachInStore<Stats::Gauge>(stats_),
+                              max_batch_metrics_, custom_namespaces_);
+    break;
+  case Phase::Gauges:
+    phase_ = Phase::TextReadouts;
+    renderer_ = textReadoutRenderer(
+        params_, stats_.symbolTable(),
+        params_.prometheus_text_readouts_
+            ? forEachInStore<Stats::TextReadout>(stats_)
+            : StatGroupRenderer<Stats::TextReadout>::ForEachFn([](const auto&) {}),
+        max_batch_metrics_, custom_namespaces_);
+    break;
+  case Phase::TextReadouts:
+    phase_ = Phase::Histograms;
+    renderer_ = histogramRenderer(params_, stats_.symbolTable(), forEachHistogramInStore(stats_),
+                                  max_batch_metrics_, custom_namespaces_);
+    break;
+  case Phase::Histograms:
+    phase_ = Phase::HostCounters;
+    // Note: This assumes that there is no overlap in stat name between per-endpoint stats and
+    // all other stats, as in statsAsPrometheus().
+    renderer_ = std::make_unique<PrimitiveStatGroupRenderer<Stats::PrimitiveCounterSnapshot>>(
+        params_, forEachHostCounter(cluster_manager_), max_batch_metrics_, "counter",
+        custom_namespaces_);
+    break;
+  case Phase::HostCounters:
+    phase_ = Phase::HostGauges;
+    renderer_ = std::make_unique<PrimitiveStatGroupRenderer<Stats::PrimitiveGaugeSnapshot>>(
+        params_, forEachHostGauge(cluster_manager_), max_batch_metrics_, "gauge",
+        custom_namespaces_);
+    break;
+  case Phase::HostGauges:
+    renderer_.reset();
+    phase_ = Phase::Done;
+    break;
+  case Phase::Done:
+    IS_ENVOY_BUG("advancing past the last prometheus phase");
+    break;
+  }
 }
 
 } // namespace Server
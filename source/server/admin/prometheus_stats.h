@@ -4,9 +4,13 @@
 #include <string>
 
 #include "envoy/buffer/buffer.h"
+#include "envoy/server/admin.h"
 #include "envoy/stats/custom_stat_namespaces.h"
 #include "envoy/stats/histogram.h"
+#include "envoy/stats/primitive_stats.h"
 #include "envoy/stats/stats.h"
+#include "envoy/stats/store.h"
+#include "envoy/upstream/cluster_manager.h"
 
 #include "source/server/admin/stats_params.h"
 
@@ -53,5 +57,74 @@ public:
              const Stats::CustomStatNamespaces& custom_namespace_factory);
 };
 
+/**
+ * Renders the metrics of one stat type, one group of metrics sharing a tag-extracted name at a
+ * time, so that the exposition can be produced incrementally.
+ */
+class PrometheusGroupRenderer {
+public:
+  virtual ~PrometheusGroupRenderer() = default;
+
+  /**
+   * Renders the next group of metrics into the response.
+   * @return false if all groups were already rendered.
+   */
+  virtual bool renderNextGroup(Buffer::Instance& response) PURE;
+
+  /**
+   * @return the number of groups rendered so far.
+   */
+  uint64_t groupCount() const { return group_count_; }
+
+protected:
+  uint64_t group_count_{0};
+};
+
+using PrometheusGroupRendererPtr = std::unique_ptr<PrometheusGroupRenderer>;
+
+/**
+ * Streams the prometheus exposition of a store in chunks. The stats of each type are walked in
+ * batches: each walk of the store collects, in tag-extracted name order, the groups following the
+ * last one rendered, up to a bounded number of stats. The groups are rendered until the chunk
+ * size is reached. Only the references to one batch of stats and the current chunk are held in
+ * memory, rather than all the stats of a type or the text of the whole exposition.
+ */
+class PrometheusStatsRequest : public Admin::Request {
+public:
+  static constexpr uint64_t DefaultChunkSize = 2 * 1000 * 1000;
+  static constexpr uint64_t DefaultMaxBatchMetrics = 100 * 1000;
+
+  PrometheusStatsRequest(Stats::Store& stats, const StatsParams& params,
+                         const Upstream::ClusterManager& cluster_manager,
+                         const Stats::CustomStatNamespaces& custom_namespaces);
+
+  // Admin::Request
+  Http::Code start(Http::ResponseHeaderMap& response_headers) override;
+  bool nextChunk(Buffer::Instance& response) override;
+
+  // Sets the chunk size.
+  void setChunkSize(uint64_t chunk_size) { chunk_size_ = chunk_size; }
+
+  // Sets the number of stats collected by a walk of the store, unless a single group of stats
+  // sharing a tag-extracted name is larger. This must be set before start().
+  void setMaxBatchMetrics(uint64_t max_batch_metrics) { max_batch_metrics_ = max_batch_metrics; }
+
+private:
+  // Ordered as the exposition is rendered.
+  enum class Phase { Counters, Gauges, TextReadouts, Histograms, HostCounters, HostGauges, Done };
+
+  // Moves on to the renderer of the next stat type.
+  void nextPhase();
+
+  Stats::Store& stats_;
+  const StatsParams params_;
+  const Upstream::ClusterManager& cluster_manager_;
+  const Stats::CustomStatNamespaces& custom_namespaces_;
+  Phase phase_{Phase::Counters};
+  PrometheusGroupRendererPtr renderer_;
+  uint64_t chunk_size_{DefaultChunkSize};
+  uint64_t max_batch_metrics_{DefaultMaxBatchMetrics};
+};
+
 } // namespace Server
 } // namespace Envoy
@@ -71,6 +71,51 @@ Http::Code StatsHandler::handlerStatsRecentLookupsEnable(Http::ResponseHeaderMap
   return Http::Code::OK;
 }
 
+Http::Code StatsHandler::handlerStatsSnapshot(Http::ResponseHeaderMap& response_headers,
+                                              Buffer::Instance& response,
+                                              AdminStream& admin_stream) {
+  StatsParams params;
+  Http::Code code = params.parse(admin_stream.getRequestHeaders().getPathValue(), response);
+  if (code != Http::Code::OK) {
+    return code;
+  }
+
+  if (snapshot_renderer_ == nullptr) {
+    snapshot_renderer_ = std::make_unique<StatsSnapshotRenderer>(server_.stats().symbolTable(),
+                                                                 server_.api().randomGenerator());
+  }
+
+  // The names the collector knows are only reused if they belong to the current dictionary.
+  uint32_t known_names = 0;
+  const absl::optional<std::string> dictionary_id = params.query_.getFirstValue("dictionary_id");
+  const absl::optional<std::string> known_names_value = params.query_.getFirstValue("known_names");
+  if (dictionary_id.has_value() != known_names_value.has_value()) {
+    response.add("dictionary_id and known_names must be specified together\n");
+    return Http::Code::BadRequest;
+  }
+  if (dictionary_id.has_value()) {
+    uint64_t id;
+    if (!absl::SimpleAtoi(dictionary_id.value(), &id) ||
+        !absl::SimpleAtoi(known_names_value.value(), &known_names)) {
+      response.add("dictionary_id and known_names must be integers\n");
+      return Http::Code::BadRequest;
+    }
+    if (id != snapshot_renderer_->dictionaryId()) {
+      known_names = 0;
+    }
+  }
+
+  if (server_.statsConfig().flushOnAdmin()) {
+    server_.flushStats();
+  }
+
+  envoy::admin::v3::StatsSnapshot snapshot;
+  snapshot_renderer_->render(server_.stats(), params, known_names, snapshot);
+  response_headers.setReferenceContentType(Http::Headers::get().ContentTypeValues.Protobuf);
+  response.add(snapshot.SerializeAsString());
+  return Http::Code::OK;
+}
+
 Admin::RequestPtr StatsHandler::makeRequest(AdminStream& admin_stream) {
   StatsParams params;
   Buffer::OwnedImpl response;
@@ -80,16 +125,7 @@ Admin::RequestPtr StatsHandler::makeRequest(AdminStream& admin_stream) {
   }
 
   if (params.format_ == StatsFormat::Prometheus) {
-    // TODO(#16139): modify streaming algorithm to cover Prometheus.
-    //
-    // This may be easiest to accomplish by populating the set
-    // with tagExtractedName(), and allowing for vectors of
-    // stats as multiples will have the same tag-extracted names.
-    // Ideally we'd find a way to do this without slowing down
-    // the non-Prometheus implementations.
-    Buffer::OwnedImpl response;
-    Http::Code code = prometheusFlushAndRender(params, response);
-    return Admin::makeStaticTextRequest(response, code);
+    return makePrometheusRequest(admin_stream);
   }
 
   if (server_.statsConfig().flushOnAdmin()) {
@@ -113,40 +149,33 @@ Admin::RequestPtr StatsHandler::makeRequest(Stats::Store& stats, const StatsPara
   return std::make_unique<StatsRequest>(stats, params, cluster_manager, url_handler_fn);
 }
 
-Http::Code StatsHandler::handlerPrometheusStats(Http::ResponseHeaderMap&,
-                                                Buffer::Instance& response,
-                                                AdminStream& admin_stream) {
-  return prometheusStats(admin_stream.getRequestHeaders().getPathValue(), response);
-}
-
-Http::Code StatsHandler::prometheusStats(absl::string_view path_and_query,
-                                         Buffer::Instance& response) {
+Admin::RequestPtr StatsHandler::makePrometheusRequest(AdminStream& admin_stream) {
   StatsParams params;
-  Http::Code code = params.parse(path_and_query, response);
+  Buffer::OwnedImpl response;
+  Http::Code code = params.parse(admin_stream.getRequestHeaders().getPathValue(), response);
   if (code != Http::Code::OK) {
-    return code;
-  }
-
-  if (server_.statsConfig().flushOnAdmin()) {
-    server_.flushStats();
+    return Admin::makeStaticTextRequest(response, code);
   }
 
-  return prometheusFlushAndRender(params, response);
-}
-
-Http::Code StatsHandler::prometheusFlushAndRender(const StatsParams& params,
-                                                  Buffer::Instance& response) {
   absl::Status paramsStatus = PrometheusStatsFormatter::validateParams(params);
   if (!paramsStatus.ok()) {
-    response.add(paramsStatus.message());
-    return Http::Code::BadRequest;
+    return Admin::makeStaticTextRequest(paramsStatus.message(), Http::Code::BadRequest);
   }
+
   if (server_.statsConfig().flushOnAdmin()) {
     server_.flushStats();
   }
-  prometheusRender(server_.stats(), server_.api().customStatNamespaces(), server_.clusterManager(),
-                   params, response);
-  return Http::Code::OK;
+
+  return makePrometheusRequest(server_.stats(), params, server_.clusterManager(),
+                               server_.api().customStatNamespaces());
+}
+
+Admin::RequestPtr
+StatsHandler::makePrometheusRequest(Stats::Store& stats, const StatsParams& params,
+                                    const Upstream::ClusterManager& cluster_manager,
+                                    const Stats::CustomStatNamespaces& custom_namespaces) {
+  return std::make_unique<PrometheusStatsRequest>(stats, params, cluster_manager,
+                                                  custom_namespaces);
 }
 
 void StatsHandler::prometheusRender(Stats::Store& stats,
@@ -11,6 +11,7 @@
 
 #include "source/server/admin/handler_ctx.h"
 #include "source/server/admin/stats_request.h"
+#include "source/server/admin/stats_snapshot.h"
 #include "source/server/admin/utils.h"
 
 #include "absl/strings/string_view.h"
@@ -33,26 +34,17 @@ public:
                                               Buffer::Instance& response, AdminStream&);
   Http::Code handlerStatsRecentLookupsEnable(Http::ResponseHeaderMap& response_headers,
                                              Buffer::Instance& response, AdminStream&);
-  Http::Code handlerPrometheusStats(Http::ResponseHeaderMap& response_headers,
-                                    Buffer::Instance& response, AdminStream&);
+  Http::Code handlerStatsSnapshot(Http::ResponseHeaderMap& response_headers,
+                                  Buffer::Instance& response, AdminStream&);
 
   /**
-   * Parses and executes a prometheus stats request.
+   * Parses a prometheus stats request, flushing stats if configured, and
+   * returns a request which streams the stats in chunks.
    *
-   * @param path_and_query the URL path and query
-   * @param response buffer into which to write response
-   * @return http response code
+   * @param admin_stream the admin stream holding the request headers.
+   * @return the request, or a static-text request holding an error.
    */
-  Http::Code prometheusStats(absl::string_view path_and_query, Buffer::Instance& response);
-
-  /**
-   * Checks the server_ to see if a flush is needed, and then renders the
-   * prometheus stats request.
-   *
-   * @params params the already-parsed parameters.
-   * @param response buffer into which to write response
-   */
-  Http::Code prometheusFlushAndRender(const StatsParams& params, Buffer::Instance& response);
+  Admin::RequestPtr makePrometheusRequest(AdminStream& admin_stream);
 
   /**
    * Renders the stats as prometheus. This is broken out as a separately
@@ -87,15 +79,24 @@ public:
    */
   Admin::UrlHandler statsHandler(bool active_mode);
 
+  /**
+   * Makes a streaming prometheus request. This is broken out as a separately
+   * callable API to facilitate the benchmark, which does not have a server
+   * object. The params must already have been validated.
+   */
+  static Admin::RequestPtr
+  makePrometheusRequest(Stats::Store& stats, const StatsParams& params,
+                        const Upstream::ClusterManager& cluster_manager,
+                        const Stats::CustomStatNamespaces& custom_namespaces);
+
   static Admin::RequestPtr makeRequest(Stats::Store& stats, const StatsParams& params,
                                        const Upstream::ClusterManager& cm,
                                        StatsRequest::UrlHandlerFn url_handler_fn = nullptr);
   Admin::RequestPtr makeRequest(AdminStream&);
 
 private:
-  static Http::Code prometheusStats(absl::string_view path_and_query, Buffer::Instance& response,
-                                    Stats::Store& stats,
-                                    Stats::CustomStatNamespaces& custom_namespaces);
+  // Created on the first /stats/snapshot request, as the dictionary is retained from then on.
+  std::unique_ptr<StatsSnapshotRenderer> snapshot_renderer_;
 };
 
 } // namespace Server
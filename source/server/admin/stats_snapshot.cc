@@ -0,0 +1,136 @@
+#include "source/server/admin/stats_snapshot.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Server {
+
+namespace {
+
+// Appends the delta encoding of the ascending ids.
+template <class IdAndStat>
+void addIdDeltas(const std::vector<IdAndStat>& stats,
+                 Protobuf::RepeatedField<uint32_t>& id_deltas) {
+  id_deltas.Reserve(stats.size());
+  uint32_t previous_id = 0;
+  for (const auto& [id, stat] : stats) {
+    id_deltas.Add(id - previous_id);
+    previous_id = id;
+  }
+}
+
+} // namespace
+
+StatsSnapshotRenderer::StatsSnapshotRenderer(Stats::SymbolTable& symbol_table,
+                                             Random::RandomGenerator& random)
+    : random_(random), dictionary_id_(random.random()), symbol_table_(symbol_table),
+      pool_(symbol_table) {}
+
+uint32_t StatsSnapshotRenderer::nameId(Stats::StatName name) {
+  const auto iter = ids_.find(name);
+  if (iter != ids_.end()) {
+    return iter->second;
+  }
+  // The name is copied into the pool, as the dictionary may outlive the stat.
+  const Stats::StatName stored_name = pool_.add(name);
+  const uint32_t id = names_.size();
+  ids_.emplace(stored_name, id);
+  names_.push_back(stored_name);
+  return id;
+}
+
+bool StatsSnapshotRenderer::maybeResetDictionary(const Stats::Store& stats) {
+  // Counting the stats walks the store, so they are only counted again once the dictionary holds
+  // twice as many names as there were stats at the previous count.
+  if (names_.size() <= 2 * num_stats_) {
+    return false;
+  }
+  num_stats_ = 0;
+  const Stats::SizeFn add_size = [this](std::size_t size) { num_stats_ += size; };
+  stats.forEachCounter(add_size, [](Stats::Counter&) {});
+  stats.forEachGauge(add_size, [](Stats::Gauge&) {});
+  stats.forEachHistogram(add_size, [](Stats::ParentHistogram&) {});
+  if (names_.size() <= 2 * num_stats_) {
+    return false;
+  }
+
+  dictionary_id_ = random_.random();
+  names_.clear();
+  ids_.clear();
+  pool_.clear();
+  return true;
+}
+
+template <class StatType>
+std::vector<StatsSnapshotRenderer::IdAndStat<StatType>>
+StatsSnapshotRenderer::collect(const std::vector<Stats::RefcountPtr<StatType>>& stats,
+                               const StatsParams& params) {
+  std::vector<IdAndStat<StatType>> result;
+  result.reserve(stats.size());
+  for (const auto& stat : stats) {
+    if (params.shouldShowMetric(*stat)) {
+      result.emplace_back(nameId(stat->statName()), stat.get());
+    }
+  }
+  std::sort(result.begin(), result.end(),
+            [](const IdAndStat<StatType>& a, const IdAndStat<StatType>& b) {
+              return a.first < b.first;
+            });
+  return result;
+}
+
+void StatsSnapshotRenderer::render(Stats::Store& stats, const StatsParams& params,
+                                   uint32_t known_names,
+                                   envoy::admin::v3::StatsSnapshot& snapshot) {
+  if (maybeResetDictionary(stats)) {
+    known_names = 0;
+  }
+  snapshot.set_dictionary_id(dictionary_id_);
+  const bool all = params.type_ == StatsType::All;
+
+  if (all || params.type_ == StatsType::Counters) {
+    const std::vector<Stats::CounterSharedPtr> counters = stats.counters();
+    const auto entries = collect(counters, params);
+    addIdDeltas(entries, *snapshot.mutable_counter_id_deltas());
+    snapshot.mutable_counter_values()->Reserve(entries.size());
+    for (const auto& [id, counter] : entries) {
+      snapshot.add_counter_values(counter->value());
+    }
+  }
+
+  if (all || params.type_ == StatsType::Gauges) {
+    const std::vector<Stats::GaugeSharedPtr> gauges = stats.gauges();
+    const auto entries = collect(gauges, params);
+    addIdDeltas(entries, *snapshot.mutable_gauge_id_deltas());
+    snapshot.mutable_gauge_values()->Reserve(entries.size());
+    for (const auto& [id, gauge] : entries) {
+      snapshot.add_gauge_values(gauge->value());
+    }
+  }
+
+  if (all || params.type_ == StatsType::Histograms) {
+    const std::vector<Stats::ParentHistogramSharedPtr> histograms = stats.histograms();
+    const auto entries = collect(histograms, params);
+    addIdDeltas(entries, *snapshot.mutable_histogram_id_deltas());
+    snapshot.mutable_histogram_sample_counts()->Reserve(entries.size());
+    snapshot.mutable_histogram_sample_sums()->Reserve(entries.size());
+    for (const auto& [id, histogram] : entries) {
+      const Stats::HistogramStatistics& statistics = histogram->cumulativeStatistics();
+      snapshot.add_histogram_sample_counts(statistics.sampleCount());
+      snapshot.add_histogram_sample_sums(statistics.sampleSum());
+    }
+  }
+
+  // Names are sent after the values, as rendering the values may have assigned new ids.
+  if (known_names > names_.size()) {
+    known_names = 0;
+  }
+  snapshot.set_first_name_id(known_names);
+  snapshot.mutable_names()->Reserve(names_.size() - known_names);
+  for (uint32_t id = known_names; id < names_.size(); ++id) {
+    snapshot.add_names(symbol_table_.toString(names_[id]));
+  }
+}
+
+} // namespace Server
+} // namespace Envoy
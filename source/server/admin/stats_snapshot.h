@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "envoy/admin/v3/metrics.pb.h"
+#include "envoy/common/random_generator.h"
+#include "envoy/stats/store.h"
+
+#include "source/common/stats/symbol_table.h"
+#include "source/server/admin/stats_params.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * Renders the compact binary snapshots served by /stats/snapshot. Each stat name is assigned an
+ * id the first time it is rendered, and ids are not reused within a dictionary, so a collector
+ * only needs to receive each name once. The names of stats which have since been deleted are
+ * retained until they outnumber the stats of the store, at which point the dictionary is started
+ * over under a new id.
+ *
+ * This is only used from the main thread, as admin requests are.
+ */
+class StatsSnapshotRenderer {
+public:
+  /**
+   * @param symbol_table the symbol table of the stats which will be rendered.
+   * @param random generates the ids of the dictionaries, which are random so that a collector can
+   *        detect a server restart.
+   */
+  StatsSnapshotRenderer(Stats::SymbolTable& symbol_table, Random::RandomGenerator& random);
+
+  /**
+   * Populates a snapshot of the stats.
+   *
+   * @param stats the store to snapshot.
+   * @param params the query parameters, used to filter the stats.
+   * @param known_names the number of names of the dictionary the collector already has. If this
+   *        exceeds the number of names of the dictionary, or the dictionary is started over, all
+   *        names are sent.
+   * @param snapshot the proto to populate.
+   */
+  void render(Stats::Store& stats, const StatsParams& params, uint32_t known_names,
+              envoy::admin::v3::StatsSnapshot& snapshot);
+
+  /**
+   * @return the id identifying the dictionary of names.
+   */
+  uint64_t dictionaryId() const { return dictionary_id_; }
+
+  /**
+   * @return the number of names in the dictionary.
+   */
+  uint32_t numNames() const { return names_.size(); }
+
+private:
+  template <class StatType> using IdAndStat = std::pair<uint32_t, const StatType*>;
+
+  // Returns the id of the name, assigning the next id if it was never rendered.
+  uint32_t nameId(Stats::StatName name);
+
+  // Starts a new dictionary if the names of deleted stats outnumber the stats of the store.
+  // Returns whether it did.
+  bool maybeResetDictionary(const Stats::Store& stats);
+
+  // Filters the stats, and returns them with their ids in ascending id order.
+  template <class StatType>
+  std::vector<IdAndStat<StatType>>
+  collect(const std::vector<Stats::RefcountPtr<StatType>>& stats, const StatsParams& params);
+
+  Random::RandomGenerator& random_;
+  uint64_t dictionary_id_;
+  // The number of stats of the store when they were last counted.
+  uint64_t num_stats_{0};
+  Stats::SymbolTable& symbol_table_;
+  Stats::StatNamePool pool_;
+  Stats::StatNameHashMap<uint32_t> ids_;
+  std::vector<Stats::StatName> names_; // Indexed by id, backed by pool_.
+};
+
+} // namespace Server
+} // namespace Envoy
@@ -83,7 +83,8 @@ bool FilterChainUtility::buildQuicFilterChain(
 
 StatsConfigImpl::StatsConfigImpl(const envoy::config::bootstrap::v3::Bootstrap& bootstrap,
                                  absl::Status& status)
-    : deferred_stat_options_(bootstrap.deferred_stat_options()) {
+    : flush_changed_only_(bootstrap.stats_flush_changed_only()),
+      deferred_stat_options_(bootstrap.deferred_stat_options()) {
   status = absl::OkStatus();
   if (bootstrap.has_stats_flush_interval() &&
       bootstrap.stats_flush_case() !=
@@ -158,6 +158,9 @@ OptionsImpl::OptionsImpl(std::vector<std::string> args,
       "", "enable-mutex-tracing", "Enable mutex contention tracing functionality", cmd, false);
   TCLAP::SwitchArg cpuset_threads(
       "", "cpuset-threads", "Get the default # of worker threads from cpuset size", cmd, false);
+  TCLAP::SwitchArg stats_slab_allocation(
+      "", "stats-slab-allocation",
+      "Allocate counters and gauges in contiguous slabs rather than individually", cmd, false);
 
   TCLAP::ValueArg<std::string> disable_extensions("", "disable-extensions",
                                                   "Comma-separated list of extensions to disable",
@@ -204,6 +207,7 @@ OptionsImpl::OptionsImpl(std::vector<std::string> args,
   core_dump_enabled_ = enable_core_dump.getValue();
 
   cpuset_threads_ = cpuset_threads.getValue();
+  stats_slab_allocation_ = stats_slab_allocation.getValue();
 
   if (log_level.isSet()) {
     auto status_or_error = parseAndValidateLogLevel(log_level.getValue());
@@ -443,6 +447,7 @@ Server::CommandLineOptionsPtr OptionsImpl::toCommandLineOptions() const {
   command_line_options->set_disable_hot_restart(hotRestartDisabled());
   command_line_options->set_enable_mutex_tracing(mutexTracingEnabled());
   command_line_options->set_cpuset_threads(cpusetThreadsEnabled());
+  command_line_options->set_stats_slab_allocation(statsSlabAllocationEnabled());
   command_line_options->set_restart_epoch(restartEpoch());
   for (const auto& e : disabledExtensions()) {
     command_line_options->add_disabled_extensions(e);
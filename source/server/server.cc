@@ -169,33 +169,48 @@ void InstanceBase::failHealthcheck(bool fail) {
 
 MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store,
                                        Upstream::ClusterManager& cluster_manager,
-                                       TimeSource& time_source) {
-  store.forEachSinkedCounter(
-      [this](std::size_t size) {
-        snapped_counters_.reserve(size);
-        counters_.reserve(size);
-      },
-      [this](Stats::Counter& counter) {
-        snapped_counters_.push_back(Stats::CounterSharedPtr(&counter));
-        counters_.push_back({counter.latch(), counter});
-      });
-
-  store.forEachSinkedGauge(
-      [this](std::size_t size) {
-        snapped_gauges_.reserve(size);
-        gauges_.reserve(size);
-      },
-      [this](Stats::Gauge& gauge) {
-        snapped_gauges_.push_back(Stats::GaugeSharedPtr(&gauge));
-        gauges_.push_back(gauge);
-      });
+                                       TimeSource& time_source, bool changed_only) {
+  // When only flushing changed stats, the store only visits the counters and gauges that changed
+  // since the previous flush, rather than every stat.
+  auto counters_size = [this](std::size_t size) {
+    snapped_counters_.reserve(size);
+    counters_.reserve(size);
+  };
+  auto counter_fn = [this, changed_only](Stats::Counter& counter) {
+    const uint64_t delta = counter.latch();
+    if (changed_only && delta == 0) {
+      return;
+    }
+    snapped_counters_.push_back(Stats::CounterSharedPtr(&counter));
+    counters_.push_back({delta, counter});
+  };
+  auto gauges_size = [this](std::size_t size) {
+    snapped_gauges_.reserve(size);
+    gauges_.reserve(size);
+  };
+  auto gauge_fn = [this](Stats::Gauge& gauge) {
+    snapped_gauges_.push_back(Stats::GaugeSharedPtr(&gauge));
+    gauges_.push_back(gauge);
+  };
+  if (changed_only) {
+    store.forEachChangedSinkedCounter(counters_size, counter_fn);
+    store.forEachChangedSinkedGauge(gauges_size, gauge_fn);
+  } else {
+    store.forEachSinkedCounter(counters_size, counter_fn);
+    store.forEachSinkedGauge(gauges_size, gauge_fn);
+  }
 
   store.forEachSinkedHistogram(
-      [this](std::size_t size) {
-        snapped_histograms_.reserve(size);
-        histograms_.reserve(size);
+      [this, changed_only](std::size_t size) {
+        if (!changed_only) {
+          snapped_histograms_.reserve(size);
+          histograms_.reserve(size);
+        }
       },
-      [this](Stats::ParentHistogram& histogram) {
+      [this, changed_only](Stats::ParentHistogram& histogram) {
+        if (changed_only && histogram.intervalStatistics().sampleCount() == 0) {
+          return;
+        }
         snapped_histograms_.push_back(Stats::ParentHistogramSharedPtr(&histogram));
         histograms_.push_back(histogram);
       });
@@ -212,8 +227,10 @@ MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store,
 
   Upstream::HostUtility::forEachHostMetric(
       cluster_manager,
-      [this](Stats::PrimitiveCounterSnapshot&& metric) {
-        host_counters_.emplace_back(std::move(metric));
+      [this, changed_only](Stats::PrimitiveCounterSnapshot&& metric) {
+        if (!changed_only || metric.delta() != 0) {
+          host_counters_.emplace_back(std::move(metric));
+        }
       },
       [this](Stats::PrimitiveGaugeSnapshot&& metric) {
         host_gauges_.emplace_back(std::move(metric));
@@ -223,12 +240,13 @@ MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store,
 }
 
 void InstanceUtil::flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks, Stats::Store& store,
-                                       Upstream::ClusterManager& cm, TimeSource& time_source) {
+                                       Upstream::ClusterManager& cm, TimeSource& time_source,
+                                       bool changed_only) {
   // Create a snapshot and flush to all sinks.
   // NOTE: Even if there are no sinks, creating the snapshot has the important property that it
   //       latches all counters on a periodic basis. The hot restart code assumes this is being
   //       done so this should not be removed.
-  MetricSnapshotImpl snapshot(store, cm, time_source);
+  MetricSnapshotImpl snapshot(store, cm, time_source, changed_only);
   for (const auto& sink : sinks) {
     sink->flush(snapshot);
   }
@@ -290,7 +308,7 @@ void InstanceBase::flushStatsInternal() {
   updateServerStats();
   auto& stats_config = config_.statsConfig();
   InstanceUtil::flushMetricsToSinks(stats_config.sinks(), stats_store_, clusterManager(),
-                                    timeSource());
+                                    timeSource(), stats_config.flushChangedOnly());
   // TODO(ramaraochavali): consider adding different flush interval for histograms.
   if (stat_flush_timer_ != nullptr) {
     stat_flush_timer_->enableTimer(stats_config.flushInterval());
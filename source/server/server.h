@@ -131,9 +131,11 @@ public:
    * flush() on each sink.
    * @param sinks supplies the list of sinks.
    * @param store provides the store being flushed.
+   * @param changed_only if true, only stats that changed since the previous flush are flushed.
    */
   static void flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks, Stats::Store& store,
-                                  Upstream::ClusterManager& cm, TimeSource& time_source);
+                                  Upstream::ClusterManager& cm, TimeSource& time_source,
+                                  bool changed_only = false);
 
   /**
    * Load a bootstrap config and perform validation.
@@ -461,8 +463,13 @@ private:
 //                     copying and probably be a cleaner API in general.
 class MetricSnapshotImpl : public Stats::MetricSnapshot {
 public:
-  explicit MetricSnapshotImpl(Stats::Store& store, Upstream::ClusterManager& cluster_manager,
-                              TimeSource& time_source);
+  /**
+   * @param changed_only if true, only counters that were incremented, gauges that were changed
+   *        and histograms that recorded values since the previous snapshot are included. All
+   *        counters are latched either way.
+   */
+  MetricSnapshotImpl(Stats::Store& store, Upstream::ClusterManager& cluster_manager,
+                     TimeSource& time_source, bool changed_only = false);
 
   // Stats::MetricSnapshot
   const std::vector<CounterSnapshot>& counters() override { return counters_; }
@@ -11,6 +11,8 @@
 #include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -169,8 +171,8 @@ TEST_F(AccessLogManagerImplTest, FlushToLogFileOnDemand) {
   EXPECT_EQ(0UL, store_.counter("filesystem.flushed_by_timer").value());
 
   // The first write to a given file will start the flush thread. Because AccessManagerImpl::write
-  // holds the write_lock_ when the thread is started, the thread will flush on its first loop, once
-  // it obtains the write_lock_. Perform a write to get all that out of the way.
+  // buffers the data before the thread is started, the thread will flush on its first loop.
+  // Perform a write to get all that out of the way.
   EXPECT_CALL(*file_, write_(_))
       .WillOnce(Invoke([](absl::string_view data) -> Api::IoCallSizeResult {
         return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
@@ -443,6 +445,90 @@ TEST_F(AccessLogManagerImplTest, BigDataChunkShouldBeFlushedWithoutTimer) {
   EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
 }
 
+// Writes from several threads are pushed onto the write queue without locking. Every entry must be
+// written, and the entries from each thread must stay in order.
+TEST_F(AccessLogManagerImplTest, ConcurrentWriters) {
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log_file =
+      access_log_manager_
+          .createAccessLog(Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"})
+          .value();
+
+  absl::Mutex written_mutex;
+  std::string written;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        absl::MutexLock lock(&written_mutex);
+        absl::StrAppend(&written, data);
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  constexpr uint32_t num_threads = 8;
+  constexpr uint32_t num_writes = 1000;
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t t = 0; t < num_threads; ++t) {
+    threads.push_back(thread_factory_.createThread([&log_file, t]() {
+      for (uint32_t i = 0; i < num_writes; ++i) {
+        log_file->write(absl::StrCat(t, ":", i, "\n"));
+      }
+    }));
+  }
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+  log_file->flush();
+
+  EXPECT_EQ(num_threads * num_writes, store_.counter("filesystem.write_buffered").value());
+  EXPECT_TRUE(waitForGaugeEq("filesystem.write_total_buffered", 0));
+
+  absl::MutexLock lock(&written_mutex);
+  std::vector<absl::string_view> lines = absl::StrSplit(written, '\n', absl::SkipEmpty());
+  ASSERT_EQ(num_threads * num_writes, lines.size());
+  std::vector<uint32_t> next_index(num_threads, 0);
+  for (absl::string_view line : lines) {
+    std::pair<absl::string_view, absl::string_view> parts = absl::StrSplit(line, ':');
+    uint32_t thread_index, write_index;
+    ASSERT_TRUE(absl::SimpleAtoi(parts.first, &thread_index));
+    ASSERT_TRUE(absl::SimpleAtoi(parts.second, &write_index));
+    ASSERT_LT(thread_index, num_threads);
+    EXPECT_EQ(next_index[thread_index]++, write_index);
+  }
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+// Entries are written in the order of their write() calls, even when made from different threads
+// between two flushes.
+TEST_F(AccessLogManagerImplTest, KeepLineOrderAcrossThreads) {
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log_file =
+      access_log_manager_
+          .createAccessLog(Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"})
+          .value();
+
+  absl::Mutex written_mutex;
+  std::string written;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        absl::MutexLock lock(&written_mutex);
+        absl::StrAppend(&written, data);
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  log_file->write("1\n");
+  thread_factory_.createThread([&log_file]() { log_file->write("2\n"); })->join();
+  log_file->write("3\n");
+  thread_factory_.createThread([&log_file]() { log_file->write("4\n"); })->join();
+  log_file->flush();
+
+  {
+    absl::MutexLock lock(&written_mutex);
+    EXPECT_EQ("1\n2\n3\n4\n", written);
+  }
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
 TEST_F(AccessLogManagerImplTest, ReopenAllFiles) {
   EXPECT_CALL(dispatcher_, createTimer_(_)).WillRepeatedly(ReturnNew<NiceMock<Event::MockTimer>>());
 
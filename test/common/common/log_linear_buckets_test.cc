@@ -0,0 +1,48 @@
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "source/common/common/log_linear_buckets.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+TEST(LogLinearBucketsTest, Index) {
+  EXPECT_EQ(0, LogLinearBuckets::index(0, 64));
+  EXPECT_EQ(3, LogLinearBuckets::index(3, 64));
+  EXPECT_EQ(4, LogLinearBuckets::index(4, 64));
+  EXPECT_EQ(7, LogLinearBuckets::index(7, 64));
+  EXPECT_EQ(8, LogLinearBuckets::index(8, 64));
+  EXPECT_EQ(8, LogLinearBuckets::index(9, 64));
+  EXPECT_EQ(9, LogLinearBuckets::index(10, 64));
+  EXPECT_EQ(63, LogLinearBuckets::index(std::numeric_limits<uint64_t>::max(), 64));
+  EXPECT_EQ(1, LogLinearBuckets::index(3, 2));
+}
+
+TEST(LogLinearBucketsTest, Bounds) {
+  size_t previous_index = 0;
+  for (uint64_t value = 0; value < 100000; ++value) {
+    const size_t index = LogLinearBuckets::index(value, 64);
+    EXPECT_GE(index, previous_index);
+    EXPECT_GE(LogLinearBuckets::upperBound(index), value);
+    EXPECT_LE(LogLinearBuckets::upperBound(index) - value, value / 4);
+    previous_index = index;
+  }
+}
+
+TEST(LogLinearBucketsTest, QuantileIndex) {
+  std::array<uint64_t, 4> counts{0, 90, 0, 10};
+  EXPECT_EQ(1, LogLinearBuckets::quantileIndex(counts, 100, 0));
+  EXPECT_EQ(1, LogLinearBuckets::quantileIndex(counts, 100, 0.5));
+  EXPECT_EQ(1, LogLinearBuckets::quantileIndex(counts, 100, 0.9));
+  EXPECT_EQ(3, LogLinearBuckets::quantileIndex(counts, 100, 0.91));
+  EXPECT_EQ(3, LogLinearBuckets::quantileIndex(counts, 100, 1.0));
+  // A total larger than the counts, as when they are read while being updated, still ends in the
+  // last bucket.
+  EXPECT_EQ(3, LogLinearBuckets::quantileIndex(counts, 200, 1.0));
+}
+
+} // namespace
+} // namespace Envoy
@@ -92,6 +92,9 @@ public:
               (const Upstream::HostDescriptionConstSharedPtr& n, absl::string_view,
                ConnectionPool::PoolFailureReason, AttachContext&));
   MOCK_METHOD(void, onPoolReady, (ActiveClient&, AttachContext&));
+  absl::optional<uint32_t> maxIdleClients() const override { return max_idle_clients_; }
+
+  absl::optional<uint32_t> max_idle_clients_;
 };
 
 class ConnPoolImplBaseTest : public testing::Test {
@@ -473,6 +476,62 @@ TEST_F(ConnPoolImplDispatcherBaseTest, NoAvailableStreams) {
   pool_.destructAllConnections();
 }
 
+TEST_F(ConnPoolImplDispatcherBaseTest, AdaptivePreconnect) {
+  cluster_->max_adaptive_preconnect_streams_ = 3;
+  TestConnPoolImplBase pool(host_, Upstream::ResourcePriority::Default, *dispatcher_, nullptr,
+                            nullptr, state_);
+  ON_CALL(pool, instantiateActiveClient).WillByDefault(Invoke([&]() -> ActiveClientPtr {
+    auto ret = std::make_unique<NiceMock<TestActiveClient>>(pool, stream_limit_,
+                                                            concurrent_streams_, false);
+    clients_.push_back(ret.get());
+    ret->real_host_description_ = descr_;
+    return ret;
+  }));
+  ON_CALL(pool, onPoolReady(_, _)).WillByDefault(Invoke([](ActiveClient& client, AttachContext&) {
+    TestActiveClient::incrementActiveStreams(client);
+  }));
+  auto& stats = *cluster_->trafficStats();
+
+  // Without any history only the connection for the pending stream is created.
+  EXPECT_CALL(pool, instantiateActiveClient);
+  pool.newStreamImpl(context_, /*can_send_early_data=*/false);
+  EXPECT_EQ(1, clients_.size());
+  EXPECT_EQ(1, stats.upstream_rq_preconnect_miss_.value());
+
+  // The connection takes 10ms to establish.
+  time_system_.advanceTimeWait(std::chrono::milliseconds(10));
+  EXPECT_CALL(pool, onPoolReady);
+  clients_[0]->onEvent(Network::ConnectionEvent::Connected);
+
+  // The next stream arrives 12ms after the first one, so one more stream is expected to arrive
+  // while a connection is being established and a spare connection is created.
+  time_system_.advanceTimeWait(std::chrono::milliseconds(2));
+  EXPECT_CALL(pool, instantiateActiveClient).Times(2);
+  pool.newStreamImpl(context_, /*can_send_early_data=*/false);
+  EXPECT_EQ(3, clients_.size());
+  EXPECT_EQ(2, stats.upstream_rq_preconnect_miss_.value());
+
+  EXPECT_CALL(pool, onPoolReady);
+  clients_[1]->onEvent(Network::ConnectionEvent::Connected);
+  clients_[2]->onEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(ActiveClient::State::Ready, clients_[2]->state());
+
+  // The third stream uses the preconnected connection.
+  EXPECT_CALL(pool, onPoolReady);
+  EXPECT_CALL(pool, instantiateActiveClient).Times(testing::AtMost(1));
+  pool.newStreamImpl(context_, /*can_send_early_data=*/false);
+  EXPECT_EQ(1, stats.upstream_rq_preconnect_hit_.value());
+
+  // Clean up.
+  for (TestActiveClient* client : clients_) {
+    while (client->active_streams_ > 0) {
+      --client->active_streams_;
+      pool.onStreamClosed(*client, false);
+    }
+  }
+  pool.destructAllConnections();
+}
+
 // Verify that not fully connected active client calls
 // idle callbacks upon destruction.
 TEST_F(ConnPoolImplBaseTest, PoolIdleNotConnected) {
@@ -514,6 +573,37 @@ TEST_F(ConnPoolImplBaseTest, PoolIdleCallbackTriggeredRemoteClose) {
   pool_.drainConnectionsImpl(Envoy::ConnectionPool::DrainBehavior::DrainAndDelete);
 }
 
+// A client that goes idle while the pool already keeps the maximum number of idle clients is
+// closed, the last idle client is kept.
+TEST_F(ConnPoolImplBaseTest, MaxIdleClients) {
+  EXPECT_CALL(dispatcher_, createTimer_(_)).Times(AnyNumber());
+  pool_.max_idle_clients_ = 1;
+
+  // Create two clients, each with one stream.
+  EXPECT_CALL(pool_, instantiateActiveClient).Times(2);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  ASSERT_EQ(2, clients_.size());
+  EXPECT_CALL(pool_, onPoolReady).Times(2);
+  clients_[0]->onEvent(Network::ConnectionEvent::Connected);
+  clients_[1]->onEvent(Network::ConnectionEvent::Connected);
+
+  // The first client to go idle is kept.
+  clients_[0]->active_streams_ = 0;
+  pool_.onStreamClosed(*clients_[0], false);
+  EXPECT_EQ(ActiveClient::State::Ready, clients_[0]->state());
+  EXPECT_EQ(0, pool_.host()->cluster().trafficStats()->upstream_cx_idle_limit_.value());
+
+  // The second one is closed.
+  clients_[1]->active_streams_ = 0;
+  pool_.onStreamClosed(*clients_[1], false);
+  EXPECT_EQ(ActiveClient::State::Closed, clients_[1]->state());
+  EXPECT_EQ(1, pool_.host()->cluster().trafficStats()->upstream_cx_idle_limit_.value());
+  EXPECT_EQ(ActiveClient::State::Ready, clients_[0]->state());
+
+  pool_.drainConnectionsImpl(Envoy::ConnectionPool::DrainBehavior::DrainAndDelete);
+}
+
 // Local close simulates what would happen for an idle timeout on a connection.
 TEST_F(ConnPoolImplBaseTest, PoolIdleCallbackTriggeredLocalClose) {
   EXPECT_CALL(dispatcher_, createTimer_(_)).Times(AnyNumber());
@@ -29,6 +29,21 @@ std::unique_ptr<Envoy::Formatter::JsonFormatterImpl> makeJsonFormatter() {
   return std::make_unique<Envoy::Formatter::JsonFormatterImpl>(JsonLogFormat, false);
 }
 
+// A format whose values mix literal text, which needs JSON escaping, with commands.
+std::unique_ptr<Envoy::Formatter::JsonFormatterImpl> makeMixedTemplateJsonFormatter() {
+  ProtobufWkt::Struct JsonLogFormat;
+  const std::string format_yaml = R"EOF(
+    request: '"%REQ(:METHOD)% %REQ(X-ENVOY-ORIGINAL-PATH?:PATH)% %PROTOCOL%"'
+    upstream: 'host=%UPSTREAM_HOST% cluster=%UPSTREAM_CLUSTER%'
+    timing: 'duration=%DURATION%ms sent=%BYTES_SENT% received=%BYTES_RECEIVED%'
+    client: '%DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT% "%REQ(USER-AGENT)%"'
+    service: 'edge\proxy'
+    response_code: '%RESPONSE_CODE%'
+  )EOF";
+  TestUtility::loadFromYaml(format_yaml, JsonLogFormat);
+  return std::make_unique<Envoy::Formatter::JsonFormatterImpl>(JsonLogFormat, false);
+}
+
 std::unique_ptr<Envoy::Formatter::StructFormatter> makeStructFormatter(bool typed) {
   ProtobufWkt::Struct StructLogFormat;
   const std::string format_yaml = R"EOF(
@@ -141,6 +156,22 @@ static void BM_JsonAccessLogFormatter(benchmark::State& state) {
 }
 BENCHMARK(BM_JsonAccessLogFormatter);
 
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_JsonAccessLogFormatterMixedTemplates(benchmark::State& state) {
+  testing::NiceMock<MockTimeSystem> time_system;
+
+  std::unique_ptr<Envoy::TestStreamInfo> stream_info = makeStreamInfo(time_system);
+  std::unique_ptr<Envoy::Formatter::JsonFormatterImpl> json_formatter =
+      makeMixedTemplateJsonFormatter();
+
+  size_t output_bytes = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    output_bytes += json_formatter->formatWithContext({}, *stream_info).length();
+  }
+  benchmark::DoNotOptimize(output_bytes);
+}
+BENCHMARK(BM_JsonAccessLogFormatterMixedTemplates);
+
 // NOLINTNEXTLINE(readability-identifier-naming)
 static void BM_FormatterCommandParsing(benchmark::State& state) {
   const std::string token = "Listener:namespace:key";
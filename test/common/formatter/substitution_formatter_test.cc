@@ -4695,6 +4695,37 @@ TEST(SubstitutionFormatterTest, JsonFormatterWithOrderedPropertiesTest) {
   EXPECT_EQ(legacy_out_json, legacy_expected);
 }
 
+TEST(SubstitutionFormatterTest, JsonFormatterTemplateLiteralsTest) {
+  NiceMock<StreamInfo::MockStreamInfo> stream_info;
+  Http::TestRequestHeaderMapImpl request_header{{"key_1", "value\\1"}};
+  HttpFormatterContext formatter_context(&request_header);
+
+  ProtobufWkt::Struct key_mapping;
+  TestUtility::loadFromYaml(R"EOF(
+    a_literal: 'with "quotes" and \back\slash'
+    b_template: '"%REQ(key_1)%" \%REQ(missing)%\'
+    c_missing: '%REQ(missing)%'
+  )EOF",
+                            key_mapping);
+
+  // The literal text of templates is escaped once, when compiling the format, and the values of
+  // the commands on every format.
+  {
+    JsonFormatterImpl formatter(key_mapping, false);
+    EXPECT_EQ(R"({"a_literal":"with \"quotes\" and \\back\\slash",)"
+              R"("b_template":"\"value\\1\" \\-\\","c_missing":null})"
+              "\n",
+              formatter.formatWithContext(formatter_context, stream_info));
+  }
+  {
+    JsonFormatterImpl formatter(key_mapping, true);
+    EXPECT_EQ(R"({"a_literal":"with \"quotes\" and \\back\\slash",)"
+              R"("b_template":"\"value\\1\" \\\\","c_missing":null})"
+              "\n",
+              formatter.formatWithContext(formatter_context, stream_info));
+  }
+}
+
 TEST(SubstitutionFormatterTest, CompositeFormatterSuccess) {
   Http::TestRequestHeaderMapImpl request_header{{"first", "GET"}, {":path", "/"}};
   Http::TestResponseHeaderMapImpl response_header{{"second", "PUT"}, {"test", "test"}};
@@ -2,6 +2,7 @@
 
 #include "test/common/http/conn_manager_impl_test_base.h"
 #include "test/common/http/custom_header_extension.h"
+#include "test/common/stats/stat_test_utility.h"
 #include "test/extensions/filters/network/common/fuzz/utils/fakes.h"
 #include "test/server/utility.h"
 #include "test/test_common/logging.h"
@@ -9,6 +10,7 @@
 
 using testing::_;
 using testing::AtLeast;
+using testing::ElementsAre;
 using testing::InSequence;
 using testing::Invoke;
 using testing::InvokeWithoutArgs;
@@ -4314,6 +4316,146 @@ TEST_F(HttpConnectionManagerImplTest, NoProxyProtocolAdded) {
   filter_callbacks_.connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
 }
 
+TEST_F(HttpConnectionManagerImplTest, FilterLatenciesRecorded) {
+  Stats::TestUtil::TestStore latency_stats;
+  filter_latency_stats_ =
+      std::make_unique<FilterLatencyStats>(*latency_stats.rootScope(), "http.fake.",
+                                           std::vector<std::string>{"0", "1"});
+  setup();
+  setupFilterChain(1, 0);
+
+  EXPECT_CALL(*decoder_filters_[0], decodeHeaders(_, true))
+      .WillOnce(Invoke([this](RequestHeaderMap&, bool) -> FilterHeadersStatus {
+        test_time_.timeSystem().advanceTimeWait(std::chrono::microseconds(20));
+        return FilterHeadersStatus::StopIteration;
+      }));
+  startRequest(true);
+
+  const auto* latencies =
+      decoder_->streamInfo().filterState()->getDataReadOnly<StreamInfo::FilterLatencies>(
+          StreamInfo::FilterLatencies::key());
+  ASSERT_NE(nullptr, latencies);
+  EXPECT_TRUE(latencies->filterTimes(0).in_chain_);
+  EXPECT_GE(latencies->filterTimes(0).decode_time_, std::chrono::microseconds(20));
+  EXPECT_EQ(std::chrono::nanoseconds(0), latencies->filterTimes(0).encode_time_);
+  EXPECT_FALSE(latencies->filterTimes(1).in_chain_);
+  EXPECT_FALSE(latency_stats.histogramRecordedValues("http.fake.filter_latency.0.decode_us"));
+
+  // The latencies are recorded into the histograms once the stream completes.
+  filter_callbacks_.connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
+  const std::vector<uint64_t> decode_us =
+      latency_stats.histogramValues("http.fake.filter_latency.0.decode_us", false);
+  ASSERT_EQ(1, decode_us.size());
+  EXPECT_GE(decode_us[0], 20);
+  EXPECT_THAT(latency_stats.histogramValues("http.fake.filter_latency.0.encode_us", false),
+              ElementsAre(0));
+  // Filters which didn't run on the stream record nothing.
+  EXPECT_FALSE(latency_stats.histogramRecordedValues("http.fake.filter_latency.1.decode_us"));
+  EXPECT_FALSE(latency_stats.histogramRecordedValues("http.fake.filter_latency.1.encode_us"));
+}
+
+TEST_F(HttpConnectionManagerImplTest, FilterLatenciesExcludeNestedLocalReply) {
+  Stats::TestUtil::TestStore latency_stats;
+  filter_latency_stats_ = std::make_unique<FilterLatencyStats>(
+      *latency_stats.rootScope(), "http.fake.", std::vector<std::string>{"0"});
+  setup();
+  setupFilterChain(1, 1);
+
+  EXPECT_CALL(*decoder_filters_[0], decodeHeaders(_, true))
+      .WillOnce(InvokeWithoutArgs([this]() -> FilterHeadersStatus {
+        test_time_.timeSystem().advanceTimeWait(std::chrono::microseconds(10));
+        decoder_filters_[0]->callbacks_->sendLocalReply(Code::BadRequest, "Bad request", nullptr,
+                                                        absl::nullopt, "");
+        return FilterHeadersStatus::StopIteration;
+      }));
+  EXPECT_CALL(*encoder_filters_[0], encodeHeaders(_, false))
+      .WillOnce(InvokeWithoutArgs([this]() -> FilterHeadersStatus {
+        test_time_.timeSystem().advanceTimeWait(std::chrono::microseconds(50));
+        return FilterHeadersStatus::Continue;
+      }));
+  EXPECT_CALL(response_encoder_, encodeHeaders(_, false))
+      .WillOnce(InvokeWithoutArgs([this]() {
+        test_time_.timeSystem().advanceTimeWait(std::chrono::microseconds(5));
+      }));
+  // The codec completes the stream from within the decoder filter's callback.
+  EXPECT_CALL(response_encoder_, encodeData(_, true))
+      .WillOnce(InvokeWithoutArgs(
+          [this]() { response_encoder_.stream_.codec_callbacks_->onCodecEncodeComplete(); }));
+  startRequest(true);
+
+  // The local reply's encoding is not part of the time of the filter which sent it, and the
+  // latencies are emitted once the filter's callback returns.
+  EXPECT_THAT(latency_stats.histogramValues("http.fake.filter_latency.0.decode_us", false),
+              ElementsAre(10));
+  EXPECT_THAT(latency_stats.histogramValues("http.fake.filter_latency.0.encode_us", false),
+              ElementsAre(50));
+  EXPECT_THAT(latency_stats.histogramValues("http.fake.phase_latency.codec_encode_us", false),
+              ElementsAre(5));
+  EXPECT_FALSE(latency_stats.histogramRecordedValues("http.fake.phase_latency.pool_wait_us"));
+}
+
+TEST_F(HttpConnectionManagerImplTest, FilterLatenciesRecordedAcrossInternalRedirect) {
+  Stats::TestUtil::TestStore latency_stats;
+  filter_latency_stats_ = std::make_unique<FilterLatencyStats>(
+      *latency_stats.rootScope(), "http.fake.", std::vector<std::string>{"0", "1"});
+  setup(SetupOpts().setTracing(false));
+  setupFilterChain(1, 0, /* num_requests = */ 2);
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance&) -> Http::Status {
+    decoder_ = &conn_manager_->newStream(response_encoder_);
+    RequestHeaderMapPtr headers{
+        new TestRequestHeaderMapImpl{{":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+    decoder_->decodeHeaders(std::move(headers), true);
+    return Http::okStatus();
+  }));
+  EXPECT_CALL(*decoder_filters_[0], decodeHeaders(_, true))
+      .WillOnce(Invoke([this](HeaderMap&, bool) -> FilterHeadersStatus {
+        test_time_.timeSystem().advanceTimeWait(std::chrono::microseconds(20));
+        // Request data makes the redirect replace the filter state of the new stream.
+        decoder_filters_[0]->callbacks_->streamInfo().filterState()->setData(
+            "per_downstream_request", std::make_unique<SimpleType>(2),
+            StreamInfo::FilterState::StateType::ReadOnly,
+            StreamInfo::FilterState::LifeSpan::Request);
+        return FilterHeadersStatus::StopIteration;
+      }));
+  EXPECT_CALL(*decoder_filters_[1], decodeHeaders(_, true))
+      .WillOnce(Invoke([this](HeaderMap&, bool) -> FilterHeadersStatus {
+        test_time_.timeSystem().advanceTimeWait(std::chrono::microseconds(30));
+        return FilterHeadersStatus::StopIteration;
+      }));
+
+  Buffer::OwnedImpl fake_input;
+  conn_manager_->onData(fake_input, false);
+  decoder_filters_[0]->callbacks_->recreateStream(nullptr);
+
+  const StreamInfo::FilterStateSharedPtr& filter_state =
+      decoder_filters_[1]->callbacks_->streamInfo().filterState();
+  const auto* latencies = filter_state->getDataReadOnly<StreamInfo::FilterLatencies>(
+      StreamInfo::FilterLatencies::key());
+  ASSERT_NE(nullptr, latencies);
+  EXPECT_EQ(std::chrono::microseconds(30), latencies->filterTime("1"));
+  EXPECT_FALSE(latencies->filterTime("0").has_value());
+
+  filter_callbacks_.connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_THAT(latency_stats.histogramValues("http.fake.filter_latency.0.decode_us", false),
+              ElementsAre(20));
+  EXPECT_THAT(latency_stats.histogramValues("http.fake.filter_latency.1.decode_us", false),
+              ElementsAre(30));
+}
+
+TEST_F(HttpConnectionManagerImplTest, FilterLatenciesNotRecordedByDefault) {
+  setup();
+  Buffer::OwnedImpl fake_input("input");
+  conn_manager_->createCodec(fake_input);
+
+  startRequest(false);
+
+  EXPECT_FALSE(
+      decoder_->streamInfo().filterState()->hasDataWithName(StreamInfo::FilterLatencies::key()));
+  // Clean up.
+  filter_callbacks_.connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
 // Validate that deferred streams are processed with a variety of
 // headers, data, metadata, and trailers arriving in the same I/O cycle
 TEST_F(HttpConnectionManagerImplTest, LimitWorkPerIOCycle) {
@@ -142,6 +142,9 @@ public:
   bool addProxyProtocolConnectionState() const override {
     return parent_.addProxyProtocolConnectionState();
   }
+  OptRef<const FilterLatencyStats> filterLatencyStats() const override {
+    return parent_.filterLatencyStats();
+  }
 
 private:
   ConnectionManagerConfig& parent_;
@@ -213,6 +213,9 @@ public:
   bool addProxyProtocolConnectionState() const override {
     return add_proxy_protocol_connection_state_;
   }
+  OptRef<const FilterLatencyStats> filterLatencyStats() const override {
+    return makeOptRefFromPtr<const FilterLatencyStats>(filter_latency_stats_.get());
+  }
 
   // Simple helper to wrapper filter to the factory function.
   FilterFactoryCb createDecoderFilterFactoryCb(StreamDecoderFilterSharedPtr filter) {
@@ -320,6 +323,7 @@ public:
   std::vector<Http::OriginalIPDetectionSharedPtr> ip_detection_extensions_{};
   std::vector<Http::EarlyHeaderMutationPtr> early_header_mutations_{};
   bool add_proxy_protocol_connection_state_ = true;
+  FilterLatencyStatsPtr filter_latency_stats_;
 
   const LocalReply::LocalReplyPtr local_reply_;
 
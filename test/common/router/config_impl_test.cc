@@ -4,6 +4,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "envoy/common/hashable.h"
@@ -5248,6 +5249,156 @@ virtual_hosts:
   EXPECT_EQ(0, percent.numerator());
 }
 
+TEST_F(RouteMatcherTest, HedgeOnLatency) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+- domains: [www.lyft.com]
+  name: www
+  routes:
+  - match: {prefix: /foo}
+    route:
+      cluster: www
+      hedge_policy:
+        hedge_on_per_try_timeout: true
+        hedge_on_latency:
+          percentile: {value: 50}
+          min_delay: 0.005s
+          max_delay: 0.2s
+          min_samples: 10
+  - match: {prefix: /bar}
+    route:
+      cluster: www
+      hedge_policy:
+        hedge_on_per_try_timeout: true
+        hedge_on_latency:
+          min_delay: 0.005s
+          min_samples: 1
+  - match: {prefix: /}
+    route: {cluster: www}
+  )EOF";
+
+  factory_context_.cluster_manager_.initializeClusters({"www"}, {});
+  TestConfigImpl config(parseRouteConfigurationFromYaml(yaml), factory_context_, true,
+                        creation_status_);
+
+  const HedgePolicy& foo_policy =
+      config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_TRUE(foo_policy.hedgeOnLatency());
+  EXPECT_TRUE(foo_policy.hedgeOnPerTryTimeout());
+
+  // No delay until enough latencies were observed.
+  for (int i = 0; i < 9; ++i) {
+    foo_policy.recordUpstreamLatency(std::chrono::milliseconds(100));
+  }
+  EXPECT_EQ(absl::nullopt, foo_policy.latencyHedgeDelay());
+  foo_policy.recordUpstreamLatency(std::chrono::milliseconds(100));
+  // The delay is the upper bound of the bucket holding the median.
+  EXPECT_EQ(std::chrono::milliseconds(111), foo_policy.latencyHedgeDelay());
+
+  // The delay is capped by max_delay.
+  for (int i = 0; i < 20; ++i) {
+    foo_policy.recordUpstreamLatency(std::chrono::milliseconds(1000));
+  }
+  EXPECT_EQ(std::chrono::milliseconds(200), foo_policy.latencyHedgeDelay());
+
+  // The delay is at least min_delay and the latencies of other routes are not shared.
+  const HedgePolicy& bar_policy =
+      config.route(genHeaders("www.lyft.com", "/bar", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_EQ(absl::nullopt, bar_policy.latencyHedgeDelay());
+  bar_policy.recordUpstreamLatency(std::chrono::milliseconds(1));
+  EXPECT_EQ(std::chrono::milliseconds(5), bar_policy.latencyHedgeDelay());
+
+  const HedgePolicy& default_policy =
+      config.route(genHeaders("www.lyft.com", "/", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_FALSE(default_policy.hedgeOnLatency());
+  default_policy.recordUpstreamLatency(std::chrono::milliseconds(1));
+  EXPECT_EQ(absl::nullopt, default_policy.latencyHedgeDelay());
+}
+
+// Latency hedging without per try timeout hedging is rejected, whether the policy is set on the
+// route or inherited from the virtual host.
+TEST_F(RouteMatcherTest, HedgeOnLatencyRequiresHedgeOnPerTryTimeout) {
+  {
+    const std::string yaml = R"EOF(
+virtual_hosts:
+- domains: [www.lyft.com]
+  name: www
+  routes:
+  - name: foo
+    match: {prefix: /foo}
+    route:
+      cluster: www
+      hedge_policy:
+        hedge_on_latency: {}
+  )EOF";
+
+    factory_context_.cluster_manager_.initializeClusters({"www"}, {});
+    TestConfigImpl config(parseRouteConfigurationFromYaml(yaml), factory_context_, true,
+                          creation_status_);
+    EXPECT_EQ(
+        creation_status_.message(),
+        "hedge_on_latency requires hedge_on_per_try_timeout in the hedge policy of route foo");
+  }
+  {
+    const std::string yaml = R"EOF(
+virtual_hosts:
+- domains: [www.lyft.com]
+  name: www
+  hedge_policy:
+    hedge_on_per_try_timeout: false
+    hedge_on_latency: {}
+  routes:
+  - name: bar
+    match: {prefix: /bar}
+    route: {cluster: www}
+  )EOF";
+
+    creation_status_ = absl::OkStatus();
+    TestConfigImpl config(parseRouteConfigurationFromYaml(yaml), factory_context_, true,
+                          creation_status_);
+    EXPECT_EQ(
+        creation_status_.message(),
+        "hedge_on_latency requires hedge_on_per_try_timeout in the hedge policy of route bar");
+  }
+}
+
+TEST(UpstreamLatencyHistogramTest, Decay) {
+  UpstreamLatencyHistogram histogram;
+  for (uint64_t i = 0; i < UpstreamLatencyHistogram::DecayInterval - 1; ++i) {
+    histogram.record(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(std::chrono::milliseconds(11),
+            histogram.percentile(99, UpstreamLatencyHistogram::DecayInterval - 1));
+
+  // Recording the last latency of the interval halves the counts.
+  histogram.record(std::chrono::milliseconds(10));
+  EXPECT_EQ(absl::nullopt, histogram.percentile(99, UpstreamLatencyHistogram::DecayInterval));
+  EXPECT_EQ(std::chrono::milliseconds(11),
+            histogram.percentile(99, UpstreamLatencyHistogram::DecayInterval / 2));
+}
+
+// Latencies recorded concurrently with a decay are neither lost nor halved twice.
+TEST(UpstreamLatencyHistogramTest, ConcurrentDecay) {
+  UpstreamLatencyHistogram histogram;
+  constexpr uint64_t PerThread = UpstreamLatencyHistogram::DecayInterval * 8;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&histogram]() {
+      for (uint64_t j = 0; j < PerThread; ++j) {
+        histogram.record(std::chrono::milliseconds(10));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // The counts keep decaying, stay around two intervals worth of latencies at most and at least
+  // half an interval survives the last decay.
+  EXPECT_EQ(absl::nullopt, histogram.percentile(99, UpstreamLatencyHistogram::DecayInterval * 4));
+  EXPECT_EQ(std::chrono::milliseconds(11),
+            histogram.percentile(99, UpstreamLatencyHistogram::DecayInterval / 2));
+}
+
 TEST_F(RouteMatcherTest, TestBadDefaultConfig) {
   const std::string yaml = R"EOF(
 virtual_hosts:
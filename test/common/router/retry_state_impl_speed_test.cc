@@ -0,0 +1,91 @@
+#include "envoy/config/route/v3/route.pb.h"
+
+#include "source/common/router/config_impl.h"
+#include "source/common/router/retry_state_impl.h"
+
+#include "test/common/memory/memory_test_utility.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/server/instance.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+using testing::NiceMock;
+using testing::ReturnRef;
+
+constexpr absl::string_view RouteConfigYaml = R"EOF(
+virtual_hosts:
+- name: default
+  domains: ["*"]
+  routes:
+  - match: { prefix: "/" }
+    route:
+      cluster: backend
+      retry_policy:
+        retry_on: 5xx,retriable-status-codes,retriable-headers
+        num_retries: 3
+        retriable_status_codes: [409, 429, 502, 503]
+        retriable_headers:
+        - name: x-upstream-retry
+        rate_limited_retry_back_off:
+          reset_headers:
+          - name: retry-after
+            format: SECONDS
+          max_interval: 10s
+)EOF";
+
+/**
+ * Measure the cost of the retry state of a request that succeeds on the first attempt, which is
+ * the common case for routes with a retry policy. The retry state is created, consulted for the
+ * 200 response and destroyed. The bytes held by one retry state are reported as a counter.
+ */
+static void bmRetryStateSuccessPath(benchmark::State& state) {
+  Api::ApiPtr api = Api::createApiForTest();
+  NiceMock<Server::Configuration::MockServerFactoryContext> factory_context;
+  ON_CALL(factory_context, api()).WillByDefault(ReturnRef(*api));
+  NiceMock<StreamInfo::MockStreamInfo> stream_info;
+  NiceMock<Upstream::MockClusterInfo> cluster;
+  NiceMock<Event::MockDispatcher> dispatcher;
+
+  envoy::config::route::v3::RouteConfiguration route_config;
+  TestUtility::loadFromYaml(std::string(RouteConfigYaml), route_config);
+  std::shared_ptr<ConfigImpl> config = *ConfigImpl::create(
+      route_config, factory_context, ProtobufMessage::getNullValidationVisitor(), false);
+
+  const Http::TestRequestHeaderMapImpl request_headers{
+      {":authority", "www.example.com"}, {":method", "GET"}, {":path", "/"}};
+  const Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  const RouteConstSharedPtr route = config->route(request_headers, stream_info, 0);
+  const RetryPolicy& policy = route->routeEntry()->retryPolicy();
+
+  {
+    Http::TestRequestHeaderMapImpl headers = request_headers;
+    Memory::TestUtil::MemoryTest memory_test;
+    auto retry_state =
+        RetryStateImpl::create(policy, headers, cluster, nullptr, absl::nullopt, factory_context,
+                               dispatcher, Upstream::ResourcePriority::Default);
+    state.counters["retry_state_bytes"] = memory_test.consumedBytes();
+  }
+
+  for (auto _ : state) { // NOLINT
+    Http::TestRequestHeaderMapImpl headers = request_headers;
+    auto retry_state =
+        RetryStateImpl::create(policy, headers, cluster, nullptr, absl::nullopt, factory_context,
+                               dispatcher, Upstream::ResourcePriority::Default);
+    bool disable_early_data = false;
+    benchmark::DoNotOptimize(
+        retry_state->wouldRetryFromHeaders(response_headers, headers, disable_early_data));
+  }
+}
+BENCHMARK(bmRetryStateSuccessPath);
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
@@ -1010,6 +1010,27 @@ TEST_F(RouterRetryStateImplTest, MaxRetriesHeader) {
   EXPECT_EQ(1UL, route_stats_context_.stats().upstream_rq_retry_limit_exceeded_.value());
 }
 
+// The backoff intervals from runtime are read when the request starts, not on the first backoff.
+TEST_F(RouterRetryStateImplTest, BackoffRuntimeSnapshotAtCreation) {
+  policy_.num_retries_ = 1;
+  policy_.retry_on_ = RetryPolicy::RETRY_ON_CONNECT_FAILURE;
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.base_retry_backoff_ms", 25))
+      .WillOnce(Return(100));
+  setup();
+  EXPECT_TRUE(state_->enabled());
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.base_retry_backoff_ms", 25))
+      .WillByDefault(Return(1000));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(190));
+  retry_timer_ = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*retry_timer_, enableTimer(std::chrono::milliseconds(90), _));
+  EXPECT_EQ(RetryStatus::Yes,
+            state_->shouldRetryReset(connect_failure_, RetryState::Http3Used::Unknown,
+                                     reset_callback_, false));
+  EXPECT_CALL(callback_ready_, ready());
+  retry_timer_->invokeCallback();
+}
+
 TEST_F(RouterRetryStateImplTest, Backoff) {
   policy_.num_retries_ = 5;
   policy_.retry_on_ = RetryPolicy::RETRY_ON_CONNECT_FAILURE;
@@ -55,6 +55,7 @@
 
 using testing::_;
 using testing::AtLeast;
+using testing::ElementsAre;
 using testing::InSequence;
 using testing::Invoke;
 using testing::InvokeWithoutArgs;
@@ -2240,7 +2241,12 @@ TEST_F(RouterTest, HedgedPerTryTimeoutFirstRequestSucceeds) {
   EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
   EXPECT_EQ(0U, router_->upstreamRequests().size());
 
-  // TODO: Verify hedge stats here once they are implemented.
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_attempted")
+                    .value());
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_abandoned")
+                    .value());
 }
 
 // Tests that an upstream request is reset even if it can't be retried as long as there is
@@ -2338,7 +2344,12 @@ TEST_F(RouterTest, HedgedPerTryTimeoutResetsOnBadHeaders) {
   response_decoder1->decodeHeaders(std::move(response_headers), true);
   EXPECT_TRUE(verifyHostUpstreamStats(1, 1));
 
-  // TODO: Verify hedge stats here once they are implemented.
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_attempted")
+                    .value());
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_abandoned")
+                    .value());
 }
 
 // Three requests sent: 1) 5xx error, 2) per try timeout, 3) gets good response
@@ -2484,7 +2495,131 @@ TEST_F(RouterTest, HedgedPerTryTimeoutThirdRequestSucceeds) {
 
   EXPECT_EQ(333U, callbacks_.stream_info_.upstreamInfo()->upstreamConnectionId());
 
-  // TODO: Verify hedge stats here once they are implemented.
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_attempted")
+                    .value());
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_abandoned")
+                    .value());
+}
+
+// The first request is slower than the observed latency of the route, so a hedge is sent. The
+// hedge answers first and the original request is abandoned.
+TEST_F(RouterTest, LatencyHedgeFirstResponseWins) {
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_on_per_try_timeout_ = true;
+  callbacks_.route_->route_entry_.hedge_policy_.latency_hedge_delay_ =
+      std::chrono::milliseconds(20);
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder1 = nullptr;
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, newStream(_, _, _))
+      .WillOnce(
+          Invoke([&](Http::ResponseDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks,
+                     const Http::ConnectionPool::Instance::StreamOptions&)
+                     -> Http::ConnectionPool::Cancellable* {
+            response_decoder1 = &decoder;
+            EXPECT_CALL(*router_->retry_state_, onHostAttempted(_));
+            callbacks.onPoolReady(encoder1, cm_.thread_local_cluster_.conn_pool_.host_,
+                                  upstream_stream_info_, Http::Protocol::Http10);
+            return nullptr;
+          }));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->outlier_detector_,
+              putResult(Upstream::Outlier::Result::LocalOriginConnectSuccess,
+                        absl::optional<uint64_t>(absl::nullopt)))
+      .Times(2);
+  // The hedge timer is created after the response timer.
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableTimer(std::chrono::milliseconds(20), _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+  expectResponseTimerCreate();
+
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_->decodeHeaders(headers, true);
+  EXPECT_EQ(1U, router_->upstreamRequests().size());
+
+  test_time_.advanceTimeWait(std::chrono::milliseconds(20));
+  NiceMock<Http::MockRequestEncoder> encoder2;
+  Http::ResponseDecoder* response_decoder2 = nullptr;
+  EXPECT_CALL(*router_->retry_state_, shouldHedgeOnLatency(_))
+      .WillOnce(DoAll(SaveArg<0>(&router_->retry_state_->callback_), Return(RetryStatus::Yes)));
+  hedge_timer->invokeCallback();
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, newStream(_, _, _))
+      .WillOnce(
+          Invoke([&](Http::ResponseDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks,
+                     const Http::ConnectionPool::Instance::StreamOptions&)
+                     -> Http::ConnectionPool::Cancellable* {
+            response_decoder2 = &decoder;
+            EXPECT_CALL(*router_->retry_state_, onHostAttempted(_));
+            callbacks.onPoolReady(encoder2, cm_.thread_local_cluster_.conn_pool_.host_,
+                                  upstream_stream_info_, Http::Protocol::Http10);
+            return nullptr;
+          }));
+  router_->retry_state_->callback_();
+  EXPECT_EQ(2U, router_->upstreamRequests().size());
+  test_time_.advanceTimeWait(std::chrono::milliseconds(10));
+
+  // The hedge answers first, the original request is reset.
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  EXPECT_CALL(*router_->retry_state_, shouldRetryHeaders(_, _, _))
+      .WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->outlier_detector_,
+              putHttpResponseCode(200));
+  EXPECT_CALL(encoder1.stream_, resetStream(_));
+  EXPECT_CALL(encoder2.stream_, resetStream(_)).Times(0);
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, _))
+      .WillOnce(Invoke([&](Http::ResponseHeaderMap& headers, bool end_stream) -> void {
+        EXPECT_EQ(headers.Status()->value(), "200");
+        EXPECT_TRUE(end_stream);
+      }));
+  ASSERT(response_decoder2);
+  response_decoder2->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(0U, router_->upstreamRequests().size());
+  EXPECT_NE(nullptr, response_decoder1);
+
+  // The latency of the hedge is recorded, followed by the time the abandoned original request was
+  // in flight as a lower bound of its latency.
+  EXPECT_THAT(callbacks_.route_->route_entry_.hedge_policy_.recorded_upstream_latencies_,
+              ElementsAre(std::chrono::milliseconds(10), std::chrono::milliseconds(30)));
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_attempted")
+                    .value());
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_abandoned")
+                    .value());
+}
+
+// A response that arrives before the hedge delay cancels the hedge.
+TEST_F(RouterTest, LatencyHedgeNotSentWhenResponseIsFast) {
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_on_per_try_timeout_ = true;
+  callbacks_.route_->route_entry_.hedge_policy_.latency_hedge_delay_ =
+      std::chrono::milliseconds(20);
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder1, &response_decoder, Http::Protocol::Http10);
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableTimer(std::chrono::milliseconds(20), _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+  expectResponseTimerCreate();
+
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_->decodeHeaders(headers, true);
+
+  EXPECT_CALL(*router_->retry_state_, shouldHedgeOnLatency(_)).Times(0);
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->outlier_detector_,
+              putHttpResponseCode(200));
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+
+  EXPECT_EQ(1U,
+            callbacks_.route_->route_entry_.hedge_policy_.recorded_upstream_latencies_.size());
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_attempted")
+                    .value());
 }
 
 // First request times out and is retried, and then a response is received.
@@ -3040,7 +3175,12 @@ TEST_F(RouterTest, HedgedPerTryTimeoutGlobalTimeout) {
   response_timeout_->invokeCallback();
   EXPECT_TRUE(verifyHostUpstreamStats(0, 2));
   EXPECT_EQ(2, cm_.thread_local_cluster_.conn_pool_.host_->stats_.rq_timeout_.value());
-  // TODO: Verify hedge stats here once they are implemented.
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_attempted")
+                    .value());
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_abandoned")
+                    .value());
 }
 
 // Sequence: 1) per try timeout w/ hedge retry, 2) second request gets a 5xx
@@ -5540,6 +5680,30 @@ TEST(RouterFilterUtilityTest, FinalHedgingParamsHedgeOnPerTryTimeout) {
   }
 }
 
+TEST(RouterFilterUtilityTest, FinalHedgingParamsHedgeOnLatency) {
+  Http::TestRequestHeaderMapImpl empty_headers;
+  { // route hedges on latency, header not present, expect latency hedging.
+    NiceMock<MockRouteEntry> route;
+    route.hedge_policy_.hedge_on_per_try_timeout_ = true;
+    route.hedge_policy_.latency_hedge_delay_ = std::chrono::milliseconds(20);
+    EXPECT_CALL(route, hedgePolicy).WillRepeatedly(ReturnRef(route.hedge_policy_));
+    FilterUtility::HedgingParams hedgingParams =
+        FilterUtility::finalHedgingParams(route, empty_headers);
+    EXPECT_TRUE(hedgingParams.hedge_on_per_try_timeout_);
+    EXPECT_TRUE(hedgingParams.hedge_on_latency_);
+  }
+  { // route hedges on latency, header disables per try timeout hedging, expect no hedging.
+    Http::TestRequestHeaderMapImpl headers{{"x-envoy-hedge-on-per-try-timeout", "false"}};
+    NiceMock<MockRouteEntry> route;
+    route.hedge_policy_.hedge_on_per_try_timeout_ = true;
+    route.hedge_policy_.latency_hedge_delay_ = std::chrono::milliseconds(20);
+    EXPECT_CALL(route, hedgePolicy).WillRepeatedly(ReturnRef(route.hedge_policy_));
+    FilterUtility::HedgingParams hedgingParams = FilterUtility::finalHedgingParams(route, headers);
+    EXPECT_FALSE(hedgingParams.hedge_on_per_try_timeout_);
+    EXPECT_FALSE(hedgingParams.hedge_on_latency_);
+  }
+}
+
 TEST(RouterFilterUtilityTest, FinalTimeout) {
   {
     NiceMock<MockRouteEntry> route;
@@ -6914,6 +7078,64 @@ TEST_F(RouterTest, OrcaLoadReportCallbacks) {
             headers_orca_load_report.cpu_utilization());
 }
 
+class TestResponseTimeLbData : public Upstream::HostLbPolicyData {
+public:
+  MOCK_METHOD(void, onUpstreamResponseTime, (std::chrono::microseconds), (override));
+  MOCK_METHOD(void, onUpstreamFailure, (std::chrono::microseconds), (override));
+};
+
+// The upstream response time is reported to the host's LB policy data for complete responses.
+TEST_F(RouterTest, UpstreamResponseTimeReportedOnSuccess) {
+  EXPECT_CALL(callbacks_.route_->route_entry_, timeout())
+      .WillOnce(Return(std::chrono::milliseconds(0)));
+  EXPECT_CALL(callbacks_.dispatcher_, createTimer_(_)).Times(0);
+
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+
+  auto host_lb_policy_data = std::make_unique<TestResponseTimeLbData>();
+  auto* host_lb_policy_data_raw_ptr = host_lb_policy_data.get();
+  cm_.thread_local_cluster_.conn_pool_.host_->lb_policy_data_ = std::move(host_lb_policy_data);
+
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_->decodeHeaders(headers, true);
+
+  test_time_.advanceTimeWait(std::chrono::milliseconds(10));
+  EXPECT_CALL(*host_lb_policy_data_raw_ptr,
+              onUpstreamResponseTime(std::chrono::microseconds(10000)));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+}
+
+// Resets are reported as failures rather than response times, so that a failing host does not look
+// fast to latency aware load balancers.
+TEST_F(RouterTest, UpstreamFailureReportedOnReset) {
+  EXPECT_CALL(callbacks_.route_->route_entry_, timeout())
+      .WillOnce(Return(std::chrono::milliseconds(0)));
+  EXPECT_CALL(callbacks_.dispatcher_, createTimer_(_)).Times(0);
+
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+
+  auto host_lb_policy_data = std::make_unique<TestResponseTimeLbData>();
+  auto* host_lb_policy_data_raw_ptr = host_lb_policy_data.get();
+  cm_.thread_local_cluster_.conn_pool_.host_->lb_policy_data_ = std::move(host_lb_policy_data);
+
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_->decodeHeaders(headers, true);
+
+  test_time_.advanceTimeWait(std::chrono::milliseconds(5));
+  EXPECT_CALL(*host_lb_policy_data_raw_ptr, onUpstreamResponseTime(_)).Times(0);
+  EXPECT_CALL(*host_lb_policy_data_raw_ptr, onUpstreamFailure(std::chrono::microseconds(5000)));
+  encoder.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+  EXPECT_EQ(callbacks_.details(), "upstream_reset_before_response_started{remote_reset}");
+}
+
 TEST_F(RouterTest, OrcaLoadReportCallbackReturnsError) {
   EXPECT_CALL(callbacks_.route_->route_entry_, timeout())
       .WillOnce(Return(std::chrono::milliseconds(0)));
@@ -18,9 +18,10 @@ namespace Envoy {
 namespace Stats {
 namespace {
 
-class AllocatorImplTest : public testing::Test {
+// Runs each test with individually heap-allocated stats and with slab allocation.
+class AllocatorImplTest : public testing::TestWithParam<bool> {
 protected:
-  AllocatorImplTest() : pool_(symbol_table_), alloc_(symbol_table_) {}
+  AllocatorImplTest() : pool_(symbol_table_), alloc_(symbol_table_, GetParam()) {}
   ~AllocatorImplTest() override { clearStorage(); }
 
   StatNameStorage makeStatStorage(absl::string_view name) { return {name, symbol_table_}; }
@@ -45,8 +46,10 @@ protected:
   bool are_stats_marked_for_deletion_ = false;
 };
 
+INSTANTIATE_TEST_SUITE_P(SlabAllocation, AllocatorImplTest, testing::Bool());
+
 // Allocate 2 counters of the same name, and you'll get the same object.
-TEST_F(AllocatorImplTest, CountersWithSameName) {
+TEST_P(AllocatorImplTest, CountersWithSameName) {
   StatName counter_name = makeStat("counter.name");
   CounterSharedPtr c1 = alloc_.makeCounter(counter_name, StatName(), {});
   EXPECT_EQ(1, c1->use_count());
@@ -64,7 +67,7 @@ TEST_F(AllocatorImplTest, CountersWithSameName) {
   EXPECT_EQ(2, c2->value());
 }
 
-TEST_F(AllocatorImplTest, GaugesWithSameName) {
+TEST_P(AllocatorImplTest, GaugesWithSameName) {
   StatName gauge_name = makeStat("gauges.name");
   GaugeSharedPtr g1 = alloc_.makeGauge(gauge_name, StatName(), {}, Gauge::ImportMode::Accumulate);
   EXPECT_EQ(1, g1->use_count());
@@ -84,11 +87,101 @@ TEST_F(AllocatorImplTest, GaugesWithSameName) {
   EXPECT_EQ(0, g2->value());
 }
 
+TEST_P(AllocatorImplTest, GaugeLatchChanged) {
+  GaugeSharedPtr gauge =
+      alloc_.makeGauge(makeStat("gauge.name"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  EXPECT_FALSE(gauge->latchChanged());
+
+  gauge->add(2);
+  EXPECT_TRUE(gauge->latchChanged());
+  EXPECT_FALSE(gauge->latchChanged());
+
+  gauge->sub(1);
+  EXPECT_TRUE(gauge->latchChanged());
+  EXPECT_FALSE(gauge->latchChanged());
+
+  gauge->set(5);
+  gauge->inc();
+  EXPECT_TRUE(gauge->latchChanged());
+  EXPECT_FALSE(gauge->latchChanged());
+
+  // The value inherited from a hot restart parent is part of value(), so it changes the gauge too.
+  gauge->setParentValue(3);
+  EXPECT_TRUE(gauge->latchChanged());
+  EXPECT_FALSE(gauge->latchChanged());
+  EXPECT_EQ(9, gauge->value());
+  gauge->setParentValue(3);
+  EXPECT_FALSE(gauge->latchChanged());
+}
+
+TEST_P(AllocatorImplTest, ForEachChangedSinkedCounter) {
+  CounterSharedPtr idle = alloc_.makeCounter(makeStat("idle"), StatName(), {});
+  CounterSharedPtr changed = alloc_.makeCounter(makeStat("changed"), StatName(), {});
+  std::vector<std::string> names;
+  auto collect = [&names](Counter& counter) {
+    counter.latch();
+    names.push_back(counter.name());
+  };
+
+  // Changes are only tracked from the first call, which visits every counter.
+  alloc_.forEachChangedSinkedCounter([](std::size_t size) { EXPECT_EQ(2, size); }, collect);
+  EXPECT_EQ(2, names.size());
+
+  names.clear();
+  alloc_.forEachChangedSinkedCounter([](std::size_t size) { EXPECT_EQ(0, size); }, collect);
+  EXPECT_TRUE(names.empty());
+
+  changed->inc();
+  changed->add(2);
+  alloc_.forEachChangedSinkedCounter([](std::size_t size) { EXPECT_EQ(1, size); }, collect);
+  EXPECT_THAT(names, testing::ElementsAre("changed"));
+
+  // A counter marked for deletion is no longer visited, even when it is still incremented.
+  names.clear();
+  alloc_.markCounterForDeletion(changed);
+  changed->inc();
+  alloc_.forEachChangedSinkedCounter(nullptr, collect);
+  EXPECT_TRUE(names.empty());
+}
+
+TEST_P(AllocatorImplTest, ForEachChangedSinkedGauge) {
+  GaugeSharedPtr untouched =
+      alloc_.makeGauge(makeStat("untouched"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  GaugeSharedPtr changed =
+      alloc_.makeGauge(makeStat("changed"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  GaugeSharedPtr hidden =
+      alloc_.makeGauge(makeStat("hidden"), StatName(), {}, Gauge::ImportMode::HiddenAccumulate);
+  std::vector<std::string> names;
+  auto collect = [&names](Gauge& gauge) { names.push_back(gauge.name()); };
+
+  // The first call finds the gauges changed before tracking started by their flag.
+  changed->set(1);
+  hidden->set(1);
+  alloc_.forEachChangedSinkedGauge([](std::size_t) {}, collect);
+  EXPECT_THAT(names, testing::ElementsAre("changed"));
+
+  names.clear();
+  alloc_.forEachChangedSinkedGauge([](std::size_t) {}, collect);
+  EXPECT_TRUE(names.empty());
+
+  changed->dec();
+  hidden->inc();
+  alloc_.forEachChangedSinkedGauge(nullptr, collect);
+  EXPECT_THAT(names, testing::ElementsAre("changed"));
+
+  // A gauge destroyed after it changed is dropped from the changed set.
+  names.clear();
+  changed->inc();
+  changed.reset();
+  alloc_.forEachChangedSinkedGauge(nullptr, collect);
+  EXPECT_TRUE(names.empty());
+}
+
 // Test for a race-condition where we may decrement the ref-count of a stat to
 // zero at the same time as we are allocating another instance of that
 // stat. This test reproduces that race organically by having a 12 threads each
 // iterate 10k times.
-TEST_F(AllocatorImplTest, RefCountDecAllocRaceOrganic) {
+TEST_P(AllocatorImplTest, RefCountDecAllocRaceOrganic) {
   StatName counter_name = makeStat("counter.name");
   StatName gauge_name = makeStat("gauge.name");
   Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
@@ -119,7 +212,7 @@ TEST_F(AllocatorImplTest, RefCountDecAllocRaceOrganic) {
 // makeCounter() until the first thread finishes destructing the object. Thus
 // the test gives thread2 5 seconds to complete before releasing thread 1 to
 // complete its destruction of the counter.
-TEST_F(AllocatorImplTest, RefCountDecAllocRaceSynchronized) {
+TEST_P(AllocatorImplTest, RefCountDecAllocRaceSynchronized) {
   StatName counter_name = makeStat("counter.name");
   Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
   alloc_.sync().enable();
@@ -137,7 +230,7 @@ TEST_F(AllocatorImplTest, RefCountDecAllocRaceSynchronized) {
   EXPECT_FALSE(alloc_.isMutexLockedForTest());
 }
 
-TEST_F(AllocatorImplTest, HiddenGauge) {
+TEST_P(AllocatorImplTest, HiddenGauge) {
   GaugeSharedPtr hidden_gauge =
       alloc_.makeGauge(makeStat("hidden"), StatName(), {}, Gauge::ImportMode::HiddenAccumulate);
   EXPECT_EQ(hidden_gauge->importMode(), Gauge::ImportMode::HiddenAccumulate);
@@ -154,7 +247,7 @@ TEST_F(AllocatorImplTest, HiddenGauge) {
   EXPECT_FALSE(never_import_hidden_gauge->hidden());
 }
 
-TEST_F(AllocatorImplTest, ForEachCounter) {
+TEST_P(AllocatorImplTest, ForEachCounter) {
   StatNameHashSet stat_names;
   std::vector<CounterSharedPtr> counters;
 
@@ -207,7 +300,7 @@ TEST_F(AllocatorImplTest, ForEachCounter) {
   EXPECT_EQ(num_iterations, 0);
 }
 
-TEST_F(AllocatorImplTest, ForEachGauge) {
+TEST_P(AllocatorImplTest, ForEachGauge) {
   StatNameHashSet stat_names;
   std::vector<GaugeSharedPtr> gauges;
 
@@ -260,7 +353,7 @@ TEST_F(AllocatorImplTest, ForEachGauge) {
   EXPECT_EQ(num_iterations, 0);
 }
 
-TEST_F(AllocatorImplTest, ForEachTextReadout) {
+TEST_P(AllocatorImplTest, ForEachTextReadout) {
   StatNameHashSet stat_names;
   std::vector<TextReadoutSharedPtr> text_readouts;
 
@@ -316,7 +409,7 @@ TEST_F(AllocatorImplTest, ForEachTextReadout) {
 
 // Verify that we don't crash if a nullptr is passed in for the size lambda for
 // the for each stat methods.
-TEST_F(AllocatorImplTest, ForEachWithNullSizeLambda) {
+TEST_P(AllocatorImplTest, ForEachWithNullSizeLambda) {
   std::vector<CounterSharedPtr> counters;
   std::vector<TextReadoutSharedPtr> text_readouts;
   std::vector<GaugeSharedPtr> gauges;
@@ -363,7 +456,7 @@ TEST_F(AllocatorImplTest, ForEachWithNullSizeLambda) {
 // Currently, if we ask for a stat from the Allocator that has already been
 // marked for deletion (i.e. rejected) we get a new stat with the same name.
 // This test documents this behavior.
-TEST_F(AllocatorImplTest, AskForDeletedStat) {
+TEST_P(AllocatorImplTest, AskForDeletedStat) {
   const size_t num_stats = 10;
   are_stats_marked_for_deletion_ = true;
 
@@ -431,7 +524,7 @@ TEST_F(AllocatorImplTest, AskForDeletedStat) {
   EXPECT_EQ(rejected_text_readout.value(), "deleted value");
 }
 
-TEST_F(AllocatorImplTest, ForEachSinkedCounter) {
+TEST_P(AllocatorImplTest, ForEachSinkedCounter) {
   std::unique_ptr<TestUtil::TestSinkPredicates> moved_sink_predicates =
       std::make_unique<TestUtil::TestSinkPredicates>();
   TestUtil::TestSinkPredicates* sink_predicates = moved_sink_predicates.get();
@@ -477,7 +570,7 @@ TEST_F(AllocatorImplTest, ForEachSinkedCounter) {
   EXPECT_EQ(num_iterations, 0);
 }
 
-TEST_F(AllocatorImplTest, ForEachSinkedGauge) {
+TEST_P(AllocatorImplTest, ForEachSinkedGauge) {
   std::unique_ptr<TestUtil::TestSinkPredicates> moved_sink_predicates =
       std::make_unique<TestUtil::TestSinkPredicates>();
   TestUtil::TestSinkPredicates* sink_predicates = moved_sink_predicates.get();
@@ -522,7 +615,7 @@ TEST_F(AllocatorImplTest, ForEachSinkedGauge) {
   EXPECT_EQ(num_iterations, 0);
 }
 
-TEST_F(AllocatorImplTest, ForEachSinkedGaugeHidden) {
+TEST_P(AllocatorImplTest, ForEachSinkedGaugeHidden) {
   GaugeSharedPtr unhidden_gauge;
   GaugeSharedPtr hidden_gauge;
 
@@ -547,7 +640,7 @@ TEST_F(AllocatorImplTest, ForEachSinkedGaugeHidden) {
   EXPECT_EQ(num_iterations, 1);
 }
 
-TEST_F(AllocatorImplTest, ForEachSinkedGaugeHiddenPredicate) {
+TEST_P(AllocatorImplTest, ForEachSinkedGaugeHiddenPredicate) {
   std::unique_ptr<TestUtil::TestSinkPredicates> moved_sink_predicates =
       std::make_unique<TestUtil::TestSinkPredicates>();
   TestUtil::TestSinkPredicates* sink_predicates = moved_sink_predicates.get();
@@ -581,7 +674,7 @@ TEST_F(AllocatorImplTest, ForEachSinkedGaugeHiddenPredicate) {
   EXPECT_EQ(num_iterations, 2);
 }
 
-TEST_F(AllocatorImplTest, ForEachSinkedTextReadout) {
+TEST_P(AllocatorImplTest, ForEachSinkedTextReadout) {
   std::unique_ptr<TestUtil::TestSinkPredicates> moved_sink_predicates =
       std::make_unique<TestUtil::TestSinkPredicates>();
   TestUtil::TestSinkPredicates* sink_predicates = moved_sink_predicates.get();
@@ -626,6 +719,88 @@ TEST_F(AllocatorImplTest, ForEachSinkedTextReadout) {
   EXPECT_EQ(num_iterations, 0);
 }
 
+// Freed counter and gauge slots are reused, and the slabs are only grown once
+// the existing ones are full.
+TEST_P(AllocatorImplTest, SlabSlotsReused) {
+  if (!GetParam()) {
+    EXPECT_FALSE(alloc_.slabAllocation());
+    EXPECT_EQ(0, alloc_.slabBytes());
+    return;
+  }
+  EXPECT_TRUE(alloc_.slabAllocation());
+  EXPECT_EQ(0, alloc_.slabBytes());
+
+  std::vector<CounterSharedPtr> counters;
+  std::vector<GaugeSharedPtr> gauges;
+  for (uint32_t i = 0; i < StatSlabs::SlotsPerSlab; ++i) {
+    counters.emplace_back(alloc_.makeCounter(makeStat(absl::StrCat("c", i)), StatName(), {}));
+    gauges.emplace_back(alloc_.makeGauge(makeStat(absl::StrCat("g", i)), StatName(), {},
+                                         Gauge::ImportMode::Accumulate));
+  }
+  const uint64_t full_bytes = alloc_.slabBytes();
+  EXPECT_LT(0, full_bytes);
+
+  // Stats in the same slab are laid out contiguously.
+  const auto* first = reinterpret_cast<const char*>(counters[0].get());
+  const auto* second = reinterpret_cast<const char*>(counters[1].get());
+  const auto* third = reinterpret_cast<const char*>(counters[2].get());
+  EXPECT_LT(0, second - first);
+  EXPECT_EQ(second - first, third - second);
+
+  // Releasing a counter and making a new one reuses its slot without growing the slabs.
+  const Counter* released = counters[7].get();
+  counters[7]->add(5);
+  counters[7].reset();
+  CounterSharedPtr reused = alloc_.makeCounter(makeStat("reused"), StatName(), {});
+  EXPECT_EQ(released, reused.get());
+  EXPECT_EQ(0, reused->value());
+  EXPECT_EQ(full_bytes, alloc_.slabBytes());
+
+  // One more counter than fits in a slab requires a new slab.
+  CounterSharedPtr overflow = alloc_.makeCounter(makeStat("overflow"), StatName(), {});
+  EXPECT_LT(full_bytes, alloc_.slabBytes());
+
+  size_t num_counters = 0;
+  alloc_.forEachCounter(nullptr, [&num_counters](Counter&) { ++num_counters; });
+  EXPECT_EQ(StatSlabs::SlotsPerSlab + 1, num_counters);
+}
+
+TEST(StatSlabsTest, ListedSlots) {
+  StatSlabs slabs(20, 8);
+  EXPECT_EQ(24, slabs.slotSize());
+
+  std::vector<void*> slots;
+  for (uint32_t i = 0; i < StatSlabs::SlotsPerSlab + 2; ++i) {
+    slots.push_back(slabs.allocate());
+  }
+  EXPECT_EQ(2, slabs.numSlabs());
+  EXPECT_EQ(StatSlabs::SlotsPerSlab + 2, slabs.numAllocated());
+  EXPECT_EQ(static_cast<char*>(slots[0]) + slabs.slotSize(), slots[1]);
+
+  // Unlisted slots are skipped by forEachListed, and addresses outside the slabs are ignored.
+  slabs.unlist(slots[3]);
+  int not_in_slabs;
+  slabs.unlist(&not_in_slabs);
+  std::vector<void*> listed;
+  slabs.forEachListed([&listed](void* slot) { listed.push_back(slot); });
+  EXPECT_EQ(StatSlabs::SlotsPerSlab + 1, listed.size());
+  EXPECT_EQ(slots[2], listed[2]);
+  EXPECT_EQ(slots[4], listed[3]);
+
+  // Released slots are handed out again, most recently released first.
+  slabs.release(slots[3]);
+  slabs.release(slots[10]);
+  EXPECT_EQ(StatSlabs::SlotsPerSlab, slabs.numAllocated());
+  EXPECT_EQ(slots[10], slabs.allocate());
+  EXPECT_EQ(slots[3], slabs.allocate());
+  EXPECT_EQ(2, slabs.numSlabs());
+
+  for (void* slot : slots) {
+    slabs.release(slot);
+  }
+  EXPECT_EQ(0, slabs.numAllocated());
+}
+
 } // namespace
 } // namespace Stats
 } // namespace Envoy
@@ -232,7 +232,6 @@ TEST_F(StatNameTest, TestSuccessfulDecode) {
 class StatNameDeathTest : public StatNameTest {
 public:
   void decodeSymbolVec(const SymbolVec& symbol_vec) {
-    Thread::LockGuard lock(table_.lock_);
     for (Symbol symbol : symbol_vec) {
       table_.fromSymbol(symbol);
     }
@@ -532,20 +531,11 @@ TEST_F(StatNameTest, RacingSymbolCreation) {
   access.setReady();
   accesses.Wait();
 
-  // In a perfect world, we could use reader-locks in the SymbolTable
-  // implementation, and there should be zero additional contentions
-  // after latching 'create_contentions' above. And we can definitely
-  // have this world, but this slows down BM_CreateRace in
-  // symbol_table_speed_test.cc, even on a 72-core machine.
-  //
-  // Thus it is better to avoid symbol-table contention by refactoring
-  // all stat-creation code to symbolize all stat string elements at
-  // construction, as composition does not require a lock.
-  //
-  // See this commit
-  // https://github.com/envoyproxy/envoy/pull/5321/commits/ef712d0f5a11ff49831c1935e8a2ef8a0a935bc9
-  // for a working reader-lock implementation, which would pass this EXPECT:
-  //     EXPECT_EQ(create_contentions, mutex_tracer.numContentions());
+  // Existing symbols are found and referenced without taking the shard
+  // locks, so the symbol table adds no contentions after latching
+  // 'create_contentions' above. The tracer also counts contentions on the
+  // absl::BlockingCounter synchronizing the threads, so we cannot expect
+  // the count to be unchanged.
   //
   // Note also that we cannot guarantee there *will* be contentions
   // as a machine or OS is free to run all threads serially.
@@ -600,20 +590,11 @@ TEST_F(StatNameTest, MutexContentionOnExistingSymbols) {
   access.setReady();
   accesses.Wait();
 
-  // In a perfect world, we could use reader-locks in the SymbolTable
-  // implementation, and there should be zero additional contentions
-  // after latching 'create_contentions' above. And we can definitely
-  // have this world, but this slows down BM_CreateRace in
-  // symbol_table_speed_test.cc, even on a 72-core machine.
-  //
-  // Thus it is better to avoid symbol-table contention by refactoring
-  // all stat-creation code to symbolize all stat string elements at
-  // construction, as composition does not require a lock.
-  //
-  // See this commit
-  // https://github.com/envoyproxy/envoy/pull/5321/commits/ef712d0f5a11ff49831c1935e8a2ef8a0a935bc9
-  // for a working reader-lock implementation, which would pass this EXPECT:
-  //     EXPECT_EQ(create_contentions, mutex_tracer.numContentions());
+  // Existing symbols are found and referenced without taking the shard
+  // locks, so the symbol table adds no contentions after latching
+  // 'create_contentions' above. The tracer also counts contentions on the
+  // absl::BlockingCounter synchronizing the threads, so we cannot expect
+  // the count to be unchanged.
   //
   // Note also that we cannot guarantee there *will* be contentions
   // as a machine or OS is free to run all threads serially.
@@ -624,6 +605,85 @@ TEST_F(StatNameTest, MutexContentionOnExistingSymbols) {
   }
 }
 
+// Validates that we don't get tsan or other errors when decoding names, which
+// takes no locks, while other threads create and free symbols, which may
+// re-use freed symbols and allocate new blocks of the decode table.
+TEST_F(StatNameTest, DecodeWhileCreatingAndFreeing) {
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+  const StatName held = makeStat("held.name");
+
+  constexpr int num_threads = 8;
+  std::vector<Thread::ThreadPtr> threads;
+  threads.reserve(num_threads);
+  ConditionalInitializer start;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(thread_factory.createThread([this, i, &start, held]() {
+      start.wait();
+      for (int count = 0; count < 1000; ++count) {
+        if (i % 2 == 0) {
+          EXPECT_EQ("held.name", table_.toString(held));
+        } else {
+          StatNameManagedStorage storage(absl::StrCat("thread", i, ".name", count), table_);
+          EXPECT_FALSE(table_.lessThan(storage.statName(), held));
+        }
+      }
+    }));
+  }
+  start.setReady();
+  for (auto& thread : threads) {
+    thread->join();
+  }
+}
+
+// Validates that symbols whose last reference is being freed while other
+// threads encode them again are neither lost nor freed twice, as encoding an
+// existing symbol takes no lock.
+TEST_F(StatNameTest, EncodeWhileFreeingLastReference) {
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+
+  constexpr int num_threads = 8;
+  std::vector<Thread::ThreadPtr> threads;
+  threads.reserve(num_threads);
+  ConditionalInitializer start;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(thread_factory.createThread([this, &start]() {
+      start.wait();
+      for (int count = 0; count < 1000; ++count) {
+        const std::string name = absl::StrCat("shared", count % 4, ".name");
+        StatNameManagedStorage storage(name, table_);
+        EXPECT_EQ(name, table_.toString(storage.statName()));
+      }
+    }));
+  }
+  start.setReady();
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  EXPECT_EQ(0, table_.numSymbols());
+}
+
+// Validates that the decode and encode tables grow past their initial sizes,
+// and that symbols freed along the way are re-used.
+TEST_F(StatNameTest, GrowTables) {
+  constexpr int num_names = 50000;
+  std::vector<StatName> names;
+  names.reserve(num_names);
+  for (int i = 0; i < num_names; ++i) {
+    names.push_back(makeStat(absl::StrCat("name", i)));
+  }
+  EXPECT_EQ(num_names, table_.numSymbols());
+  for (int i = 0; i < num_names; ++i) {
+    EXPECT_EQ(absl::StrCat("name", i), table_.toString(names[i]));
+  }
+  const Symbol monotonic_counter = monotonicCounter();
+  clearStorage();
+
+  for (int i = 0; i < num_names; ++i) {
+    makeStat(absl::StrCat("other", i));
+  }
+  EXPECT_EQ(monotonic_counter, monotonicCounter());
+}
+
 TEST_F(StatNameTest, SharedStatNameStorageSetInsertAndFind) {
   StatNameStorageSet set;
   const int iters = 10;
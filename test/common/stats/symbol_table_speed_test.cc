@@ -63,6 +63,68 @@ static void bmCreateRace(benchmark::State& state) {
 }
 BENCHMARK(bmCreateRace)->Unit(::benchmark::kMillisecond);
 
+// Runs fn(thread_index) on state.range(0) threads at once, 'iterations' times each.
+static void runContended(benchmark::State& state, uint32_t iterations,
+                         const std::function<void(uint32_t)>& fn) {
+  Envoy::Thread::ThreadFactory& thread_factory = Envoy::Thread::threadFactoryForTest();
+  const uint32_t num_threads = state.range(0);
+  std::vector<Envoy::Thread::ThreadPtr> threads;
+  threads.reserve(num_threads);
+  Envoy::ConditionalInitializer start;
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads.push_back(thread_factory.createThread([&start, &fn, iterations, i]() {
+      start.wait();
+      for (uint32_t count = 0; count < iterations; ++count) {
+        fn(i);
+      }
+    }));
+  }
+  start.setReady();
+  for (auto& thread : threads) {
+    thread->join();
+  }
+}
+
+// Measures encoding names whose symbols already exist, as done when scopes are
+// created at runtime for routes and clusters, on a varying number of threads.
+// Each thread encodes names made of its own tokens and of tokens shared by all
+// threads, so that threads contend on the shards of the shared tokens only.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void bmEncodeExistingContention(benchmark::State& state) {
+  Envoy::Stats::SymbolTableImpl table;
+  Envoy::Stats::StatNamePool pool(table);
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    names.push_back(absl::StrCat("cluster.tenant_", i, ".upstream_rq_total"));
+    pool.add(names.back()); // Holds a reference, so the symbols are never freed.
+  }
+
+  for (auto _ : state) { // NOLINT
+    runContended(state, 1000, [&table, &names](uint32_t i) {
+      // NOLINTNEXTLINE(clang-analyzer-unix.Malloc)
+      Envoy::Stats::StatNameStorage storage(names[i], table);
+      storage.free(table);
+    });
+  }
+}
+BENCHMARK(bmEncodeExistingContention)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+
+// Measures decoding names to strings on a varying number of threads, as done
+// by the admin handlers and stat sinks. This takes no locks.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void bmDecodeContention(benchmark::State& state) {
+  Envoy::Stats::SymbolTableImpl table;
+  Envoy::Stats::StatNamePool pool(table);
+  const Envoy::Stats::StatName name = pool.add("cluster.backend.upstream_rq_total");
+
+  for (auto _ : state) { // NOLINT
+    runContended(state, 1000, [&table, name](uint32_t) {
+      benchmark::DoNotOptimize(table.toString(name));
+    });
+  }
+}
+BENCHMARK(bmDecodeContention)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+
 // NOLINTNEXTLINE(readability-identifier-naming)
 static void bmJoinStatNames(benchmark::State& state) {
   Envoy::Stats::SymbolTableImpl symbol_table;
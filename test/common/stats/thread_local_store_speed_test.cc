@@ -66,6 +66,29 @@ public:
     store_.initializeThreading(*dispatcher_, *tls_);
   }
 
+  void createHistograms(uint64_t num_histograms) {
+    Stats::Scope& scope = *store_.rootScope();
+    Stats::StatNamePool pool(symbol_table_);
+    histograms_.reserve(num_histograms);
+    for (uint64_t i = 0; i < num_histograms; ++i) {
+      histograms_.push_back(&scope.histogramFromStatName(
+          pool.add(absl::StrCat("histogram.", i)), Stats::Histogram::Unit::Milliseconds));
+    }
+  }
+
+  // Records one value into every stride'th histogram.
+  void recordHistograms(uint64_t stride) {
+    for (uint64_t i = 0; i < histograms_.size(); i += stride) {
+      histograms_[i]->recordValue(i);
+    }
+  }
+
+  // Runs a complete histogram merge, as done on every stats flush.
+  void mergeHistograms() {
+    store_.mergeHistograms([]() -> void {});
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  }
+
   void initPrefixRejections(const std::string& prefix) {
     stats_config_.mutable_stats_matcher()->mutable_exclusion_list()->add_patterns()->set_prefix(
         prefix);
@@ -84,6 +107,7 @@ private:
   Api::ApiPtr api_;
   envoy::config::metrics::v3::StatsConfig stats_config_;
   std::vector<std::unique_ptr<Stats::StatNameManagedStorage>> stat_names_;
+  std::vector<Stats::Histogram*> histograms_;
 };
 
 } // namespace Envoy
@@ -138,5 +162,57 @@ static void BM_StatsWithTlsAndRejectionsWithoutDot(benchmark::State& state) {
 }
 BENCHMARK(BM_StatsWithTlsAndRejectionsWithoutDot);
 
+// Measures the main-thread cost of a stats flush histogram merge against the number of
+// histograms, when only one in range(1) histograms saw a value during the interval.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_HistogramMerge(benchmark::State& state) {
+  Envoy::ThreadLocalStorePerf context;
+  context.initThreading();
+  context.createHistograms(state.range(0));
+  // Record into every histogram once so that all of them have been merged before.
+  context.recordHistograms(1);
+  context.mergeHistograms();
+
+  for (auto _ : state) { // NOLINT
+    state.PauseTiming();
+    context.recordHistograms(state.range(1));
+    state.ResumeTiming();
+    context.mergeHistograms();
+  }
+}
+BENCHMARK(BM_HistogramMerge)
+    ->ArgsProduct({{1000, 10000, 100000}, {1, 100}})
+    ->Unit(benchmark::kMillisecond);
+
+// Measures the cost of visiting every counter, as a sink flush does, with range(0)
+// counters allocated individually (range(1) == 0) or in slabs (range(1) == 1). Each
+// counter is created alongside some unrelated heap allocations, so that individually
+// allocated counters are scattered the way they are in a long-running server.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_ForEachCounter(benchmark::State& state) {
+  Envoy::Stats::SymbolTableImpl symbol_table;
+  Envoy::Stats::AllocatorImpl alloc(symbol_table, state.range(1) != 0);
+  Envoy::Stats::StatNamePool pool(symbol_table);
+  std::vector<Envoy::Stats::CounterSharedPtr> counters;
+  std::vector<std::string> clutter;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    counters.push_back(alloc.makeCounter(pool.add(absl::StrCat("cluster.", i / 100, ".rq_", i)),
+                                         Envoy::Stats::StatName(), {}));
+    counters.back()->add(i);
+    clutter.push_back(std::string(48 + i % 64, 'x'));
+  }
+
+  for (auto _ : state) { // NOLINT
+    uint64_t sum = 0;
+    alloc.forEachCounter(nullptr,
+                         [&sum](Envoy::Stats::Counter& counter) { sum += counter.value(); });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["slab_bytes"] = alloc.slabBytes();
+}
+BENCHMARK(BM_ForEachCounter)
+    ->ArgsProduct({{1000, 100000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
 // TODO(jmarantz): add multi-threaded variant of this test, that aggressively
 // looks up stats in multiple threads to try to trigger contention issues.
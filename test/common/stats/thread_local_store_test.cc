@@ -1689,6 +1689,37 @@ TEST_F(HistogramTest, MultiHistogramMultipleMerges) {
   EXPECT_EQ(2, validateMerge());
 }
 
+// A histogram that sees no values resets its interval statistics on the first idle merge only,
+// and keeps its cumulative statistics across idle merges.
+TEST_F(HistogramTest, IdleIntervalMerge) {
+  Histogram& h1 = scope_.histogramFromString("h1", Histogram::Unit::Unspecified);
+  expectCallAndAccumulate(h1, 5);
+  expectCallAndAccumulate(h1, 7);
+  EXPECT_EQ(1, validateMerge());
+  const ParentHistogramSharedPtr parent = store_->histograms().front();
+  EXPECT_EQ(2, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(2, parent->cumulativeStatistics().sampleCount());
+  const std::string cumulative_summary = parent->cumulativeStatistics().quantileSummary();
+
+  // The first idle interval clears the interval statistics.
+  EXPECT_EQ(1, validateMerge());
+  EXPECT_EQ(0, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(2, parent->cumulativeStatistics().sampleCount());
+  EXPECT_EQ(cumulative_summary, parent->cumulativeStatistics().quantileSummary());
+
+  // Further idle intervals leave both unchanged.
+  EXPECT_EQ(1, validateMerge());
+  EXPECT_EQ(0, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(2, parent->cumulativeStatistics().sampleCount());
+  EXPECT_EQ(cumulative_summary, parent->cumulativeStatistics().quantileSummary());
+
+  // Values recorded after the idle intervals only show up in the next interval.
+  expectCallAndAccumulate(h1, 9);
+  EXPECT_EQ(1, validateMerge());
+  EXPECT_EQ(1, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(3, parent->cumulativeStatistics().sampleCount());
+}
+
 TEST_F(HistogramTest, BasicScopeHistogramMerge) {
   ScopeSharedPtr scope1 = store_->createScope("scope1.");
 
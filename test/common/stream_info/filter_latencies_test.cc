@@ -0,0 +1,107 @@
+#include "source/common/stream_info/filter_latencies.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace StreamInfo {
+namespace {
+
+using std::chrono::microseconds;
+
+class FilterLatenciesTest : public testing::Test {
+public:
+  FilterLatenciesTest() {
+    latencies_.addFilter(0);
+    latencies_.addFilter(2);
+    latencies_.addDecodeTime(0, microseconds(3));
+    latencies_.addDecodeTime(0, microseconds(4));
+    latencies_.addEncodeTime(0, microseconds(5));
+    latencies_.addDecodeTime(2, microseconds(20));
+    latencies_.addPhaseTime(FilterLatencies::Phase::RouteMatch, microseconds(2));
+  }
+
+  // "buffer" is configured but not part of the stream's filter chain.
+  const std::vector<std::string> filter_names_{"cors", "buffer", "router"};
+  FilterLatencies latencies_{filter_names_};
+};
+
+TEST_F(FilterLatenciesTest, AccumulatesPerFilter) {
+  EXPECT_TRUE(latencies_.filterTimes(0).in_chain_);
+  EXPECT_EQ(microseconds(7), latencies_.filterTimes(0).decode_time_);
+  EXPECT_EQ(microseconds(5), latencies_.filterTimes(0).encode_time_);
+  EXPECT_FALSE(latencies_.filterTimes(1).in_chain_);
+  EXPECT_EQ(microseconds(12), latencies_.filterTime("cors"));
+  EXPECT_EQ(microseconds(20), latencies_.filterTime("router"));
+  EXPECT_FALSE(latencies_.filterTime("buffer").has_value());
+  EXPECT_FALSE(latencies_.filterTime("lua").has_value());
+
+  // Filters without an index are ignored.
+  latencies_.addFilter(FilterLatencies::NoFilter);
+  latencies_.addDecodeTime(FilterLatencies::NoFilter, microseconds(1));
+  latencies_.addEncodeTime(FilterLatencies::NoFilter, microseconds(1));
+  EXPECT_EQ(microseconds(12), latencies_.filterTime("cors"));
+}
+
+TEST_F(FilterLatenciesTest, AccumulatesPerPhase) {
+  EXPECT_EQ(microseconds(2), latencies_.phaseTime(FilterLatencies::Phase::RouteMatch));
+  EXPECT_FALSE(latencies_.phaseTime(FilterLatencies::Phase::PoolWait).has_value());
+  latencies_.addPhaseTime(FilterLatencies::Phase::RouteMatch, microseconds(3));
+  EXPECT_EQ(microseconds(5), latencies_.phaseTime(FilterLatencies::Phase::RouteMatch));
+}
+
+TEST_F(FilterLatenciesTest, NestedTimingIsSubtracted) {
+  const MonotonicTime start;
+  EXPECT_FALSE(latencies_.timing());
+  const auto outer = latencies_.startTiming(start);
+  EXPECT_TRUE(latencies_.timing());
+  const auto inner = latencies_.startTiming(start + microseconds(10));
+  const auto innermost = latencies_.startTiming(start + microseconds(11));
+  EXPECT_EQ(microseconds(4), latencies_.finishTiming(innermost, start + microseconds(15)));
+  EXPECT_EQ(microseconds(10), latencies_.finishTiming(inner, start + microseconds(24)));
+  const auto sibling = latencies_.startTiming(start + microseconds(30));
+  EXPECT_EQ(microseconds(5), latencies_.finishTiming(sibling, start + microseconds(35)));
+  EXPECT_TRUE(latencies_.timing());
+  // 50us less the 14us of the inner timing and the 5us of its sibling.
+  EXPECT_EQ(microseconds(31), latencies_.finishTiming(outer, start + microseconds(50)));
+  EXPECT_FALSE(latencies_.timing());
+
+  // Timings after the outermost one finished are not affected by it.
+  const auto next = latencies_.startTiming(start + microseconds(60));
+  EXPECT_EQ(microseconds(3), latencies_.finishTiming(next, start + microseconds(63)));
+}
+
+TEST_F(FilterLatenciesTest, TestProto) {
+  auto message = latencies_.serializeAsProto();
+  auto* latencies_struct = dynamic_cast<ProtobufWkt::Struct*>(message.get());
+  ASSERT_NE(nullptr, latencies_struct);
+  const auto& filters = latencies_struct->fields().at("filters").struct_value().fields();
+  EXPECT_EQ(2, filters.size());
+  const auto& cors = filters.at("cors").struct_value().fields();
+  EXPECT_EQ(7, cors.at("decode_us").number_value());
+  EXPECT_EQ(5, cors.at("encode_us").number_value());
+  const auto& router = filters.at("router").struct_value().fields();
+  EXPECT_EQ(20, router.at("decode_us").number_value());
+  EXPECT_EQ(0, router.at("encode_us").number_value());
+  const auto& phases = latencies_struct->fields().at("phases").struct_value().fields();
+  EXPECT_EQ(1, phases.size());
+  EXPECT_EQ(2, phases.at("route_match_us").number_value());
+}
+
+TEST_F(FilterLatenciesTest, TestString) {
+  EXPECT_EQ("cors:7:5,router:20:0;route_match:2", latencies_.serializeAsString());
+  latencies_.addPhaseTime(FilterLatencies::Phase::CodecEncode, microseconds(1));
+  EXPECT_EQ("cors:7:5,router:20:0;route_match:2,codec_encode:1",
+            latencies_.serializeAsString());
+}
+
+TEST_F(FilterLatenciesTest, TestField) {
+  EXPECT_TRUE(latencies_.hasFieldSupport());
+  EXPECT_EQ(12, absl::get<int64_t>(latencies_.getField("cors")));
+  EXPECT_EQ(2, absl::get<int64_t>(latencies_.getField("route_match")));
+  EXPECT_TRUE(absl::holds_alternative<absl::monostate>(latencies_.getField("buffer")));
+  EXPECT_TRUE(absl::holds_alternative<absl::monostate>(latencies_.getField("pool_wait")));
+}
+
+} // namespace
+} // namespace StreamInfo
+} // namespace Envoy
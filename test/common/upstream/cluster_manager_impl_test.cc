@@ -4719,6 +4719,114 @@ TEST_P(ClusterManagerLifecycleTest, MergedUpdatesDestroyedOnUpdate) {
                    .value());
 }
 
+// Tests that membership updates of existing clusters are held and coalesced into a single
+// cross-thread update when a thread local update batch window is configured.
+TEST_F(ClusterManagerImplTest, ThreadLocalUpdateBatching) {
+  const std::string yaml = R"EOF(
+  cluster_manager:
+    thread_local_update_batch_window: 1s
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      type: STATIC
+      lb_policy: ROUND_ROBIN
+      common_lb_config:
+        update_merge_window: 0s
+      load_assignment:
+        cluster_name: cluster_1
+        endpoints:
+        - lb_endpoints:
+          - endpoint:
+              address:
+                socket_address:
+                  address: 127.0.0.1
+                  port_value: 11001
+          - endpoint:
+              address:
+                socket_address:
+                  address: 127.0.0.1
+                  port_value: 11002
+  )EOF";
+  create(parseBootstrapFromV3Yaml(yaml));
+
+  Cluster& cluster = cluster_manager_->activeClusters().begin()->second;
+  const HostVector initial_hosts = cluster.prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(2, initial_hosts.size());
+  HostsPerLocalitySharedPtr hosts_per_locality = std::make_shared<HostsPerLocalityImpl>();
+  const auto thread_local_hosts = [this]() {
+    return cluster_manager_->getThreadLocalCluster("cluster_1")
+        ->prioritySet()
+        .hostSetsPerPriority()[0]
+        ->hosts()
+        .size();
+  };
+  EXPECT_EQ(2, thread_local_hosts());
+
+  // Remove the first host. The update is held until the batch is flushed.
+  HostVectorSharedPtr hosts(new HostVector{initial_hosts[1]});
+  cluster.prioritySet().updateHosts(
+      0,
+      updateHostsParams(hosts, hosts_per_locality,
+                        std::make_shared<const HealthyHostVector>(*hosts), hosts_per_locality),
+      {}, {}, {initial_hosts[0]}, 123, absl::nullopt, absl::nullopt);
+  EXPECT_EQ(1, factory_.stats_.counter("cluster_manager.update_batched").value());
+  EXPECT_EQ(0, factory_.stats_.counter("cluster_manager.update_batch_coalesced").value());
+  EXPECT_EQ(0, factory_.stats_.counter("cluster_manager.update_batch_posted").value());
+  EXPECT_EQ(2, thread_local_hosts());
+
+  // A health change for the same cluster is merged into the pending update.
+  initial_hosts[1]->healthFlagSet(Host::HealthFlag::FAILED_EDS_HEALTH);
+  cluster.prioritySet().updateHosts(
+      0, updateHostsParams(hosts, hosts_per_locality, std::make_shared<const HealthyHostVector>(),
+                           hosts_per_locality),
+      {}, {}, {}, 123, absl::nullopt, absl::nullopt);
+  EXPECT_EQ(2, factory_.stats_.counter("cluster_manager.update_batched").value());
+  EXPECT_EQ(1, factory_.stats_.counter("cluster_manager.update_batch_coalesced").value());
+  EXPECT_EQ(0, factory_.stats_.counter("cluster_manager.update_batch_posted").value());
+  EXPECT_EQ(2, thread_local_hosts());
+
+  // Flushing posts a single batch that carries the latest state of the cluster.
+  cluster_manager_->flushThreadLocalClusterUpdates();
+  EXPECT_EQ(1, factory_.stats_.counter("cluster_manager.update_batch_posted").value());
+  EXPECT_EQ(1, thread_local_hosts());
+  EXPECT_EQ(0, cluster_manager_->getThreadLocalCluster("cluster_1")
+                   ->prioritySet()
+                   .hostSetsPerPriority()[0]
+                   ->healthyHosts()
+                   .size());
+
+  // Nothing left to flush.
+  cluster_manager_->flushThreadLocalClusterUpdates();
+  EXPECT_EQ(1, factory_.stats_.counter("cluster_manager.update_batch_posted").value());
+}
+
+// Tests that hosts added and removed within the same batch cancel each other out.
+TEST_F(ClusterManagerImplTest, ThreadLocalUpdateParamsMergeCancelsOut) {
+  using UpdateParams = TestClusterManagerImpl::ThreadLocalClusterUpdateParams;
+  auto info = std::make_shared<NiceMock<MockClusterInfo>>();
+  HostSharedPtr host1 = makeTestHost(info, "tcp://127.0.0.1:80", time_system_);
+  HostSharedPtr host2 = makeTestHost(info, "tcp://127.0.0.1:81", time_system_);
+  HostSharedPtr host3 = makeTestHost(info, "tcp://127.0.0.1:82", time_system_);
+
+  UpdateParams params(0, {host1, host2}, {});
+  params.merge(UpdateParams(0, {host3}, {host1}));
+  params.merge(UpdateParams(1, {host1}, {}));
+
+  ASSERT_EQ(2, params.per_priority_update_params_.size());
+  EXPECT_EQ(0, params.per_priority_update_params_[0].priority_);
+  EXPECT_EQ(HostVector({host2, host3}), params.per_priority_update_params_[0].hosts_added_);
+  EXPECT_TRUE(params.per_priority_update_params_[0].hosts_removed_.empty());
+  EXPECT_EQ(1, params.per_priority_update_params_[1].priority_);
+  EXPECT_EQ(HostVector({host1}), params.per_priority_update_params_[1].hosts_added_);
+
+  // A removal followed by an add of the same host also cancels out.
+  UpdateParams removed_then_added(0, {}, {host2});
+  removed_then_added.merge(UpdateParams(0, {host2}, {}));
+  EXPECT_TRUE(removed_then_added.per_priority_update_params_[0].hosts_added_.empty());
+  EXPECT_TRUE(removed_then_added.per_priority_update_params_[0].hosts_removed_.empty());
+}
+
 TEST_F(ClusterManagerImplTest, UpstreamSocketOptionsPassedToTcpConnPool) {
   createWithBasicStaticCluster();
   NiceMock<MockLoadBalancerContext> context;
@@ -418,6 +418,67 @@ TEST_P(StaticClusterTest, RemoveDeferredCluster) {
   EXPECT_EQ(readGauge("thread_local_cluster_manager.test_thread.clusters_inflated"), 0);
 }
 
+// Test that clusters which went idle are returned to the deferred state and can be initialized
+// again.
+TEST_P(StaticClusterTest, IdleClustersAreEvicted) {
+  const std::string yaml = R"EOF(
+    cluster_manager:
+      deferred_cluster_idle_timeout: 10s
+    static_resources:
+      clusters:
+      - name: cluster_1
+        connect_timeout: 0.250s
+        lb_policy: ROUND_ROBIN
+        load_assignment:
+          cluster_name: cluster_1
+          endpoints:
+          - lb_endpoints:
+            - endpoint:
+                address:
+                  socket_address:
+                    address: 127.0.0.1
+                    port_value: 11001
+            - endpoint:
+                address:
+                  socket_address:
+                    address: 127.0.0.1
+                    port_value: 11002
+    )EOF";
+
+  auto bootstrap = parseBootstrapFromV3YamlEnableDeferredCluster(yaml);
+  auto* eviction_timer = new NiceMock<Event::MockTimer>(&factory_.tls_.dispatcher_);
+  create(bootstrap);
+  EXPECT_TRUE(eviction_timer->enabled());
+
+  EXPECT_NE(cluster_manager_->getThreadLocalCluster("cluster_1"), nullptr);
+  EXPECT_EQ(readGauge("thread_local_cluster_manager.test_thread.clusters_inflated"), 1);
+
+  // The cluster was used since the last sweep.
+  eviction_timer->invokeCallback();
+  EXPECT_EQ(readGauge("thread_local_cluster_manager.test_thread.clusters_inflated"), 1);
+
+  // Using the cluster again keeps it initialized for another sweep.
+  EXPECT_NE(cluster_manager_->getThreadLocalCluster("cluster_1"), nullptr);
+  eviction_timer->invokeCallback();
+  EXPECT_EQ(readGauge("thread_local_cluster_manager.test_thread.clusters_inflated"), 1);
+
+  EXPECT_LOG_CONTAINS("debug", "evicting idle TLS cluster cluster_1",
+                      eviction_timer->invokeCallback());
+  EXPECT_EQ(readGauge("thread_local_cluster_manager.test_thread.clusters_inflated"), 0);
+  EXPECT_EQ(
+      factory_.stats_.counter("thread_local_cluster_manager.test_thread.clusters_evicted").value(),
+      1);
+  EXPECT_TRUE(eviction_timer->enabled());
+
+  ThreadLocalCluster* cluster = nullptr;
+  EXPECT_LOG_CONTAINS("debug", "initializing TLS cluster cluster_1 inline",
+                      cluster = cluster_manager_->getThreadLocalCluster("cluster_1"));
+  ASSERT_NE(cluster, nullptr);
+  EXPECT_EQ(readGauge("thread_local_cluster_manager.test_thread.clusters_inflated"), 1);
+  EXPECT_TRUE(
+      hostsInHostsVector(cluster->prioritySet().hostSetsPerPriority()[0]->hosts(), {11001, 11002}));
+}
+
 class MockConfigSubscriptionFactory : public Config::ConfigSubscriptionFactory {
 public:
   std::string name() const override { return "envoy.config_subscription.rest"; }
@@ -167,6 +167,8 @@ public:
 // clusters, which is necessary in order to call updateHosts on the priority set.
 class TestClusterManagerImpl : public ClusterManagerImpl {
 public:
+  using ClusterManagerImpl::ThreadLocalClusterUpdateParams;
+
   static std::unique_ptr<TestClusterManagerImpl> createAndInit(
       const envoy::config::bootstrap::v3::Bootstrap& bootstrap, ClusterManagerFactory& factory,
       Server::Configuration::CommonFactoryContext& context, Stats::Store& stats,
@@ -209,6 +211,8 @@ public:
     return ClusterManagerImpl::createAndSwapClusterDiscoveryManager(std::move(thread_name));
   }
 
+  void flushThreadLocalClusterUpdates() { ClusterManagerImpl::flushThreadLocalClusterUpdates(); }
+
 protected:
   using ClusterManagerImpl::ClusterManagerImpl;
 
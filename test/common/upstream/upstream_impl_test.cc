@@ -6367,6 +6367,82 @@ TEST(HostPartitionTest, PartitionHosts) {
   EXPECT_EQ(hosts[5], update_hosts_params.excluded_hosts_per_locality->get()[1][2]);
 }
 
+// Verifies that partitionHostsOnHealthChange only rebuilds the views a host enters or leaves and
+// produces the same partitioning as partitionHosts.
+TEST(HostPartitionTest, PartitionHostsOnHealthChange) {
+  std::shared_ptr<MockClusterInfo> info{new NiceMock<MockClusterInfo>()};
+  auto time_source = std::make_unique<NiceMock<MockTimeSystem>>();
+  envoy::config::core::v3::Locality zone_a;
+  zone_a.set_zone("A");
+  envoy::config::core::v3::Locality zone_b;
+  zone_b.set_zone("B");
+  HostVector hosts{makeTestHost(info, "tcp://127.0.0.1:80", *time_source, zone_a),
+                   makeTestHost(info, "tcp://127.0.0.1:81", *time_source, zone_a),
+                   makeTestHost(info, "tcp://127.0.0.1:82", *time_source, zone_b),
+                   makeTestHost(info, "tcp://127.0.0.1:83", *time_source, zone_b)};
+  hosts[3]->healthFlagSet(Host::HealthFlag::DEGRADED_ACTIVE_HC);
+
+  auto hosts_per_locality = makeHostsPerLocality({{hosts[0], hosts[1]}, {hosts[2], hosts[3]}});
+  HostSetImpl host_set(0, absl::nullopt, absl::nullopt);
+  host_set.updateHosts(
+      HostSetImpl::partitionHosts(std::make_shared<const HostVector>(hosts), hosts_per_locality),
+      nullptr, hosts, {}, 0);
+  const auto healthy = host_set.healthyHostsPtr();
+  const auto healthy_per_locality = host_set.healthyHostsPerLocalityPtr();
+  const auto degraded = host_set.degradedHostsPtr();
+  const auto degraded_per_locality = host_set.degradedHostsPerLocalityPtr();
+
+  // A flag change that does not move the host between views shares every view.
+  hosts[0]->healthFlagSet(Host::HealthFlag::FAILED_OUTLIER_CHECK);
+  hosts[0]->healthFlagClear(Host::HealthFlag::FAILED_OUTLIER_CHECK);
+  auto params = HostSetImpl::partitionHostsOnHealthChange(host_set, hosts[0]);
+  EXPECT_EQ(host_set.hostsPtr(), params.hosts);
+  EXPECT_EQ(host_set.hostsPerLocalityPtr(), params.hosts_per_locality);
+  EXPECT_EQ(healthy, params.healthy_hosts);
+  EXPECT_EQ(healthy_per_locality, params.healthy_hosts_per_locality);
+  EXPECT_EQ(degraded, params.degraded_hosts);
+  EXPECT_EQ(host_set.excludedHostsPtr(), params.excluded_hosts);
+
+  // Failing a host only rebuilds the healthy views, changing only the host's locality bucket.
+  hosts[2]->healthFlagSet(Host::HealthFlag::FAILED_ACTIVE_HC);
+  params = HostSetImpl::partitionHostsOnHealthChange(host_set, hosts[2]);
+  EXPECT_NE(healthy, params.healthy_hosts);
+  EXPECT_EQ(HostVector({hosts[0], hosts[1]}), params.healthy_hosts->get());
+  const std::vector<HostVector> expected_healthy_per_locality = {{hosts[0], hosts[1]}, {}};
+  EXPECT_EQ(expected_healthy_per_locality, params.healthy_hosts_per_locality->get());
+  EXPECT_EQ(degraded, params.degraded_hosts);
+  EXPECT_EQ(degraded_per_locality, params.degraded_hosts_per_locality);
+
+  // The result matches a full partitioning of the same hosts.
+  auto full =
+      HostSetImpl::partitionHosts(std::make_shared<const HostVector>(hosts), hosts_per_locality);
+  EXPECT_EQ(full.healthy_hosts->get(), params.healthy_hosts->get());
+  EXPECT_EQ(full.healthy_hosts_per_locality->get(), params.healthy_hosts_per_locality->get());
+  EXPECT_EQ(full.degraded_hosts->get(), params.degraded_hosts->get());
+  EXPECT_EQ(full.excluded_hosts->get(), params.excluded_hosts->get());
+
+  host_set.updateHosts(std::move(params), nullptr, {}, {}, 0);
+
+  // A host that recovers is moved back to its position in the host set.
+  hosts[0]->healthFlagSet(Host::HealthFlag::FAILED_ACTIVE_HC);
+  host_set.updateHosts(HostSetImpl::partitionHostsOnHealthChange(host_set, hosts[0]), nullptr, {},
+                       {}, 0);
+  EXPECT_EQ(HostVector({hosts[1]}), host_set.healthyHosts());
+  hosts[0]->healthFlagClear(Host::HealthFlag::FAILED_ACTIVE_HC);
+  params = HostSetImpl::partitionHostsOnHealthChange(host_set, hosts[0]);
+  EXPECT_EQ(full.healthy_hosts->get(), params.healthy_hosts->get());
+  EXPECT_EQ(full.healthy_hosts_per_locality->get(), params.healthy_hosts_per_locality->get());
+  EXPECT_EQ(host_set.degradedHostsPtr(), params.degraded_hosts);
+  host_set.updateHosts(std::move(params), nullptr, {}, {}, 0);
+
+  // A host that is no longer part of the host set is not added to any view.
+  HostSharedPtr removed_host = makeTestHost(info, "tcp://127.0.0.1:84", *time_source, zone_a);
+  params = HostSetImpl::partitionHostsOnHealthChange(host_set, removed_host);
+  EXPECT_EQ(full.healthy_hosts->get(), params.healthy_hosts->get());
+  EXPECT_EQ(full.healthy_hosts_per_locality->get(), params.healthy_hosts_per_locality->get());
+  EXPECT_EQ(host_set.degradedHostsPtr(), params.degraded_hosts);
+}
+
 TEST_F(ClusterInfoImplTest, MaxRequestsPerConnectionValidation) {
   const std::string yaml = R"EOF(
   name: cluster1
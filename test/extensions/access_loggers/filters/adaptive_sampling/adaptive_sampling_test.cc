@@ -0,0 +1,271 @@
+#include "envoy/config/accesslog/v3/accesslog.pb.h"
+#include "envoy/extensions/access_loggers/filters/adaptive_sampling/v3/adaptive_sampling.pb.h"
+#include "envoy/registry/registry.h"
+
+#include "source/extensions/access_loggers/filters/adaptive_sampling/adaptive_sampling.h"
+#include "source/extensions/access_loggers/filters/adaptive_sampling/config.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/router/mocks.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Filters {
+namespace AdaptiveSampling {
+namespace {
+
+TEST(LatencyHistogramTest, BucketIndex) {
+  EXPECT_EQ(9, LatencyHistogram::bucketIndex(10));
+  EXPECT_EQ(LatencyHistogram::NumBuckets - 1,
+            LatencyHistogram::bucketIndex(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(LatencyHistogramTest, QuantileAndDecay) {
+  LatencyHistogram histogram;
+  for (uint32_t i = 0; i < 90; i++) {
+    histogram.record(10);
+  }
+  for (uint32_t i = 0; i < 10; i++) {
+    histogram.record(20);
+  }
+  EXPECT_EQ(100, histogram.count());
+  EXPECT_EQ(10, histogram.quantileBucket(0.5));
+  EXPECT_EQ(10, histogram.quantileBucket(0.9));
+  EXPECT_EQ(20, histogram.quantileBucket(0.91));
+  EXPECT_EQ(20, histogram.quantileBucket(1.0));
+
+  histogram.decay();
+  EXPECT_EQ(50, histogram.count());
+  EXPECT_EQ(20, histogram.quantileBucket(0.99));
+}
+
+class AdaptiveSamplingFilterTest : public testing::Test {
+public:
+  void initialize(const std::string& yaml, uint32_t concurrency = 1) {
+    envoy::extensions::access_loggers::filters::adaptive_sampling::v3::AdaptiveSamplingFilter
+        config;
+    TestUtility::loadFromYaml(yaml, config);
+    filter_ = std::make_unique<AdaptiveSamplingFilter>(config, concurrency, tls_, time_system_,
+                                                       random_);
+    stream_info_.response_code_ = 200;
+  }
+
+  bool evaluate() { return filter_->evaluate({}, stream_info_); }
+
+  // Evaluates the filter the given number of times and returns how often it logged.
+  uint32_t evaluateTimes(uint32_t times) {
+    uint32_t logged = 0;
+    for (uint32_t i = 0; i < times; i++) {
+      logged += evaluate();
+    }
+    return logged;
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<Random::MockRandomGenerator> random_{0};
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  std::unique_ptr<AdaptiveSamplingFilter> filter_;
+};
+
+TEST_F(AdaptiveSamplingFilterTest, FailedRequestsAreAlwaysLogged) {
+  initialize("healthy_logs_per_second: 1");
+
+  stream_info_.response_code_ = 503;
+  EXPECT_EQ(10, evaluateTimes(10));
+
+  stream_info_.response_code_ = 200;
+  stream_info_.setResponseFlag(StreamInfo::CoreResponseFlag::UpstreamRequestTimeout);
+  EXPECT_EQ(10, evaluateTimes(10));
+}
+
+TEST_F(AdaptiveSamplingFilterTest, HealthyRequestsAreLimitedPerGroup) {
+  initialize("healthy_logs_per_second: 2");
+
+  EXPECT_EQ(2, evaluateTimes(10));
+
+  // Every response code class is sampled on its own.
+  stream_info_.response_code_ = 404;
+  EXPECT_EQ(2, evaluateTimes(10));
+
+  // So is every upstream cluster.
+  stream_info_.response_code_ = 200;
+  auto cluster_info = std::make_shared<NiceMock<Upstream::MockClusterInfo>>();
+  stream_info_.upstream_cluster_info_ = cluster_info;
+  EXPECT_EQ(2, evaluateTimes(10));
+
+  // And the budget is renewed every second.
+  stream_info_.upstream_cluster_info_ = absl::nullopt;
+  EXPECT_EQ(0, evaluateTimes(10));
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_EQ(2, evaluateTimes(10));
+}
+
+TEST_F(AdaptiveSamplingFilterTest, HealthyRequestsAreSampledOverTheWindow) {
+  initialize("healthy_logs_per_second: 1");
+
+  EXPECT_EQ(1, evaluateTimes(4));
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+
+  // The previous window had 4 requests, so requests are logged with a probability of 25%.
+  EXPECT_CALL(random_, random()).WillOnce(Return(500000)).WillOnce(Return(250000));
+  EXPECT_FALSE(evaluate());
+  EXPECT_FALSE(evaluate());
+  EXPECT_CALL(random_, random()).WillOnce(Return(100000));
+  EXPECT_TRUE(evaluate());
+  // The budget of the window is used up.
+  EXPECT_FALSE(evaluate());
+}
+
+TEST_F(AdaptiveSamplingFilterTest, BudgetIsSplitBetweenThreads) {
+  initialize("healthy_logs_per_second: 2", 4);
+
+  // Every thread may log one request every two seconds.
+  EXPECT_EQ(1, evaluateTimes(10));
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_EQ(0, evaluateTimes(10));
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_EQ(1, evaluateTimes(10));
+}
+
+TEST_F(AdaptiveSamplingFilterTest, SlowRequestsAreAlwaysLogged) {
+  initialize(R"EOF(
+    healthy_logs_per_second: 1
+    slow_request_percentile:
+      value: 90
+    min_latency_samples: 20
+  )EOF");
+
+  auto route = std::make_shared<NiceMock<Router::MockRoute>>();
+  ON_CALL(stream_info_, route()).WillByDefault(Return(route));
+
+  // Too few durations were recorded to tell slow requests apart.
+  stream_info_.end_time_ = std::chrono::milliseconds(10);
+  EXPECT_EQ(1, evaluateTimes(19));
+  stream_info_.end_time_ = std::chrono::milliseconds(100);
+  EXPECT_FALSE(evaluate());
+
+  stream_info_.end_time_ = std::chrono::milliseconds(10);
+  EXPECT_EQ(0, evaluateTimes(100));
+  stream_info_.end_time_ = std::chrono::milliseconds(100);
+  EXPECT_TRUE(evaluate());
+  // A duration within the bucket of the percentile isn't slow.
+  stream_info_.end_time_ = std::chrono::microseconds(10100);
+  EXPECT_FALSE(evaluate());
+
+  // Durations are kept per route, so only the first request of the other route is logged, by the
+  // sampling of healthy requests.
+  auto other_route = std::make_shared<NiceMock<Router::MockRoute>>();
+  ON_CALL(stream_info_, route()).WillByDefault(Return(other_route));
+  stream_info_.end_time_ = std::chrono::milliseconds(100);
+  EXPECT_EQ(1, evaluateTimes(2));
+
+  // Once the durations of the route decayed, requests aren't slow until enough new durations
+  // are recorded.
+  ON_CALL(stream_info_, route()).WillByDefault(Return(route));
+  time_system_.advanceTimeWait(std::chrono::seconds(60));
+  EXPECT_EQ(1, evaluateTimes(2));
+}
+
+// Route names are optional, so routes are told apart by identity.
+TEST_F(AdaptiveSamplingFilterTest, UnnamedRoutesAreKeptApart) {
+  initialize(R"EOF(
+    healthy_logs_per_second: 1
+    slow_request_percentile:
+      value: 90
+    min_latency_samples: 20
+  )EOF");
+
+  auto fast_route = std::make_shared<NiceMock<Router::MockRoute>>();
+  fast_route->route_name_ = "";
+  auto slow_route = std::make_shared<NiceMock<Router::MockRoute>>();
+  slow_route->route_name_ = "";
+
+  ON_CALL(stream_info_, route()).WillByDefault(Return(slow_route));
+  stream_info_.end_time_ = std::chrono::milliseconds(100);
+  EXPECT_EQ(1, evaluateTimes(100));
+  ON_CALL(stream_info_, route()).WillByDefault(Return(fast_route));
+  stream_info_.end_time_ = std::chrono::milliseconds(10);
+  // The healthy requests of each route have their own budget.
+  EXPECT_EQ(1, evaluateTimes(100));
+
+  // Requests which are usual on the slow route are slow on the fast one.
+  stream_info_.end_time_ = std::chrono::milliseconds(100);
+  EXPECT_TRUE(evaluate());
+  ON_CALL(stream_info_, route()).WillByDefault(Return(slow_route));
+  EXPECT_FALSE(evaluate());
+}
+
+// Requests without a route, such as those of the TCP proxy, are kept apart by upstream cluster.
+TEST_F(AdaptiveSamplingFilterTest, RequestsWithoutRouteAreKeptApartByCluster) {
+  initialize(R"EOF(
+    healthy_logs_per_second: 1
+    slow_request_percentile:
+      value: 90
+    min_latency_samples: 20
+  )EOF");
+
+  ON_CALL(stream_info_, route()).WillByDefault(Return(nullptr));
+  auto slow_cluster = std::make_shared<NiceMock<Upstream::MockClusterInfo>>();
+  slow_cluster->name_ = "slow_cluster";
+  stream_info_.upstream_cluster_info_ = slow_cluster;
+  stream_info_.end_time_ = std::chrono::milliseconds(100);
+  EXPECT_EQ(1, evaluateTimes(100));
+
+  auto fast_cluster = std::make_shared<NiceMock<Upstream::MockClusterInfo>>();
+  fast_cluster->name_ = "fast_cluster";
+  stream_info_.upstream_cluster_info_ = fast_cluster;
+  stream_info_.end_time_ = std::chrono::milliseconds(10);
+  EXPECT_EQ(1, evaluateTimes(100));
+  stream_info_.end_time_ = std::chrono::milliseconds(100);
+  EXPECT_TRUE(evaluate());
+
+  stream_info_.upstream_cluster_info_ = slow_cluster;
+  EXPECT_FALSE(evaluate());
+}
+
+TEST(AdaptiveSamplingFilterFactoryTest, CreateFilter) {
+  auto* factory = Registry::FactoryRegistry<AccessLog::ExtensionFilterFactory>::getFactory(
+      "envoy.access_loggers.extension_filters.adaptive_sampling");
+  ASSERT_NE(nullptr, factory);
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  envoy::config::accesslog::v3::ExtensionFilter config;
+  TestUtility::loadFromYaml(R"EOF(
+    name: envoy.access_loggers.extension_filters.adaptive_sampling
+    typed_config:
+      "@type": type.googleapis.com/envoy.extensions.access_loggers.filters.adaptive_sampling.v3.AdaptiveSamplingFilter
+      healthy_logs_per_second: 10
+  )EOF",
+                            config);
+  EXPECT_NE(nullptr, factory->createFilter(config, context));
+
+  TestUtility::loadFromYaml(R"EOF(
+    name: envoy.access_loggers.extension_filters.adaptive_sampling
+    typed_config:
+      "@type": type.googleapis.com/envoy.extensions.access_loggers.filters.adaptive_sampling.v3.AdaptiveSamplingFilter
+      healthy_logs_per_second: 0
+  )EOF",
+                            config);
+  EXPECT_THROW(factory->createFilter(config, context), ProtoValidationException);
+}
+
+} // namespace
+} // namespace AdaptiveSampling
+} // namespace Filters
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
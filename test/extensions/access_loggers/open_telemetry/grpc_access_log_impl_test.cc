@@ -199,6 +199,74 @@ TEST_F(GrpcAccessLoggerImplTest, LogWithStats) {
             1);
 }
 
+// Entries built on the arena of the logger are batched with entries built on the heap, and the
+// arena is reset once the batch was flushed.
+TEST_F(GrpcAccessLoggerImplTest, LogEntriesOnArena) {
+  config_.mutable_common_config()->mutable_buffer_size_bytes()->set_value(1024 * 1024);
+  setUpLogger();
+
+  for (absl::string_view severity_text : {"first", "second"}) {
+    Protobuf::Arena* arena = logger_->entryArena();
+    ASSERT_NE(nullptr, arena);
+    auto* entry = Protobuf::Arena::Create<opentelemetry::proto::logs::v1::LogRecord>(arena);
+    entry->set_severity_text(severity_text);
+    logger_->log(std::move(*entry));
+  }
+  opentelemetry::proto::logs::v1::LogRecord entry;
+  entry.set_severity_text("third");
+  logger_->log(std::move(entry));
+
+  grpc_access_logger_impl_test_helper_.expectSentMessage(R"EOF(
+  resource_logs:
+    resource:
+      attributes:
+        - key: "log_name"
+          value:
+            string_value: "test_log_name"
+        - key: "zone_name"
+          value:
+            string_value: "zone_name"
+        - key: "cluster_name"
+          value:
+            string_value: "cluster_name"
+        - key: "node_name"
+          value:
+            string_value: "node_name"
+    scope_logs:
+      - log_records:
+          - severity_text: "first"
+          - severity_text: "second"
+          - severity_text: "third"
+  )EOF");
+  EXPECT_CALL(*timer_, enableTimer(_, _));
+  timer_->invokeCallback();
+  EXPECT_EQ(stats_store_.findCounterByString("access_logs.open_telemetry_access_log.logs_written")
+                .value()
+                .get()
+                .value(),
+            3);
+
+  EXPECT_EQ(0, logger_->entryArena()->SpaceUsed());
+}
+
+// A logger destroyed with records still batched releases them to its arena rather than leaving
+// them to the batch, which would delete them after the arena freed them.
+TEST_F(GrpcAccessLoggerImplTest, DestroyWithUnflushedEntries) {
+  config_.mutable_common_config()->mutable_buffer_size_bytes()->set_value(1024 * 1024);
+  setUpLogger();
+
+  Protobuf::Arena* arena = logger_->entryArena();
+  auto* arena_entry = Protobuf::Arena::Create<opentelemetry::proto::logs::v1::LogRecord>(arena);
+  arena_entry->set_severity_text("on the arena");
+  logger_->log(std::move(*arena_entry));
+  opentelemetry::proto::logs::v1::LogRecord heap_entry;
+  heap_entry.set_severity_text("on the heap");
+  logger_->log(std::move(heap_entry));
+
+  EXPECT_CALL(*async_client_, sendRaw(_, _, _, _, _, _)).Times(0);
+  logger_.reset();
+}
+
 TEST_F(GrpcAccessLoggerImplTest, StatsWithCustomPrefix) {
   *config_.mutable_stat_prefix() = "custom.";
   setUpLogger();
@@ -366,6 +434,60 @@ values:
             1);
 }
 
+// Configured resource attributes replace the built-in labels and earlier attributes with the same
+// key.
+TEST_F(GrpcAccessLoggerCacheImplTest, LoggerCreationDuplicateResourceAttributes) {
+  envoy::extensions::access_loggers::open_telemetry::v3::OpenTelemetryAccessLogConfig config;
+  config.mutable_common_config()->set_log_name("test_log");
+  config.mutable_common_config()->set_transport_api_version(
+      envoy::config::core::v3::ApiVersion::V3);
+  // Force a flush for every log entry.
+  config.mutable_common_config()->mutable_buffer_size_bytes()->set_value(BUFFER_SIZE_BYTES);
+
+  const auto kv_yaml = R"EOF(
+values:
+- key: host_name
+  value:
+    string_value: first_host_name
+- key: node_name
+  value:
+    string_value: configured_node_name
+- key: host_name
+  value:
+    string_value: second_host_name
+  )EOF";
+  TestUtility::loadFromYaml(kv_yaml, *config.mutable_resource_attributes());
+
+  GrpcAccessLoggerSharedPtr logger =
+      logger_cache_.getOrCreateLogger(config, Common::GrpcAccessLoggerType::HTTP);
+  grpc_access_logger_impl_test_helper_.expectSentMessage(R"EOF(
+  resource_logs:
+    resource:
+      attributes:
+        - key: "log_name"
+          value:
+            string_value: "test_log"
+        - key: "zone_name"
+          value:
+            string_value: "zone_name"
+        - key: "cluster_name"
+          value:
+            string_value: "cluster_name"
+        - key: "node_name"
+          value:
+            string_value: "configured_node_name"
+        - key: "host_name"
+          value:
+            string_value: "second_host_name"
+    scope_logs:
+      - log_records:
+          - severity_text: "test-severity-text"
+  )EOF");
+  opentelemetry::proto::logs::v1::LogRecord entry;
+  entry.set_severity_text("test-severity-text");
+  logger->log(std::move(entry));
+}
+
 class GrpcAccessLoggerDisableBuiltinImplTest : public testing::Test {
 public:
   GrpcAccessLoggerDisableBuiltinImplTest()
@@ -7,6 +7,7 @@
 
 #include "benchmark/benchmark.h"
 #include "opentelemetry/proto/common/v1/common.pb.h"
+#include "opentelemetry/proto/logs/v1/logs.pb.h"
 
 using testing::NiceMock;
 
@@ -81,6 +82,28 @@ static void BM_OpenTelemetryAccessLogFormatter(benchmark::State& state) {
 }
 BENCHMARK(BM_OpenTelemetryAccessLogFormatter);
 
+// Formats into the attributes of log records allocated on an arena which is reset every 100
+// records, the way the gRPC logger batches them.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_OpenTelemetryAccessLogFormatterOnArena(benchmark::State& state) {
+  std::unique_ptr<Envoy::TestStreamInfo> stream_info = makeStreamInfo();
+  std::unique_ptr<OpenTelemetryFormatter> otel_formatter = makeOpenTelemetryFormatter();
+
+  Protobuf::Arena arena;
+  size_t output_bytes = 0;
+  size_t records = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    auto* record = Protobuf::Arena::Create<opentelemetry::proto::logs::v1::LogRecord>(&arena);
+    otel_formatter->format({}, *stream_info, *record->mutable_attributes());
+    output_bytes += record->ByteSizeLong();
+    if (++records % 100 == 0) {
+      arena.Reset();
+    }
+  }
+  benchmark::DoNotOptimize(output_bytes);
+}
+BENCHMARK(BM_OpenTelemetryAccessLogFormatterOnArena);
+
 } // namespace OpenTelemetry
 } // namespace AccessLoggers
 } // namespace Extensions
@@ -708,6 +708,60 @@ TEST_F(HttpConnectionManagerConfigTest, UnixSocketInternalAddress) {
   EXPECT_FALSE(config.internalAddressConfig().isInternalAddress(externalIpAddress));
 }
 
+TEST_F(HttpConnectionManagerConfigTest, RecordFilterLatency) {
+  const std::string yaml_string = R"EOF(
+  stat_prefix: ingress_http
+  record_filter_latency: true
+  route_config:
+    name: local_route
+  http_filters:
+  - name: envoy.filters.http.router
+    typed_config:
+      "@type": type.googleapis.com/envoy.extensions.filters.http.router.v3.Router
+  )EOF";
+
+  HttpConnectionManagerConfig config(parseHttpConnectionManagerFromYaml(yaml_string), context_,
+                                     date_provider_, route_config_provider_manager_,
+                                     &scoped_routes_config_provider_manager_, tracer_manager_,
+                                     filter_config_provider_manager_, creation_status_);
+  ASSERT_TRUE(creation_status_.ok());
+  ASSERT_TRUE(config.filterLatencyStats().has_value());
+  EXPECT_TRUE(context_.store_
+                  .findHistogramByString(
+                      "http.ingress_http.filter_latency.envoy.filters.http.router.decode_us")
+                  .has_value());
+  EXPECT_TRUE(context_.store_
+                  .findHistogramByString(
+                      "http.ingress_http.filter_latency.envoy.filters.http.router.encode_us")
+                  .has_value());  EXPECT_TRUE(
+      context_.store_.findHistogramByString("http.ingress_http.phase_latency.route_match_us")
+          .has_value());
+}
+
+TEST_F(HttpConnectionManagerConfigTest, RecordFilterLatencyDisabled) {
+  const std::string yaml_string = R"EOF(
+  stat_prefix: ingress_http
+  record_filter_latency: false
+  route_config:
+    name: local_route
+  http_filters:
+  - name: envoy.filters.http.router
+    typed_config:
+      "@type": type.googleapis.com/envoy.extensions.filters.http.router.v3.Router
+  )EOF";
+
+  HttpConnectionManagerConfig config(parseHttpConnectionManagerFromYaml(yaml_string), context_,
+                                     date_provider_, route_config_provider_manager_,
+                                     &scoped_routes_config_provider_manager_, tracer_manager_,
+                                     filter_config_provider_manager_, creation_status_);
+  ASSERT_TRUE(creation_status_.ok());
+  EXPECT_FALSE(config.filterLatencyStats().has_value());
+  EXPECT_FALSE(context_.store_
+                   .findHistogramByString(
+                       "http.ingress_http.filter_latency.envoy.filters.http.router.decode_us")
+                   .has_value());
+}
+
 TEST_F(HttpConnectionManagerConfigTest, DefaultInternalAddress) {
   const std::string yaml_string = R"EOF(
   stat_prefix: ingress_http
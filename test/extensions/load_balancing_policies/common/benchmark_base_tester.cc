@@ -36,5 +36,30 @@ BaseTester::BaseTester(uint64_t num_hosts, uint32_t weighted_subset_percent, uin
       random_.random(), absl::nullopt);
 }
 
+BaseTester::HostUpdate BaseTester::prepareHostReplacement(uint64_t num_hosts) {
+  Upstream::HostVector hosts = priority_set_.hostSetsPerPriority()[0]->hosts();
+  ASSERT(num_hosts <= hosts.size());
+  Upstream::HostVector hosts_added;
+  Upstream::HostVector hosts_removed(hosts.begin(), hosts.begin() + num_hosts);
+  for (uint64_t i = 0; i < num_hosts; i++) {
+    const uint64_t n = replacement_hosts_++;
+    const std::string url =
+        fmt::format("tcp://10.{}.{}.{}:6379", 1 + (n / 65536) % 255, (n / 256) % 256, n % 256);
+    hosts[i] = Upstream::makeTestHost(info_, url, simTime());
+    hosts_added.push_back(hosts[i]);
+  }
+
+  Upstream::HostVectorConstSharedPtr updated_hosts = std::make_shared<Upstream::HostVector>(hosts);
+  Upstream::HostsPerLocalityConstSharedPtr hosts_per_locality =
+      Upstream::makeHostsPerLocality({hosts});
+  return {Upstream::HostSetImpl::partitionHosts(updated_hosts, hosts_per_locality),
+          std::move(hosts_added), std::move(hosts_removed)};
+}
+
+void BaseTester::applyHostUpdate(HostUpdate&& update) {
+  priority_set_.updateHosts(0, std::move(update.params_), {}, update.hosts_added_,
+                            update.hosts_removed_, random_.random(), absl::nullopt);
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -25,6 +25,18 @@ public:
   BaseTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0,
              bool attach_metadata = false);
 
+  struct HostUpdate {
+    Upstream::PrioritySet::UpdateHostsParams params_;
+    Upstream::HostVector hosts_added_;
+    Upstream::HostVector hosts_removed_;
+  };
+
+  // Prepare the replacement of the first num_hosts hosts of priority 0 with new hosts, as on an
+  // autoscaling event. Preparing is kept apart from applyHostUpdate() so that benchmarks can time
+  // only the update itself.
+  HostUpdate prepareHostReplacement(uint64_t num_hosts);
+  void applyHostUpdate(HostUpdate&& update);
+
   Envoy::Thread::MutexBasicLockable lock_;
   // Reduce default log level to warn while running this benchmark to avoid problems due to
   // excessive debug logging in upstream_impl.cc
@@ -46,6 +58,7 @@ public:
   envoy::config::cluster::v3::Cluster::CommonLbConfig common_config_;
   envoy::config::cluster::v3::Cluster::RoundRobinLbConfig round_robin_lb_config_;
   std::shared_ptr<Upstream::MockClusterInfo> info_{new NiceMock<Upstream::MockClusterInfo>()};
+  uint64_t replacement_hosts_{};
 };
 
 class TestLoadBalancerContext : public Upstream::LoadBalancerContextBase {
@@ -2,6 +2,7 @@
 
 #include "test/benchmark/main.h"
 #include "test/extensions/load_balancing_policies/common/benchmark_base_tester.h"
+#include "test/test_common/test_runtime.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -184,6 +185,34 @@ BENCHMARK(benchmarkMaglevLoadBalancerWeighted)
     ->Args({500, 95, 75, 25, 10000})
     ->Unit(::benchmark::kMillisecond);
 
+void benchmarkMaglevLoadBalancerHostChurn(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t hosts_to_replace = state.range(1);
+  const bool incremental = state.range(2) != 0;
+
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.incremental_hash_lb_rebuild", incremental ? "true" : "false"}});
+  MaglevTester tester(num_hosts);
+  ASSERT_TRUE(tester.maglev_lb_->initialize().ok());
+
+  // Only the host set update, and the table rebuild it triggers, is timed. Replacing no hosts models
+  // an update which doesn't change the hash keys or weights, e.g. a metadata only EDS update.
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    auto update = tester.prepareHostReplacement(hosts_to_replace);
+    state.ResumeTiming();
+    tester.applyHostUpdate(std::move(update));
+  }
+}
+BENCHMARK(benchmarkMaglevLoadBalancerHostChurn)
+    ->Args({500, 0, 0})
+    ->Args({500, 0, 1})
+    ->Args({500, 1, 0})
+    ->Args({500, 1, 1})
+    ->Args({500, 10, 1})
+    ->Unit(::benchmark::kMillisecond);
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -566,6 +566,41 @@ TEST_F(MaglevLoadBalancerTest, LocalityWeightedLopsided) {
   EXPECT_EQ(MaglevTable::DefaultTableSize - 1023, counts[0]);
 }
 
+// A refresh that leaves the hash keys and weights unchanged reuses the table, while a hash key
+// change on an existing host rebuilds it.
+TEST_F(MaglevLoadBalancerTest, ReuseUnchangedTable) {
+  host_set_.hosts_ = {makeTestHostWithHashKey(info_, "90", "tcp://127.0.0.1:90", simTime()),
+                      makeTestHostWithHashKey(info_, "91", "tcp://127.0.0.1:91", simTime()),
+                      makeTestHostWithHashKey(info_, "92", "tcp://127.0.0.1:92", simTime())};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(7);
+  EXPECT_EQ(3, lb_->stats().max_entries_per_host_.value());
+
+  // The gauges are only set when a table is built.
+  lb_->stats().max_entries_per_host_.set(0);
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(0, lb_->stats().max_entries_per_host_.value());
+
+  envoy::config::core::v3::Metadata metadata;
+  Config::Metadata::mutableMetadataValue(metadata, Config::MetadataFilters::get().ENVOY_LB,
+                                         Config::MetadataEnvoyLbKeys::get().HASH_KEY)
+      .set_string_value("93");
+  host_set_.hosts_[0]->metadata(
+      std::make_shared<const envoy::config::core::v3::Metadata>(metadata));
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(3, lb_->stats().max_entries_per_host_.value());
+
+  {
+    TestScopedRuntime scoped_runtime;
+    scoped_runtime.mergeValues(
+        {{"envoy.reloadable_features.incremental_hash_lb_rebuild", "false"}});
+    lb_->stats().max_entries_per_host_.set(0);
+    host_set_.runCallbacks({}, {});
+    EXPECT_EQ(3, lb_->stats().max_entries_per_host_.value());
+  }
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -0,0 +1,56 @@
+#include "envoy/config/core/v3/extension.pb.h"
+
+#include "source/extensions/load_balancing_policies/peak_ewma/config.h"
+
+#include "test/mocks/server/factory_context.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/mocks/upstream/priority_set.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolices {
+namespace PeakEwma {
+namespace {
+
+TEST(PeakEwmaConfigTest, Validate) {
+  NiceMock<Server::Configuration::MockServerFactoryContext> context;
+  NiceMock<Upstream::MockClusterInfo> cluster_info;
+  NiceMock<Upstream::MockPrioritySet> main_thread_priority_set;
+  NiceMock<Upstream::MockPrioritySet> thread_local_priority_set;
+
+  envoy::config::core::v3::TypedExtensionConfig config;
+  config.set_name("envoy.load_balancing_policies.peak_ewma");
+  PeakEwmaLbProto config_msg;
+  config.mutable_typed_config()->PackFrom(config_msg);
+
+  auto& factory = Config::Utility::getAndCheckFactory<Upstream::TypedLoadBalancerFactory>(config);
+  EXPECT_EQ("envoy.load_balancing_policies.peak_ewma", factory.name());
+
+  auto lb_config = factory.loadConfig(context, *factory.createEmptyConfigProto()).value();
+  const auto& typed_lb_config = dynamic_cast<const Upstream::PeakEwmaLbConfig&>(*lb_config);
+  EXPECT_EQ(std::chrono::seconds(10), typed_lb_config.decay_time_);
+  EXPECT_EQ(std::chrono::milliseconds(10), typed_lb_config.default_rtt_);
+  EXPECT_EQ(2, typed_lb_config.choice_count_);
+
+  auto thread_aware_lb =
+      factory.create(*lb_config, cluster_info, main_thread_priority_set, context.runtime_loader_,
+                     context.api_.random_, context.time_system_);
+  EXPECT_NE(nullptr, thread_aware_lb);
+
+  ASSERT_TRUE(thread_aware_lb->initialize().ok());
+
+  auto thread_local_lb_factory = thread_aware_lb->factory();
+  EXPECT_NE(nullptr, thread_local_lb_factory);
+  EXPECT_FALSE(thread_local_lb_factory->recreateOnHostChange());
+
+  auto thread_local_lb = thread_local_lb_factory->create({thread_local_priority_set, nullptr});
+  EXPECT_NE(nullptr, thread_local_lb);
+}
+
+} // namespace
+} // namespace PeakEwma
+} // namespace LoadBalancingPolices
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,184 @@
+#include <cmath>
+
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+#include "test/extensions/load_balancing_policies/common/load_balancer_impl_base_test.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+using testing::Return;
+
+class PeakEwmaHostLbPolicyDataTest : public Event::TestUsingSimulatedTime, public testing::Test {
+public:
+  PeakEwmaHostLbPolicyData data_{std::chrono::seconds(10), std::chrono::milliseconds(10),
+                                 simTime()};
+};
+
+TEST_F(PeakEwmaHostLbPolicyDataTest, StartsWithDefaultRtt) {
+  EXPECT_DOUBLE_EQ(10e6, data_.latency(simTime().monotonicTime()));
+}
+
+TEST_F(PeakEwmaHostLbPolicyDataTest, SlowResponseReplacesAverage) {
+  data_.onUpstreamResponseTime(std::chrono::milliseconds(100));
+  EXPECT_DOUBLE_EQ(100e6, data_.latency(simTime().monotonicTime()));
+}
+
+TEST_F(PeakEwmaHostLbPolicyDataTest, FastResponseDecaysAverage) {
+  data_.onUpstreamResponseTime(std::chrono::milliseconds(100));
+
+  // A faster response observed immediately does not move the peak.
+  data_.onUpstreamResponseTime(std::chrono::milliseconds(1));
+  EXPECT_DOUBLE_EQ(100e6, data_.latency(simTime().monotonicTime()));
+
+  // After one decay time the average moves 1 - 1/e of the way towards the faster response.
+  simTime().advanceTimeWait(std::chrono::seconds(10));
+  data_.onUpstreamResponseTime(std::chrono::milliseconds(1));
+  EXPECT_NEAR(1e6 + 99e6 * std::exp(-1.0), data_.latency(simTime().monotonicTime()), 1.0);
+}
+
+TEST_F(PeakEwmaHostLbPolicyDataTest, IdleHostRecovers) {
+  data_.onUpstreamResponseTime(std::chrono::milliseconds(100));
+  simTime().advanceTimeWait(std::chrono::seconds(10));
+  EXPECT_NEAR(100e6 * std::exp(-1.0), data_.latency(simTime().monotonicTime()), 1.0);
+}
+
+TEST_F(PeakEwmaHostLbPolicyDataTest, FastFailureIsPenalized) {
+  // A failure faster than the average counts as a response slower than the average.
+  data_.onUpstreamFailure(std::chrono::milliseconds(1));
+  EXPECT_DOUBLE_EQ(10e6 * PeakEwmaHostLbPolicyData::FailurePenaltyFactor,
+                   data_.latency(simTime().monotonicTime()));
+
+  // Repeated failures grow the penalty up to the decay time.
+  for (int i = 0; i < 10; ++i) {
+    data_.onUpstreamFailure(std::chrono::milliseconds(1));
+  }
+  EXPECT_DOUBLE_EQ(10e9, data_.latency(simTime().monotonicTime()));
+}
+
+TEST_F(PeakEwmaHostLbPolicyDataTest, SlowFailureCountsElapsedTime) {
+  data_.onUpstreamFailure(std::chrono::seconds(15));
+  EXPECT_DOUBLE_EQ(15e9, data_.latency(simTime().monotonicTime()));
+}
+
+class PeakEwmaLoadBalancerTest : public LoadBalancerTestBase {
+public:
+  void init() {
+    lb_config_ = std::make_unique<PeakEwmaLbConfig>(lb_proto_);
+    thread_aware_lb_ = std::make_unique<PeakEwmaThreadAwareLoadBalancer>(
+        *lb_config_, *info_, priority_set_, runtime_, random_, simTime());
+    ASSERT_TRUE(thread_aware_lb_->initialize().ok());
+    lb_ = thread_aware_lb_->factory()->create({priority_set_, nullptr});
+  }
+
+  void addHosts() {
+    hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime()),
+                                makeTestHost(info_, "tcp://127.0.0.1:81", simTime())};
+    hostSet().hosts_ = hostSet().healthy_hosts_;
+    hostSet().runCallbacks(hostSet().hosts_, {});
+  }
+
+  PeakEwmaLbProto lb_proto_;
+  std::unique_ptr<PeakEwmaLbConfig> lb_config_;
+  ThreadAwareLoadBalancerPtr thread_aware_lb_;
+  LoadBalancerPtr lb_;
+};
+
+TEST_P(PeakEwmaLoadBalancerTest, NoHosts) {
+  init();
+
+  EXPECT_EQ(nullptr, lb_->peekAnotherHost(nullptr));
+  EXPECT_EQ(nullptr, lb_->chooseHost(nullptr).host);
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, AttachesDataToAddedHosts) {
+  init();
+  addHosts();
+
+  for (const auto& host : hostSet().hosts_) {
+    EXPECT_TRUE(host->typedLbPolicyData<PeakEwmaHostLbPolicyData>().has_value());
+  }
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, PrefersLowerLatency) {
+  init();
+  addHosts();
+
+  hostSet().healthy_hosts_[0]->lbPolicyData()->onUpstreamResponseTime(
+      std::chrono::milliseconds(100));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr).host);
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr).host);
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, ActiveRequestsScaleLatency) {
+  init();
+  addHosts();
+
+  // Host 0 is twice as slow but host 1 has three requests in flight.
+  hostSet().healthy_hosts_[0]->lbPolicyData()->onUpstreamResponseTime(
+      std::chrono::milliseconds(20));
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(3);
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr).host);
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, FailingHostLosesPick) {
+  init();
+  addHosts();
+
+  // Host 0 resets requests right away while host 1 answers in 20ms. Had the resets counted as
+  // response times, host 0 would keep its 10ms default and win every pick.
+  hostSet().healthy_hosts_[0]->lbPolicyData()->onUpstreamFailure(std::chrono::milliseconds(1));
+  hostSet().healthy_hosts_[1]->lbPolicyData()->onUpstreamResponseTime(
+      std::chrono::milliseconds(20));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr).host);
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr).host);
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, ChoiceCount) {
+  lb_proto_.mutable_choice_count()->set_value(3);
+  init();
+  addHosts();
+
+  hostSet().healthy_hosts_[0]->lbPolicyData()->onUpstreamResponseTime(
+      std::chrono::milliseconds(100));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr).host);
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, PeekThenChoose) {
+  init();
+  addHosts();
+
+  hostSet().healthy_hosts_[0]->lbPolicyData()->onUpstreamResponseTime(
+      std::chrono::milliseconds(100));
+
+  // The random value of the first choice is stashed by the peek and reused by the next choice.
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->peekAnotherHost(nullptr));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr).host);
+}
+
+INSTANTIATE_TEST_SUITE_P(PrimaryOrFailoverAndLegacyOrNew, PeakEwmaLoadBalancerTest,
+                         ::testing::Values(LoadBalancerTestParam{true},
+                                           LoadBalancerTestParam{false}));
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
@@ -2,6 +2,7 @@
 
 #include "test/benchmark/main.h"
 #include "test/extensions/load_balancing_policies/common/benchmark_base_tester.h"
+#include "test/test_common/test_runtime.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -92,6 +93,34 @@ BENCHMARK(benchmarkRingHashLoadBalancerChooseHost)
     ->Args({500, 256000, 100000})
     ->Unit(::benchmark::kMillisecond);
 
+// Unlike the benchmark above, this times only chooseHost() and reports the per lookup latency, which
+// is dominated by cache misses once the ring no longer fits in the CPU caches.
+void benchmarkRingHashLoadBalancerChooseHostLatency(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t min_ring_size = state.range(1);
+
+  if (benchmark::skipExpensiveBenchmarks() && min_ring_size > 65536) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  RingHashTester tester(num_hosts, min_ring_size);
+  ASSERT_TRUE(tester.ring_hash_lb_->initialize().ok());
+  LoadBalancerPtr lb = tester.ring_hash_lb_->factory()->create(tester.lb_params_);
+  TestLoadBalancerContext context;
+  uint64_t i = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    context.hash_key_ = hashInt(i++);
+    ::benchmark::DoNotOptimize(lb->chooseHost(&context).host);
+  }
+  state.counters["ring_size"] = tester.ring_hash_lb_->stats().size_.value();
+}
+BENCHMARK(benchmarkRingHashLoadBalancerChooseHostLatency)
+    ->Args({100, 65536})
+    ->Args({500, 256000})
+    ->Args({500, 1048576})
+    ->Args({500, 4194304});
+
 void benchmarkRingHashLoadBalancerHostLoss(::benchmark::State& state) {
   const uint64_t num_hosts = state.range(0);
   const uint64_t min_ring_size = state.range(1);
@@ -146,6 +175,43 @@ BENCHMARK(benchmarkRingHashLoadBalancerHostLoss)
     ->Args({500, 256000, 3, 10000})
     ->Unit(::benchmark::kMillisecond);
 
+void benchmarkRingHashLoadBalancerHostChurn(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t min_ring_size = state.range(1);
+  const uint64_t hosts_to_replace = state.range(2);
+  const bool incremental = state.range(3) != 0;
+
+  if (benchmark::skipExpensiveBenchmarks() && min_ring_size > 65536) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.incremental_hash_lb_rebuild", incremental ? "true" : "false"}});
+  RingHashTester tester(num_hosts, min_ring_size);
+  ASSERT_TRUE(tester.ring_hash_lb_->initialize().ok());
+
+  // Only the host set update, and the ring rebuild it triggers, is timed. The replacement hosts are
+  // created and partitioned beforehand. The number of hosts stays the same: adding or removing hosts
+  // changes the number of points of every host, so the ring is then built from scratch.
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    auto update = tester.prepareHostReplacement(hosts_to_replace);
+    state.ResumeTiming();
+    tester.applyHostUpdate(std::move(update));
+  }
+  state.counters["ring_size"] = tester.ring_hash_lb_->stats().size_.value();
+}
+BENCHMARK(benchmarkRingHashLoadBalancerHostChurn)
+    ->Args({500, 65536, 1, 0})
+    ->Args({500, 65536, 1, 1})
+    ->Args({500, 65536, 10, 1})
+    ->Args({500, 1048576, 1, 0})
+    ->Args({500, 1048576, 1, 1})
+    ->Args({500, 1048576, 10, 1})
+    ->Unit(::benchmark::kMillisecond);
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -957,6 +957,49 @@ TEST_P(RingHashLoadBalancerTest, LopsidedWeightSmallScale) {
   }
 }
 
+// Rebuilding the ring incrementally after hosts are replaced must give the same ring as building it
+// from scratch.
+TEST_P(RingHashLoadBalancerTest, IncrementalRebuildMatchesFullBuild) {
+  for (uint32_t i = 0; i < 10; ++i) {
+    hostSet().hosts_.push_back(
+        makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i), simTime()));
+  }
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({}, {});
+
+  config_ = envoy::config::cluster::v3::Cluster::RingHashLbConfig();
+  config_.value().mutable_minimum_ring_size()->set_value(1000);
+  init();
+  EXPECT_EQ(1000, lb_->stats().size_.value());
+
+  // Replace two hosts, which keeps the number of hashes of the other hosts unchanged.
+  HostVector hosts_removed{hostSet().hosts_[2], hostSet().hosts_[7]};
+  hostSet().hosts_[2] = makeTestHost(info_, "tcp://127.0.0.1:100", simTime());
+  hostSet().hosts_[7] = makeTestHost(info_, "tcp://127.0.0.1:101", simTime());
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({hostSet().hosts_[2], hostSet().hosts_[7]}, hosts_removed);
+
+  RingHashLoadBalancer full_lb(
+      priority_set_, stats_, *stats_store_.rootScope(), runtime_, random_,
+      makeOptRef<const envoy::config::cluster::v3::Cluster::RingHashLbConfig>(config_.value()),
+      common_config_);
+  ASSERT_TRUE(full_lb.initialize().ok());
+
+  LoadBalancerPtr lb = lb_->factory()->create(lb_params_);
+  LoadBalancerPtr expected_lb = full_lb.factory()->create(lb_params_);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    TestLoadBalancerContext context(i * 0x9E3779B97F4A7C15);
+    EXPECT_EQ(expected_lb->chooseHost(&context).host, lb->chooseHost(&context).host);
+  }
+
+  // Losing a host changes the number of hashes of every host, which rebuilds the whole ring.
+  hosts_removed = {hostSet().hosts_.back()};
+  hostSet().hosts_.pop_back();
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({}, hosts_removed);
+  EXPECT_EQ(1008, lb_->stats().size_.value());
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
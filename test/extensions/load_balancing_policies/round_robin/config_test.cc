@@ -44,6 +44,22 @@ TEST(RoundRobinConfigTest, ValidateFail) {
   EXPECT_NE(nullptr, thread_local_lb);
 }
 
+TEST(RoundRobinConfigTest, SharedRotationAcrossWorkers) {
+  NiceMock<Server::Configuration::MockServerFactoryContext> context;
+
+  envoy::config::core::v3::TypedExtensionConfig config;
+  config.set_name("envoy.load_balancing_policies.round_robin");
+  auto& factory = Config::Utility::getAndCheckFactory<Upstream::TypedLoadBalancerFactory>(config);
+
+  RoundRobinLbProto config_msg;
+  auto lb_config = factory.loadConfig(context, config_msg).value();
+  EXPECT_EQ(nullptr, dynamic_cast<const TypedRoundRobinLbConfig&>(*lb_config).shared_state_);
+
+  config_msg.set_share_rotation_across_workers(true);
+  lb_config = factory.loadConfig(context, config_msg).value();
+  EXPECT_NE(nullptr, dynamic_cast<const TypedRoundRobinLbConfig&>(*lb_config).shared_state_);
+}
+
 } // namespace
 } // namespace RoundRobin
 } // namespace LoadBalancingPolices
@@ -320,6 +320,32 @@ TEST_P(RoundRobinLoadBalancerTest, Seed) {
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr).host);
 }
 
+// Validate that load balancers sharing a rotation, as the workers of a cluster do with
+// share_rotation_across_workers, advance a single rotation together.
+TEST_P(RoundRobinLoadBalancerTest, SharedRotationAcrossWorkers) {
+  hostSet().healthy_hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:80", simTime()),
+      makeTestHost(info_, "tcp://127.0.0.1:81", simTime()),
+      makeTestHost(info_, "tcp://127.0.0.1:82", simTime()),
+  };
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  auto shared_state = std::make_shared<RoundRobinSharedState>(1);
+  RoundRobinLoadBalancer lb_1(priority_set_, nullptr, stats_, runtime_, random_, 50,
+                              round_robin_lb_policy_, simTime(), shared_state);
+  RoundRobinLoadBalancer lb_2(priority_set_, nullptr, stats_, runtime_, random_, 50,
+                              round_robin_lb_policy_, simTime(), shared_state);
+
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_1.chooseHost(nullptr).host);
+  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_2.chooseHost(nullptr).host);
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_2.chooseHost(nullptr).host);
+
+  // Peeks see the shared rotation but do not advance it.
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_1.peekAnotherHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_1.peekAnotherHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_2.chooseHost(nullptr).host);
+  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_1.chooseHost(nullptr).host);
+}
+
 TEST_P(RoundRobinLoadBalancerTest, Locality) {
   envoy::config::core::v3::Locality zone_a;
   zone_a.set_zone("A");
@@ -19,6 +19,8 @@ namespace OpenTelemetry {
 TEST(OpenTelemetryTracerConfigTest, OpenTelemetryTracerWithGrpcExporter) {
   NiceMock<Server::Configuration::MockTracerFactoryContext> context;
   context.server_factory_context_.cluster_manager_.initializeClusters({"fake_cluster"}, {});
+  ON_CALL(context.server_factory_context_.api_, threadFactory())
+      .WillByDefault([]() -> Thread::ThreadFactory& { return Thread::threadFactoryForTest(); });
   OpenTelemetryTracerFactory factory;
 
   const std::string yaml_string = R"EOF(
@@ -44,6 +46,8 @@ TEST(OpenTelemetryTracerConfigTest, OpenTelemetryTracerWithGrpcExporter) {
 TEST(OpenTelemetryTracerConfigTest, OpenTelemetryTracerWithHttpExporter) {
   NiceMock<Server::Configuration::MockTracerFactoryContext> context;
   context.server_factory_context_.cluster_manager_.initializeClusters({"fake_cluster"}, {});
+  ON_CALL(context.server_factory_context_.api_, threadFactory())
+      .WillByDefault([]() -> Thread::ThreadFactory& { return Thread::threadFactoryForTest(); });
   OpenTelemetryTracerFactory factory;
 
   const std::string yaml_string = R"EOF(
@@ -63,6 +63,22 @@ TEST_F(OpenTelemetryGrpcTraceExporterTest, CreateExporterAndExportSpan) {
             "OTel-OTLP-Exporter-Envoy/" + Envoy::VersionInfo::version());
 }
 
+TEST_F(OpenTelemetryGrpcTraceExporterTest, ExportSerializedRequest) {
+  OpenTelemetryGrpcTraceExporter exporter(Grpc::RawAsyncClientPtr{async_client_});
+
+  expectTraceExportMessage(R"EOF(
+    resource_spans:
+      scope_spans:
+        - spans:
+          - name: "test"
+  )EOF");
+  opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest request;
+  opentelemetry::proto::trace::v1::Span span;
+  span.set_name("test");
+  *request.add_resource_spans()->add_scope_spans()->add_spans() = span;
+  EXPECT_TRUE(exporter.logSerialized(request.SerializeAsString()));
+}
+
 TEST_F(OpenTelemetryGrpcTraceExporterTest, ExportWithRemoteClose) {
   OpenTelemetryGrpcTraceExporter exporter(Grpc::RawAsyncClientPtr{async_client_});
   std::string request_yaml = R"EOF(
@@ -1,7 +1,10 @@
 #include <sys/types.h>
 
+#include <vector>
+
 #include "envoy/common/exception.h"
 
+#include "source/common/buffer/zero_copy_input_stream_impl.h"
 #include "source/common/tracing/http_tracer_impl.h"
 #include "source/common/version/version.h"
 #include "source/extensions/tracers/opentelemetry/opentelemetry_tracer_impl.h"
@@ -14,6 +17,7 @@
 #include "test/mocks/tracing/mocks.h"
 #include "test/test_common/utility.h"
 
+#include "absl/synchronization/mutex.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -52,6 +56,15 @@ public:
     ON_CALL(factory_context.cluster_manager_.async_client_manager_, factoryForGrpcService(_, _, _))
         .WillByDefault(Return(ByMove(std::move(mock_client_factory))));
     ON_CALL(factory_context, scope()).WillByDefault(ReturnRef(scope_));
+    ON_CALL(factory_context.api_, threadFactory())
+        .WillByDefault([]() -> Thread::ThreadFactory& { return Thread::threadFactoryForTest(); });
+    // Serialized exports are posted back from the serializer thread; they are run by
+    // sendPostedExports() on the test thread.
+    ON_CALL(factory_context.thread_local_.dispatcher_, post(_))
+        .WillByDefault(Invoke([this](Event::PostCb callback) {
+          absl::MutexLock lock(&posted_mutex_);
+          posted_.push_back(std::move(callback));
+        }));
 
     Resource resource;
     resource.attributes_.insert(std::pair<std::string, std::string>("key1", "val1"));
@@ -93,7 +106,47 @@ public:
     setup(opentelemetry_config);
   }
 
+  void setupTailSamplingDriver(const std::string& tail_sampling_yaml) {
+    const std::string yaml_string = fmt::format(R"EOF(
+    grpc_service:
+      envoy_grpc:
+        cluster_name: fake-cluster
+      timeout: 0.250s
+    tail_sampling:
+      {}
+    )EOF",
+                                                tail_sampling_yaml);
+    envoy::config::trace::v3::OpenTelemetryConfig opentelemetry_config;
+    TestUtility::loadFromYaml(yaml_string, opentelemetry_config);
+
+    setup(opentelemetry_config);
+    // Export every kept span right away.
+    ON_CALL(runtime_.snapshot_, getInteger("tracing.opentelemetry.min_flush_spans", 5U))
+        .WillByDefault(Return(1));
+  }
+
+  /**
+   * Waits for the serializer thread to post the given number of serialized exports, and sends them.
+   */
+  void sendPostedExports(size_t count) {
+    std::vector<Event::PostCb> posted;
+    {
+      absl::MutexLock lock(&posted_mutex_);
+      expected_posts_ = count;
+      posted_mutex_.Await(absl::Condition(this, &OpenTelemetryDriverTest::exportsPosted));
+      posted.swap(posted_);
+    }
+    EXPECT_EQ(count, posted.size());
+    for (auto& callback : posted) {
+      callback();
+    }
+  }
+
 protected:
+  bool exportsPosted() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(posted_mutex_) {
+    return posted_.size() >= expected_posts_;
+  }
+
   const std::string operation_name_{"test"};
   NiceMock<Envoy::Server::Configuration::MockTracerFactoryContext> context_;
   NiceMock<Envoy::Tracing::MockConfig> mock_tracing_config_;
@@ -101,6 +154,10 @@ protected:
   Event::SimulatedTimeSystem time_system_;
   NiceMock<Grpc::MockAsyncClient>* mock_client_{nullptr};
   envoy::config::trace::v3::OpenTelemetryConfig config_;
+  // Declared before the driver, whose serializer thread may still post while it is destroyed.
+  absl::Mutex posted_mutex_;
+  std::vector<Event::PostCb> posted_ ABSL_GUARDED_BY(posted_mutex_);
+  size_t expected_posts_ ABSL_GUARDED_BY(posted_mutex_){0};
   Tracing::DriverPtr driver_;
   NiceMock<Runtime::MockLoader> runtime_;
   NiceMock<Event::MockTimer>* timer_;
@@ -238,6 +295,7 @@ resource_spans:
       *mock_client_,
       sendRaw(_, _, Grpc::ProtoBufferEqIgnoreRepeatedFieldOrdering(request_proto), _, _, _));
   span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -321,6 +379,7 @@ TEST_F(OpenTelemetryDriverTest, ExportOTLPSpan) {
   // We should see a call to sendMessage to export that single span.
   EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _));
   span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -349,6 +408,7 @@ TEST_F(OpenTelemetryDriverTest, ExportOTLPSpanWithBuffer) {
   // Only now should we see the span exported.
   EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _));
   second_span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(2U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -381,10 +441,94 @@ TEST_F(OpenTelemetryDriverTest, ExportOTLPSpanWithFlushTimeout) {
   EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.opentelemetry.flush_interval_ms", 5000U))
       .WillOnce(Return(5000U));
   timer_->invokeCallback();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.timer_flushed").value());
 }
 
+// Verifies spans beyond max_pending_spans are dropped and that the shared resource and scope
+// blocks are exported with every batch.
+TEST_F(OpenTelemetryDriverTest, DropSpansOverMaxPendingSpans) {
+  timer_ =
+      new NiceMock<Event::MockTimer>(&context_.server_factory_context_.thread_local_.dispatcher_);
+  ON_CALL(context_.server_factory_context_.thread_local_.dispatcher_, createTimer_(_))
+      .WillByDefault(Invoke([this](Event::TimerCb) { return timer_; }));
+  setupValidDriver();
+  Tracing::TestTraceContextImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+
+  // Only flush on the timer and keep at most two spans between flushes.
+  ON_CALL(runtime_.snapshot_, getInteger("tracing.opentelemetry.min_flush_spans", 5U))
+      .WillByDefault(Return(10));
+  ON_CALL(runtime_.snapshot_, getInteger("tracing.opentelemetry.max_pending_spans", 0U))
+      .WillByDefault(Return(2));
+
+  for (int i = 0; i < 3; i++) {
+    Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                               operation_name_, {Tracing::Reason::Sampling, true});
+    span->finishSpan();
+  }
+  EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_dropped").value());
+
+  auto expect_batch = [this](int expected_spans) {
+    EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _))
+        .WillOnce(Invoke([expected_spans](absl::string_view, absl::string_view,
+                                          Buffer::InstancePtr&& request,
+                                          Grpc::RawAsyncRequestCallbacks&, Tracing::Span&,
+                                          const Http::AsyncClient::RequestOptions&)
+                             -> Grpc::AsyncRequest* {
+          opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest message;
+          Buffer::ZeroCopyInputStreamImpl request_stream(std::move(request));
+          EXPECT_TRUE(message.ParseFromZeroCopyStream(&request_stream));
+          EXPECT_EQ(1, message.resource_spans_size());
+          EXPECT_TRUE(message.resource_spans(0).has_resource());
+          EXPECT_EQ("envoy", message.resource_spans(0).scope_spans(0).scope().name());
+          EXPECT_EQ(expected_spans, message.resource_spans(0).scope_spans(0).spans_size());
+          return nullptr;
+        }));
+  };
+  expect_batch(2);
+  timer_->invokeCallback();
+  sendPostedExports(1);
+  EXPECT_EQ(2U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+
+  // The next batch starts empty and still carries the resource and scope.
+  Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                             operation_name_, {Tracing::Reason::Sampling, true});
+  span->finishSpan();
+  expect_batch(1);
+  timer_->invokeCallback();
+  sendPostedExports(1);
+  EXPECT_EQ(3U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_dropped").value());
+}
+
+// Verifies pending spans are not dropped unless max_pending_spans is set.
+TEST_F(OpenTelemetryDriverTest, PendingSpansUnboundedByDefault) {
+  timer_ =
+      new NiceMock<Event::MockTimer>(&context_.server_factory_context_.thread_local_.dispatcher_);
+  ON_CALL(context_.server_factory_context_.thread_local_.dispatcher_, createTimer_(_))
+      .WillByDefault(Invoke([this](Event::TimerCb) { return timer_; }));
+  setupValidDriver();
+  Tracing::TestTraceContextImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+
+  // Only flush on the timer.
+  ON_CALL(runtime_.snapshot_, getInteger("tracing.opentelemetry.min_flush_spans", 5U))
+      .WillByDefault(Return(2000));
+  for (int i = 0; i < 1500; i++) {
+    Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                               operation_name_, {Tracing::Reason::Sampling, true});
+    span->finishSpan();
+  }
+  EXPECT_EQ(0U, stats_.counter("tracing.opentelemetry.spans_dropped").value());
+
+  EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _));
+  timer_->invokeCallback();
+  sendPostedExports(1);
+  EXPECT_EQ(1500U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+}
+
 // Verifies child span is related to parent span
 TEST_F(OpenTelemetryDriverTest, SpawnChildSpan) {
   // Set up driver
@@ -423,6 +567,7 @@ TEST_F(OpenTelemetryDriverTest, SpawnChildSpan) {
   // We should see a call to sendMessage to export that single span.
   EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _));
   child_span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -622,6 +767,7 @@ resource_spans:
       *mock_client_,
       sendRaw(_, _, Grpc::ProtoBufferEqIgnoreRepeatedFieldOrdering(request_proto), _, _, _));
   span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -704,6 +850,7 @@ resource_spans:
       *mock_client_,
       sendRaw(_, _, Grpc::ProtoBufferEqIgnoreRepeatedFieldOrdering(request_proto), _, _, _));
   span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -794,6 +941,7 @@ resource_spans:
       *mock_client_,
       sendRaw(_, _, Grpc::ProtoBufferEqIgnoreRepeatedFieldOrdering(request_proto), _, _, _));
   span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -906,6 +1054,7 @@ resource_spans:
       *mock_client_,
       sendRaw(_, _, Grpc::ProtoBufferEqIgnoreRepeatedFieldOrdering(request_proto), _, _, _));
   span->finishSpan();
+  sendPostedExports(1);
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
@@ -937,10 +1086,126 @@ TEST_F(OpenTelemetryDriverTest, ExportOTLPSpanHTTP) {
               send_(_, _, _));
 
   span->finishSpan();
+  sendPostedExports(1);
 
   EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_sent").value());
 }
 
+// Verifies that a healthy trace is dropped by the tail sampler together with its child spans.
+TEST_F(OpenTelemetryDriverTest, TailSamplingDropsHealthyTrace) {
+  setupTailSamplingDriver("latency_threshold: 1s");
+  Tracing::TestTraceContextImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+
+  Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                             operation_name_, {Tracing::Reason::Sampling, true});
+  Tracing::SpanPtr child_span =
+      span->spawnChild(mock_tracing_config_, operation_name_, time_system_.systemTime());
+
+  EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _)).Times(0);
+  child_span->finishSpan();
+  span->finishSpan();
+  EXPECT_EQ(0U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.tail_sampling_traces_dropped").value());
+  EXPECT_EQ(0U, stats_.counter("tracing.opentelemetry.tail_sampling_traces_kept").value());
+}
+
+// Verifies that an error on a child span keeps the whole trace.
+TEST_F(OpenTelemetryDriverTest, TailSamplingKeepsErroredTrace) {
+  setupTailSamplingDriver("latency_threshold: 1s");
+  Tracing::TestTraceContextImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+
+  Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                             operation_name_, {Tracing::Reason::Sampling, true});
+  Tracing::SpanPtr child_span =
+      span->spawnChild(mock_tracing_config_, operation_name_, time_system_.systemTime());
+  child_span->setTag(Tracing::Tags::get().Error, Tracing::Tags::get().True);
+
+  // The child span is held until the root span finishes.
+  EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _)).Times(0);
+  child_span->finishSpan();
+  testing::Mock::VerifyAndClearExpectations(mock_client_);
+
+  EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _)).Times(2);
+  span->finishSpan();
+  sendPostedExports(2);
+  EXPECT_EQ(2U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.tail_sampling_traces_kept").value());
+}
+
+// Verifies that a trace whose root span exceeds the latency threshold is kept, and that a child
+// finishing after the root span follows that decision.
+TEST_F(OpenTelemetryDriverTest, TailSamplingKeepsSlowTrace) {
+  setupTailSamplingDriver("latency_threshold: 1s");
+  Tracing::TestTraceContextImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+
+  Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                             operation_name_, {Tracing::Reason::Sampling, true});
+  Tracing::SpanPtr child_span =
+      span->spawnChild(mock_tracing_config_, operation_name_, time_system_.systemTime());
+  time_system_.advanceTimeWait(std::chrono::seconds(2));
+
+  EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _)).Times(2);
+  span->finishSpan();
+  child_span->finishSpan();
+  sendPostedExports(2);
+  EXPECT_EQ(2U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.tail_sampling_traces_kept").value());
+}
+
+// Verifies that the random sample of healthy traces is rate limited per second.
+TEST_F(OpenTelemetryDriverTest, TailSamplingRateLimitsHealthyTraces) {
+  setupTailSamplingDriver(R"EOF(
+      healthy_sample_percentage:
+        value: 100
+      max_healthy_traces_per_second: 1
+  )EOF");
+  Tracing::TestTraceContextImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+
+  auto finish_trace = [&]() {
+    Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                               operation_name_, {Tracing::Reason::Sampling, true});
+    span->finishSpan();
+  };
+  EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _)).Times(2);
+  finish_trace();
+  finish_trace();
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  finish_trace();
+  sendPostedExports(2);
+  EXPECT_EQ(2U, stats_.counter("tracing.opentelemetry.tail_sampling_traces_kept").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.tail_sampling_traces_dropped").value());
+}
+
+// Verifies that the tail sampler holds at most max_buffered_spans spans per worker.
+TEST_F(OpenTelemetryDriverTest, TailSamplingBoundsBufferedSpans) {
+  setupTailSamplingDriver(R"EOF(
+      max_buffered_spans: 1
+      healthy_sample_percentage:
+        value: 100
+  )EOF");
+  Tracing::TestTraceContextImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+
+  Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                             operation_name_, {Tracing::Reason::Sampling, true});
+  Tracing::SpanPtr first_child =
+      span->spawnChild(mock_tracing_config_, operation_name_, time_system_.systemTime());
+  Tracing::SpanPtr second_child =
+      span->spawnChild(mock_tracing_config_, operation_name_, time_system_.systemTime());
+  first_child->finishSpan();
+  second_child->finishSpan();
+  EXPECT_EQ(1U, stats_.counter("tracing.opentelemetry.spans_dropped").value());
+
+  EXPECT_CALL(*mock_client_, sendRaw(_, _, _, _, _, _)).Times(2);
+  span->finishSpan();
+  sendPostedExports(2);
+  EXPECT_EQ(2U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+}
+
 } // namespace OpenTelemetry
 } // namespace Tracers
 } // namespace Extensions
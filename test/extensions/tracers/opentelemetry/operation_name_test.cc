@@ -32,6 +32,9 @@ OpenTelemetryTracerOperationNameTest::OpenTelemetryTracerOperationNameTest() {
   cluster_manager_.initializeClusters({"fake-cluster"}, {});
   cluster_manager_.thread_local_cluster_.cluster_.info_->name_ = "fake-cluster";
   cluster_manager_.initializeThreadLocalClusters({"fake-cluster"});
+  // The driver starts a thread to serialize the exported spans.
+  ON_CALL(context.server_factory_context_.api_, threadFactory())
+      .WillByDefault([]() -> Thread::ThreadFactory& { return Thread::threadFactoryForTest(); });
 }
 
 TEST_F(OpenTelemetryTracerOperationNameTest, OperationName) {
@@ -48,6 +48,12 @@ public:
 };
 
 class SamplerFactoryTest : public testing::Test {
+public:
+  SamplerFactoryTest() {
+    // The driver starts a thread to serialize the exported spans.
+    ON_CALL(context.server_factory_context_.api_, threadFactory())
+        .WillByDefault([]() -> Thread::ThreadFactory& { return Thread::threadFactoryForTest(); });
+  }
 
 protected:
   NiceMock<Tracing::MockConfig> config;
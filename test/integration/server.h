@@ -315,6 +315,14 @@ public:
     Thread::LockGuard lock(lock_);
     store_.forEachSinkedHistogram(f_size, f_stat);
   }
+  void forEachChangedSinkedCounter(Stats::SizeFn f_size, StatFn<Counter> f_stat) override {
+    Thread::LockGuard lock(lock_);
+    store_.forEachChangedSinkedCounter(f_size, f_stat);
+  }
+  void forEachChangedSinkedGauge(Stats::SizeFn f_size, StatFn<Gauge> f_stat) override {
+    Thread::LockGuard lock(lock_);
+    store_.forEachChangedSinkedGauge(f_size, f_stat);
+  }
   void setSinkPredicates(std::unique_ptr<SinkPredicates>&& sink_predicates) override {
     UNREFERENCED_PARAMETER(sink_predicates);
   }
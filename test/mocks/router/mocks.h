@@ -111,10 +111,19 @@ public:
     return additional_request_chance_;
   }
   bool hedgeOnPerTryTimeout() const override { return hedge_on_per_try_timeout_; }
+  bool hedgeOnLatency() const override { return latency_hedge_delay_.has_value(); }
+  absl::optional<std::chrono::milliseconds> latencyHedgeDelay() const override {
+    return latency_hedge_delay_;
+  }
+  void recordUpstreamLatency(std::chrono::milliseconds latency) const override {
+    recorded_upstream_latencies_.push_back(latency);
+  }
 
   uint32_t initial_requests_{};
   envoy::type::v3::FractionalPercent additional_request_chance_{};
   bool hedge_on_per_try_timeout_{};
+  absl::optional<std::chrono::milliseconds> latency_hedge_delay_;
+  mutable std::vector<std::chrono::milliseconds> recorded_upstream_latencies_;
 };
 
 class TestRetryPolicy : public RetryPolicy {
@@ -221,6 +230,7 @@ public:
               (const Http::StreamResetReason reset_reason, Http3Used alternate_protocol_used,
                DoRetryResetCallback callback, bool upstream_request_started));
   MOCK_METHOD(RetryStatus, shouldHedgeRetryPerTryTimeout, (DoRetryCallback callback));
+  MOCK_METHOD(RetryStatus, shouldHedgeOnLatency, (DoRetryCallback callback));
   MOCK_METHOD(void, onHostAttempted, (Upstream::HostDescriptionConstSharedPtr));
   MOCK_METHOD(bool, shouldSelectAnotherHost, (const Upstream::Host& host));
   MOCK_METHOD(const Upstream::HealthyAndDegradedLoad&, priorityLoadForRetry,
@@ -52,6 +52,7 @@ public:
   MOCK_METHOD(bool, mutexTracingEnabled, (), (const));
   MOCK_METHOD(bool, coreDumpEnabled, (), (const));
   MOCK_METHOD(bool, cpusetThreadsEnabled, (), (const));
+  MOCK_METHOD(bool, statsSlabAllocationEnabled, (), (const));
   MOCK_METHOD(const std::vector<std::string>&, disabledExtensions, (), (const));
   MOCK_METHOD(Server::CommandLineOptionsPtr, toCommandLineOptions, (), (const));
   MOCK_METHOD(const std::string&, socketPath, (), (const));
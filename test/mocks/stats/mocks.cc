@@ -30,6 +30,7 @@ MockGauge::MockGauge() : used_(false), value_(0), import_mode_(ImportMode::Accum
   ON_CALL(*this, hidden()).WillByDefault(ReturnPointee(&hidden_));
   ON_CALL(*this, value()).WillByDefault(ReturnPointee(&value_));
   ON_CALL(*this, importMode()).WillByDefault(ReturnPointee(&import_mode_));
+  ON_CALL(*this, latchChanged()).WillByDefault(Return(true));
 }
 MockGauge::~MockGauge() = default;
 
@@ -166,6 +166,7 @@ public:
   MOCK_METHOD(bool, used, (), (const));
   MOCK_METHOD(bool, hidden, (), (const));
   MOCK_METHOD(uint64_t, value, (), (const));
+  MOCK_METHOD(bool, latchChanged, ());
   MOCK_METHOD(absl::optional<bool>, cachedShouldImport, (), (const));
   MOCK_METHOD(ImportMode, importMode, (), (const));
 
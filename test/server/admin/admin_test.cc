@@ -152,6 +152,10 @@ TEST_P(AdminInstanceTest, Help) {
       name_regex: Dump only the currently loaded configurations whose names match the specified regex. Can be used with both resource and mask query parameters.
       include_eds: Dump currently loaded configuration including EDS. See the response definition for more information
   /contention: dump current Envoy mutex contention stats (if enabled)
+  /continuous_cpuprofiler (POST): enable/disable the continuous CPU profiler
+      enable: enable/disable the continuous CPU profiler; One of (y, n)
+  /continuous_cpuprofiler/profile: dump the samples of the continuous CPU profiler in pprof format
+      thread_id: Only include samples taken on the thread with this kernel thread id
   /cpuprofiler (POST): enable/disable the CPU profiler
       enable: enables the CPU profiler; One of (y, n)
   /drain_listeners (POST): drain listeners
@@ -195,6 +199,12 @@ TEST_P(AdminInstanceTest, Help) {
   /stats/recentlookups/clear (POST): clear list of stat-name lookups and counter
   /stats/recentlookups/disable (POST): disable recording of reset stat-name lookup names
   /stats/recentlookups/enable (POST): enable recording of reset stat-name lookup names
+  /stats/snapshot: print server stats as a binary StatsSnapshot proto
+      usedonly: Only include stats that have been written by system since restart
+      filter: Regular expression (Google re2) for filtering stats
+      type: Stat types to include.; One of (All, Counters, Histograms, Gauges)
+      dictionary_id: Id of the dictionary of names known by the collector
+      known_names: Number of names of the dictionary known by the collector
 )EOF";
   EXPECT_EQ(expected, response.toString());
 }
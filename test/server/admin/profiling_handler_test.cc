@@ -1,11 +1,69 @@
+#include <numeric>
+#include <vector>
+
 #include "source/common/profiler/profiler.h"
 
 #include "test/server/admin/admin_instance.h"
 #include "test/test_common/logging.h"
+#include "test/test_common/test_time.h"
+
+#include "absl/strings/str_cat.h"
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace Envoy {
 namespace Server {
 
+#ifdef __linux__
+namespace {
+
+// The sample count of every stack of a profile in the legacy pprof format. The stack records
+// follow the five header words and end with the trailer, whose count is zero.
+std::vector<uintptr_t> stackCounts(const Buffer::Instance& profile) {
+  std::vector<uintptr_t> words(profile.length() / sizeof(uintptr_t));
+  profile.copyOut(0, words.size() * sizeof(uintptr_t), words.data());
+  std::vector<uintptr_t> counts;
+  for (size_t i = 5; i + 1 < words.size() && words[i] != 0; i += 2 + words[i + 1]) {
+    counts.push_back(words[i]);
+  }
+  return counts;
+}
+
+// Burns CPU on the calling thread until the continuous profiler recorded a sample of it or the
+// deadline passed, and returns the stack counts of the profile of the thread.
+std::vector<uintptr_t> awaitOwnThreadSamples(AdminInstanceTest& test) {
+  const std::string path =
+      absl::StrCat("/continuous_cpuprofiler/profile?thread_id=", syscall(SYS_gettid));
+  Event::TestRealTimeSystem time_system;
+  const MonotonicTime deadline = time_system.monotonicTime() + std::chrono::seconds(30);
+  Http::TestResponseHeaderMapImpl header_map;
+  while (true) {
+    // A sample is taken every 10ms the thread spends on the CPU.
+    volatile uint64_t sum = 0;
+    for (uint64_t i = 0; i < 1000000; i++) {
+      sum = sum + i;
+    }
+    Buffer::OwnedImpl profile;
+    EXPECT_EQ(Http::Code::OK, test.getCallback(path, header_map, profile));
+    const std::vector<uintptr_t> counts = stackCounts(profile);
+    if (!counts.empty() || time_system.monotonicTime() >= deadline) {
+      return counts;
+    }
+  }
+}
+
+bool profilingSignalHandled() {
+  struct sigaction action {};
+  return sigaction(SIGPROF, nullptr, &action) == 0 && (action.sa_flags & SA_SIGINFO) != 0;
+}
+
+} // namespace
+#endif
+
 INSTANTIATE_TEST_SUITE_P(IpVersions, AdminInstanceTest,
                          testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
                          TestUtility::ipTestParamsToString);
@@ -77,6 +135,95 @@ TEST_P(AdminInstanceTest, AdminBadProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+TEST_P(AdminInstanceTest, AdminContinuousCpuProfiler) {
+  Buffer::OwnedImpl data;
+  Http::TestResponseHeaderMapImpl header_map;
+
+  if (!Profiler::ContinuousCpu::profilerEnabled()) {
+    EXPECT_EQ(Http::Code::NotImplemented,
+              postCallback("/continuous_cpuprofiler?enable=y", header_map, data));
+    EXPECT_EQ(Http::Code::NotImplemented,
+              getCallback("/continuous_cpuprofiler/profile", header_map, data));
+    return;
+  }
+
+  EXPECT_EQ(Http::Code::BadRequest, postCallback("/continuous_cpuprofiler", header_map, data));
+  EXPECT_EQ(Http::Code::OK, postCallback("/continuous_cpuprofiler?enable=y", header_map, data));
+  EXPECT_TRUE(Profiler::ContinuousCpu::isProfilerStarted());
+  // Repeated enables are a no-op, like /cpuprofiler.
+  EXPECT_EQ(Http::Code::OK, postCallback("/continuous_cpuprofiler?enable=y", header_map, data));
+
+  // The gperftools CPU profiler cannot share SIGPROF with the continuous profiler.
+  if (!Profiler::Cpu::profilerEnabled()) {
+    EXPECT_EQ(Http::Code::BadRequest, postCallback("/cpuprofiler?enable=y", header_map, data));
+  }
+
+#ifdef __linux__
+  const std::vector<uintptr_t> own_counts = awaitOwnThreadSamples(*this);
+  ASSERT_FALSE(own_counts.empty()) << "no sample of the test thread was recorded";
+
+  Buffer::OwnedImpl profile;
+  EXPECT_EQ(Http::Code::OK, getCallback("/continuous_cpuprofiler/profile", header_map, profile));
+  // The legacy pprof header: header count, header words, version, sampling period, padding.
+  const std::vector<uintptr_t> header{0, 3, 0, 10000, 0};
+  ASSERT_GE(profile.length(), header.size() * sizeof(uintptr_t));
+  std::vector<uintptr_t> words(header.size());
+  profile.copyOut(0, header.size() * sizeof(uintptr_t), words.data());
+  EXPECT_EQ(header, words);
+  // The profile of all threads includes the samples of the test thread.
+  const std::vector<uintptr_t> counts = stackCounts(profile);
+  ASSERT_FALSE(counts.empty());
+  EXPECT_GE(std::accumulate(counts.begin(), counts.end(), uintptr_t(0)),
+            std::accumulate(own_counts.begin(), own_counts.end(), uintptr_t(0)));
+
+  // Kernel thread ids stay far below the largest 32 bit value, so no sample matches it.
+  Buffer::OwnedImpl other_profile;
+  EXPECT_EQ(Http::Code::OK, getCallback("/continuous_cpuprofiler/profile?thread_id=4294967295",
+                                        header_map, other_profile));
+  ASSERT_GE(other_profile.length(), header.size() * sizeof(uintptr_t));
+  EXPECT_TRUE(stackCounts(other_profile).empty());
+#endif
+
+  EXPECT_EQ(Http::Code::BadRequest,
+            getCallback("/continuous_cpuprofiler/profile?thread_id=main", header_map, data));
+
+  EXPECT_EQ(Http::Code::OK, postCallback("/continuous_cpuprofiler?enable=n", header_map, data));
+  EXPECT_FALSE(Profiler::ContinuousCpu::isProfilerStarted());
+  // Samples collected before the profiler was stopped are still available.
+  EXPECT_EQ(Http::Code::OK, getCallback("/continuous_cpuprofiler/profile", header_map, data));
+}
+
+// The gperftools CPU profiler restores the default disposition of SIGPROF when it stops, which
+// would terminate the process on the first sample of a continuous profiler started afterwards.
+TEST_P(AdminInstanceTest, AdminContinuousCpuProfilerAfterCpuProfiler) {
+  if (!Profiler::ContinuousCpu::profilerEnabled()) {
+    return;
+  }
+
+#ifdef __linux__
+  Buffer::OwnedImpl data;
+  Http::TestResponseHeaderMapImpl header_map;
+  EXPECT_EQ(Http::Code::OK, postCallback("/continuous_cpuprofiler?enable=y", header_map, data));
+  EXPECT_EQ(Http::Code::OK, postCallback("/continuous_cpuprofiler?enable=n", header_map, data));
+#ifdef PROFILER_AVAILABLE
+  EXPECT_EQ(Http::Code::OK, postCallback("/cpuprofiler?enable=y", header_map, data));
+  EXPECT_EQ(Http::Code::OK, postCallback("/cpuprofiler?enable=n", header_map, data));
+#else
+  EXPECT_EQ(Http::Code::InternalServerError,
+            postCallback("/cpuprofiler?enable=y", header_map, data));
+  EXPECT_EQ(Http::Code::OK, postCallback("/cpuprofiler?enable=n", header_map, data));
+  // Do what the gperftools CPU profiler does when it stops.
+  signal(SIGPROF, SIG_DFL);
+  EXPECT_FALSE(profilingSignalHandled());
+#endif
+
+  EXPECT_EQ(Http::Code::OK, postCallback("/continuous_cpuprofiler?enable=y", header_map, data));
+  EXPECT_TRUE(profilingSignalHandled());
+  EXPECT_FALSE(awaitOwnThreadSamples(*this).empty());
+  EXPECT_EQ(Http::Code::OK, postCallback("/continuous_cpuprofiler?enable=n", header_map, data));
+#endif
+}
+
 TEST_P(AdminInstanceTest, AdminHeapDump) {
   Buffer::OwnedImpl data;
   Http::TestResponseHeaderMapImpl header_map;
@@ -211,6 +211,32 @@ public:
     return count;
   }
 
+  /**
+   * Issues a streaming prometheus request against the stats saved in store_,
+   * draining each chunk as it is produced.
+   *
+   * @param params the already-parsed parameters.
+   * @param max_chunk set to the largest chunk held in memory at once.
+   * @return the total number of bytes rendered.
+   */
+  uint64_t handlerPrometheusStreaming(const StatsParams& params, uint64_t& max_chunk) {
+    Admin::RequestPtr request =
+        StatsHandler::makePrometheusRequest(*store_, params, cm_, custom_namespaces_);
+    auto response_headers = Http::ResponseHeaderMapImpl::create();
+    request->start(*response_headers);
+    Buffer::OwnedImpl data;
+    uint64_t count = 0;
+    max_chunk = 0;
+    bool more = true;
+    do {
+      more = request->nextChunk(data);
+      count += data.length();
+      max_chunk = std::max<uint64_t>(max_chunk, data.length());
+      data.drain(data.length());
+    } while (more);
+    return count;
+  }
+
   std::vector<Stats::ScopeSharedPtr> scopes_;
   Envoy::Stats::CustomStatNamespacesImpl custom_namespaces_;
   FastMockClusterManager cm_;
@@ -382,6 +408,32 @@ BENCHMARK_CAPTURE(BM_AllCountersPrometheus, per_endpoint_stats_disabled, false)
 BENCHMARK_CAPTURE(BM_AllCountersPrometheus, per_endpoint_stats_enabled, true)
     ->Unit(benchmark::kMillisecond);
 
+// Same as BM_AllCountersPrometheus, but streams the output in chunks rather than
+// rendering it into a single buffer. The label reports the largest chunk held in
+// memory at once, which is the full output size for the buffered benchmark.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_AllCountersPrometheusStreaming(benchmark::State& state, bool per_endpoint_stats) {
+  Envoy::Server::StatsHandlerTest& test_context = testContext(per_endpoint_stats);
+  Envoy::Server::StatsParams params;
+  Envoy::Buffer::OwnedImpl response;
+  params.parse("?format=prometheus&type=Counters", response);
+
+  uint64_t count;
+  uint64_t max_chunk;
+  for (auto _ : state) { // NOLINT
+    count = test_context.handlerPrometheusStreaming(params, max_chunk);
+    RELEASE_ASSERT(count > 250 * 1000 * 1000, "expected count > 250M");
+    RELEASE_ASSERT(max_chunk < count, "expected max_chunk < count");
+  }
+
+  auto label = absl::StrCat("output per iteration: ", count, "; max chunk: ", max_chunk);
+  state.SetLabel(label);
+}
+BENCHMARK_CAPTURE(BM_AllCountersPrometheusStreaming, per_endpoint_stats_disabled, false)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_AllCountersPrometheusStreaming, per_endpoint_stats_enabled, true)
+    ->Unit(benchmark::kMillisecond);
+
 // NOLINTNEXTLINE(readability-identifier-naming)
 static void BM_UsedCountersPrometheus(benchmark::State& state, bool per_endpoint_stats) {
   Envoy::Server::StatsHandlerTest& test_context = testContext(per_endpoint_stats);
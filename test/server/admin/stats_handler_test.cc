@@ -4,6 +4,7 @@
 #include "source/common/common/regex.h"
 #include "source/common/stats/custom_stat_namespaces_impl.h"
 #include "source/common/stats/thread_local_store.h"
+#include "source/server/admin/prometheus_stats.h"
 #include "source/server/admin/stats_handler.h"
 #include "source/server/admin/stats_request.h"
 
@@ -17,11 +18,14 @@
 #include "test/test_common/utility.h"
 
 using testing::Combine;
+using testing::ElementsAre;
 using testing::HasSubstr;
 using testing::InSequence;
+using testing::IsEmpty;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
+using testing::UnorderedElementsAre;
 using testing::Values;
 using testing::ValuesIn;
 
@@ -190,6 +194,83 @@ TEST_F(AdminStatsTest, HandlerStatsPlainText) {
   EXPECT_EQ(expected, code_response.second);
 }
 
+class AdminStatsSnapshotTest : public AdminStatsTest {
+protected:
+  AdminStatsSnapshotTest() {
+    EXPECT_CALL(admin_stream_, getRequestHeaders()).WillRepeatedly(ReturnRef(request_headers_));
+    EXPECT_CALL(instance_, statsConfig()).WillRepeatedly(ReturnRef(stats_config_));
+    EXPECT_CALL(stats_config_, flushOnAdmin()).WillRepeatedly(Return(false));
+    ON_CALL(instance_, stats()).WillByDefault(ReturnRef(*store_));
+    EXPECT_CALL(instance_, api()).WillRepeatedly(ReturnRef(api_));
+    ON_CALL(api_.random_, random()).WillByDefault(Return(DictionaryId));
+  }
+
+  // Issues a /stats/snapshot request to the same handler, which retains the dictionary.
+  std::pair<Http::Code, std::string> handlerStatsSnapshot(absl::string_view url) {
+    request_headers_.setPath(url);
+    Http::TestResponseHeaderMapImpl response_headers;
+    Buffer::OwnedImpl data;
+    const Http::Code code = handler_.handlerStatsSnapshot(response_headers, data, admin_stream_);
+    return {code, data.toString()};
+  }
+
+  envoy::admin::v3::StatsSnapshot snapshot(absl::string_view url) {
+    const auto [code, body] = handlerStatsSnapshot(url);
+    EXPECT_EQ(Http::Code::OK, code);
+    envoy::admin::v3::StatsSnapshot snapshot;
+    EXPECT_TRUE(snapshot.ParseFromString(body));
+    return snapshot;
+  }
+
+  static constexpr uint64_t DictionaryId = 42;
+  NiceMock<MockInstance> instance_;
+  StatsHandler handler_{instance_};
+};
+
+TEST_F(AdminStatsSnapshotTest, KnownNamesOfTheDictionaryAreNotSent) {
+  store_->counterFromString("c1").add(10);
+  store_->counterFromString("c2").add(20);
+
+  envoy::admin::v3::StatsSnapshot result = snapshot("/stats/snapshot");
+  EXPECT_EQ(DictionaryId, result.dictionary_id());
+  EXPECT_THAT(result.names(), UnorderedElementsAre("c1", "c2"));
+  EXPECT_THAT(result.counter_values(), UnorderedElementsAre(10, 20));
+
+  result = snapshot("/stats/snapshot?dictionary_id=42&known_names=2");
+  EXPECT_EQ(DictionaryId, result.dictionary_id());
+  EXPECT_EQ(2, result.first_name_id());
+  EXPECT_THAT(result.names(), IsEmpty());
+  EXPECT_THAT(result.counter_values(), UnorderedElementsAre(10, 20));
+}
+
+TEST_F(AdminStatsSnapshotTest, DictionaryMismatchSendsAllNames) {
+  store_->counterFromString("c1").add(10);
+  snapshot("/stats/snapshot");
+
+  const envoy::admin::v3::StatsSnapshot result =
+      snapshot("/stats/snapshot?dictionary_id=7&known_names=1");
+  EXPECT_EQ(DictionaryId, result.dictionary_id());
+  EXPECT_EQ(0, result.first_name_id());
+  EXPECT_THAT(result.names(), ElementsAre("c1"));
+}
+
+TEST_F(AdminStatsSnapshotTest, BadRequest) {
+  const auto expect_bad_request = [this](absl::string_view url, absl::string_view message) {
+    const auto [code, body] = handlerStatsSnapshot(url);
+    EXPECT_EQ(Http::Code::BadRequest, code) << url;
+    EXPECT_EQ(message, body) << url;
+  };
+  expect_bad_request("/stats/snapshot?dictionary_id=42",
+                     "dictionary_id and known_names must be specified together\n");
+  expect_bad_request("/stats/snapshot?known_names=1",
+                     "dictionary_id and known_names must be specified together\n");
+  expect_bad_request("/stats/snapshot?dictionary_id=abc&known_names=1",
+                     "dictionary_id and known_names must be integers\n");
+  expect_bad_request("/stats/snapshot?dictionary_id=42&known_names=-1",
+                     "dictionary_id and known_names must be integers\n");
+  EXPECT_EQ(Http::Code::BadRequest, handlerStatsSnapshot("/stats/snapshot?type=blergh").first);
+}
+
 #ifdef ENVOY_ADMIN_HTML
 TEST_F(AdminStatsTest, HandlerStatsHtml) {
   InSequence s;
@@ -1406,6 +1487,80 @@ envoy_cluster_upstream_cx_active{cluster="c2"} 12
   EXPECT_EQ(expected_response, code_response.second);
 }
 
+TEST_F(StatsHandlerPrometheusDefaultTest, StatsHandlerPrometheusChunked) {
+  createTestStats();
+
+  StatsParams params;
+  Buffer::OwnedImpl parse_response;
+  ASSERT_EQ(Http::Code::OK, params.parse("/stats?format=prometheus", parse_response));
+  PrometheusStatsRequest request(*store_, params, endpoints_helper_.cm_, custom_namespaces_);
+  request.setChunkSize(1);
+
+  // With a chunk size of 1, each chunk holds exactly one group of metrics.
+  Http::TestResponseHeaderMapImpl response_headers;
+  EXPECT_EQ(Http::Code::OK, request.start(response_headers));
+  std::vector<std::string> chunks;
+  bool more;
+  do {
+    Buffer::OwnedImpl chunk;
+    more = request.nextChunk(chunk);
+    if (chunk.length() > 0) {
+      chunks.push_back(chunk.toString());
+    }
+  } while (more);
+
+  EXPECT_THAT(chunks, ElementsAre("# TYPE envoy_cluster_upstream_cx_total counter\n"
+                                  "envoy_cluster_upstream_cx_total{cluster=\"c1\"} 10\n"
+                                  "envoy_cluster_upstream_cx_total{cluster=\"c2\"} 20\n",
+                                  "# TYPE envoy_cluster_upstream_cx_active gauge\n"
+                                  "envoy_cluster_upstream_cx_active{cluster=\"c1\"} 11\n"
+                                  "envoy_cluster_upstream_cx_active{cluster=\"c2\"} 12\n"));
+}
+
+TEST_F(StatsHandlerPrometheusDefaultTest, StatsHandlerPrometheusBatched) {
+  Stats::StatNameTagVector c1_tags{{makeStat("cluster"), makeStat("c1")}};
+  Stats::StatNameTagVector c2_tags{{makeStat("cluster"), makeStat("c2")}};
+  store_->rootScope()->counterFromStatNameWithTags(makeStat("cluster.c.total"), c2_tags).add(2);
+  store_->rootScope()->counterFromStatNameWithTags(makeStat("cluster.c.total"), c1_tags).add(1);
+  store_->rootScope()->counterFromStatNameWithTags(makeStat("cluster.a.total"), c1_tags).add(3);
+  store_->rootScope()->counterFromStatNameWithTags(makeStat("cluster.b.total"), c1_tags).add(4);
+  // Stats held by overlapping scopes are visited once per scope, but rendered once.
+  Stats::ScopeSharedPtr scope1 = store_->rootScope()->createScope("dup");
+  Stats::ScopeSharedPtr scope2 = store_->rootScope()->createScope("dup");
+  scope1->counterFromString("total").inc();
+  scope2->counterFromString("total").inc();
+
+  StatsParams params;
+  Buffer::OwnedImpl parse_response;
+  ASSERT_EQ(Http::Code::OK, params.parse("/stats?format=prometheus", parse_response));
+  auto render = [&](uint64_t max_batch_metrics) {
+    PrometheusStatsRequest request(*store_, params, endpoints_helper_.cm_, custom_namespaces_);
+    request.setMaxBatchMetrics(max_batch_metrics);
+    Http::TestResponseHeaderMapImpl response_headers;
+    EXPECT_EQ(Http::Code::OK, request.start(response_headers));
+    Buffer::OwnedImpl response;
+    while (request.nextChunk(response)) {
+    }
+    return response.toString();
+  };
+
+  // A batch never splits the stats sharing a tag-extracted name, so batches of a single stat
+  // still render whole groups, in the same order as a single batch.
+  const std::string expected_response = R"EOF(# TYPE envoy_cluster_a_total counter
+envoy_cluster_a_total{cluster="c1"} 3
+# TYPE envoy_cluster_b_total counter
+envoy_cluster_b_total{cluster="c1"} 4
+# TYPE envoy_cluster_c_total counter
+envoy_cluster_c_total{cluster="c1"} 1
+envoy_cluster_c_total{cluster="c2"} 2
+# TYPE envoy_dup_total counter
+envoy_dup_total{} 2
+)EOF";
+  EXPECT_EQ(expected_response, render(PrometheusStatsRequest::DefaultMaxBatchMetrics));
+  EXPECT_EQ(expected_response, render(1));
+  EXPECT_EQ(expected_response, render(2));
+}
+
 TEST_F(StatsHandlerPrometheusDefaultTest, StatsHandlerPrometheusInvalidRegex) {
   const std::string url = "/stats?format=prometheus&filter=(+invalid)";
 
@@ -0,0 +1,150 @@
+#include <string>
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/common/stats/thread_local_store.h"
+#include "source/server/admin/stats_snapshot.h"
+
+#include "test/mocks/common.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Server {
+
+class StatsSnapshotRendererTest : public testing::Test {
+protected:
+  static constexpr uint64_t DictionaryId = 1234;
+
+  StatsSnapshotRendererTest() : renderer_(store_.symbolTable(), random_) {}
+
+  envoy::admin::v3::StatsSnapshot render(absl::string_view url, uint32_t known_names) {
+    StatsParams params;
+    Buffer::OwnedImpl response;
+    EXPECT_EQ(Http::Code::OK, params.parse(url, response));
+    envoy::admin::v3::StatsSnapshot snapshot;
+    renderer_.render(store_, params, known_names, snapshot);
+    return snapshot;
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<Random::MockRandomGenerator> random_{DictionaryId};
+  StatsSnapshotRenderer renderer_;
+};
+
+TEST_F(StatsSnapshotRendererTest, Empty) {
+  const envoy::admin::v3::StatsSnapshot snapshot = render("/stats/snapshot", 0);
+  EXPECT_EQ(DictionaryId, snapshot.dictionary_id());
+  EXPECT_EQ(0, snapshot.first_name_id());
+  EXPECT_THAT(snapshot.names(), IsEmpty());
+  EXPECT_THAT(snapshot.counter_id_deltas(), IsEmpty());
+  EXPECT_THAT(snapshot.gauge_id_deltas(), IsEmpty());
+}
+
+TEST_F(StatsSnapshotRendererTest, NamesSentOnlyUntilKnown) {
+  store_.counterFromString("c1").add(10);
+  store_.gaugeFromString("g1", Stats::Gauge::ImportMode::Accumulate).set(5);
+
+  envoy::admin::v3::StatsSnapshot snapshot = render("/stats/snapshot", 0);
+  EXPECT_EQ(0, snapshot.first_name_id());
+  EXPECT_THAT(snapshot.names(), ElementsAre("c1", "g1"));
+  EXPECT_THAT(snapshot.counter_id_deltas(), ElementsAre(0));
+  EXPECT_THAT(snapshot.counter_values(), ElementsAre(10));
+  EXPECT_THAT(snapshot.gauge_id_deltas(), ElementsAre(1));
+  EXPECT_THAT(snapshot.gauge_values(), ElementsAre(5));
+
+  // Only the name of the new stat is sent to a collector knowing the first two names, and the
+  // ids of the existing stats are stable.
+  store_.counterFromString("c0").add(3);
+  snapshot = render("/stats/snapshot", renderer_.numNames());
+  EXPECT_EQ(2, snapshot.first_name_id());
+  EXPECT_THAT(snapshot.names(), ElementsAre("c0"));
+  EXPECT_THAT(snapshot.counter_id_deltas(), ElementsAre(0, 2));
+  EXPECT_THAT(snapshot.counter_values(), ElementsAre(10, 3));
+  EXPECT_THAT(snapshot.gauge_id_deltas(), ElementsAre(1));
+}
+
+TEST_F(StatsSnapshotRendererTest, UnknownNameCountSendsAllNames) {
+  store_.counterFromString("c1").add(1);
+
+  const envoy::admin::v3::StatsSnapshot snapshot = render("/stats/snapshot", 5);
+  EXPECT_EQ(0, snapshot.first_name_id());
+  EXPECT_THAT(snapshot.names(), ElementsAre("c1"));
+}
+
+TEST_F(StatsSnapshotRendererTest, IdsAssignedInRenderOrder) {
+  store_.counterFromString("a").add(1);
+  store_.counterFromString("b").add(2);
+  EXPECT_THAT(render("/stats/snapshot?filter=b", 0).names(), ElementsAre("b"));
+
+  // Values are sent in id order, which is the order in which the names were first rendered.
+  const envoy::admin::v3::StatsSnapshot snapshot = render("/stats/snapshot", 0);
+  EXPECT_THAT(snapshot.names(), ElementsAre("b", "a"));
+  EXPECT_THAT(snapshot.counter_id_deltas(), ElementsAre(0, 1));
+  EXPECT_THAT(snapshot.counter_values(), ElementsAre(2, 1));
+}
+
+TEST_F(StatsSnapshotRendererTest, Filtered) {
+  store_.counterFromString("c1").add(1);
+  store_.counterFromString("c2");
+  store_.gaugeFromString("g1", Stats::Gauge::ImportMode::Accumulate).set(1);
+
+  const envoy::admin::v3::StatsSnapshot snapshot =
+      render("/stats/snapshot?usedonly&type=Counters", 0);
+  EXPECT_THAT(snapshot.names(), ElementsAre("c1"));
+  EXPECT_THAT(snapshot.counter_values(), ElementsAre(1));
+  EXPECT_THAT(snapshot.gauge_id_deltas(), IsEmpty());
+}
+
+// The names of deleted stats are dropped once they outnumber the stats of the store, under a new
+// dictionary id.
+TEST(StatsSnapshotRendererResetTest, DeletedNamesOutnumberingStatsResetDictionary) {
+  Stats::SymbolTableImpl symbol_table;
+  Stats::AllocatorImpl alloc(symbol_table);
+  Stats::ThreadLocalStoreImpl store(alloc);
+  NiceMock<Random::MockRandomGenerator> random;
+  EXPECT_CALL(random, random()).WillOnce(Return(1)).WillOnce(Return(2));
+  StatsSnapshotRenderer renderer(symbol_table, random);
+
+  StatsParams params;
+  Buffer::OwnedImpl response;
+  ASSERT_EQ(Http::Code::OK, params.parse("/stats/snapshot", response));
+
+  store.counterFromString("live").inc();
+  {
+    Stats::ScopeSharedPtr scope = store.createScope("deleted");
+    for (int i = 0; i < 20; ++i) {
+      scope->counterFromString(absl::StrCat("c", i)).inc();
+    }
+    envoy::admin::v3::StatsSnapshot snapshot;
+    renderer.render(store, params, 0, snapshot);
+    EXPECT_EQ(1, snapshot.dictionary_id());
+    EXPECT_EQ(21, snapshot.names_size());
+  }
+
+  // Only the two stats still alive are sent under the new dictionary.
+  store.counterFromString("another").inc();
+  envoy::admin::v3::StatsSnapshot snapshot;
+  renderer.render(store, params, renderer.numNames(), snapshot);
+  EXPECT_EQ(2, snapshot.dictionary_id());
+  EXPECT_EQ(0, snapshot.first_name_id());
+  EXPECT_THAT(snapshot.names(), testing::UnorderedElementsAre("live", "another"));
+  EXPECT_THAT(snapshot.counter_values(), ElementsAre(1, 1));
+
+  // The dictionary is kept while its names are those of live stats.
+  snapshot.Clear();
+  renderer.render(store, params, renderer.numNames(), snapshot);
+  EXPECT_EQ(2, snapshot.dictionary_id());
+  EXPECT_EQ(2, snapshot.first_name_id());
+  EXPECT_THAT(snapshot.names(), IsEmpty());
+}
+
+} // namespace Server
+} // namespace Envoy
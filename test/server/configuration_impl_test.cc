@@ -126,6 +126,22 @@ TEST_F(ConfigurationImplTest, CustomStatsFlushInterval) {
 
   EXPECT_EQ(std::chrono::milliseconds(500), config.statsConfig().flushInterval());
   EXPECT_FALSE(config.statsConfig().flushOnAdmin());
+  EXPECT_FALSE(config.statsConfig().flushChangedOnly());
+}
+
+TEST_F(ConfigurationImplTest, StatsFlushChangedOnly) {
+  std::string json = R"EOF(
+  {
+    "stats_flush_changed_only": true
+  }
+  )EOF";
+
+  auto bootstrap = Upstream::parseBootstrapFromV3Json(json);
+
+  MainImpl config;
+  EXPECT_TRUE(config.initialize(bootstrap, server_, cluster_manager_factory_).ok());
+
+  EXPECT_TRUE(config.statsConfig().flushChangedOnly());
 }
 
 TEST_F(ConfigurationImplTest, StatsOnAdmin) {
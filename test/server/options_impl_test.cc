@@ -108,7 +108,8 @@ TEST_F(OptionsImplTest, All) {
       "--drain-time-s 60 --log-format [%v] --parent-shutdown-time-s 90 "
       "--log-path "
       "/foo/bar "
-      "--disable-hot-restart --cpuset-threads --allow-unknown-static-fields "
+      "--disable-hot-restart --cpuset-threads --stats-slab-allocation "
+      "--allow-unknown-static-fields "
       "--reject-unknown-dynamic-fields --base-id 5 "
       "--use-dynamic-base-id --base-id-path /foo/baz "
       "--stats-tag foo:bar --stats-tag baz:bar "
@@ -135,6 +136,7 @@ TEST_F(OptionsImplTest, All) {
   EXPECT_EQ(std::chrono::seconds(90), options->parentShutdownTime());
   EXPECT_TRUE(options->hotRestartDisabled());
   EXPECT_TRUE(options->cpusetThreadsEnabled());
+  EXPECT_TRUE(options->statsSlabAllocationEnabled());
   EXPECT_TRUE(options->allowUnknownStaticFields());
   EXPECT_TRUE(options->rejectUnknownDynamicFields());
   EXPECT_EQ(5U, options->baseId());
@@ -204,6 +206,7 @@ TEST_F(OptionsImplTest, SetAll) {
   options->setHotRestartDisabled(!options->hotRestartDisabled());
   options->setSignalHandling(!options->signalHandlingEnabled());
   options->setCpusetThreads(!options->cpusetThreadsEnabled());
+  options->setStatsSlabAllocation(true);
   options->setAllowUnknownFields(true);
   options->setRejectUnknownFieldsDynamic(true);
   options->setSocketPath("/foo/envoy_domain_socket");
@@ -237,6 +240,7 @@ TEST_F(OptionsImplTest, SetAll) {
   EXPECT_EQ(!hot_restart_disabled, options->hotRestartDisabled());
   EXPECT_EQ(!signal_handling_enabled, options->signalHandlingEnabled());
   EXPECT_EQ(!cpuset_threads_enabled, options->cpusetThreadsEnabled());
+  EXPECT_TRUE(options->statsSlabAllocationEnabled());
   EXPECT_TRUE(options->allowUnknownStaticFields());
   EXPECT_TRUE(options->rejectUnknownDynamicFields());
   EXPECT_EQ("/foo/envoy_domain_socket", options->socketPath());
@@ -271,6 +275,7 @@ TEST_F(OptionsImplTest, SetAll) {
   EXPECT_EQ(options->mutexTracingEnabled(), command_line_options->enable_mutex_tracing());
   EXPECT_EQ(options->coreDumpEnabled(), command_line_options->enable_core_dump());
   EXPECT_EQ(options->cpusetThreadsEnabled(), command_line_options->cpuset_threads());
+  EXPECT_TRUE(command_line_options->stats_slab_allocation());
   EXPECT_EQ(options->socketPath(), command_line_options->socket_path());
   EXPECT_EQ(options->socketMode(), command_line_options->socket_mode());
   EXPECT_EQ(1U, command_line_options->stats_tag().size());
@@ -291,6 +296,7 @@ TEST_F(OptionsImplTest, DefaultParams) {
   EXPECT_EQ(0U, options->statsTags().size());
   EXPECT_FALSE(options->hotRestartDisabled());
   EXPECT_FALSE(options->cpusetThreadsEnabled());
+  EXPECT_FALSE(options->statsSlabAllocationEnabled());
 
   // Validate that CommandLineOptions is constructed correctly with default params.
   Server::CommandLineOptionsPtr command_line_options = options->toCommandLineOptions();
@@ -305,6 +311,7 @@ TEST_F(OptionsImplTest, DefaultParams) {
   EXPECT_EQ(0, command_line_options->socket_mode());
   EXPECT_FALSE(command_line_options->disable_hot_restart());
   EXPECT_FALSE(command_line_options->cpuset_threads());
+  EXPECT_FALSE(command_line_options->stats_slab_allocation());
   EXPECT_FALSE(command_line_options->allow_unknown_static_fields());
   EXPECT_FALSE(command_line_options->reject_unknown_dynamic_fields());
   EXPECT_EQ(0, options->statsTags().size());
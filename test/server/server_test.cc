@@ -13,6 +13,7 @@
 #include "source/common/network/listen_socket_impl.h"
 #include "source/common/network/socket_option_impl.h"
 #include "source/common/protobuf/protobuf.h"
+#include "source/common/stats/histogram_impl.h"
 #include "source/common/thread_local/thread_local_impl.h"
 #include "source/common/version/version.h"
 #include "source/server/instance_impl.h"
@@ -49,6 +50,7 @@ using testing::InSequence;
 using testing::Invoke;
 using testing::InvokeWithoutArgs;
 using testing::Return;
+using testing::ReturnRef;
 using testing::SaveArg;
 using testing::StrictMock;
 
@@ -160,6 +162,101 @@ TEST(ServerInstanceUtil, flushImportModeUninitializedGauges) {
   InstanceUtil::flushMetricsToSinks(sinks, store, cm, time_system);
 }
 
+TEST(ServerInstanceUtil, flushChangedOnly) {
+  InSequence s;
+
+  NiceMock<Upstream::MockClusterManager> cm;
+  Stats::TestUtil::TestStore store;
+  Event::SimulatedTimeSystem time_system;
+  Stats::Counter& changed_counter = store.counter("changed_counter");
+  store.counter("idle_counter").inc();
+  Stats::Gauge& changed_gauge = store.gauge("changed_gauge", Stats::Gauge::ImportMode::Accumulate);
+  store.gauge("idle_gauge", Stats::Gauge::ImportMode::Accumulate).set(5);
+
+  // The first flush reports everything that was touched since the stats were created.
+  std::list<Stats::SinkPtr> sinks;
+  Stats::MockSink* sink = new StrictMock<Stats::MockSink>();
+  sinks.emplace_back(sink);
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    ASSERT_EQ(snapshot.counters().size(), 1);
+    EXPECT_EQ(snapshot.counters()[0].counter_.get().name(), "idle_counter");
+    ASSERT_EQ(snapshot.gauges().size(), 1);
+    EXPECT_EQ(snapshot.gauges()[0].get().name(), "idle_gauge");
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store, cm, time_system, true);
+
+  changed_counter.add(2);
+  changed_gauge.set(3);
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    ASSERT_EQ(snapshot.counters().size(), 1);
+    EXPECT_EQ(snapshot.counters()[0].counter_.get().name(), "changed_counter");
+    EXPECT_EQ(snapshot.counters()[0].delta_, 2);
+    ASSERT_EQ(snapshot.gauges().size(), 1);
+    EXPECT_EQ(snapshot.gauges()[0].get().name(), "changed_gauge");
+    EXPECT_EQ(snapshot.gauges()[0].get().value(), 3);
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store, cm, time_system, true);
+
+  // Decrementing a gauge is a change too.
+  changed_gauge.dec();
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    EXPECT_TRUE(snapshot.counters().empty());
+    ASSERT_EQ(snapshot.gauges().size(), 1);
+    EXPECT_EQ(snapshot.gauges()[0].get().value(), 2);
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store, cm, time_system, true);
+
+  // A full flush still reports every stat.
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    EXPECT_EQ(snapshot.counters().size(), 2);
+    EXPECT_EQ(snapshot.gauges().size(), 2);
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store, cm, time_system);
+}
+
+TEST(ServerInstanceUtil, flushChangedOnlyHistograms) {
+  NiceMock<Upstream::MockClusterManager> cm;
+  Event::SimulatedTimeSystem time_system;
+
+  // Histograms don't currently work with the isolated store so test those with a mock store.
+  NiceMock<Stats::MockStore> store;
+  auto* idle = new NiceMock<Stats::MockParentHistogram>();
+  idle->name_ = "idle";
+  auto* recorded = new NiceMock<Stats::MockParentHistogram>();
+  recorded->name_ = "recorded";
+  histogram_t* samples = hist_alloc();
+  hist_insert_intscale(samples, 1, 0, 2);
+  Stats::HistogramStatisticsImpl recorded_statistics(samples);
+  hist_free(samples);
+  ON_CALL(*recorded, intervalStatistics()).WillByDefault(ReturnRef(recorded_statistics));
+  std::vector<Stats::ParentHistogramSharedPtr> parent_histograms = {
+      Stats::ParentHistogramSharedPtr(idle), Stats::ParentHistogramSharedPtr(recorded)};
+  ON_CALL(store, forEachSinkedHistogram)
+      .WillByDefault([&](std::function<void(std::size_t)> f_size,
+                         std::function<void(Stats::ParentHistogram&)> f_stat) {
+        f_size(parent_histograms.size());
+        for (auto& histogram : parent_histograms) {
+          f_stat(*histogram);
+        }
+      });
+
+  std::list<Stats::SinkPtr> sinks;
+  Stats::MockSink* sink = new StrictMock<Stats::MockSink>();
+  sinks.emplace_back(sink);
+  // Only the histogram with samples in the last interval is reported.
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    ASSERT_EQ(snapshot.histograms().size(), 1);
+    EXPECT_EQ(snapshot.histograms()[0].get().name(), "recorded");
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store, cm, time_system, true);
+
+  // A full flush still reports every histogram.
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](Stats::MetricSnapshot& snapshot) {
+    EXPECT_EQ(snapshot.histograms().size(), 2);
+  }));
+  InstanceUtil::flushMetricsToSinks(sinks, store, cm, time_system);
+}
+
 class RunHelperTest : public testing::Test {
 public:
   RunHelperTest() {